@@ -133,7 +133,14 @@ def single(input_file: Path, output_file: Path, max_width: Optional[int],
 @click.argument('output_bundle', type=click.Path(path_type=Path))
 @click.option('--width', type=int, default=120, help='帧宽度 (像素, 默认120)')
 @click.option('--height', type=int, default=120, help='帧高度 (像素, 默认120)')
-def pack(source_dir: Path, output_bundle: Path, width: int, height: int):
+@click.option('--bundle-version', type=click.Choice(['1', '2']), default='1',
+              help='bundle格式版本 (1=原始帧, 2=RLE/差异编码, 默认1)')
+@click.option('--key-color', type=str, default=None,
+              help='v2色键背景色 (RGB565十六进制, 如0xFFFF; 默认取首帧最多的颜色)')
+@click.option('--keyframe-interval', type=int, default=30,
+              help='v2关键帧间隔 (0=仅首帧, 默认30)')
+def pack(source_dir: Path, output_bundle: Path, width: int, height: int,
+         bundle_version: str, key_color: Optional[str], keyframe_interval: int):
     """
     将目录中的帧文件打包为bundle.bin
 
@@ -157,8 +164,17 @@ def pack(source_dir: Path, output_bundle: Path, width: int, height: int):
     click.echo(f"  帧数: {len(frame_files)}")
     click.echo(f"  输出文件: {output_bundle}")
     click.echo(f"  帧尺寸: {width}x{height}")
+    click.echo(f"  格式版本: v{bundle_version}")
     click.echo()
 
+    key_color_value = None
+    if key_color is not None:
+        try:
+            key_color_value = int(key_color, 16) & 0xFFFF
+        except ValueError:
+            click.echo(f"[ERROR] 无效的色键颜色: {key_color}")
+            return
+
     # 确保输出目录存在
     output_bundle.parent.mkdir(parents=True, exist_ok=True)
 
@@ -167,7 +183,10 @@ def pack(source_dir: Path, output_bundle: Path, width: int, height: int):
         frame_files=frame_files,
         output_bundle=output_bundle,
         width=width,
-        height=height
+        height=height,
+        version=int(bundle_version),
+        key_color=key_color_value,
+        keyframe_interval=keyframe_interval
     )
 
     if success:
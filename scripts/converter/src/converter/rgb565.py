@@ -182,22 +182,104 @@ class RGB565Converter:
             print(f"转换图片 {image_path} 为C数组时出错: {e}")
             return False
 
+    # v2帧编码方式（与bird_bundle_loader.h中的FrameEncoding一致）
+    FRAME_ENCODING_RAW = 0
+    FRAME_ENCODING_RLE = 1
+    FRAME_ENCODING_DELTA = 2
+    MAX_RUN_LENGTH = 16384
+
+    @staticmethod
+    def encode_runs(literal_mask: np.ndarray, pixels: np.ndarray) -> bytes:
+        """
+        将像素编码为v2游程流
+
+        每个游程以1-2字节操作码开头：bit7=字面量，bit6=长游程，
+        其余位为count-1（长游程时再跟一个低8位字节）。字面量游程后跟RGB565像素
+
+        Args:
+            literal_mask: 布尔数组，True表示该像素需要写出，False表示跳过
+            pixels: RGB565像素数组（uint16）
+
+        Returns:
+            编码后的字节流
+        """
+        out = bytearray()
+        n = len(pixels)
+        if n == 0:
+            return bytes(out)
+
+        # 找出掩码变化的位置，得到各游程的起止
+        boundaries = np.flatnonzero(np.diff(literal_mask.astype(np.int8))) + 1
+        starts = np.concatenate(([0], boundaries))
+        ends = np.concatenate((boundaries, [n]))
+
+        for start, end in zip(starts.tolist(), ends.tolist()):
+            is_literal = bool(literal_mask[start])
+            pos = start
+            while pos < end:
+                count = min(end - pos, RGB565Converter.MAX_RUN_LENGTH)
+                op = 0x80 if is_literal else 0x00
+                value = count - 1
+                if value < 64:
+                    out.append(op | value)
+                else:
+                    out.append(op | 0x40 | (value >> 8))
+                    out.append(value & 0xFF)
+                if is_literal:
+                    out += pixels[pos:pos + count].astype('<u2').tobytes()
+                pos += count
+
+        return bytes(out)
+
+    @staticmethod
+    def encode_frame(pixels: np.ndarray, prev_pixels: Optional[np.ndarray],
+                     key_color: Optional[int]) -> Tuple[int, bytes]:
+        """
+        为单帧选择最小的编码方式
+
+        Args:
+            pixels: 当前帧RGB565像素
+            prev_pixels: 上一帧像素（None表示必须是关键帧）
+            key_color: 色键背景色（None表示不使用RLE）
+
+        Returns:
+            (编码方式, 编码数据)
+        """
+        best = (RGB565Converter.FRAME_ENCODING_RAW, pixels.astype('<u2').tobytes())
+
+        if key_color is not None:
+            rle = RGB565Converter.encode_runs(pixels != key_color, pixels)
+            if len(rle) < len(best[1]):
+                best = (RGB565Converter.FRAME_ENCODING_RLE, rle)
+
+        if prev_pixels is not None:
+            delta = RGB565Converter.encode_runs(pixels != prev_pixels, pixels)
+            if len(delta) < len(best[1]):
+                best = (RGB565Converter.FRAME_ENCODING_DELTA, delta)
+
+        return best
+
     @staticmethod
     def pack_frames_to_bundle(frame_files: list[Path], output_bundle: Path,
-                              width: int = 120, height: int = 120) -> bool:
+                              width: int = 120, height: int = 120,
+                              version: int = 1, key_color: Optional[int] = None,
+                              keyframe_interval: int = 30) -> bool:
         """
         将多个帧文件打包为bundle.bin
 
         Bundle文件格式:
         - Bundle Header (64字节): magic, version, frame_count, 等元数据
         - Frame Index (N×12字节): 每帧的offset, size, checksum
-        - Frame Data: 所有帧的LVGL 9.x格式数据
+        - Frame Data: v1为所有帧的LVGL 9.x格式数据，v2为编码后的像素数据
 
         Args:
             frame_files: 帧文件列表（按顺序，1.bin, 2.bin, ...）
             output_bundle: 输出bundle文件路径
             width: 帧宽度
             height: 帧高度
+            version: bundle格式版本（1=原始帧，2=RLE/差异编码）
+            key_color: v2色键背景色（RGB565），None时取首帧出现最多的颜色
+            keyframe_interval: v2关键帧间隔（0表示只有首帧是关键帧）
 
         Returns:
             转换是否成功
@@ -212,6 +294,10 @@ class RGB565Converter:
             # 排序帧文件（按数字顺序）
             frame_files = sorted(frame_files, key=lambda p: int(p.stem) if p.stem.isdigit() else 0)
 
+            if version == 2:
+                return RGB565Converter._pack_frames_to_bundle_v2(
+                    frame_files, output_bundle, width, height, key_color, keyframe_interval)
+
             frame_count = len(frame_files)
             print(f"开始打包 {frame_count} 帧到 {output_bundle}")
 
@@ -309,4 +395,125 @@ class RGB565Converter:
             print(f"打包帧文件时出错: {e}")
             import traceback
             traceback.print_exc()
-            return False
\ No newline at end of file
+            return False
+
+    @staticmethod
+    def _pack_frames_to_bundle_v2(frame_files: list[Path], output_bundle: Path,
+                                  width: int, height: int, key_color: Optional[int],
+                                  keyframe_interval: int) -> bool:
+        """
+        打包v2格式bundle（每帧选择RAW/RLE/DELTA中最小的编码）
+
+        v2头部在原reserved区写入key_color(2B)、keyframe_interval(1B)、max_encoded_size(4B)，
+        帧索引的size字段高8位为编码方式
+        """
+        try:
+            import zlib
+
+            frame_count = len(frame_files)
+            print(f"开始打包 {frame_count} 帧到 {output_bundle} (v2编码)")
+
+            MAGIC = 0x42495244  # "BIRD"
+            VERSION = 2
+            COLOR_FORMAT_RGB565 = 0x12
+            HEADER_SIZE = 64
+            LV_HEADER_SIZE = 24
+            INDEX_ENTRY_SIZE = 12
+            DATA_OFFSET = HEADER_SIZE + frame_count * INDEX_ENTRY_SIZE
+            pixel_count = width * height
+
+            if not 0 <= keyframe_interval <= 255:
+                print(f"错误: 关键帧间隔必须在0-255之间: {keyframe_interval}")
+                return False
+
+            # 读取并验证所有帧的像素
+            print("读取帧像素...")
+            frames = []
+            for frame_file in frame_files:
+                if not frame_file.exists():
+                    print(f"错误: 帧文件不存在: {frame_file}")
+                    return False
+
+                data = frame_file.read_bytes()
+                if len(data) < LV_HEADER_SIZE:
+                    print(f"错误: 帧文件太小: {frame_file}")
+                    return False
+
+                header_cf = struct.unpack('<I', data[:4])[0]
+                color_format = header_cf & 0xFF
+                magic = (header_cf >> 24) & 0xFF
+                if color_format != COLOR_FORMAT_RGB565 or magic != 0x37:
+                    print(f"错误: 无效的LVGL 9.x格式: {frame_file} (cf=0x{color_format:02X}, magic=0x{magic:02X})")
+                    return False
+
+                pixels = np.frombuffer(data[LV_HEADER_SIZE:], dtype='<u2')
+                if len(pixels) != pixel_count:
+                    print(f"错误: 帧尺寸不匹配: {frame_file} ({len(pixels)} 像素, 期望 {pixel_count})")
+                    return False
+                frames.append(pixels)
+
+            # 未指定色键时使用首帧出现最多的颜色（通常是背景）
+            if key_color is None:
+                values, counts = np.unique(frames[0], return_counts=True)
+                key_color = int(values[np.argmax(counts)])
+            print(f"  色键颜色: 0x{key_color:04X}")
+
+            # 编码所有帧
+            print("编码帧数据...")
+            encoded = []
+            encoding_counts = {0: 0, 1: 0, 2: 0}
+            for i, pixels in enumerate(frames):
+                is_keyframe = i == 0 or (keyframe_interval > 0 and i % keyframe_interval == 0)
+                prev = None if is_keyframe else frames[i - 1]
+                encoding, payload = RGB565Converter.encode_frame(pixels, prev, key_color)
+                encoded.append((encoding, payload))
+                encoding_counts[encoding] += 1
+
+            max_encoded_size = max(len(payload) for _, payload in encoded)
+            total_data_size = sum(len(payload) for _, payload in encoded)
+            total_size = DATA_OFFSET + total_data_size
+
+            with open(output_bundle, 'wb') as f:
+                # 1. Bundle Header (64字节)
+                f.write(struct.pack('<I', MAGIC))                    # magic (4B)
+                f.write(struct.pack('<H', VERSION))                  # version (2B)
+                f.write(struct.pack('<H', frame_count))              # frame_count (2B)
+                f.write(struct.pack('<H', width))                    # frame_width (2B)
+                f.write(struct.pack('<H', height))                   # frame_height (2B)
+                f.write(struct.pack('<I', pixel_count * 2))          # frame_size (4B, 解码后大小)
+                f.write(struct.pack('<I', HEADER_SIZE))              # index_offset (4B)
+                f.write(struct.pack('<I', DATA_OFFSET))              # data_offset (4B)
+                f.write(struct.pack('<I', total_size))               # total_size (4B)
+                f.write(struct.pack('<B', COLOR_FORMAT_RGB565))      # color_format (1B)
+                f.write(struct.pack('<H', key_color))                # key_color (2B)
+                f.write(struct.pack('<B', keyframe_interval))        # keyframe_interval (1B)
+                f.write(struct.pack('<I', max_encoded_size))         # max_encoded_size (4B)
+                f.write(bytes(28))                                   # reserved (28B)
+
+                # 2. Frame Index表 (N×12字节)，size高8位为编码方式
+                offset = DATA_OFFSET
+                for encoding, payload in encoded:
+                    checksum = zlib.crc32(payload) & 0xFFFFFFFF
+                    f.write(struct.pack('<I', offset))
+                    f.write(struct.pack('<I', (encoding << 24) | len(payload)))
+                    f.write(struct.pack('<I', checksum))
+                    offset += len(payload)
+
+                # 3. 帧数据
+                for _, payload in encoded:
+                    f.write(payload)
+
+            raw_total = frame_count * (LV_HEADER_SIZE + pixel_count * 2)
+            print(f"✓ 成功打包 {frame_count} 帧")
+            print(f"  输出文件: {output_bundle}")
+            print(f"  文件大小: {total_size / 1024:.1f} KB (v1约 {raw_total / 1024:.1f} KB, "
+                  f"压缩比 {raw_total / max(total_size, 1):.2f}x)")
+            print(f"  平均每帧: {total_data_size / frame_count:.0f} 字节, 最大 {max_encoded_size} 字节")
+            print(f"  编码分布: RAW={encoding_counts[0]}, RLE={encoding_counts[1]}, DELTA={encoding_counts[2]}")
+            return True
+
+        except Exception as e:
+            print(f"打包帧文件时出错: {e}")
+            import traceback
+            traceback.print_exc()
+            return False
@@ -99,6 +99,18 @@ class SerialConnectionManager:
         except Exception as e:
             raise ConnectionError(f"发送命令失败: {str(e)}")
 
+    async def send_bytes(self, data: bytes) -> None:
+        """发送原始字节（不清空输入缓冲区，用于二进制传输）"""
+        if not self.is_connected or not self.port or not self.port.is_open:
+            raise ConnectionError("设备未连接")
+
+        try:
+            self.port.write(data)
+        except serial.SerialTimeoutError:
+            raise CommandTimeoutError("发送数据超时")
+        except serial.SerialException as e:
+            raise ConnectionError(f"串口通信错误: {str(e)}")
+
     async def read_data(self, size: int = 1024) -> bytes:
         """读取串口数据（优化版本）"""
         if not self.is_connected or not self.port or not self.port.is_open:
@@ -1,10 +1,18 @@
 """
 文件传输模块 - 通过串口上传/下载文件到SD卡
+
+优先使用二进制分帧协议（file put / file get，见设备端 binary_transfer.h），
+设备不支持时回退到base64逐行传输。sync_directory 先用 file hash 比较CRC32，
+只上传缺失或有变化的文件。
 """
 import base64
 import asyncio
+import struct
+import time
+import zlib
 from pathlib import Path
-from typing import Optional
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Tuple
 from .connection import SerialConnectionManager
 
 
@@ -13,6 +21,122 @@ class FileTransferError(Exception):
     pass
 
 
+# 二进制帧：0xB5 类型(u8) 序号(u16) 偏移(u32) 长度(u16) 负载 CRC32(u32，覆盖类型到负载)
+FRAME_MAGIC = 0xB5
+FRAME_HEADER = struct.Struct("<BBHIH")
+FRAME_DATA = 0x01
+FRAME_END = 0x02
+FRAME_ABORT = 0x03
+FRAME_SIZE = 2048            # 与设备端 FILE_XFER_FRAME_SIZE 一致
+FRAME_WINDOW = 8             # 与设备端 FILE_XFER_WINDOW 一致
+RETRANSMIT_TIMEOUT = 1.0     # 秒，无确认时从最后确认的位置重发
+IDLE_TIMEOUT = 15.0          # 秒，无进展时放弃（保留部分文件以便续传）
+PROGRESS_INTERVAL = 0.5      # 秒，进度输出间隔
+HASH_BLOCK_SIZE = 65536      # 与设备端 FILE_HASH_BLOCK_SIZE 一致
+
+
+def build_frame(frame_type: int, seq: int, offset: int, payload: bytes = b"") -> bytes:
+    """构造一帧"""
+    header = FRAME_HEADER.pack(FRAME_MAGIC, frame_type, seq & 0xFFFF, offset, len(payload))
+    crc = zlib.crc32(header[1:] + payload)
+    return header + payload + struct.pack("<I", crc)
+
+
+def parse_frames(buffer: bytearray) -> Tuple[List[Tuple[int, int, bytes]], bool]:
+    """
+    从缓冲区取出完整的帧，返回 ([(类型, 偏移, 负载)], 是否遇到损坏数据)
+
+    帧之外的字节（设备的其他串口输出）和校验失败的数据都被跳过。
+    """
+    frames = []
+    corrupted = False
+    while True:
+        start = buffer.find(bytes([FRAME_MAGIC]))
+        if start < 0:
+            buffer.clear()
+            break
+        del buffer[:start]
+        if len(buffer) < FRAME_HEADER.size:
+            break
+
+        _, frame_type, _, offset, length = FRAME_HEADER.unpack_from(buffer)
+        if length > FRAME_SIZE or frame_type not in (FRAME_DATA, FRAME_END, FRAME_ABORT):
+            del buffer[0]
+            corrupted = True
+            continue
+
+        total = FRAME_HEADER.size + length + 4
+        if len(buffer) < total:
+            break
+
+        payload = bytes(buffer[FRAME_HEADER.size:FRAME_HEADER.size + length])
+        crc = struct.unpack_from("<I", buffer, total - 4)[0]
+        if zlib.crc32(bytes(buffer[1:FRAME_HEADER.size]) + payload) != crc:
+            del buffer[0]
+            corrupted = True
+            continue
+
+        frames.append((frame_type, offset, payload))
+        del buffer[:total]
+    return frames, corrupted
+
+
+@dataclass
+class FileHash:
+    """文件的CRC32（blocks为每HASH_BLOCK_SIZE字节的CRC32）"""
+    crc: int
+    size: int
+    blocks: List[int] = field(default_factory=list)
+
+
+def hash_local_file(path: Path) -> FileHash:
+    """计算本地文件的整体和分块CRC32"""
+    crc = 0
+    size = 0
+    blocks = []
+    with open(path, 'rb') as f:
+        while True:
+            block = f.read(HASH_BLOCK_SIZE)
+            if not block:
+                break
+            crc = zlib.crc32(block, crc)
+            size += len(block)
+            blocks.append(zlib.crc32(block))
+    return FileHash(crc, size, blocks)
+
+
+def matching_prefix(local: FileHash, remote: FileHash) -> int:
+    """设备上现有文件可以沿用的前缀字节数（到第一个不同的块为止）"""
+    matched = 0
+    for local_block, remote_block in zip(local.blocks, remote.blocks):
+        if local_block != remote_block:
+            break
+        matched += 1
+    # 最后一块可能不完整，只沿用两边都是完整块的部分
+    return min(matched * HASH_BLOCK_SIZE, local.size, remote.size) // HASH_BLOCK_SIZE * HASH_BLOCK_SIZE
+
+
+class _ProgressPrinter:
+    """限制进度输出频率"""
+
+    def __init__(self, total: int, callback=None):
+        self.total = total
+        self.callback = callback
+        self.started = time.monotonic()
+        self.last = 0.0
+
+    def update(self, current: int, force: bool = False) -> None:
+        if self.callback:
+            self.callback(current, self.total)
+        now = time.monotonic()
+        if not force and now - self.last < PROGRESS_INTERVAL:
+            return
+        self.last = now
+        percent = (current / self.total) * 100 if self.total > 0 else 100
+        rate = current / max(now - self.started, 1e-3) / 1024
+        print(f"进度: {current}/{self.total} 字节 ({percent:.1f}%, {rate:.1f} KB/s)")
+
+
 class FileTransfer:
     """文件传输管理器"""
 
@@ -21,7 +145,7 @@ class FileTransfer:
         self.chunk_size = 768  # 768字节编码后1024字符
 
     async def upload_file(self, local_path: str, remote_path: str, 
-                         progress_callback=None) -> bool:
+                         progress_callback=None, keep: int = 0) -> bool:
         """
         上传文件到设备SD卡
         
@@ -29,6 +153,7 @@ class FileTransfer:
             local_path: 本地文件路径
             remote_path: 远程SD卡路径
             progress_callback: 进度回调函数 (current, total) -> None
+            keep: 设备上现有文件与本地相同的前缀字节数（差异同步时只传之后的数据）
             
         Returns:
             bool: 上传是否成功
@@ -48,6 +173,124 @@ class FileTransfer:
         print(f"目标路径: {remote_path}")
         print(f"文件大小: {file_size} 字节 ({file_size / 1024:.2f} KB)")
 
+        result = await self._upload_binary(local_file, remote_path, progress_callback, keep)
+        if result is not None:
+            return result
+
+        print("设备不支持二进制传输，使用base64模式")
+        return await self._upload_base64(local_path, remote_path, file_size, progress_callback)
+
+    async def _read_lines(self, buffer: List[str]) -> List[str]:
+        """读取已到达的数据，返回完整的行（buffer[0]保存不完整的行）"""
+        if self.connection.bytes_available() <= 0:
+            return []
+        data = await self.connection.read_data()
+        buffer[0] += data.decode('utf-8', errors='ignore')
+        lines = buffer[0].split('\n')
+        buffer[0] = lines[-1]
+        return [line.strip() for line in lines[:-1] if line.strip()]
+
+    async def _upload_binary(self, local_file: Path, remote_path: str,
+                             progress_callback=None, keep: int = 0) -> Optional[bool]:
+        """二进制分帧上传，设备不支持时返回None"""
+        data = local_file.read_bytes()
+        file_size = len(data)
+        file_crc = zlib.crc32(data)
+
+        command = f"file put {remote_path} {file_size} {file_crc:08x}"
+        if keep > 0:
+            command += f" {keep}"
+        await self.connection.send_command(command)
+
+        # 等待BIN_READY <offset> <crc>
+        pending = [""]
+        ready = None
+        deadline = time.monotonic() + 10
+        while ready is None and time.monotonic() < deadline:
+            for line in await self._read_lines(pending):
+                if line.startswith("BIN_READY"):
+                    ready = line.split()
+                    break
+                if "Unknown file subcommand" in line:
+                    return None
+                if line.startswith("ERROR"):
+                    raise FileTransferError(f"上传失败: {line}")
+            await asyncio.sleep(0.01)
+        if ready is None or len(ready) < 3:
+            return None
+
+        # 设备上已有的部分数据与本地一致时续传
+        device_offset = int(ready[1])
+        device_crc = int(ready[2], 16)
+        start = 0
+        if 0 < device_offset <= file_size and zlib.crc32(data[:device_offset]) == device_crc:
+            start = device_offset
+            print(f"从 {start} 字节处续传")
+        print("设备已就绪，开始二进制传输...")
+
+        progress = _ProgressPrinter(file_size, progress_callback)
+        window = FRAME_WINDOW * FRAME_SIZE
+        acked = start
+        next_offset = start
+        seq = 0
+        end_sent = False
+        last_ack = time.monotonic()
+        last_progress = time.monotonic()
+
+        while True:
+            sent = False
+            if next_offset < file_size and next_offset - acked < window:
+                chunk = data[next_offset:next_offset + FRAME_SIZE]
+                await self.connection.send_bytes(build_frame(FRAME_DATA, seq, next_offset, chunk))
+                seq += 1
+                next_offset += len(chunk)
+                sent = True
+            elif acked == file_size and not end_sent:
+                await self.connection.send_bytes(
+                    build_frame(FRAME_END, seq, file_size, struct.pack("<I", file_crc)))
+                seq += 1
+                end_sent = True
+                sent = True
+
+            for line in await self._read_lines(pending):
+                if line.startswith("ACK "):
+                    value = int(line[4:])
+                    if acked < value <= next_offset:
+                        acked = value
+                        last_progress = time.monotonic()
+                        progress.update(acked)
+                    last_ack = time.monotonic()
+                elif line.startswith("NAK "):
+                    # 从设备期望的位置重发
+                    value = int(line[4:])
+                    if acked <= value <= file_size:
+                        acked = value
+                        next_offset = value
+                        end_sent = False
+                    last_ack = time.monotonic()
+                elif line.startswith("SUCCESS"):
+                    progress.update(file_size, force=True)
+                    print(f"设备响应: {line}")
+                    print("✓ 文件上传成功!")
+                    return True
+                elif line.startswith("ERROR"):
+                    raise FileTransferError(f"上传失败: {line}")
+
+            now = time.monotonic()
+            if now - last_ack > RETRANSMIT_TIMEOUT:
+                next_offset = acked
+                end_sent = False
+                last_ack = now
+            if now - last_progress > IDLE_TIMEOUT:
+                await self.connection.send_bytes(build_frame(FRAME_ABORT, seq, acked))
+                raise FileTransferError(f"传输超时，已传输 {acked}/{file_size} 字节，重新上传将自动续传")
+
+            if not sent:
+                await asyncio.sleep(0.001)
+
+    async def _upload_base64(self, local_path: str, remote_path: str, file_size: int,
+                             progress_callback=None) -> bool:
+        """base64逐行上传（旧版固件）"""
         # 发送上传命令
         command = f"file upload {remote_path}"
         await self.connection.send_command(command)
@@ -176,6 +419,126 @@ class FileTransfer:
         local_file = Path(local_path)
         local_file.parent.mkdir(parents=True, exist_ok=True)
 
+        result = await self._download_binary(remote_path, local_file, progress_callback)
+        if result is not None:
+            return result
+
+        print("设备不支持二进制传输，使用base64模式")
+        return await self._download_base64(remote_path, local_path, progress_callback)
+
+    async def _download_binary(self, remote_path: str, local_file: Path,
+                               progress_callback=None) -> Optional[bool]:
+        """二进制分帧下载，设备不支持时返回None；中断时保留.part文件以便续传"""
+        part_file = local_file.with_name(local_file.name + ".part")
+        offset = part_file.stat().st_size if part_file.exists() else 0
+
+        await self.connection.send_command(f"file get {remote_path} {offset}")
+
+        # 等待BIN_START <size> <offset>，之后的数据都是二进制帧
+        buffer = bytearray()
+        start_line = None
+        deadline = time.monotonic() + 10
+        while start_line is None and time.monotonic() < deadline:
+            if self.connection.bytes_available() > 0:
+                buffer += await self.connection.read_data()
+                while b"\n" in buffer:
+                    raw, _, rest = bytes(buffer).partition(b"\n")
+                    buffer = bytearray(rest)
+                    line = raw.decode('utf-8', errors='ignore').strip()
+                    if line.startswith("BIN_START"):
+                        start_line = line.split()
+                        break
+                    if "Unknown file subcommand" in line:
+                        return None
+                    if line.startswith("ERROR"):
+                        raise FileTransferError(f"下载失败: {line}")
+            else:
+                await asyncio.sleep(0.01)
+        if start_line is None or len(start_line) < 3:
+            return None
+
+        file_size = int(start_line[1])
+        start = int(start_line[2])
+        print(f"文件大小: {file_size} 字节 ({file_size / 1024:.2f} KB)")
+        if start > 0:
+            print(f"从 {start} 字节处续传")
+
+        progress = _ProgressPrinter(file_size, progress_callback)
+        expected = start
+        # END帧的CRC覆盖整个文件：续传时从本地已有部分的CRC接着累计，损坏的前缀会被发现
+        crc = 0
+        if start > 0:
+            with open(part_file, 'rb') as f:
+                crc = zlib.crc32(f.read(start))
+        nak_sent = False
+        last_data = time.monotonic()
+        last_progress = time.monotonic()
+
+        with open(part_file, 'r+b' if start > 0 else 'wb') as f:
+            f.truncate(start)
+            f.seek(start)
+
+            while True:
+                if self.connection.bytes_available() > 0:
+                    buffer += await self.connection.read_data()
+                    last_data = time.monotonic()
+
+                frames, corrupted = parse_frames(buffer)
+                if corrupted and not nak_sent:
+                    await self.connection.send_bytes(f"NAK {expected}\n".encode())
+                    nak_sent = True
+
+                for frame_type, frame_offset, payload in frames:
+                    if frame_type == FRAME_DATA:
+                        if frame_offset == expected:
+                            f.write(payload)
+                            crc = zlib.crc32(payload, crc)
+                            expected += len(payload)
+                            nak_sent = False
+                            last_progress = time.monotonic()
+                            await self.connection.send_bytes(f"ACK {expected}\n".encode())
+                            progress.update(expected)
+                        elif frame_offset < expected:
+                            await self.connection.send_bytes(f"ACK {expected}\n".encode())
+                        elif not nak_sent:
+                            await self.connection.send_bytes(f"NAK {expected}\n".encode())
+                            nak_sent = True
+                    elif frame_type == FRAME_END and expected == file_size:
+                        device_crc = struct.unpack("<I", payload[:4])[0] if len(payload) >= 4 else crc
+                        if device_crc != crc:
+                            await self.connection.send_bytes(b"ABORT\n")
+                            f.close()
+                            part_file.unlink()
+                            if start > 0:
+                                raise FileTransferError("CRC校验失败（续传前已有的部分文件可能已损坏），"
+                                                        "已删除不完整的文件，请重新下载")
+                            raise FileTransferError("CRC校验失败，已删除不完整的文件")
+                        await self.connection.send_bytes(b"DONE\n")
+                        f.close()
+                        if local_file.exists():
+                            local_file.unlink()
+                        part_file.rename(local_file)
+                        progress.update(file_size, force=True)
+                        print(f"✓ 文件下载成功! 总计 {file_size} 字节")
+                        return True
+                    elif frame_type == FRAME_END:
+                        await self.connection.send_bytes(f"NAK {expected}\n".encode())
+
+                now = time.monotonic()
+                if now - last_data > RETRANSMIT_TIMEOUT:
+                    # 设备可能在等确认
+                    await self.connection.send_bytes(f"NAK {expected}\n".encode())
+                    last_data = now
+                if now - last_progress > IDLE_TIMEOUT:
+                    await self.connection.send_bytes(b"ABORT\n")
+                    raise FileTransferError(f"传输超时，已接收 {expected}/{file_size} 字节，重新下载将自动续传")
+
+                if not frames:
+                    await asyncio.sleep(0.001)
+
+    async def _download_base64(self, remote_path: str, local_path: str,
+                               progress_callback=None) -> bool:
+        """base64逐行下载（旧版固件）"""
         # 发送下载命令
         command = f"file download {remote_path}"
         await self.connection.send_command(command)
@@ -285,6 +648,103 @@ class FileTransfer:
                 Path(local_path).unlink()
             raise FileTransferError(f"文件下载失败: {str(e)}")
 
+    async def get_remote_hashes(self, remote_path: str, blocks: bool = False) -> Dict[str, FileHash]:
+        """
+        获取设备上文件（或目录下所有文件）的CRC32
+
+        Returns:
+            dict: 远程路径 -> FileHash；路径不存在时为空
+        """
+        if not self.connection.is_connected:
+            raise FileTransferError("设备未连接")
+
+        command = f"file hash {remote_path}"
+        if blocks:
+            command += " blocks"
+        await self.connection.send_command(command)
+
+        # 大目录需要设备逐个读文件，以最后一次收到数据为准计算超时
+        hashes: Dict[str, FileHash] = {}
+        current: Optional[FileHash] = None
+        pending = [""]
+        last_data = time.monotonic()
+
+        while time.monotonic() - last_data < 30:
+            lines = await self._read_lines(pending)
+            if not lines:
+                await asyncio.sleep(0.01)
+                continue
+            last_data = time.monotonic()
+
+            for line in lines:
+                parts = line.split(maxsplit=3)
+                if parts[0] == "HASH" and len(parts) == 4:
+                    current = FileHash(int(parts[1], 16), int(parts[2]))
+                    hashes[parts[3]] = current
+                elif parts[0] == "BLOCK" and len(parts) == 3 and current is not None:
+                    current.blocks.append(int(parts[2], 16))
+                elif parts[0] == "HASH_END":
+                    return hashes
+                elif "Unknown file subcommand" in line:
+                    raise FileTransferError("设备固件不支持 file hash，请先更新固件")
+                elif line.startswith("ERROR: Path not found"):
+                    continue
+                elif line.startswith("ERROR"):
+                    raise FileTransferError(f"获取文件哈希失败: {line}")
+
+        raise FileTransferError("等待设备返回文件哈希超时")
+
+    async def sync_directory(self, local_dir: str, remote_dir: str, dry_run: bool = False) -> dict:
+        """
+        差异同步本地目录到设备：只上传缺失或内容不同的文件，
+        有变化的文件从第一个不同的64KB块开始传输
+
+        Returns:
+            dict: 统计信息（unchanged/added/changed/bytes_sent/bytes_total）
+        """
+        local_root = Path(local_dir)
+        if not local_root.is_dir():
+            raise FileTransferError(f"不是一个目录: {local_dir}")
+
+        remote_root = "/" + remote_dir.strip("/") if remote_dir.strip("/") else ""
+        print(f"正在获取设备文件哈希: {remote_root or '/'}")
+        remote_hashes = await self.get_remote_hashes(remote_root or "/", blocks=True)
+
+        plan = []
+        summary = {"unchanged": 0, "added": 0, "changed": 0, "bytes_sent": 0, "bytes_total": 0}
+        for local_file in sorted(p for p in local_root.rglob("*") if p.is_file()):
+            remote_path = f"{remote_root}/{local_file.relative_to(local_root).as_posix()}"
+            local_hash = hash_local_file(local_file)
+            summary["bytes_total"] += local_hash.size
+
+            remote_hash = remote_hashes.get(remote_path)
+            if remote_hash is None:
+                summary["added"] += 1
+                plan.append((local_file, remote_path, 0, local_hash.size))
+            elif remote_hash.crc == local_hash.crc and remote_hash.size == local_hash.size:
+                summary["unchanged"] += 1
+            else:
+                summary["changed"] += 1
+                keep = matching_prefix(local_hash, remote_hash)
+                plan.append((local_file, remote_path, keep, local_hash.size))
+
+        for local_file, remote_path, keep, size in plan:
+            summary["bytes_sent"] += size - keep
+            note = f"（沿用前 {keep} 字节）" if keep else ""
+            print(f"{'新增' if remote_path not in remote_hashes else '更新'}: {remote_path} "
+                  f"{size - keep}/{size} 字节{note}")
+
+        print(f"共 {summary['unchanged'] + summary['added'] + summary['changed']} 个文件: "
+              f"未变化 {summary['unchanged']}，新增 {summary['added']}，更新 {summary['changed']}；"
+              f"需传输 {summary['bytes_sent']}/{summary['bytes_total']} 字节")
+
+        if dry_run:
+            return summary
+
+        for local_file, remote_path, keep, _ in plan:
+            await self.upload_file(str(local_file), remote_path, keep=keep)
+        return summary
+
     async def delete_file(self, remote_path: str) -> bool:
         """
         删除设备SD卡上的文件
@@ -0,0 +1,65 @@
+"""
+事件跟踪（trace dump）数据收集
+
+串口输出：`trace dump` 在 TRACE_START 与 TRACE_END:<字节数>:<crc32> 之间逐行输出base64。
+这里只负责收集和校验，保存的原始数据（格式见 src/system/logging/trace_buffer.h）用
+scripts/host_bench 的 trace2json 转换为Chrome trace JSON，事件表与设备端共用。
+"""
+import base64
+import binascii
+import re
+import zlib
+from typing import List
+
+
+_BASE64_RE = re.compile(r"^[A-Za-z0-9+/]+=*$")
+
+
+class TraceDecodeError(Exception):
+    """跟踪数据收集失败"""
+    pass
+
+
+class TraceDumpCollector:
+    """从串口输出的行中收集 trace dump 数据并校验"""
+
+    def __init__(self):
+        self.started = False
+        self.finished = False
+        self._chunks: List[bytes] = []
+
+    def feed(self, line: str) -> bool:
+        """处理一行输出，导出结束时返回True"""
+        if line == "TRACE_START":
+            self.started = True
+            self._chunks = []
+            return False
+        if not self.started or self.finished:
+            return self.finished
+
+        if line.startswith("TRACE_END:"):
+            parts = line.split(":")
+            if len(parts) != 3:
+                raise TraceDecodeError(f"无法解析结束行: {line}")
+            self._verify(int(parts[1]), int(parts[2], 16))
+            self.finished = True
+            return True
+
+        # 其他任务的日志可能穿插在数据行之间，只接受base64行
+        if _BASE64_RE.match(line):
+            try:
+                self._chunks.append(base64.b64decode(line))
+            except binascii.Error:
+                pass
+        return False
+
+    def _verify(self, size: int, crc: int) -> None:
+        data = self.data
+        if len(data) != size:
+            raise TraceDecodeError(f"跟踪数据长度不符: 收到{len(data)}字节，设备发送{size}字节")
+        if zlib.crc32(data) & 0xFFFFFFFF != crc:
+            raise TraceDecodeError("跟踪数据CRC校验失败")
+
+    @property
+    def data(self) -> bytes:
+        return b"".join(self._chunks)
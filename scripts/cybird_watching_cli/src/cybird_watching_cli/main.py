@@ -3,6 +3,7 @@ CybirdWatching CLI 主入口点
 """
 import asyncio
 import sys
+import time
 import argparse
 from pathlib import Path
 
@@ -11,6 +12,7 @@ from .core.connection import SerialConnectionManager
 from .core.response_handler import CommandResponseHandler
 from .core.command_executor import CommandExecutor
 from .core.file_transfer import FileTransfer, FileTransferError
+from .core.trace_collector import TraceDecodeError, TraceDumpCollector
 from .ui.console import ConsoleInterface
 from .utils.exceptions import CybirdCLIError, ConnectionError
 
@@ -157,6 +159,13 @@ class CybirdWatchingCLI:
             # 使用原始输入来保留文件路径大小写
             await self._handle_download_command(original_input)
             return True
+        elif command.startswith('sync '):
+            await self._handle_sync_command(original_input)
+            return True
+        elif command.startswith('trace dump '):
+            # trace dump <本地.bin> - 导出并保存原始数据；不带路径时作为设备命令
+            await self._handle_trace_dump_command(original_input)
+            return True
         elif command.startswith('file upload ') or command.startswith('file download '):
             # file upload/download 带本地路径参数 - 作为本地命令处理
             # 检查是否有足够的参数（至少3个部分）
@@ -313,6 +322,100 @@ class CybirdWatchingCLI:
         except FileTransferError as e:
             self.console.show_error(f"文件下载失败: {str(e)}")
 
+    async def _handle_sync_command(self, command: str) -> None:
+        """
+        处理差异同步命令
+        sync <本地目录> <远程目录> [--dry-run]
+        """
+        parts = command.split()[1:]
+        dry_run = '--dry-run' in parts
+        parts = [part for part in parts if part != '--dry-run']
+
+        if len(parts) < 2 or not parts[-1].startswith('/'):
+            self.console.show_error("用法: sync <本地目录> <远程目录> [--dry-run]")
+            self.console.show_info("示例: sync ./resources/birds /birds")
+            return
+
+        local_dir = ' '.join(parts[:-1])
+        remote_dir = parts[-1]
+
+        try:
+            await self.file_transfer.sync_directory(local_dir, remote_dir, dry_run)
+            self.console.show_info("✓ 同步完成" if not dry_run else "✓ 比较完成（未传输）")
+        except FileTransferError as e:
+            self.console.show_error(f"同步失败: {str(e)}")
+
+    async def _fetch_trace(self) -> bytes:
+        """发送trace dump并收集校验后的二进制快照"""
+        collector = TraceDumpCollector()
+        await self.connection.send_command("trace dump")
+
+        pending = ""
+        last_data = time.monotonic()
+        while time.monotonic() - last_data < 10:
+            if self.connection.bytes_available() <= 0:
+                await asyncio.sleep(0.01)
+                continue
+            last_data = time.monotonic()
+            data = await self.connection.read_data()
+            pending += data.decode('utf-8', errors='ignore')
+            lines = pending.split('\n')
+            pending = lines[-1]
+            for line in lines[:-1]:
+                line = line.strip()
+                if "Unknown command: trace" in line:
+                    raise TraceDecodeError("设备固件不支持 trace 命令，请先更新固件")
+                if line and collector.feed(line):
+                    return collector.data
+
+        raise TraceDecodeError("等待设备导出跟踪数据超时")
+
+    async def _handle_trace_dump_command(self, command: str) -> None:
+        """trace dump <本地.bin>"""
+        parts = command.split(maxsplit=2)[2:]
+        if not parts:
+            self.console.show_error("用法: trace dump <本地.bin>")
+            return
+
+        try:
+            data = await self._fetch_trace()
+            Path(parts[0]).write_bytes(data)
+            self.console.show_info(f"✓ {len(data)} bytes -> {parts[0]}（用 scripts/host_bench 的 trace2json 转换）")
+        except (TraceDecodeError, OSError) as e:
+            self.console.show_error(f"导出跟踪数据失败: {str(e)}")
+
+    async def export_trace(self, output: str) -> None:
+        """导出跟踪数据（非交互模式）"""
+        try:
+            await self._connect_device()
+
+            if not self.connection.is_connected:
+                print("错误: 无法连接到设备")
+                sys.exit(1)
+
+            data = await self._fetch_trace()
+            Path(output).write_bytes(data)
+            print(f"{len(data)} bytes -> {output}")
+
+        except (TraceDecodeError, OSError) as e:
+            self.console.show_error(f"导出跟踪数据失败: {str(e)}")
+            sys.exit(1)
+
+    async def sync_directory(self, local_dir: str, remote_dir: str, dry_run: bool) -> None:
+        """差异同步目录（非交互模式）"""
+        try:
+            await self._connect_device()
+
+            if not self.connection.is_connected:
+                print("错误: 无法连接到设备")
+                sys.exit(1)
+
+            await self.file_transfer.sync_directory(local_dir, remote_dir, dry_run)
+
+        except FileTransferError as e:
+            self.console.show_error(f"同步失败: {str(e)}")
+            sys.exit(1)
+
     async def send_single_command(self, command: str) -> None:
         """发送单个命令（非交互模式）"""
         try:
@@ -362,6 +465,8 @@ def create_parser() -> argparse.ArgumentParser:
   %(prog)s --baudrate 9600          # 指定波特率
   %(prog)s send "log"               # 发送单个命令
   %(prog)s send "status"            # 发送状态查询命令
+  %(prog)s sync ./resources/birds /birds             # 只上传有变化的小鸟资源
+  %(prog)s trace -o trace.bin                       # 导出事件跟踪（trace2json转换后用chrome://tracing打开）
         """
     )
 
@@ -397,6 +502,16 @@ def create_parser() -> argparse.ArgumentParser:
     send_parser = subparsers.add_parser('send', help='发送单个命令到设备')
     send_parser.add_argument('device_command', help='要发送的命令')
 
+    # sync命令
+    sync_parser = subparsers.add_parser('sync', help='差异同步本地目录到SD卡（只传输有变化的文件）')
+    sync_parser.add_argument('local_dir', help='本地目录')
+    sync_parser.add_argument('remote_dir', help='SD卡目录（以/开头）')
+    sync_parser.add_argument('--dry-run', action='store_true', help='只比较，不传输')
+
+    # trace命令（保存原始数据，用scripts/host_bench的trace2json转换为Chrome trace JSON）
+    trace_parser = subparsers.add_parser('trace', help='导出设备事件跟踪的原始数据')
+    trace_parser.add_argument('--output', '-o', default='trace.bin', help='输出文件（默认trace.bin）')
+
     return parser
 
 
@@ -416,6 +531,10 @@ async def main():
         if args.command == 'send':
             # 单命令模式
             await cli.send_single_command(args.device_command)
+        elif args.command == 'sync':
+            await cli.sync_directory(args.local_dir, args.remote_dir, args.dry_run)
+        elif args.command == 'trace':
+            await cli.export_trace(args.output)
         else:
             # 交互式模式
             await cli.run_interactive()
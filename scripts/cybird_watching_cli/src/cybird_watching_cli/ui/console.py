@@ -193,6 +193,8 @@ class ConsoleInterface:
   log size         - 显示日志文件大小
   log lines N      - 显示最后N行日志 (1-500)
   log cat/export   - 显示完整日志文件内容
+  log stats        - 显示日志缓冲统计
+  log rate [TAG N] - 查看/设置标签每秒日志条数上限
 
 🔧 系统状态:
   status           - 显示系统状态
@@ -205,6 +207,7 @@ class ConsoleInterface:
   file upload <远程>      - 上传文件到SD卡 (设备命令)
   file delete <远程>      - 删除SD卡文件
   file info <远程>        - 显示文件信息
+  file hash <远程> [blocks] - 显示文件/目录的CRC32
 
 🐦 观鸟功能:
   bird trigger [id]  - 手动触发小鸟动画（可选指定小鸟ID）
@@ -220,6 +223,8 @@ class ConsoleInterface:
   reset            - 重置观鸟统计数据并落盘
   upload <本地> <远程>   - 上传文件到SD卡 (快捷方式)
   download <远程> <本地> - 下载SD卡文件 (快捷方式)
+  sync <本地目录> <远程目录> [--dry-run] - 只上传缺失或有变化的文件
+  trace dump <本地.json> [原始.bin] - 导出事件跟踪并转换为Chrome trace
   quit, exit       - 退出程序
   reconnect        - 重新连接设备
   cls              - 清除此终端屏幕
@@ -237,7 +242,7 @@ class ConsoleInterface:
   [ON] CybirdWatching> tree         # 显示SD卡目录树
   [ON] CybirdWatching> bird list    # 查看可用小鸟列表
   [ON] CybirdWatching> upload config.json /configs/bird_config.json
-  [ON] CybirdWatching> download /logs/cybird_watching.log ./device.log
+  [ON] CybirdWatching> download /logs/cybird_watching.clog ./device.clog
         """
 
         if self.console:
@@ -0,0 +1,165 @@
+/**
+ * .clog日志解码工具
+ *
+ * 编译设备端的log_codec.cpp，用与log cat相同的LogReader解码从SD卡下载的日志，
+ * 格式串/参数编码修改后不需要同步主机端实现。
+ *
+ * 用法：clog_decode [选项] <文件...>（多个轮转代按从旧到新的顺序给出）
+ *   -t, --tag TAG      只显示指定标签（可重复，不区分大小写）
+ *   -l, --level LEVEL  只显示该级别及更严重的日志（FATAL/ERROR/WARN/INFO/DEBUG/TRACE）
+ *   --since SEC        只显示开机后该秒数之后的日志
+ *   --until SEC        只显示开机后该秒数之前的日志
+ *   --boot             时间显示为开机以来的时间（默认设备已校时则显示墙上时间）
+ *   -o, --output FILE  输出到文件（默认标准输出）
+ */
+#include "system/logging/log_codec.h"
+#include <FS.h>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<std::string> files;
+    std::vector<String> tags;
+    int maxLevel = 0;               // 0为不过滤
+    double since = -1;
+    double until = -1;
+    bool bootTime = false;
+    const char* output = nullptr;
+};
+
+void usage() {
+    fprintf(stderr,
+            "usage: clog_decode [-t TAG]... [-l LEVEL] [--since SEC] [--until SEC] [--boot] [-o FILE] FILE...\n");
+}
+
+int parseLevel(const char* name) {
+    for (int level = 1; level <= 6; level++) {
+        if (strcasecmp(name, LogCodec::levelName(level)) == 0) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "-t" || arg == "--tag") && hasValue) {
+            options.tags.push_back(argv[++i]);
+        } else if ((arg == "-l" || arg == "--level") && hasValue) {
+            options.maxLevel = parseLevel(argv[++i]);
+            if (!options.maxLevel) {
+                fprintf(stderr, "Unknown level: %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--since" && hasValue) {
+            options.since = atof(argv[++i]);
+        } else if (arg == "--until" && hasValue) {
+            options.until = atof(argv[++i]);
+        } else if (arg == "--boot") {
+            options.bootTime = true;
+        } else if ((arg == "-o" || arg == "--output") && hasValue) {
+            options.output = argv[++i];
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            return false;
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+    return !options.files.empty();
+}
+
+bool matches(const Options& options, const LogEntry& entry) {
+    if (!options.tags.empty()) {
+        bool found = false;
+        for (const auto& tag : options.tags) {
+            found = found || tag.equalsIgnoreCase(entry.tag);
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    if (options.maxLevel && entry.level > options.maxLevel) {
+        return false;
+    }
+    double seconds = entry.timestamp / 1e6;
+    return (options.since < 0 || seconds >= options.since) && (options.until < 0 || seconds <= options.until);
+}
+
+// 设备已校时：显示本地墙上时间，否则与log cat相同显示开机时间
+void formatEntry(const Options& options, const LogEntry& entry, String& line) {
+    if (options.bootTime || entry.wallTime == 0) {
+        LogReader::formatLine(entry, line);
+        return;
+    }
+    time_t seconds = (time_t)(entry.wallTime / 1000000);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    char timestamp[32];
+    size_t len = strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(timestamp + len, sizeof(timestamp) - len, ".%03d", (int)(entry.wallTime / 1000 % 1000));
+    line = String("[") + timestamp + "] [" + LogCodec::levelName(entry.level) + "] [" + entry.tag + "] " +
+           entry.message;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    FILE* out = options.output ? fopen(options.output, "w") : stdout;
+    if (!out) {
+        perror(options.output);
+        return 1;
+    }
+
+    // 主机文件系统的根目录映射为FS的根目录
+    fs::FS hostFs;
+    hostFs.setHostRoot("");
+    int result = 0;
+    for (const auto& path : options.files) {
+        char resolved[PATH_MAX];
+        File file = realpath(path.c_str(), resolved) ? hostFs.open(resolved, FILE_READ) : File();
+        if (!file) {
+            fprintf(stderr, "Cannot open %s\n", path.c_str());
+            result = 1;
+            break;
+        }
+        LogReader reader(file);
+        if (!reader.isValid()) {
+            fprintf(stderr, "Not a .clog file: %s\n", path.c_str());
+            result = 1;
+            break;
+        }
+
+        LogEntry entry;
+        String line;
+        while (reader.next(entry)) {
+            if (matches(options, entry)) {
+                formatEntry(options, entry, line);
+                fprintf(out, "%s\n", line.c_str());
+            }
+        }
+        if (reader.isTruncated()) {
+            fflush(out);
+            fprintf(stderr, "Warning: %s ends with incomplete data, ignored\n", path.c_str());
+        }
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return result;
+}
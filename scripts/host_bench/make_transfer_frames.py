@@ -0,0 +1,101 @@
+"""
+生成test_binary_transfer的主机输入
+
+用cybird-cli的build_frame（core/file_transfer.py）构造上传时主机发出的字节流，
+设备端的BinaryTransfer::receive在主机上读取这些帧，两端的帧格式和CRC不一致时测试失败。
+
+输出目录中：
+  upload.bin        上传的文件内容
+  part_good.bin     与上传文件前2048字节相同的部分文件（续传）
+  part_bad.bin      与上传文件不同的部分文件（主机从0重传）
+  crc.txt           每个数据文件一行"<文件名> <zlib.crc32>"
+  <场景>.in         主机发出的字节流
+
+用法：python3 make_transfer_frames.py <输出目录>
+"""
+import sys
+import types
+import zlib
+from pathlib import Path
+
+# 只需要帧构造函数：用空模块代替依赖pyserial的connection
+sys.path.insert(0, str(Path(__file__).resolve().parents[1] / "cybird_watching_cli" / "src"))
+connection = types.ModuleType("cybird_watching_cli.core.connection")
+connection.SerialConnectionManager = object
+sys.modules["cybird_watching_cli.core.connection"] = connection
+
+from cybird_watching_cli.core.file_transfer import (FRAME_DATA, FRAME_END, FRAME_MAGIC, FRAME_SIZE,  # noqa: E402
+                                                    build_frame)
+
+FILE_SIZE = 5000
+STRAY_POS = 1500          # 第一帧负载中放一个0xB5，其后是无效的帧头
+
+
+def make_data() -> bytes:
+    """不含0xB5的数据，只在STRAY_POS处放一个，便于控制设备端找帧头的位置"""
+    data = bytearray((i * 7 + 3) % 251 for i in range(FILE_SIZE))
+    for i, b in enumerate(data):
+        if b == FRAME_MAGIC:
+            data[i] = 0
+    data[STRAY_POS] = FRAME_MAGIC
+    data[STRAY_POS + 1] = 0xFF    # 无效的帧类型
+    return bytes(data)
+
+
+def data_frames(data: bytes, start: int = 0, seq: int = 0) -> list:
+    """从start开始的DATA帧和END帧"""
+    frames = []
+    for offset in range(start, len(data), FRAME_SIZE):
+        frames.append(build_frame(FRAME_DATA, seq, offset, data[offset:offset + FRAME_SIZE]))
+        seq += 1
+    frames.append(build_frame(FRAME_END, seq, len(data), zlib.crc32(data).to_bytes(4, "little")))
+    return frames
+
+
+def with_length(frame: bytes, length: int) -> bytes:
+    """改写帧头的长度字段，CRC不变"""
+    return frame[:8] + length.to_bytes(2, "little") + frame[10:]
+
+
+def main() -> int:
+    if len(sys.argv) != 2:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 2
+    out = Path(sys.argv[1])
+    out.mkdir(parents=True, exist_ok=True)
+
+    data = make_data()
+    part_bad = bytes(range(256)) * 4
+    files = {"upload.bin": data, "part_good.bin": data[:FRAME_SIZE], "part_bad.bin": part_bad}
+    for name, content in files.items():
+        (out / name).write_bytes(content)
+    with open(out / "crc.txt", "w") as f:
+        for name, content in files.items():
+            f.write(f"{name} {zlib.crc32(content):08x}\n")
+        f.write(f"123456789 {zlib.crc32(b'123456789'):08x}\n")
+
+    frames = data_frames(data)
+    for frame in frames:
+        # 帧头/CRC中的0xB5会让找帧头的位置不可控
+        assert FRAME_MAGIC not in frame[1:10] + frame[-4:], "frame header or CRC contains 0xB5"
+    retry = data_frames(data, seq=len(frames))
+
+    scenarios = {
+        # 正常上传：行首的换行被跳过
+        "clean": b"\r\n" + b"".join(frames),
+        # 长度字段超出帧大小：读完帧头即判为坏帧，之后的帧偏移超前被丢弃，主机从0重发
+        "bad_length": with_length(frames[0], 0xFFFF) + b"".join(frames[1:] + retry),
+        # 长度字段被改小：CRC校验失败，从负载中间继续找帧头，遇到0xB5和无效帧头后重新同步
+        "stray_magic": with_length(frames[0], 1000) + b"".join(frames[1:] + retry),
+        # 续传：设备报告部分文件2048字节，主机从2048继续
+        "resume": b"".join(data_frames(data, start=FRAME_SIZE)),
+        # 部分文件与本地不一致：主机从0开始，设备重写部分文件
+        "restart": b"".join(frames),
+    }
+    for name, stream in scenarios.items():
+        (out / f"{name}.in").write_bytes(stream)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,242 @@
+// 主机编译用的Arduino.h：提供设备端代码用到的String、Serial和时间函数
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#define HEX 16
+#define DEC 10
+
+using std::max;
+using std::min;
+
+class String {
+public:
+    String(const char* s = "") : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    explicit String(char c) : s_(1, c) {}
+    String(int v, unsigned char base = DEC) : s_(format(static_cast<long long>(v), base)) {}
+    String(unsigned int v, unsigned char base = DEC) : s_(formatUnsigned(v, base)) {}
+    String(long v, unsigned char base = DEC) : s_(format(static_cast<long long>(v), base)) {}
+    String(unsigned long v, unsigned char base = DEC) : s_(formatUnsigned(v, base)) {}
+    String(long long v, unsigned char base = DEC) : s_(format(v, base)) {}
+    String(unsigned long long v, unsigned char base = DEC) : s_(formatUnsigned(v, base)) {}
+    String(float v, unsigned int decimals = 2) : s_(formatFloat(v, decimals)) {}
+    String(double v, unsigned int decimals = 2) : s_(formatFloat(v, decimals)) {}
+
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(s_.size()); }
+    bool isEmpty() const { return s_.empty(); }
+    bool reserve(unsigned int size) { s_.reserve(size); return true; }
+    char charAt(unsigned int i) const { return i < s_.size() ? s_[i] : '\0'; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return s_[i]; }
+
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= s_.size()) return String();
+        return String(s_.substr(from, std::min<size_t>(to, s_.size()) - from));
+    }
+    int indexOf(char c, unsigned int from = 0) const { return position(s_.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return position(s_.find(str.s_, from)); }
+    int lastIndexOf(char c) const { return position(s_.rfind(c)); }
+    int lastIndexOf(const String& str) const { return position(s_.rfind(str.s_)); }
+    bool startsWith(const String& prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s_.size() >= suffix.s_.size() &&
+               s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(), suffix.s_) == 0;
+    }
+    bool equals(const String& other) const { return s_ == other.s_; }
+    bool equalsIgnoreCase(const String& other) const {
+        return s_.size() == other.s_.size() &&
+               std::equal(s_.begin(), s_.end(), other.s_.begin(),
+                          [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); });
+    }
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s_.c_str(), nullptr); }
+    void trim() {
+        size_t begin = s_.find_first_not_of(" \t\r\n");
+        size_t end = s_.find_last_not_of(" \t\r\n");
+        s_ = begin == std::string::npos ? std::string() : s_.substr(begin, end - begin + 1);
+    }
+    void toLowerCase() { for (auto& c : s_) c = static_cast<char>(tolower((unsigned char)c)); }
+    void toUpperCase() { for (auto& c : s_) c = static_cast<char>(toupper((unsigned char)c)); }
+    void replace(const String& from, const String& to) {
+        if (from.s_.empty()) return;
+        for (size_t pos = 0; (pos = s_.find(from.s_, pos)) != std::string::npos; pos += to.s_.size()) {
+            s_.replace(pos, from.s_.size(), to.s_);
+        }
+    }
+    void remove(unsigned int index, unsigned int count = UINT32_MAX) {
+        if (index < s_.size()) s_.erase(index, count);
+    }
+
+    String& operator+=(const String& other) { s_ += other.s_; return *this; }
+    String& operator+=(const char* other) { s_ += other ? other : ""; return *this; }
+    String& operator+=(char c) { s_ += c; return *this; }
+    template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    String& operator+=(T v) { return *this += String(v); }
+    bool concat(const char* data, unsigned int len) { s_.append(data, len); return true; }
+
+    bool operator==(const String& other) const { return s_ == other.s_; }
+    bool operator==(const char* other) const { return s_ == (other ? other : ""); }
+    bool operator!=(const String& other) const { return s_ != other.s_; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return s_ < other.s_; }
+
+    const std::string& str() const { return s_; }
+
+private:
+    std::string s_;
+
+    static int position(size_t pos) { return pos == std::string::npos ? -1 : static_cast<int>(pos); }
+    static std::string formatUnsigned(unsigned long long v, unsigned char base) {
+        if (base < 2 || base > 36) base = DEC;
+        char buffer[72];
+        char* p = buffer + sizeof(buffer) - 1;
+        *p = '\0';
+        do {
+            unsigned digit = static_cast<unsigned>(v % base);
+            *--p = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            v /= base;
+        } while (v);
+        return p;
+    }
+    static std::string format(long long v, unsigned char base) {
+        // 与Arduino相同：只有十进制显示负号，其他进制按无符号显示
+        if (base == DEC && v < 0) return "-" + formatUnsigned(0ULL - static_cast<unsigned long long>(v), base);
+        return formatUnsigned(base == DEC ? static_cast<unsigned long long>(v)
+                                          : static_cast<unsigned long>(v), base);
+    }
+    static std::string formatFloat(double v, unsigned int decimals) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", static_cast<int>(decimals), v);
+        return buffer;
+    }
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+inline String operator+(const String& a, T b) { String r(a); r += String(b); return r; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*data++);
+        return n;
+    }
+    size_t write(const char* s) { return s ? write(reinterpret_cast<const uint8_t*>(s), strlen(s)) : 0; }
+    size_t write(const char* data, size_t size) { return write(reinterpret_cast<const uint8_t*>(data), size); }
+
+    size_t print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    size_t print(T v, int base = DEC) { return print(String(v, static_cast<unsigned char>(base))); }
+    size_t print(double v, int decimals = 2) { return print(String(v, static_cast<unsigned int>(decimals))); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T>
+    size_t println(T v, int format) { size_t n = print(v, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (len < 0) return 0;
+        return write(buffer, std::min(static_cast<size_t>(len), sizeof(buffer) - 1));
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    void setTimeout(unsigned long timeoutMs) { timeout_ = timeoutMs; }
+    unsigned long getTimeout() const { return timeout_; }
+
+    // 与Arduino相同：等待数据直到超时，返回实际读到的字节数
+    size_t readBytes(uint8_t* buffer, size_t length);
+    size_t readBytes(char* buffer, size_t length) { return readBytes(reinterpret_cast<uint8_t*>(buffer), length); }
+
+protected:
+    unsigned long timeout_ = 1000;
+};
+
+/**
+ * 主机串口：输入来自测试预先放入的字节，输出记录在内存中
+ *
+ * 没有可读数据时readBytes/delay推进虚拟时钟，超时逻辑在主机上立即走完
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    bool setRxBufferSize(size_t) { return true; }
+    explicit operator bool() const { return true; }
+
+    int available() override { return static_cast<int>(input_.size() - readPos_); }
+    int read() override { return readPos_ < input_.size() ? input_[readPos_++] : -1; }
+    int peek() override { return readPos_ < input_.size() ? input_[readPos_] : -1; }
+    size_t write(uint8_t c) override { output_.push_back(static_cast<char>(c)); echo(&c, 1); return 1; }
+    size_t write(const uint8_t* data, size_t size) override {
+        output_.append(reinterpret_cast<const char*>(data), size);
+        echo(data, size);
+        return size;
+    }
+    using Print::write;
+
+    // 以下为主机测试接口
+    void hostFeed(const void* data, size_t size) {
+        input_.insert(input_.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+    }
+    void hostFeed(const char* text) { hostFeed(text, strlen(text)); }
+    std::string hostTakeOutput() { std::string out; out.swap(output_); return out; }
+    void hostReset() { input_.clear(); readPos_ = 0; output_.clear(); }
+    void hostEcho(bool enable) { echo_ = enable; }
+
+private:
+    std::basic_string<uint8_t> input_;
+    size_t readPos_ = 0;
+    std::string output_;
+    bool echo_ = false;
+
+    void echo(const uint8_t* data, size_t size) {
+        if (echo_) fwrite(data, 1, size, stdout);
+    }
+};
+
+extern HardwareSerial Serial;
+
+// 虚拟时钟（微秒），delay()只推进时钟不休眠
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+void hostAdvanceMicros(uint64_t us);
@@ -0,0 +1,73 @@
+// 主机编译用的FS.h：文件系统映射到主机上的一个目录
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+class FileImpl;
+
+class File : public Stream {
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> impl) : impl_(std::move(impl)) {}
+
+    explicit operator bool() const;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    bool seek(uint32_t position);
+    size_t position() const;
+    size_t size() const;
+    void flush() override;
+    void close();
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+    const char* name() const;
+    const char* path() const;
+    time_t getLastWrite() { return 0; }
+
+private:
+    std::shared_ptr<FileImpl> impl_;
+};
+
+class FS {
+public:
+    // 设备路径"/a/b"对应主机上的root + "/a/b"
+    void setHostRoot(const std::string& root) { root_ = root; }
+    const std::string& hostRoot() const { return root_; }
+    std::string hostPath(const char* path) const;
+
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+
+private:
+    std::string root_ = ".";
+};
+
+} // namespace fs
+
+using fs::File;
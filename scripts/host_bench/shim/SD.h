@@ -0,0 +1,23 @@
+// 主机编译用的SD.h
+#pragma once
+
+#include "FS.h"
+
+class SPIClass;
+
+namespace fs {
+
+class SDFS : public FS {
+public:
+    bool begin(uint8_t = 0, SPIClass* = nullptr, uint32_t = 0, const char* = "/sd", uint8_t = 5, bool = false) {
+        return true;
+    }
+    void end() {}
+    uint64_t cardSize() { return 0; }
+    uint64_t totalBytes() { return 0; }
+    uint64_t usedBytes() { return 0; }
+};
+
+} // namespace fs
+
+extern fs::SDFS SD;
@@ -0,0 +1,6 @@
+// 主机编译用的SD_MMC.h
+#pragma once
+
+#include "SD.h"
+
+extern fs::SDFS SD_MMC;
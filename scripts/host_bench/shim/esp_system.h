@@ -0,0 +1,11 @@
+// 主机编译用的esp_system.h
+#pragma once
+
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+// 主机上为固定种子的伪随机数，结果可复现
+uint32_t esp_random();
+void hostSeedRandom(uint32_t seed);
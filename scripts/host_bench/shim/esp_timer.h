@@ -0,0 +1,6 @@
+// 主机编译用的esp_timer.h：返回Arduino.h的虚拟时钟（微秒）
+#pragma once
+
+#include <cstdint>
+
+int64_t esp_timer_get_time();
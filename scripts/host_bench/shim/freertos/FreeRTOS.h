@@ -0,0 +1,48 @@
+// 主机编译用的FreeRTOS.h：信号量/临界区用std::mutex实现，不支持创建任务
+#pragma once
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef struct HostTask* TaskHandle_t;
+typedef struct HostQueue* QueueHandle_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define portMAX_DELAY 0xffffffffu
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdTICKS_TO_MS(ticks) ((uint32_t)(ticks))
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7fffffff
+#define tskIDLE_PRIORITY 0
+#define configMAX_PRIORITIES 25
+#define IRAM_ATTR
+
+// 临界区：所有portMUX共用一把递归锁
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+
+void hostEnterCritical(portMUX_TYPE* mux);
+void hostExitCritical(portMUX_TYPE* mux);
+#define portENTER_CRITICAL(mux) hostEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) hostExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) hostEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) hostExitCritical(mux)
+#define taskENTER_CRITICAL(mux) hostEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux) hostExitCritical(mux)
+#define portYIELD_FROM_ISR(x) (void)(x)
+
+BaseType_t xPortGetCoreID();
+
+// 主机测试接口：设置当前线程作为"任务"的名字和所在核
+void hostSetCurrentTask(const char* name, BaseType_t core);
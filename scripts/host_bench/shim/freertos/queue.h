@@ -0,0 +1,4 @@
+// 主机编译用的queue.h（只实现信号量用到的部分）
+#pragma once
+
+#include "FreeRTOS.h"
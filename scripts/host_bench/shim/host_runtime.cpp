@@ -0,0 +1,268 @@
+// 主机运行时：shim头文件中声明的Arduino/FS/FreeRTOS/ESP-IDF函数的实现
+#include "Arduino.h"
+#include "FS.h"
+#include "SD.h"
+#include "SD_MMC.h"
+#include "freertos/semphr.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <dirent.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+fs::SDFS SD;
+fs::SDFS SD_MMC;
+
+// ========== 虚拟时钟 ==========
+
+static std::atomic<uint64_t> host_clock_us{1000000};
+
+void hostAdvanceMicros(uint64_t us) { host_clock_us += us; }
+unsigned long micros() { return static_cast<unsigned long>(host_clock_us.load()); }
+unsigned long millis() { return static_cast<unsigned long>(host_clock_us.load() / 1000); }
+void delay(uint32_t ms) { hostAdvanceMicros(static_cast<uint64_t>(ms) * 1000); }
+void delayMicroseconds(uint32_t us) { hostAdvanceMicros(us); }
+void yield() {}
+int64_t esp_timer_get_time() { return static_cast<int64_t>(host_clock_us.load()); }
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0) {
+            // 主机输入不会再增加：一次走完超时
+            delay(timeout_);
+            break;
+        }
+        buffer[count++] = static_cast<uint8_t>(c);
+    }
+    return count;
+}
+
+// ========== 随机数 ==========
+
+static uint32_t host_random_state = 0x12345678;
+
+void hostSeedRandom(uint32_t seed) { host_random_state = seed ? seed : 1; }
+
+uint32_t esp_random() {
+    // xorshift32
+    uint32_t x = host_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return host_random_state = x;
+}
+
+// ========== 文件系统 ==========
+
+namespace fs {
+
+class FileImpl {
+public:
+    std::string path;           // 设备路径
+    std::string name;           // 最后一级名字
+    FILE* fp = nullptr;
+    bool directory = false;
+    std::string hostDir;        // 目录的主机路径
+    DIR* dir = nullptr;
+    const FS* owner = nullptr;
+
+    ~FileImpl() { close(); }
+    void close() {
+        if (fp) { fclose(fp); fp = nullptr; }
+        if (dir) { closedir(dir); dir = nullptr; }
+    }
+};
+
+File::operator bool() const { return impl_ && (impl_->fp || impl_->directory); }
+
+size_t File::write(const uint8_t* data, size_t size) {
+    return impl_ && impl_->fp ? fwrite(data, 1, size, impl_->fp) : 0;
+}
+
+int File::available() {
+    if (!impl_ || !impl_->fp) return 0;
+    return static_cast<int>(size() - position());
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::peek() {
+    if (!impl_ || !impl_->fp) return -1;
+    int c = fgetc(impl_->fp);
+    if (c != EOF) ungetc(c, impl_->fp);
+    return c == EOF ? -1 : c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    return impl_ && impl_->fp ? fread(buffer, 1, size, impl_->fp) : 0;
+}
+
+bool File::seek(uint32_t position) {
+    return impl_ && impl_->fp && fseek(impl_->fp, position, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+    return impl_ && impl_->fp ? static_cast<size_t>(ftell(impl_->fp)) : 0;
+}
+
+size_t File::size() const {
+    if (!impl_ || !impl_->fp) return 0;
+    fflush(impl_->fp);
+    struct stat st;
+    return fstat(fileno(impl_->fp), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+void File::flush() {
+    if (impl_ && impl_->fp) fflush(impl_->fp);
+}
+
+void File::close() {
+    if (impl_) impl_->close();
+    impl_.reset();
+}
+
+bool File::isDirectory() const { return impl_ && impl_->directory; }
+
+File File::openNextFile(const char* mode) {
+    if (!impl_ || !impl_->dir) return File();
+    while (struct dirent* entry = readdir(impl_->dir)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = (impl_->path == "/" ? "" : impl_->path) + "/" + entry->d_name;
+        return const_cast<FS*>(impl_->owner)->open(child.c_str(), mode);
+    }
+    return File();
+}
+
+const char* File::name() const { return impl_ ? impl_->name.c_str() : ""; }
+const char* File::path() const { return impl_ ? impl_->path.c_str() : ""; }
+
+std::string FS::hostPath(const char* path) const {
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/') p = "/" + p;
+    return root_ + p;
+}
+
+File FS::open(const char* path, const char* mode, bool) {
+    std::string host = hostPath(path);
+    auto impl = std::make_shared<FileImpl>();
+    impl->path = path;
+    impl->name = impl->path.substr(impl->path.rfind('/') + 1);
+    impl->owner = this;
+
+    struct stat st;
+    if (strcmp(mode, FILE_READ) == 0 && stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->directory = true;
+        impl->dir = opendir(host.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+    // 与ESP32的VFS相同："w"截断，"a"追加，都以二进制打开
+    const char* hostMode = strcmp(mode, FILE_WRITE) == 0 ? "wb+" : strcmp(mode, FILE_APPEND) == 0 ? "ab+" : "rb";
+    impl->fp = fopen(host.c_str(), hostMode);
+    return impl->fp ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) { return unlink(hostPath(path).c_str()) == 0; }
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) { return ::mkdir(hostPath(path).c_str(), 0755) == 0; }
+
+bool FS::rmdir(const char* path) { return ::rmdir(hostPath(path).c_str()) == 0; }
+
+} // namespace fs
+
+// ========== FreeRTOS ==========
+
+struct HostTask {
+    char name[16];
+    BaseType_t core;
+};
+
+static thread_local HostTask host_current_task = {"main", 0};
+
+void hostSetCurrentTask(const char* name, BaseType_t core) {
+    snprintf(host_current_task.name, sizeof(host_current_task.name), "%s", name);
+    host_current_task.core = core;
+}
+
+BaseType_t xPortGetCoreID() { return host_current_task.core; }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return &host_current_task; }
+char* pcTaskGetName(TaskHandle_t task) { return (task ? task : &host_current_task)->name; }
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t, TaskHandle_t* handle,
+                                   BaseType_t) {
+    if (handle) *handle = nullptr;
+    return pdFAIL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* param, UBaseType_t priority,
+                       TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t) {}
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+TickType_t xTaskGetTickCount() { return static_cast<TickType_t>(millis()); }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+BaseType_t xTaskNotify(TaskHandle_t, uint32_t, eNotifyAction) { return pdPASS; }
+
+BaseType_t xTaskNotifyWait(uint32_t, uint32_t, uint32_t* value, TickType_t) {
+    if (value) *value = 0;
+    return pdFALSE;
+}
+
+static std::recursive_mutex host_critical;
+
+void hostEnterCritical(portMUX_TYPE*) { host_critical.lock(); }
+void hostExitCritical(portMUX_TYPE*) { host_critical.unlock(); }
+
+// 信号量计数：互斥锁初始为1，二值信号量初始为0；超时按真实时间等待
+struct HostQueue {
+    std::mutex lock;
+    std::condition_variable cv;
+    unsigned count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new HostQueue{{}, {}, 1}; }
+SemaphoreHandle_t xSemaphoreCreateBinary() { return new HostQueue{{}, {}, 0}; }
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait) {
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+    auto ready = [semaphore] { return semaphore->count > 0; };
+    if (wait == portMAX_DELAY) {
+        semaphore->cv.wait(guard, ready);
+    } else if (!semaphore->cv.wait_for(guard, std::chrono::milliseconds(wait), ready)) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    {
+        std::lock_guard<std::mutex> guard(semaphore->lock);
+        if (semaphore->count > 0) return pdFALSE;
+        semaphore->count = 1;
+    }
+    semaphore->cv.notify_one();
+    return pdTRUE;
+}
@@ -0,0 +1,76 @@
+// 主机上替代设备模块的最小实现：SD卡接口映射到主机目录，日志直接输出到stderr
+#include "hal/sd_interface.h"
+#include "system/logging/log_manager.h"
+#include <sys/stat.h>
+
+// ========== HAL::SDInterface ==========
+
+namespace HAL {
+
+HardwareConfig::SDCardMode SDInterface::current_mode_ = HardwareConfig::SDCardMode::SPI;
+bool SDInterface::mounted_ = true;
+SPIClass* SDInterface::spi_instance_ = nullptr;
+const char* SDInterface::mount_point_ = "";
+
+fs::FS& SDInterface::getFS() { return SD; }
+
+bool SDInterface::exists(const char* path) { return SD.exists(path); }
+
+bool SDInterface::stat(const char* path, uint32_t& size, uint32_t& mtime) {
+    struct stat st;
+    if (::stat(SD.hostPath(path).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    size = static_cast<uint32_t>(st.st_size);
+    mtime = static_cast<uint32_t>(st.st_mtime);
+    return true;
+}
+
+} // namespace HAL
+
+// ========== LogManager ==========
+
+LogManager* LogManager::instance = nullptr;
+int LogManager::runtimeLogLevel = LogManager::LM_LOG_WARN;    // 主机上默认只输出警告和错误
+
+LogManager::LogManager() : currentLogLevel(LM_LOG_WARN), logOutputMode(OUTPUT_SERIAL) {}
+
+LogManager::~LogManager() {}
+
+LogManager* LogManager::getInstance() {
+    if (!instance) {
+        instance = new LogManager();
+    }
+    return instance;
+}
+
+void LogManager::setLogLevel(LogLevel level) {
+    currentLogLevel = level;
+    runtimeLogLevel = level;
+}
+
+void LogManager::setLogOutput(LogOutput output) { logOutputMode = output; }
+
+LogManager::LogOutput LogManager::getLogOutput() { return logOutputMode; }
+
+void LogManager::log(LogLevel level, const char* tag, const char* message) {
+    static const char* const names[] = {"SILENT", "FATAL", "ERROR", "WARN", "INFO", "DEBUG", "TRACE"};
+    if (isLevelEnabled(level)) {
+        fprintf(stderr, "[%s] [%s] %s\n", names[level], tag, message);
+    }
+}
+
+void LogManager::log(LogLevel level, const String& tag, const String& message) {
+    log(level, tag.c_str(), message.c_str());
+}
+
+void LogManager::logf(LogLevel level, const char* tag, const char* format, ...) {
+    char message[LOG_FORMAT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    log(level, tag, message);
+}
+
+void LogManager::flush() { fflush(stderr); }
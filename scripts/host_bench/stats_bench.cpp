@@ -0,0 +1,254 @@
+/**
+ * 小鸟统计表主机基准测试
+ *
+ * 编译设备端的bird_stats.cpp（shim提供互斥锁和映射到临时目录的SD卡），测量
+ * BirdStatistics热路径的开销，并与旧版std::map+线性扫描（a351197）对比。
+ * 设备端的互斥锁在主机上是std::mutex，计入每次调用的耗时。
+ * 最后保存、重新加载，核对两种实现的每只小鸟次数一致。
+ *
+ * 用法：stats_bench [bird_config.csv] [遇见次数]
+ */
+#include "applications/modules/bird_watching/core/bird_stats.h"
+#include "system/logging/log_manager.h"
+#include <SD.h>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+volatile uint32_t g_sink;
+
+// 旧版：std::map<bird_id, count>，最多/最少遇见每次线性扫描
+class MapStats {
+public:
+    void recordEncounter(uint16_t bird_id) { stats_[bird_id]++; }
+
+    int getEncounterCount(uint16_t bird_id) const {
+        auto it = stats_.find(bird_id);
+        return it != stats_.end() ? it->second : 0;
+    }
+
+    std::vector<uint16_t> getEncounteredBirdIds() const {
+        std::vector<uint16_t> ids;
+        ids.reserve(stats_.size());
+        for (const auto& pair : stats_) {
+            ids.push_back(pair.first);
+        }
+        return ids;
+    }
+
+    uint16_t getMostSeenBirdId() const {
+        uint16_t id = 0;
+        int max_count = 0;
+        for (const auto& pair : stats_) {
+            if (pair.second > max_count) {
+                max_count = pair.second;
+                id = pair.first;
+            }
+        }
+        return id;
+    }
+
+    uint16_t getRarestBirdId() const {
+        uint16_t id = 0;
+        int min_count = INT_MAX;
+        for (const auto& pair : stats_) {
+            if (pair.second > 0 && pair.second < min_count) {
+                min_count = pair.second;
+                id = pair.first;
+            }
+        }
+        return id;
+    }
+
+private:
+    std::map<uint16_t, int> stats_;
+};
+
+// 与设备端相同的规则读取bird_config.csv：id>0、名称非空、权重>0
+bool loadBirds(const char* path, std::vector<BirdWatching::BirdInfo>& birds, std::vector<int>& weights) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string id, name, weight;
+        if (!std::getline(ss, id, ',') || !std::getline(ss, name, ',') || !std::getline(ss, weight, ',')) {
+            continue;
+        }
+        int bird_id = atoi(id.c_str());
+        int w = atoi(weight.c_str());
+        if (bird_id > 0 && !name.empty() && w > 0) {
+            BirdWatching::BirdInfo bird;
+            bird.id = bird_id;
+            bird.name = name;
+            bird.weight = w;
+            birds.push_back(bird);
+            weights.push_back(w);
+        }
+    }
+    return !birds.empty();
+}
+
+double nsPer(std::chrono::steady_clock::time_point start, size_t ops) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return (double)elapsed.count() / ops;
+}
+
+// 统计页每页显示的小鸟数（与StatsView一致）
+constexpr size_t PAGE_SIZE = 5;
+
+void printRow(const char* name, double record, double extremes, double pick, double page) {
+    printf("%-6s record %8.1f ns  most+rarest %8.1f ns  history pick %8.1f ns  page %8.1f ns\n",
+           name, record, extremes, pick, page);
+}
+
+// 返回发现的错误数
+int runBench(const std::vector<BirdWatching::BirdInfo>& birds, const std::vector<int>& weights, size_t encounters) {
+    std::mt19937 rng(20251216);
+    std::discrete_distribution<size_t> pick_bird(weights.begin(), weights.end());
+    std::vector<uint16_t> stream(encounters);
+    for (auto& id : stream) {
+        id = birds[pick_bird(rng)].id;
+    }
+    std::vector<uint32_t> randoms(encounters);
+    for (auto& r : randoms) {
+        r = rng();
+    }
+
+    printf("%zu birds, %zu encounters\n", birds.size(), encounters);
+
+    // 每次遇见后：查询最多/最少遇见、按历史随机选一只、翻一页统计页
+    MapStats map_stats;
+    BirdWatching::BirdStatistics stats;
+    stats.bindBirds(birds);
+    stats.initialize();
+    for (int pass = 0; pass < 2; pass++) {
+        auto t = std::chrono::steady_clock::now();
+        for (uint16_t id : stream) map_stats.recordEncounter(id);
+        double map_record = nsPer(t, encounters);
+
+        t = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < encounters; i++) g_sink = map_stats.getMostSeenBirdId() + map_stats.getRarestBirdId();
+        double map_extremes = nsPer(t, encounters);
+
+        t = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < encounters; i++) {
+            std::vector<uint16_t> seen = map_stats.getEncounteredBirdIds();
+            g_sink = seen[randoms[i] % seen.size()];
+        }
+        double map_pick = nsPer(t, encounters);
+
+        t = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < encounters; i++) {
+            size_t first = (randoms[i] % ((birds.size() + PAGE_SIZE - 1) / PAGE_SIZE)) * PAGE_SIZE;
+            for (size_t j = first; j < first + PAGE_SIZE && j < birds.size(); j++) {
+                g_sink = map_stats.getEncounterCount(birds[j].id);
+            }
+        }
+        double map_page = nsPer(t, encounters);
+
+        t = std::chrono::steady_clock::now();
+        for (uint16_t id : stream) stats.recordEncounter(id);
+        double real_record = nsPer(t, encounters);
+
+        t = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < encounters; i++) g_sink = stats.getMostSeenBirdId() + stats.getRarestBirdId();
+        double real_extremes = nsPer(t, encounters);
+
+        t = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < encounters; i++) {
+            g_sink = stats.getRankedBirdId(randoms[i] % stats.getSeenSpeciesCount());
+        }
+        double real_pick = nsPer(t, encounters);
+
+        t = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < encounters; i++) {
+            size_t first = (randoms[i] % ((birds.size() + PAGE_SIZE - 1) / PAGE_SIZE)) * PAGE_SIZE;
+            for (size_t j = first; j < first + PAGE_SIZE && j < birds.size(); j++) {
+                g_sink = stats.getEncounterCountAt(j, birds[j].id);
+            }
+        }
+        double real_page = nsPer(t, encounters);
+
+        // 第一轮用于预热
+        if (pass == 1) {
+            printRow("map", map_record, map_extremes, map_pick, map_page);
+            printRow("stats", real_record, real_extremes, real_pick, real_page);
+        }
+    }
+
+    int errors = 0;
+    if (map_stats.getMostSeenBirdId() != stats.getMostSeenBirdId() ||
+        map_stats.getEncounterCount(stats.getRarestBirdId()) !=
+            map_stats.getEncounterCount(map_stats.getRarestBirdId())) {
+        fprintf(stderr, "Most/rarest bird differs: map %u/%u stats %u/%u\n", map_stats.getMostSeenBirdId(),
+                map_stats.getRarestBirdId(), stats.getMostSeenBirdId(), stats.getRarestBirdId());
+        errors++;
+    }
+
+    // 写卡后用新实例从快照+日志恢复，次数应与旧版一致
+    auto t = std::chrono::steady_clock::now();
+    bool saved = stats.saveToFile();
+    double save_ms = nsPer(t, 1) / 1e6;
+    BirdWatching::BirdStatistics reloaded;
+    reloaded.bindBirds(birds);
+    t = std::chrono::steady_clock::now();
+    bool loaded = reloaded.loadFromFile();
+    double load_ms = nsPer(t, 1) / 1e6;
+    printf("save %zu records %.1f ms, reload %.1f ms\n", encounters * 2, save_ms, load_ms);
+    if (!saved || !loaded) {
+        fprintf(stderr, "Save/reload failed\n");
+        errors++;
+    }
+    for (const auto& bird : birds) {
+        if (reloaded.getEncounterCount(bird.id) != map_stats.getEncounterCount(bird.id)) {
+            fprintf(stderr, "Bird %u: reloaded %d, map %d\n", bird.id, reloaded.getEncounterCount(bird.id),
+                    map_stats.getEncounterCount(bird.id));
+            errors++;
+        }
+    }
+    return errors;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* config = argc > 1 ? argv[1] : "../../resources/configs/bird_config.csv";
+    size_t encounters = argc > 2 ? strtoul(argv[2], nullptr, 10) : 200000;
+
+    std::vector<BirdWatching::BirdInfo> birds;
+    std::vector<int> weights;
+    if (!loadBirds(config, birds, weights)) {
+        fprintf(stderr, "Cannot read bird list from %s\n", config);
+        return 1;
+    }
+
+    // 统计文件写到临时目录，BirdStatistics析构时还会保存一次，结束后再清理
+    char root[] = "/tmp/stats_bench.XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    SD.setHostRoot(root);
+
+    int errors = runBench(birds, weights, encounters);
+
+    for (const char* file : {"/stats.snap", "/stats.snap.tmp", "/stats.jrn"}) {
+        SD.remove(file);
+    }
+    rmdir(root);
+    return errors ? 1 : 0;
+}
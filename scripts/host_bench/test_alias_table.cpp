@@ -0,0 +1,146 @@
+/**
+ * 小鸟随机选择（Vose别名表）的统计检验
+ *
+ * 编译设备端的bird_alias_table.cpp（BirdSelector::getRandomBird()使用同一个AliasTable），
+ * 检验别名表给出的选中概率与配置的权重一致：
+ * 枚举全部列映射得到精确概率，再用esp_random()的主机实现抽样做卡方检验。
+ *
+ * 用法：test_alias_table [bird_config.csv]
+ */
+#include "applications/modules/bird_watching/core/bird_alias_table.h"
+#include "test_check.h"
+#include <esp_system.h>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using BirdWatching::AliasTable;
+
+namespace {
+
+// 按设备端规则读取bird_config.csv：id>0、名称非空、权重>0的行
+std::vector<uint32_t> loadConfigWeights(const char* path) {
+    std::vector<uint32_t> weights;
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string id, name, weight;
+        if (!std::getline(ss, id, ',') || !std::getline(ss, name, ',') || !std::getline(ss, weight, ',')) {
+            continue;
+        }
+        if (atoi(id.c_str()) > 0 && !name.empty() && atoi(weight.c_str()) > 0) {
+            weights.push_back(atoi(weight.c_str()));
+        }
+    }
+    return weights;
+}
+
+// 枚举高16位的全部取值得到的精确选中概率
+std::vector<double> exactDistribution(const AliasTable& table) {
+    const size_t n = table.size();
+    std::vector<uint32_t> column_hits(n, 0);
+    for (uint32_t high = 0; high < 65536; high++) {
+        column_hits[(high * n) >> 16]++;
+    }
+
+    std::vector<double> probability(n, 0.0);
+    for (size_t column = 0; column < n; column++) {
+        double p_column = column_hits[column] / 65536.0;
+        double p_self = table.threshold(column) / 65536.0;
+        probability[column] += p_column * p_self;
+        probability[table.alias(column)] += p_column * (1 - p_self);
+    }
+    return probability;
+}
+
+// 卡方分布上分位点（Wilson-Hilferty近似），z=3.090对应显著性0.001
+double chiSquareCritical(size_t dof, double z = 3.090) {
+    double k = 2.0 / (9.0 * dof);
+    return dof * std::pow(1 - k + z * std::sqrt(k), 3);
+}
+
+void checkWellFormed(const char* name, const std::vector<uint32_t>& weights, const AliasTable& table) {
+    CHECK_MSG(table.size() == weights.size(), "%s", name);
+    for (size_t i = 0; i < table.size(); i++) {
+        CHECK_MSG(table.threshold(i) <= 65536, "%s column %zu", name, i);
+        CHECK_MSG(table.alias(i) < weights.size(), "%s column %zu", name, i);
+    }
+}
+
+// 误差来源只有阈值取整（每列±0.5/65536）和列映射的取整（±1/65536）
+void checkExactProbabilities(const char* name, const std::vector<uint32_t>& weights, const AliasTable& table) {
+    std::vector<double> probability = exactDistribution(table);
+    double total = 0;
+    for (uint32_t weight : weights) {
+        total += weight;
+    }
+    for (size_t i = 0; i < weights.size(); i++) {
+        double expected = weights[i] / total;
+        CHECK_MSG(std::fabs(probability[i] - expected) <= 2.0 / 65536, "%s bird %zu: p=%.6f expected %.6f",
+                  name, i, probability[i], expected);
+    }
+}
+
+void checkChiSquare(const char* name, const std::vector<uint32_t>& weights, const AliasTable& table) {
+    if (weights.size() < 2) {
+        return;
+    }
+    const size_t samples = 400000;
+    std::vector<size_t> counts(weights.size(), 0);
+    for (size_t i = 0; i < samples; i++) {
+        counts[table.pick(esp_random())]++;
+    }
+
+    double total = 0;
+    for (uint32_t weight : weights) {
+        total += weight;
+    }
+    double chi2 = 0;
+    for (size_t i = 0; i < weights.size(); i++) {
+        double expected = samples * weights[i] / total;
+        chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+    }
+    double critical = chiSquareCritical(weights.size() - 1);
+    CHECK_MSG(chi2 < critical, "%s: chi2=%.1f critical=%.1f", name, chi2, critical);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::map<std::string, std::vector<uint32_t>> weight_sets = {
+        {"uniform", std::vector<uint32_t>(7, 10)},
+        {"skewed", {1, 1000, 3, 50, 50, 7, 200}},
+        {"single", {42}},
+        {"prime_count", {5, 1, 9, 2, 30, 4, 4, 11, 1, 60, 3, 8, 2}},
+        {"default_fallback", {50, 30}},
+    };
+    if (argc > 1) {
+        weight_sets["bird_config.csv"] = loadConfigWeights(argv[1]);
+        CHECK(!weight_sets["bird_config.csv"].empty());
+    }
+
+    hostSeedRandom(20251216);
+    for (const auto& entry : weight_sets) {
+        AliasTable table;
+        table.build(entry.second);
+        checkWellFormed(entry.first.c_str(), entry.second, table);
+        checkExactProbabilities(entry.first.c_str(), entry.second, table);
+        checkChiSquare(entry.first.c_str(), entry.second, table);
+    }
+
+    // 权重全为0或没有小鸟时表为空，BirdSelector据此返回空对象
+    AliasTable empty;
+    empty.build({0, 0});
+    CHECK(empty.empty());
+    empty.build({});
+    CHECK(empty.empty());
+
+    return testResult("test_alias_table");
+}
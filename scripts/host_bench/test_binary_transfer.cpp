@@ -0,0 +1,169 @@
+/**
+ * 二进制分帧上传测试
+ *
+ * 编译设备端的binary_transfer.cpp（SD卡映射到临时目录）：make_transfer_frames.py用
+ * cybird-cli的build_frame生成主机发出的字节流，喂给串口后调用BinaryTransfer::receive，
+ * 检查设备的回复行和写到卡上的文件。覆盖CRC与zlib.crc32一致、长度字段损坏、负载中
+ * 的0xB5导致的重新同步、续传和部分文件不一致时从偏移0重写。
+ *
+ * 用法：test_binary_transfer <make_transfer_frames.py的输出目录>
+ */
+#include "system/commands/binary_transfer.h"
+#include "test_check.h"
+#include <SD.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+const char* const UPLOAD_PATH = "/birds/1001/upload.bin";
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+uint32_t crcOf(const std::string& data) {
+    return BinaryTransfer::crc32(0, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+// crc.txt：每行"<文件名> <zlib.crc32>"
+std::map<std::string, uint32_t> readCrcs(const std::string& dir) {
+    std::map<std::string, uint32_t> crcs;
+    std::ifstream file(dir + "/crc.txt");
+    std::string name;
+    std::string crc;
+    while (file >> name >> crc) {
+        crcs[name] = strtoul(crc.c_str(), nullptr, 16);
+    }
+    return crcs;
+}
+
+// 与zlib.crc32相同，分段计算时结果不变
+void testCrc(const std::string& dir, const std::map<std::string, uint32_t>& crcs) {
+    CHECK(crcs.size() == 4);
+    CHECK(crcOf("123456789") == 0xCBF43926);
+    CHECK(crcs.count("123456789") && crcs.at("123456789") == 0xCBF43926);
+    CHECK(BinaryTransfer::crc32(0, nullptr, 0) == 0);
+
+    for (const auto& entry : crcs) {
+        if (entry.first == "123456789") continue;
+        std::string data = readFile(dir + "/" + entry.first);
+        CHECK_MSG(crcOf(data) == entry.second, "%s: %08x, zlib %08x", entry.first.c_str(), crcOf(data),
+                  entry.second);
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+        size_t split = data.size() / 3;
+        uint32_t crc = BinaryTransfer::crc32(0, bytes, split);
+        crc = BinaryTransfer::crc32(crc, bytes + split, data.size() - split);
+        CHECK_MSG(crc == entry.second, "%s split: %08x, zlib %08x", entry.first.c_str(), crc, entry.second);
+    }
+}
+
+class UploadTest {
+public:
+    UploadTest(const std::string& dir, const std::string& root, const std::map<std::string, uint32_t>& crcs)
+        : dir_(dir), root_(root), data_(readFile(dir + "/upload.bin")), crc_(crcs.at("upload.bin")) {}
+
+    /**
+     * 喂入场景的字节流后接收
+     *
+     * @param part 预先放在卡上的部分文件（空为没有）
+     * @param expected 设备回复的前几行（Rate行与耗时有关，不比较）
+     */
+    void run(const char* scenario, const std::string& part, const std::string& expected) {
+        std::string part_path = root_ + UPLOAD_PATH + ".part";
+        unlink((root_ + UPLOAD_PATH).c_str());
+        unlink(part_path.c_str());
+        if (!part.empty()) {
+            writeFile(part_path, readFile(dir_ + "/" + part));
+        }
+
+        std::string input = readFile(dir_ + "/" + scenario + ".in");
+        CHECK_MSG(!input.empty(), "%s.in missing", scenario);
+        Serial.hostReset();
+        Serial.hostFeed(input.data(), input.size());
+
+        bool ok = BinaryTransfer::receive(UPLOAD_PATH, data_.size(), crc_);
+        std::string output = Serial.hostTakeOutput();
+        CHECK_MSG(ok, "%s: receive failed:\n%s", scenario, output.c_str());
+        CHECK_MSG(output.compare(0, expected.size(), expected) == 0, "%s:\n--- got ---\n%s--- expected ---\n%s",
+                  scenario, output.c_str(), expected.c_str());
+        CHECK_MSG(output.find("Rate: ") != std::string::npos, "%s: no rate line", scenario);
+        CHECK_MSG(readFile(root_ + UPLOAD_PATH) == data_, "%s: uploaded file differs", scenario);
+        CHECK_MSG(access(part_path.c_str(), F_OK) != 0, "%s: .part left behind", scenario);
+        CHECK_MSG(Serial.available() == 0, "%s: %d bytes not consumed", scenario, Serial.available());
+    }
+
+    std::string success(size_t resumed) const {
+        // SUCCESS行用println输出（\r\n），其余用printf
+        char text[160];
+        snprintf(text, sizeof(text),
+                 "SUCCESS: File uploaded successfully!\r\nPath: %s\nSize: %zu bytes (%zu resumed)\n", UPLOAD_PATH,
+                 data_.size(), resumed);
+        return text;
+    }
+
+private:
+    std::string dir_;
+    std::string root_;
+    std::string data_;
+    uint32_t crc_;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: test_binary_transfer <frames dir>\n");
+        return 2;
+    }
+    std::string dir = argv[1];
+    std::map<std::string, uint32_t> crcs = readCrcs(dir);
+    if (!crcs.count("upload.bin") || !crcs.count("part_good.bin") || !crcs.count("part_bad.bin")) {
+        fprintf(stderr, "%s/crc.txt missing, run make_transfer_frames.py first\n", dir.c_str());
+        return 1;
+    }
+    testCrc(dir, crcs);
+
+    char root[] = "/tmp/test_binary_transfer.XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    SD.setHostRoot(root);
+
+    UploadTest test(dir, root, crcs);
+    const std::string acks = "ACK 2048\nACK 4096\nACK 5000\n";
+
+    // 正常上传（父目录逐级创建）
+    test.run("clean", "", "BIN_READY 0 00000000\n" + acks + test.success(0));
+
+    // 坏帧只NAK一次，之后偏移超前的帧和END帧静默丢弃，等主机从0重发
+    test.run("bad_length", "", "BIN_READY 0 00000000\nNAK 0\n" + acks + test.success(0));
+    test.run("stray_magic", "", "BIN_READY 0 00000000\nNAK 0\n" + acks + test.success(0));
+
+    // 部分文件一致：报告其大小和CRC，主机从2048续传
+    char ready[64];
+    snprintf(ready, sizeof(ready), "BIN_READY 2048 %08x\n", crcs.at("part_good.bin"));
+    test.run("resume", "part_good.bin", std::string(ready) + "ACK 4096\nACK 5000\n" + test.success(2048));
+
+    // 部分文件不一致：主机从0开始，设备重写部分文件，不沿用原来的1024字节
+    snprintf(ready, sizeof(ready), "BIN_READY 1024 %08x\n", crcs.at("part_bad.bin"));
+    test.run("restart", "part_bad.bin", std::string(ready) + acks + test.success(0));
+
+    unlink((std::string(root) + UPLOAD_PATH).c_str());
+    rmdir((std::string(root) + "/birds/1001").c_str());
+    rmdir((std::string(root) + "/birds").c_str());
+    rmdir(root);
+    return testResult("test_binary_transfer");
+}
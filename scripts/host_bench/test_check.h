@@ -0,0 +1,37 @@
+// 主机测试用的断言：失败时输出位置并计数，main返回失败数
+#pragma once
+
+#include <cstdio>
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            testFailures()++; \
+        } \
+    } while (0)
+
+#define CHECK_MSG(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s: ", __FILE__, __LINE__, #cond); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            testFailures()++; \
+        } \
+    } while (0)
+
+// 在main末尾调用：输出结果，返回进程退出码
+inline int testResult(const char* name) {
+    if (testFailures()) {
+        printf("%s: %d check(s) FAILED\n", name, testFailures());
+        return 1;
+    }
+    printf("%s: OK\n", name);
+    return 0;
+}
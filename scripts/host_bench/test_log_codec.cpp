@@ -0,0 +1,253 @@
+/**
+ * 日志参数编解码测试
+ *
+ * 编译设备端的log_codec.cpp：LogCodec::encodeArgs编码的参数经formatArgs解码后，
+ * 应与主机printf直接格式化的结果相同；按.clog格式写出的文件经clog_decode解码、
+ * 过滤后得到预期的行。
+ *
+ * 用法：test_log_codec <clog_decode路径>
+ */
+#include "system/logging/log_codec.h"
+#include "test_check.h"
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 编码后再解码
+std::string roundTrip(const char* format, va_list args) {
+    uint8_t payload[256];
+    size_t length = LogCodec::encodeArgs(payload, sizeof(payload), format, args);
+    String text;
+    LogCodec::formatArgs(format, payload, length, text);
+    return text.c_str();
+}
+
+// 与vsnprintf的结果比较
+__attribute__((format(printf, 1, 2))) void checkFormat(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    char expected[256];
+    va_list copy;
+    va_copy(copy, args);
+    vsnprintf(expected, sizeof(expected), format, copy);
+    va_end(copy);
+    std::string decoded = roundTrip(format, args);
+    va_end(args);
+    CHECK_MSG(decoded == expected, "format \"%s\": decoded \"%s\", printf \"%s\"", format, decoded.c_str(), expected);
+}
+
+// 与给定文本比较
+void checkDecoded(const char* expected, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    std::string decoded = roundTrip(format, args);
+    va_end(args);
+    CHECK_MSG(decoded == expected, "format \"%s\": decoded \"%s\", expected \"%s\"", format, decoded.c_str(),
+              expected);
+}
+
+// 按log_codec.h的格式拼出一个.clog文件
+class ClogWriter {
+public:
+    ClogWriter() {
+        uint8_t header[LogCodec::FILE_HEADER_SIZE];
+        append(header, LogCodec::writeFileHeader(header));
+    }
+
+    void sync(uint64_t epoch, uint64_t syncUs) {
+        data_.push_back(LogCodec::ENTRY_SYNC);
+        varint(epoch);
+        varint(syncUs);
+        last_ = 0;
+    }
+
+    void define(LogCodec::EntryType type, uint32_t id, const char* text) {
+        data_.push_back(type);
+        varint(id);
+        varint(strlen(text));
+        append(text, strlen(text));
+    }
+
+    void drop(uint32_t count) {
+        data_.push_back(LogCodec::ENTRY_DROP);
+        varint(count);
+    }
+
+    void text(uint8_t level, uint64_t us, uint32_t tag, const char* message) {
+        record(level, us, tag, 0, reinterpret_cast<const uint8_t*>(message), strlen(message));
+    }
+
+    // 与LogManager::logf相同，用encodeArgs编码参数
+    void formatted(uint8_t level, uint64_t us, uint32_t tag, uint32_t formatId, const char* format, ...) {
+        uint8_t payload[LOG_PAYLOAD_SIZE];
+        va_list args;
+        va_start(args, format);
+        size_t length = LogCodec::encodeArgs(payload, sizeof(payload), format, args);
+        va_end(args);
+        record(level, us, tag, formatId, payload, length);
+    }
+
+    // 模拟写入中途断电：只留下半个条目
+    void truncate(size_t bytes) { data_.resize(data_.size() - bytes); }
+
+    bool save(const char* path) const {
+        FILE* file = fopen(path, "wb");
+        if (!file) return false;
+        bool ok = fwrite(data_.data(), 1, data_.size(), file) == data_.size();
+        return fclose(file) == 0 && ok;
+    }
+
+private:
+    static constexpr size_t LOG_PAYLOAD_SIZE = 256;
+    std::vector<uint8_t> data_;
+    uint64_t last_ = 0;
+
+    void append(const void* bytes, size_t length) {
+        data_.insert(data_.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + length);
+    }
+
+    void varint(uint64_t value) {
+        uint8_t bytes[LogCodec::MAX_VARINT_SIZE];
+        append(bytes, LogCodec::writeVarint(bytes, value));
+    }
+
+    void record(uint8_t level, uint64_t us, uint32_t tag, uint32_t formatId, const uint8_t* payload, size_t length) {
+        data_.push_back(LogCodec::ENTRY_RECORD | level);
+        varint(LogCodec::zigzag((int64_t)(us - last_)));
+        varint(tag);
+        varint(formatId);
+        varint(length);
+        append(payload, length);
+        last_ = us;
+    }
+};
+
+// 运行解码工具，返回标准输出（标准错误合并进来，便于检查截断警告）
+std::string runDecoder(const std::string& tool, const std::string& args) {
+    std::string output;
+    FILE* pipe = popen((tool + " " + args + " 2>&1").c_str(), "r");
+    if (!pipe) return output;
+    char buffer[512];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, n);
+    }
+    pclose(pipe);
+    return output;
+}
+
+void checkDecoder(const std::string& tool, const std::string& args, const std::string& expected) {
+    std::string output = runDecoder(tool, args);
+    CHECK_MSG(output == expected, "clog_decode %s:\n--- got ---\n%s--- expected ---\n%s", args.c_str(),
+              output.c_str(), expected.c_str());
+}
+
+void testDecoderTool(const std::string& tool) {
+    char dir[] = "/tmp/test_log_codec.XXXXXX";
+    if (!mkdtemp(dir)) {
+        CHECK(!"mkdtemp failed");
+        return;
+    }
+    std::string first = std::string(dir) + "/cybird_watching.1.clog";
+    std::string current = std::string(dir) + "/cybird_watching.clog";
+
+    // 上一代：未校时
+    ClogWriter old;
+    old.sync(0, 0);
+    old.define(LogCodec::ENTRY_TAG, 1, "SYSTEM");
+    old.text(4, 500000, 1, "Boot");
+    CHECK(old.save(first.c_str()));
+
+    // 当前文件：标签/格式串在SYNC后重新定义，id与上一代不同也能解码
+    ClogWriter log;
+    log.sync(0, 1000000);
+    log.define(LogCodec::ENTRY_TAG, 1, "BIRD");
+    log.define(LogCodec::ENTRY_TAG, 2, "SD");
+    log.define(LogCodec::ENTRY_FORMAT, 1, "Playing bird %d (%hx, %s)");
+    log.formatted(4, 1500000, 1, 1, "Playing bird %d (%hx, %s)", 1001, -1, "manual");
+    log.text(3, 2250000, 2, "SD card slow");
+    log.drop(3);
+    log.formatted(5, 4000000, 1, 1, "Playing bird %d (%hx, %s)", 1002, 0x12345, "auto");
+    log.text(2, 5000000, 2, "Read failed");
+    log.truncate(3);
+    CHECK(log.save(current.c_str()));
+
+    const std::string all =
+        "[00:00:01.500] [INFO] [BIRD] Playing bird 1001 (ffff, manual)\n"
+        "[00:00:02.250] [WARN] [SD] SD card slow\n"
+        "[00:00:02.250] [WARN] [LOG] 3 log records dropped (buffer full)\n"
+        "[00:00:04.000] [DEBUG] [BIRD] Playing bird 1002 (2345, auto)\n";
+    const std::string warning = "Warning: " + current + " ends with incomplete data, ignored\n";
+
+    checkDecoder(tool, first + " " + current, "[00:00:00.500] [INFO] [SYSTEM] Boot\n" + all + warning);
+    checkDecoder(tool, "--tag bird " + current,
+                 "[00:00:01.500] [INFO] [BIRD] Playing bird 1001 (ffff, manual)\n"
+                 "[00:00:04.000] [DEBUG] [BIRD] Playing bird 1002 (2345, auto)\n" + warning);
+    checkDecoder(tool, "-t SD -t LOG " + current,
+                 "[00:00:02.250] [WARN] [SD] SD card slow\n"
+                 "[00:00:02.250] [WARN] [LOG] 3 log records dropped (buffer full)\n" + warning);
+    checkDecoder(tool, "--level info " + current,
+                 "[00:00:01.500] [INFO] [BIRD] Playing bird 1001 (ffff, manual)\n"
+                 "[00:00:02.250] [WARN] [SD] SD card slow\n"
+                 "[00:00:02.250] [WARN] [LOG] 3 log records dropped (buffer full)\n" + warning);
+    checkDecoder(tool, "--since 2 --until 3.5 " + current,
+                 "[00:00:02.250] [WARN] [SD] SD card slow\n"
+                 "[00:00:02.250] [WARN] [LOG] 3 log records dropped (buffer full)\n" + warning);
+
+    // 已校时的文件默认显示墙上时间（UTC下检查），--boot显示开机时间
+    ClogWriter synced;
+    synced.sync(1767225600, 2000000);    // 2026-01-01 00:00:00 UTC时刻为开机后2秒
+    synced.define(LogCodec::ENTRY_TAG, 1, "NTP");
+    synced.text(4, 3250000, 1, "Time synced");
+    std::string syncedPath = std::string(dir) + "/synced.clog";
+    CHECK(synced.save(syncedPath.c_str()));
+    checkDecoder("TZ=UTC " + tool, syncedPath, "[2026-01-01 00:00:01.250] [INFO] [NTP] Time synced\n");
+    checkDecoder(tool, "--boot " + syncedPath, "[00:00:03.250] [INFO] [NTP] Time synced\n");
+
+    for (const auto& path : {first, current, syncedPath}) {
+        unlink(path.c_str());
+    }
+    rmdir(dir);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    checkFormat("plain text");
+    checkFormat("100%% done");
+    checkFormat("bird %d at %u ms", -1001, 4000000000u);
+    checkFormat("%ld %lu %lld %llu", -5L, 7UL, -1234567890123LL, 18446744073709551615ULL);
+    checkFormat("%zu bytes, %x/%X/%o/%#x", (size_t)4096, 0xBEEFu, 0xBEEFu, 8u, 255u);
+    checkFormat("[%5d] [%-5d] [%05d] [%+d]", 42, 42, 42, 42);
+    checkFormat("[%*d] [%-*d] [%.*f]", 6, 7, 6, 7, 3, 3.14159);
+    checkFormat("%.2f %e %g %8.3f", 1.005, 12345.678, 0.0001, -2.5);
+    checkFormat("%s, %10s, %-10s|, %.3s", "bird", "bird", "bird", "kingfisher");
+    checkFormat("%c%c%c", 'c', 'y', 'b');
+
+    // hh/h：参数在调用处被提升为int，编码时要按printf截断
+    checkFormat("%hhd %hhd %hhu %hhx", 300, -129, 511, 0x1FF);
+    checkFormat("%hd %hd %hu %hx", 40000, -32769, 70000, -1);
+    checkDecoded("44", "%hhd", 300);
+    checkDecoded("ffff", "%hx", -1);
+    checkDecoded("-25536", "%hd", 40000);
+    checkDecoded("255", "%hhu", -1);
+
+    // 负载被截断时缺少的参数显示为"?"
+    uint8_t payload[1] = {0x02};
+    String text;
+    LogCodec::formatArgs("a=%d b=%d", payload, sizeof(payload), text);
+    CHECK_MSG(text == "a=1 b=?", "%s", text.c_str());
+
+    if (argc > 1) {
+        testDecoderTool(argv[1]);
+    } else {
+        fprintf(stderr, "clog_decode path not given, skipping decoder tests\n");
+        testFailures()++;
+    }
+
+    return testResult("test_log_codec");
+}
@@ -0,0 +1,165 @@
+/**
+ * 小鸟命令邮箱测试
+ *
+ * 编译设备端的bird_command_mailbox.cpp，检验打包/解包、同类命令合并（最新的生效）、
+ * 槽之间互不影响，以及多线程投递/取走时计数守恒、同一投递者的命令不会乱序。
+ */
+#include "applications/modules/bird_watching/core/bird_command_mailbox.h"
+#include "test_check.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace BirdWatching;
+
+namespace {
+
+void testRoundTrip() {
+    BirdCommandMailbox mailbox;
+    BirdCommand command;
+    CHECK(!mailbox.take(BIRD_CMD_PLAY, command));
+
+    CHECK(!mailbox.post(BIRD_CMD_PLAY, 0xFFFF, TRIGGER_GESTURE, false));
+    CHECK(mailbox.take(BIRD_CMD_PLAY, command));
+    CHECK(command.type == BIRD_CMD_PLAY);
+    CHECK(command.arg == 0xFFFF);
+    CHECK(command.trigger == TRIGGER_GESTURE);
+    CHECK(!command.record_stats);
+    CHECK(command.seq == 1);
+    CHECK(!mailbox.take(BIRD_CMD_PLAY, command));
+
+    CHECK(!mailbox.post(BIRD_CMD_PLAY, 0, TRIGGER_MANUAL, true));
+    CHECK(mailbox.take(BIRD_CMD_PLAY, command));
+    CHECK(command.arg == 0);
+    CHECK(command.trigger == TRIGGER_MANUAL);
+    CHECK(command.record_stats);
+    CHECK(command.seq == 2);
+}
+
+void testLatestWins() {
+    BirdCommandMailbox mailbox;
+    CHECK(!mailbox.post(BIRD_CMD_PLAY, 1001, TRIGGER_AUTO));
+    CHECK(mailbox.post(BIRD_CMD_PLAY, 1002, TRIGGER_MANUAL));
+    CHECK(mailbox.post(BIRD_CMD_PLAY, 1003, TRIGGER_GESTURE, false));
+
+    BirdCommand command;
+    CHECK(mailbox.take(BIRD_CMD_PLAY, command));
+    CHECK(command.arg == 1003);
+    CHECK(command.trigger == TRIGGER_GESTURE);
+    CHECK(!command.record_stats);
+    CHECK(command.seq == 3);
+    CHECK(!mailbox.take(BIRD_CMD_PLAY, command));
+
+    BirdMailboxStats stats = mailbox.getStats();
+    CHECK(stats.posted == 3);
+    CHECK(stats.taken == 1);
+    CHECK(stats.coalesced == 2);
+}
+
+void testSlotsAreIndependent() {
+    BirdCommandMailbox mailbox;
+    mailbox.post(BIRD_CMD_PLAY, 1001);
+    CHECK(!mailbox.post(BIRD_CMD_GESTURE, 4, TRIGGER_GESTURE));
+
+    BirdCommand command;
+    CHECK(mailbox.take(BIRD_CMD_GESTURE, command));
+    CHECK(command.type == BIRD_CMD_GESTURE && command.arg == 4);
+    CHECK(mailbox.take(BIRD_CMD_PLAY, command));
+    CHECK(command.type == BIRD_CMD_PLAY && command.arg == 1001);
+
+    // clear只丢弃该类型
+    mailbox.post(BIRD_CMD_PLAY, 1002);
+    mailbox.post(BIRD_CMD_GESTURE, 5);
+    mailbox.clear(BIRD_CMD_PLAY);
+    CHECK(!mailbox.take(BIRD_CMD_PLAY, command));
+    CHECK(mailbox.take(BIRD_CMD_GESTURE, command) && command.arg == 5);
+}
+
+void testInvalidTypes() {
+    BirdCommandMailbox mailbox;
+    BirdCommand command;
+    CHECK(!mailbox.post(BIRD_CMD_NONE, 1));
+    CHECK(!mailbox.post((BirdCommandType)3, 1));
+    CHECK(!mailbox.take(BIRD_CMD_NONE, command));
+    CHECK(!mailbox.take((BirdCommandType)3, command));
+    CHECK(mailbox.getStats().posted == 0);
+}
+
+void testSequenceWraps() {
+    // 序号回绕到0时打包字仍非0（类型在高位），命令不会被当成空槽
+    BirdCommandMailbox mailbox;
+    BirdCommand command;
+    for (int i = 1; i <= 256; i++) {
+        mailbox.post(BIRD_CMD_PLAY, (uint16_t)i);
+        CHECK(mailbox.take(BIRD_CMD_PLAY, command));
+        CHECK(command.seq == (uint8_t)i);
+        CHECK(command.arg == i);
+    }
+    CHECK(command.seq == 0);
+}
+
+// 多个投递者与一个消费者并发：每个投递者的arg递增，消费者看到的不能倒退
+void testConcurrentLatestWins() {
+    constexpr int PRODUCERS = 3;
+    constexpr int POSTS = 200000;
+    BirdCommandMailbox mailbox;
+    std::atomic<int> running(PRODUCERS);
+
+    // arg高2位为投递者编号，低14位随该投递者的投递次数递增
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&mailbox, &running, p] {
+            for (int i = 1; i <= POSTS; i++) {
+                mailbox.post(BIRD_CMD_PLAY, (uint16_t)((p << 14) | (int)((int64_t)i * 0x3FFF / POSTS)), TRIGGER_AUTO);
+            }
+            running--;
+        });
+    }
+
+    int last[PRODUCERS] = {0};
+    uint32_t taken = 0;
+    bool ordered = true;
+    auto consume = [&](const BirdCommand& command) {
+        taken++;
+        int p = command.arg >> 14;
+        int value = command.arg & 0x3FFF;
+        if (p >= PRODUCERS || value < last[p]) {
+            ordered = false;
+        } else {
+            last[p] = value;
+        }
+    };
+
+    BirdCommand command;
+    while (running > 0) {
+        if (mailbox.take(BIRD_CMD_PLAY, command)) {
+            consume(command);
+        }
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    while (mailbox.take(BIRD_CMD_PLAY, command)) {
+        consume(command);
+    }
+
+    BirdMailboxStats stats = mailbox.getStats();
+    CHECK(ordered);
+    CHECK(stats.posted == (uint32_t)PRODUCERS * POSTS);
+    CHECK(stats.taken == taken);
+    // 每次投递要么放进空槽（之后被取走一次），要么覆盖一条未处理的命令
+    CHECK_MSG(stats.posted == stats.taken + stats.coalesced, "posted %u taken %u coalesced %u", stats.posted,
+              stats.taken, stats.coalesced);
+}
+
+} // namespace
+
+int main() {
+    testRoundTrip();
+    testLatestWins();
+    testSlotsAreIndependent();
+    testInvalidTypes();
+    testSequenceWraps();
+    testConcurrentLatestWins();
+    return testResult("test_mailbox");
+}
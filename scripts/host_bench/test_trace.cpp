@@ -0,0 +1,243 @@
+/**
+ * 事件跟踪导出/转换测试
+ *
+ * 编译设备端的trace_buffer.cpp：两个任务在两个核上记录事件，TraceBuffer::dump导出到
+ * 文件，用trace2json转换后检查每个BEGIN都有对应的END、参数和任务名、32位时间戳回绕
+ * 后的展开；环被覆盖时开头孤立的END被丢弃。
+ *
+ * 用法：test_trace <trace2json路径>
+ */
+#include "system/logging/trace_buffer.h"
+#include "test_check.h"
+#include <esp_timer.h>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 转换结果中的一个事件（trace2json每个事件输出一行）
+struct Event {
+    std::string name;
+    std::string phase;
+    uint64_t ts;
+    int pid;
+    int tid;
+    std::string args;        // args对象的原文，如{"frame":3}
+};
+
+// 取出一行中某个字段的原文（字符串去掉引号）
+std::string field(const std::string& line, const char* key) {
+    std::string pattern = std::string("\"") + key + "\":";
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) return "";
+    pos += pattern.size();
+    if (line[pos] == '"') {
+        return line.substr(pos + 1, line.find('"', pos + 1) - pos - 1);
+    }
+    if (line[pos] == '{') {
+        return line.substr(pos, line.find('}', pos) - pos + 1);
+    }
+    return line.substr(pos, line.find_first_of(",}", pos) - pos);
+}
+
+void fileSink(const uint8_t* data, size_t length, void* context) {
+    fwrite(data, 1, length, static_cast<FILE*>(context));
+}
+
+class TraceTest {
+public:
+    TraceTest(const std::string& tool, const std::string& dir) : tool_(tool), dir_(dir) {}
+
+    // 导出并转换，返回trace2json的摘要行
+    std::string convert(const char* name) {
+        std::string dump_path = dir_ + "/" + name + ".bin";
+        std::string json_path = dir_ + "/" + name + ".json";
+        FILE* fp = fopen(dump_path.c_str(), "wb");
+        size_t total = fp ? TraceBuffer::dump(fileSink, fp) : 0;
+        if (fp) fclose(fp);
+        CHECK(total > 0);
+
+        std::string summary;
+        FILE* pipe = popen((tool_ + " -o " + json_path + " " + dump_path + " 2>&1").c_str(), "r");
+        if (pipe) {
+            char buffer[256];
+            while (fgets(buffer, sizeof(buffer), pipe)) summary += buffer;
+            CHECK_MSG(pclose(pipe) == 0, "trace2json failed: %s", summary.c_str());
+        }
+
+        events_.clear();
+        threads_.clear();
+        std::ifstream json(json_path);
+        std::string line;
+        std::getline(json, line);
+        CHECK_MSG(line == "{\"traceEvents\":[", "%s", line.c_str());
+        while (std::getline(json, line) && line[0] == '{') {
+            Event event{field(line, "name"), field(line, "ph"), strtoull(field(line, "ts").c_str(), nullptr, 10),
+                        atoi(field(line, "pid").c_str()), atoi(field(line, "tid").c_str()), field(line, "args")};
+            if (event.phase == "M") {
+                if (event.name == "thread_name") threads_[{event.pid, event.tid}] = field(event.args, "name");
+            } else {
+                events_.push_back(event);
+            }
+        }
+        CHECK_MSG(line == "],\"displayTimeUnit\":\"ms\"}", "%s", line.c_str());
+        unlink(dump_path.c_str());
+        unlink(json_path.c_str());
+        return summary;
+    }
+
+    // 按时间排序，同一线程的BEGIN/END按名称成对嵌套
+    void checkPairs() {
+        std::map<std::tuple<int, int, std::string>, int> depth;
+        uint64_t last = 0;
+        for (const auto& event : events_) {
+            CHECK_MSG(event.ts >= last, "%s at %llu after %llu", event.name.c_str(), (unsigned long long)event.ts,
+                      (unsigned long long)last);
+            last = event.ts;
+            int& open = depth[std::make_tuple(event.pid, event.tid, event.name)];
+            if (event.phase == "B") {
+                open++;
+            } else if (event.phase == "E") {
+                CHECK_MSG(open > 0, "%s: END without BEGIN", event.name.c_str());
+                open--;
+            } else {
+                CHECK_MSG(event.phase == "i", "%s: phase %s", event.name.c_str(), event.phase.c_str());
+            }
+        }
+        for (const auto& span : depth) {
+            CHECK_MSG(span.second == 0, "%s: %d BEGIN without END", std::get<2>(span.first).c_str(), span.second);
+        }
+    }
+
+    int count(const char* phase) const {
+        int n = 0;
+        for (const auto& event : events_) n += event.phase == phase;
+        return n;
+    }
+
+    const std::vector<Event>& events() const { return events_; }
+    std::string thread(int pid, int tid) const {
+        auto it = threads_.find({pid, tid});
+        return it != threads_.end() ? it->second : "";
+    }
+
+private:
+    std::string tool_;
+    std::string dir_;
+    std::vector<Event> events_;
+    std::map<std::pair<int, int>, std::string> threads_;
+};
+
+// 每个事件之间走100us
+void record(TraceEvent event, uint16_t arg = 0) {
+    TRACE_EVENT(event, arg);
+    hostAdvanceMicros(100);
+}
+
+// UI任务（核1）和预取任务（核0）各跑一个周期，中途esp_timer低32位回绕
+void testSpans(TraceTest& test) {
+    TraceBuffer::clear();
+    uint64_t start = esp_timer_get_time();
+    hostAdvanceMicros(0x100000000ULL - start % 0x100000000ULL - 450);
+    start = esp_timer_get_time();
+
+    record(TRACE_UI_CYCLE_BEGIN, 1);
+    record(TRACE_LOCK_WAIT_BEGIN);
+    record(TRACE_LOCK_WAIT_END, 0);
+    record(TRACE_LOCK_HOLD_BEGIN);
+    record(TRACE_FLUSH_BEGIN, 120);
+    record(TRACE_FLUSH_END);
+    record(TRACE_LOCK_HOLD_END);
+    record(TRACE_FRAME_SHOW, 3);
+    record(TRACE_UI_CYCLE_END);
+
+    std::thread prefetch([] {
+        hostSetCurrentTask("bird_prefetch", 0);
+        record(TRACE_FRAME_LOAD_BEGIN, 4);
+        record(TRACE_SD_READ_BEGIN, 28800);
+        record(TRACE_SD_READ_END);
+        record(TRACE_FRAME_LOAD_END, 4);
+        record(TRACE_FRAME_UNDERRUN);
+    });
+    prefetch.join();
+
+    std::string summary = test.convert("spans");
+    CHECK_MSG(summary == "14 events over 1.3ms, 2 tasks (overwritten core 0: 0, core 1: 0)\n", "%s",
+              summary.c_str());
+    test.checkPairs();
+    CHECK(test.count("B") == 6);
+    CHECK(test.count("E") == 6);
+    CHECK(test.count("i") == 2);
+    CHECK(test.thread(1, 0) == "loopTask");
+    CHECK(test.thread(0, 1) == "bird_prefetch");
+
+    const auto& events = test.events();
+    if (events.size() != 14) {
+        CHECK_MSG(false, "%zu events", events.size());
+        return;
+    }
+    // 时间戳跨过2^32后仍按64位连续递增
+    for (size_t i = 0; i < events.size(); i++) {
+        CHECK_MSG(events[i].ts == start + i * 100, "event %zu: ts %llu, expected %llu", i,
+                  (unsigned long long)events[i].ts, (unsigned long long)(start + i * 100));
+    }
+    CHECK(events[0].name == "ui_cycle" && events[0].args == "{\"notified\":1}");
+    CHECK(events[2].name == "lvgl_lock_wait" && events[2].phase == "E" && events[2].args == "{\"timeout\":0}");
+    CHECK(events[4].name == "flush" && events[4].args == "{\"lines\":120}");
+    CHECK(events[7].name == "frame_show" && events[7].args == "{\"frame\":3}");
+    CHECK(events[10].name == "sd_read" && events[10].pid == 0 && events[10].args == "{\"bytes\":28800}");
+    CHECK(events[13].name == "frame_underrun" && events[13].args.empty());
+}
+
+// 环被覆盖：保留的最旧记录是END，转换时丢弃
+void testOverwritten(TraceTest& test) {
+    TraceBuffer::clear();
+    const int pairs = TRACE_RING_SIZE / 2 + 44;
+    for (int i = 0; i < pairs; i++) {
+        record(TRACE_FRAME_LOAD_BEGIN, i);
+        record(TRACE_FRAME_LOAD_END, i);
+    }
+    record(TRACE_FRAME_SHOW, pairs);
+    CHECK(TraceBuffer::getWritten(1) == (uint32_t)pairs * 2 + 1);
+
+    std::string summary = test.convert("overwritten");
+    char expected[128];
+    snprintf(expected, sizeof(expected), "%d events over %.1fms, 2 tasks (overwritten core 0: 0, core 1: %d)\n",
+             TRACE_RING_SIZE, (TRACE_RING_SIZE - 1) / 10.0, pairs * 2 + 1 - TRACE_RING_SIZE);
+    CHECK_MSG(summary == expected, "%s", summary.c_str());
+    test.checkPairs();
+    CHECK(test.count("B") == TRACE_RING_SIZE / 2 - 1);
+    CHECK(test.count("E") == TRACE_RING_SIZE / 2 - 1);
+    CHECK(test.count("i") == 1);
+    CHECK(!test.events().empty() && test.events().front().phase == "B");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: test_trace <trace2json>\n");
+        return 2;
+    }
+    char dir[] = "/tmp/test_trace.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    // 主线程作为核1上的UI任务
+    hostSetCurrentTask("loopTask", 1);
+    TraceTest test(argv[1], dir);
+    testSpans(test);
+    testOverwritten(test);
+    CHECK(TraceBuffer::isEnabled());
+
+    rmdir(dir);
+    return testResult("test_trace");
+}
@@ -0,0 +1,257 @@
+/**
+ * 事件跟踪转换工具
+ *
+ * 把cybird-cli trace保存的导出数据（格式见trace_buffer.h）转换为Chrome trace JSON，
+ * 事件名称、阶段和参数名取自设备端trace_buffer.cpp的事件表，新增事件不需要修改主机端。
+ * 结果可用chrome://tracing或https://ui.perfetto.dev打开。
+ *
+ * 进程对应CPU核，线程对应任务；环被覆盖后开头可能缺少BEGIN，这类孤立的END被丢弃。
+ * 摘要（记录数、时间跨度、被覆盖数）输出到标准错误。
+ *
+ * 用法：trace2json [-o 输出.json] <导出数据>（默认输出到标准输出）
+ */
+#include "system/logging/trace_buffer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct Record {
+    uint64_t timestamp_us;      // 开机以来的微秒数（已展开32位回绕）
+    uint16_t core;
+    TraceRecord raw;
+};
+
+struct Dump {
+    uint64_t dump_time_us = 0;
+    std::map<uint8_t, std::string> tasks;
+    std::vector<Record> records;
+    std::vector<uint32_t> overwritten;      // 每个核被覆盖的记录数
+};
+
+// 按字节顺序读取小端数据（主机与ESP32都是小端，直接复制）
+class Cursor {
+public:
+    explicit Cursor(const std::vector<uint8_t>& data) : data_(data) {}
+
+    bool read(void* out, size_t length) {
+        if (pos_ + length > data_.size()) {
+            return false;
+        }
+        memcpy(out, data_.data() + pos_, length);
+        pos_ += length;
+        return true;
+    }
+
+private:
+    const std::vector<uint8_t>& data_;
+    size_t pos_ = 0;
+};
+
+bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+// 解析导出数据，失败时返回错误说明
+const char* parseDump(const std::vector<uint8_t>& data, Dump& dump) {
+    Cursor cursor(data);
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint16_t cores = 0;
+    if (!cursor.read(&magic, sizeof(magic)) || magic != TraceBuffer::DUMP_MAGIC) {
+        return "not a trace dump (missing CTRC header)";
+    }
+    if (!cursor.read(&version, sizeof(version)) || version != TraceBuffer::DUMP_VERSION) {
+        return "unsupported trace dump version";
+    }
+    uint8_t task_count = 0;
+    if (!cursor.read(&cores, sizeof(cores)) || !cursor.read(&dump.dump_time_us, sizeof(dump.dump_time_us)) ||
+        !cursor.read(&task_count, sizeof(task_count))) {
+        return "trace dump is incomplete";
+    }
+
+    for (int i = 0; i < task_count; i++) {
+        uint8_t id;
+        char name[TraceBuffer::TASK_NAME_SIZE + 1] = {0};
+        if (!cursor.read(&id, sizeof(id)) || !cursor.read(name, TraceBuffer::TASK_NAME_SIZE)) {
+            return "trace dump is incomplete";
+        }
+        dump.tasks[id] = name;
+    }
+
+    // 时间戳只有低32位（约71分钟回绕），以导出时刻为基准向前展开
+    uint32_t now32 = (uint32_t)dump.dump_time_us;
+    for (uint16_t core = 0; core < cores; core++) {
+        uint32_t count;
+        uint32_t overwritten;
+        if (!cursor.read(&count, sizeof(count)) || !cursor.read(&overwritten, sizeof(overwritten))) {
+            return "trace dump is incomplete";
+        }
+        dump.overwritten.push_back(overwritten);
+        for (uint32_t i = 0; i < count; i++) {
+            Record record;
+            if (!cursor.read(&record.raw, sizeof(record.raw))) {
+                return "trace dump is incomplete";
+            }
+            record.timestamp_us = dump.dump_time_us - (uint32_t)(now32 - record.raw.timestamp_us);
+            record.core = core;
+            dump.records.push_back(record);
+        }
+    }
+
+    std::stable_sort(dump.records.begin(), dump.records.end(),
+                     [](const Record& a, const Record& b) { return a.timestamp_us < b.timestamp_us; });
+    return nullptr;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+// 每个事件一行，便于查看和比较
+void writeChromeTrace(const Dump& dump, FILE* out) {
+    std::vector<std::string> events;
+    char line[256];
+    for (size_t core = 0; core < dump.overwritten.size(); core++) {
+        snprintf(line, sizeof(line),
+                 "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%zu,\"tid\":0,\"args\":{\"name\":\"Core %zu\"}}",
+                 core, core);
+        events.push_back(line);
+    }
+
+    std::map<std::pair<uint16_t, uint8_t>, bool> seen_threads;
+    std::map<std::tuple<uint16_t, uint8_t, std::string>, int> open_spans;
+    for (const auto& record : dump.records) {
+        const TraceEventInfo* info = TraceBuffer::eventInfo(record.raw.event);
+        std::string name = info ? info->name : "event_" + std::to_string(record.raw.event);
+        char phase = info ? info->phase : 'i';
+        const char* arg = info ? info->arg : "arg";
+
+        auto key = std::make_tuple(record.core, record.raw.task, name);
+        if (phase == 'E') {
+            auto it = open_spans.find(key);
+            if (it == open_spans.end() || it->second == 0) {
+                continue;
+            }
+            it->second--;
+        } else if (phase == 'B') {
+            open_spans[key]++;
+        }
+
+        auto thread = std::make_pair(record.core, record.raw.task);
+        if (!seen_threads[thread]) {
+            seen_threads[thread] = true;
+            auto task = dump.tasks.find(record.raw.task);
+            std::string task_name =
+                task != dump.tasks.end() ? task->second : "task " + std::to_string(record.raw.task);
+            snprintf(line, sizeof(line),
+                     "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":%s}}",
+                     record.core, record.raw.task, jsonString(task_name).c_str());
+            events.push_back(line);
+        }
+
+        int len = snprintf(line, sizeof(line), "{\"name\":%s,\"ph\":\"%c\",\"ts\":%llu,\"pid\":%u,\"tid\":%u",
+                           jsonString(name).c_str(), phase, (unsigned long long)record.timestamp_us, record.core,
+                           record.raw.task);
+        if (phase == 'i') {
+            len += snprintf(line + len, sizeof(line) - len, ",\"s\":\"t\"");
+        }
+        if (arg) {
+            len += snprintf(line + len, sizeof(line) - len, ",\"args\":{%s:%u}", jsonString(arg).c_str(),
+                            record.raw.arg);
+        }
+        snprintf(line + len, sizeof(line) - len, "}");
+        events.push_back(line);
+    }
+
+    fprintf(out, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); i++) {
+        fprintf(out, "%s%s\n", events[i].c_str(), i + 1 < events.size() ? "," : "");
+    }
+    fprintf(out, "],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+// 一行摘要：记录数、时间跨度、被覆盖数
+void printSummary(const Dump& dump) {
+    double span_ms = dump.records.empty()
+                         ? 0
+                         : (dump.records.back().timestamp_us - dump.records.front().timestamp_us) / 1000.0;
+    fprintf(stderr, "%zu events over %.1fms, %zu tasks (overwritten", dump.records.size(), span_ms,
+            dump.tasks.size());
+    for (size_t core = 0; core < dump.overwritten.size(); core++) {
+        fprintf(stderr, "%s core %zu: %u", core ? "," : "", core, dump.overwritten[core]);
+    }
+    fprintf(stderr, ")\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* input = nullptr;
+    const char* output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
+            output = argv[++i];
+        } else if (argv[i][0] != '-' && !input) {
+            input = argv[i];
+        } else {
+            input = nullptr;
+            break;
+        }
+    }
+    if (!input) {
+        fprintf(stderr, "usage: trace2json [-o FILE] DUMP\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(input, data)) {
+        perror(input);
+        return 1;
+    }
+    Dump dump;
+    if (const char* error = parseDump(data, dump)) {
+        fprintf(stderr, "Cannot convert %s: %s\n", input, error);
+        return 1;
+    }
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+    writeChromeTrace(dump, out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    printSummary(dump);
+    return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * 帧放大主机基准测试
+ *
+ * 对比两种把120x120 RGB565小鸟帧显示为240x240的方式：
+ *   - LVGL缩放：lv_image以512缩放绘制原始帧（lv_draw_sw_transform）
+ *   - 预放大：FrameUpscaler先放大到240x240，LVGL以1倍绘制（直接拷贝）
+ * 使用仓库内的LVGL（lib/lvgl，lv_conf.h与设备相同）和设备端的frame_upscaler.cpp，
+ * 显示为240x240局部刷新、每个缓冲区DISPLAY_BUF_LINES行，刷新回调立即完成（不含SPI传输）。
+ *
+ * 用法：upscale_bench [帧数]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <lvgl.h>
+#include "applications/modules/bird_watching/core/frame_upscaler.h"
+#include "drivers/display/display.h"
+
+using namespace BirdWatching;
+
+namespace {
+
+constexpr uint16_t FRAME_SIZE = 120;
+constexpr uint16_t SCREEN_SIZE = 240;
+
+using Clock = std::chrono::steady_clock;
+const Clock::time_point g_start = Clock::now();
+
+uint32_t tickMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - g_start).count();
+}
+
+uint64_t g_flushed_pixels;
+
+void flushCb(lv_display_t* disp, const lv_area_t* area, uint8_t*) {
+    g_flushed_pixels += (uint64_t)lv_area_get_width(area) * lv_area_get_height(area);
+    lv_display_flush_ready(disp);
+}
+
+double usSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count() / 1000.0;
+}
+
+// 平滑渐变叠加少量噪声，接近小鸟动画帧的内容
+void fillFrame(uint16_t* pixels, uint32_t seed) {
+    for (uint16_t y = 0; y < FRAME_SIZE; y++) {
+        for (uint16_t x = 0; x < FRAME_SIZE; x++) {
+            seed = seed * 1664525u + 1013904223u;
+            uint8_t noise = seed >> 29;
+            uint8_t r = (x * 31 / FRAME_SIZE + noise) & 0x1F;
+            uint8_t g = (y * 63 / FRAME_SIZE + noise) & 0x3F;
+            uint8_t b = ((x + y) * 31 / (2 * FRAME_SIZE)) & 0x1F;
+            pixels[y * FRAME_SIZE + x] = (r << 11) | (g << 5) | b;
+        }
+    }
+}
+
+lv_image_dsc_t makeDsc(const uint16_t* pixels, uint16_t size) {
+    lv_image_dsc_t dsc = {};
+    dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc.header.cf = LV_COLOR_FORMAT_RGB565;
+    dsc.header.w = size;
+    dsc.header.h = size;
+    dsc.header.stride = size * 2;
+    dsc.data = reinterpret_cast<const uint8_t*>(pixels);
+    dsc.data_size = (uint32_t)size * size * 2;
+    return dsc;
+}
+
+// 与BirdAnimation::showSlot()相同的设置：中心为轴心缩放后居中
+void showImage(lv_obj_t* img, const lv_image_dsc_t* dsc, uint16_t zoom) {
+    lv_image_set_src(img, dsc);
+    lv_image_set_pivot(img, dsc->header.w / 2, dsc->header.h / 2);
+    lv_image_set_scale(img, zoom);
+    lv_obj_center(img);
+}
+
+// 每帧整图失效后立即渲染，返回平均每帧耗时（微秒）
+double renderFrames(lv_display_t* disp, lv_obj_t* img, int frames) {
+    lv_refr_now(disp);
+    g_flushed_pixels = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < frames; i++) {
+        lv_obj_invalidate(img);
+        lv_refr_now(disp);
+    }
+    double us = usSince(start) / frames;
+
+    // 每帧都应刷新整个240x240区域，否则测到的不是整帧绘制
+    if (g_flushed_pixels != (uint64_t)frames * SCREEN_SIZE * SCREEN_SIZE) {
+        fprintf(stderr, "Unexpected flush size: %llu pixels in %d frames\n",
+                (unsigned long long)g_flushed_pixels, frames);
+        exit(1);
+    }
+    return us;
+}
+
+template <typename Upscale>
+double upscaleFrames(Upscale upscale, const uint16_t* src, uint16_t* dst, int frames) {
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < frames; i++) {
+        upscale(src, FRAME_SIZE, FRAME_SIZE, dst);
+    }
+    return usSince(start) / frames;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 500;
+    if (frames <= 0) {
+        frames = 500;
+    }
+
+    lv_init();
+    lv_tick_set_cb(tickMs);
+
+    lv_display_t* disp = lv_display_create(SCREEN_SIZE, SCREEN_SIZE);
+    lv_display_set_flush_cb(disp, flushCb);
+    size_t buf_size = SCREEN_SIZE * DISPLAY_BUF_LINES * sizeof(lv_color16_t);
+    std::vector<uint8_t> buf1(buf_size + LV_DRAW_BUF_ALIGN), buf2(buf_size + LV_DRAW_BUF_ALIGN);
+    lv_display_set_buffers(disp, lv_draw_buf_align(buf1.data(), LV_COLOR_FORMAT_RGB565),
+                           lv_draw_buf_align(buf2.data(), LV_COLOR_FORMAT_RGB565), buf_size,
+                           LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+    lv_obj_t* scr = lv_screen_active();
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+    lv_obj_t* img = lv_image_create(scr);
+
+    std::vector<uint16_t> frame(FRAME_SIZE * FRAME_SIZE);
+    std::vector<uint16_t> scaled(SCREEN_SIZE * SCREEN_SIZE);
+    fillFrame(frame.data(), 20251216);
+
+    lv_image_dsc_t frame_dsc = makeDsc(frame.data(), FRAME_SIZE);
+    lv_image_dsc_t scaled_dsc = makeDsc(scaled.data(), SCREEN_SIZE);
+
+    // LVGL缩放（BIRD_FRAME_UPSCALE=0的路径），分别测默认的抗锯齿和关闭抗锯齿
+    showImage(img, &frame_dsc, 512);
+    lv_image_set_antialias(img, true);
+    double lvgl_aa = renderFrames(disp, img, frames);
+    lv_image_set_antialias(img, false);
+    double lvgl_nearest = renderFrames(disp, img, frames);
+    lv_image_set_antialias(img, true);
+
+    // 预放大后1倍绘制
+    double nearest = upscaleFrames(FrameUpscaler::upscale2xNearest, frame.data(), scaled.data(), frames);
+    double bilinear = upscaleFrames(FrameUpscaler::upscale2xBilinear, frame.data(), scaled.data(), frames);
+    showImage(img, &scaled_dsc, 256);
+    double blit = renderFrames(disp, img, frames);
+
+    printf("%d frames, %ux%u RGB565 -> %ux%u, %u-line partial buffers\n",
+           frames, FRAME_SIZE, FRAME_SIZE, SCREEN_SIZE, SCREEN_SIZE, (unsigned)DISPLAY_BUF_LINES);
+    printf("LVGL zoom 512 (antialias)          render %8.1f us/frame\n", lvgl_aa);
+    printf("LVGL zoom 512 (no antialias)       render %8.1f us/frame\n", lvgl_nearest);
+    printf("upscale2xNearest  + zoom 256       upscale %7.1f us  render %8.1f us  total %8.1f us\n",
+           nearest, blit, nearest + blit);
+    printf("upscale2xBilinear + zoom 256       upscale %7.1f us  render %8.1f us  total %8.1f us\n",
+           bilinear, blit, bilinear + blit);
+
+    lv_deinit();
+    return 0;
+}
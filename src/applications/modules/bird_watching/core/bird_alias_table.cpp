@@ -0,0 +1,61 @@
+#include "bird_alias_table.h"
+
+namespace BirdWatching {
+
+void AliasTable::build(const std::vector<uint32_t>& weights) {
+    const size_t n = weights.size();
+    uint64_t total = 0;
+    for (uint32_t weight : weights) {
+        total += weight;
+    }
+    threshold_.clear();
+    alias_.clear();
+    if (n == 0 || total == 0) {
+        return;
+    }
+    threshold_.assign(n, 0);
+    alias_.assign(n, 0);
+
+    // 整数Vose算法：每列容量为总权重，权重按n倍放大后分配
+    std::vector<uint64_t> scaled(n);
+    std::vector<uint16_t> small;
+    std::vector<uint16_t> large;
+    small.reserve(n);
+    large.reserve(n);
+
+    const uint64_t column_size = total;
+    for (size_t i = 0; i < n; i++) {
+        scaled[i] = (uint64_t)weights[i] * n;
+        if (scaled[i] < column_size) {
+            small.push_back(i);
+        } else {
+            large.push_back(i);
+        }
+    }
+
+    std::vector<uint64_t> share(n, column_size);
+    while (!small.empty() && !large.empty()) {
+        uint16_t s = small.back();
+        small.pop_back();
+        uint16_t l = large.back();
+
+        // 小列用自身权重填一部分，剩余部分由大列补齐
+        share[s] = scaled[s];
+        alias_[s] = l;
+        scaled[l] -= column_size - scaled[s];
+        if (scaled[l] < column_size) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // 剩余列（整数运算下正好满）总是选中自己
+    for (size_t i = 0; i < n; i++) {
+        threshold_[i] = (uint32_t)((share[i] * 65536 + column_size / 2) / column_size);
+        if (share[i] == column_size) {
+            alias_[i] = i;
+        }
+    }
+}
+
+} // namespace BirdWatching
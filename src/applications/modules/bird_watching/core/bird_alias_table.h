@@ -0,0 +1,44 @@
+#ifndef BIRD_ALIAS_TABLE_H
+#define BIRD_ALIAS_TABLE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace BirdWatching {
+
+/**
+ * 按权重O(1)随机选择下标的Vose别名表（整数运算）
+ *
+ * 第i列以threshold(i)/65536的概率选中i，否则选中alias(i)。
+ * 只依赖标准库，主机测试（scripts/host_bench/test_alias_table.cpp）直接编译本文件。
+ */
+class AliasTable {
+public:
+    // 按权重重建别名表，权重全为0时表为空
+    void build(const std::vector<uint32_t>& weights);
+
+    /**
+     * 用一个32位随机数选出下标
+     *
+     * 高16位选列，低16位决定取本列还是别名；调用者保证表不为空
+     */
+    uint16_t pick(uint32_t random) const {
+        uint32_t column = ((random >> 16) * (uint32_t)threshold_.size()) >> 16;
+        uint32_t coin = random & 0xFFFF;
+        return (coin < threshold_[column]) ? column : alias_[column];
+    }
+
+    size_t size() const { return threshold_.size(); }
+    bool empty() const { return threshold_.empty(); }
+    uint32_t threshold(size_t column) const { return threshold_[column]; }
+    uint16_t alias(size_t column) const { return alias_[column]; }
+
+private:
+    std::vector<uint32_t> threshold_;
+    std::vector<uint16_t> alias_;
+};
+
+} // namespace BirdWatching
+
+#endif // BIRD_ALIAS_TABLE_H
@@ -1,8 +1,10 @@
 #include "bird_animation.h"
 #include "bird_utils.h"
+#include "frame_upscaler.h"
+#include "bird_catalog.h"
 #include "system/logging/log_manager.h"
-#include "hal/sd_interface.h"
 #include "system/tasks/task_manager.h"
+#include "system/logging/trace_buffer.h"
 #include <cstring>
 #include <cstdio>
 
@@ -14,21 +16,22 @@ BirdAnimation::BirdAnimation()
     , current_frame_count_(0)
     , play_timer_(nullptr)
     , is_playing_(false)
-    , frame_processing_(false)
-    , current_img_dsc_(nullptr)
-    , current_img_data_(nullptr)
-    , next_img_dsc_(nullptr)
-    , next_img_data_(nullptr)
-    , next_frame_ready_(false)
-    , preload_fail_count_(0)
-    , preload_enabled_(true)
+    , frame_late_(false)
+    , clip_start_time_(0)
+    , next_seq_(0)
+    , frame_interval_ms_(STREAMING_FRAME_INTERVAL_MS)
+    , current_slot_(nullptr)
+    , prefetcher_(frame_pool_, bundle_loader_)
     , running_in_ui_task_(false)
 {
+    memset(&display_dsc_, 0, sizeof(display_dsc_));
+    memset(&dirty_stats_, 0, sizeof(dirty_stats_));
+    memset(&clip_stats_, 0, sizeof(clip_stats_));
+    memset(&last_clip_stats_, 0, sizeof(last_clip_stats_));
 }
 
 BirdAnimation::~BirdAnimation() {
     stop();
-    releasePreviousFrame();
 }
 
 bool BirdAnimation::init(lv_obj_t* parent_obj) {
@@ -61,7 +64,11 @@ bool BirdAnimation::init(lv_obj_t* parent_obj) {
         }
 
         display_obj_ = lv_image_create(parent_obj);
-        
+        if (display_obj_) {
+            // 设置位置（缩放后会自动调整大小）
+            lv_obj_set_pos(display_obj_, 0, 0);
+        }
+
         if (needRelease) {
             taskMgr->giveLVGLMutex();
         }
@@ -70,9 +77,12 @@ bool BirdAnimation::init(lv_obj_t* parent_obj) {
             LOG_ERROR("ANIM", "Failed to create LVGL image object");
             return false;
         }
+    }
 
-        // 设置位置（缩放后会自动调整大小）
-        lv_obj_set_pos(display_obj_, 0, 0);
+    // 启动帧预取任务（播放期间所有SD卡读取都在预取任务中完成）
+    if (!prefetcher_.begin()) {
+        LOG_ERROR("ANIM", "Failed to start frame prefetcher");
+        return false;
     }
 
     LOG_INFO("ANIM", "Bird animation system initialized");
@@ -80,8 +90,18 @@ bool BirdAnimation::init(lv_obj_t* parent_obj) {
 }
 
 bool BirdAnimation::loadBird(const BirdInfo& bird_info) {
-    // 停止当前动画
-    stop();
+    // LVGL仍引用帧槽时不能替换bundle和帧池
+    if (play_timer_ || current_slot_) {
+        LOG_ERROR("ANIM", "Animation still attached, detach() before loading");
+        return false;
+    }
+
+    // 等待预取任务空闲（不持LVGL锁，另一核可以继续渲染）
+    // 超时时任务可能仍在读当前bundle、写帧槽，不能替换它们
+    if (!stopPrefetch()) {
+        LOG_ERROR("ANIM", "Prefetch task still busy, not loading bird " + String(bird_info.id));
+        return false;
+    }
 
     // 设置小鸟信息
     current_bird_ = bird_info;
@@ -97,16 +117,48 @@ bool BirdAnimation::loadBird(const BirdInfo& bird_info) {
         return false;
     }
 
+    // 按bundle帧尺寸准备帧池（尺寸不变时直接复用，不会重新分配）
+    // 启用预放大时每个槽额外准备4倍大小的放大缓冲区，分配失败则退回LVGL缩放
+    uint32_t frame_bytes = bundle_loader_.getFrameDataSize();
+    bool reserved = false;
+    if (FrameUpscaler::enabled()) {
+        reserved = frame_pool_.reserve(frame_bytes, frame_bytes * 4);
+        if (!reserved) {
+            LOG_WARN("ANIM", "No memory for 2x upscale buffers, falling back to LVGL zoom");
+        }
+    }
+    if (!reserved) {
+        reserved = frame_pool_.reserve(frame_bytes);
+    }
+    if (!reserved) {
+        LOG_ERROR("ANIM", "Failed to reserve frame pool for " + String(bundle_path));
+        bundle_loader_.close();
+        return false;
+    }
+
     // 从bundle获取帧数
     current_frame_count_ = bundle_loader_.getFrameCount();
-    LOG_INFO("ANIM", "Bundle loaded: " + String(current_frame_count_) + " frames from " + String(bundle_path));
+
+    // bundle在目录缓存之后被替换（例如直接在电脑上拷贝），让缓存下次开机重建
+    if (bird_info.bundle_size && bird_info.bundle_size != bundle_loader_.getBundleSize()) {
+        LOG_WARN("ANIM", "Bundle size differs from catalog for bird " + String(bird_info.id));
+        BirdCatalog::invalidate();
+    }
+
+    // 常驻PSRAM时不再受SD卡带宽限制，可以使用更短的帧间隔
+    frame_interval_ms_ = bundle_loader_.isResident() ? RESIDENT_FRAME_INTERVAL_MS
+                                                     : STREAMING_FRAME_INTERVAL_MS;
+
+    LOG_INFO("ANIM", "Bundle loaded: " + String(current_frame_count_) + " frames from " + String(bundle_path) +
+             (bundle_loader_.isResident() ? " (resident)" : " (streaming)"));
 
     return true;
 }
 
 void BirdAnimation::startLoop() {
-    if (is_playing_) {
-        stop();
+    if (is_playing_ && !stop()) {
+        LOG_ERROR("ANIM", "Prefetch task still busy, not restarting animation");
+        return;
     }
 
     if (current_bird_.id == 0) {
@@ -119,54 +171,78 @@ void BirdAnimation::startLoop() {
         return;
     }
 
-    // 重置到第一帧
+    // 重置到第一帧，新片段的时间基准在第一帧显示时确定
     current_frame_ = 0;
-    frame_processing_ = false;
-    next_frame_ready_ = false;
-    preload_fail_count_ = 0;
-    preload_enabled_ = true;  // 25MHz SD卡：启用预加载优化
-
-    // 加载并显示第一帧
-    if (!loadAndShowFrame(0)) {
-        LOG_ERROR("ANIM", "Failed to load first frame");
-        return;
-    }
+    frame_late_ = false;
+    clip_start_time_ = 0;
+    next_seq_ = 0;
+    memset(&clip_stats_, 0, sizeof(clip_stats_));
+    clip_stats_.bird_id = current_bird_.id;
+    clip_stats_.target_fps = 1000 / frame_interval_ms_;
 
-    // 设置第一帧处理完成的时间，确保第一帧显示足够时间
-    last_frame_time_ = millis();
+    // 预取任务从第一帧开始读取，第一帧就绪后立即显示
+    prefetcher_.start(0, current_frame_count_);
 
     is_playing_ = true;
+    frame_pool_.setPlaybackActive(true);
 
-    // 创建播放定时器，20ms周期检查
-    play_timer_ = lv_timer_create(timerCallback, 20, this);
+    // 创建播放定时器：每次回调后把周期设为距下一帧截止时间的剩余时长
+    play_timer_ = lv_timer_create(timerCallback, UNDERRUN_RETRY_MS, this);
     if (!play_timer_) {
         LOG_ERROR("ANIM", "Failed to create animation timer");
+        prefetcher_.cancel();
         is_playing_ = false;
         return;
     }
 
-    LOG_INFO("ANIM", "Animation started at 20 FPS (50ms/frame) with 25MHz SD card");
+    LOG_INFO("ANIM", "Animation started at " + String(1000 / frame_interval_ms_) + " FPS (" +
+             String(frame_interval_ms_) + "ms/frame, " +
+             String(bundle_loader_.isResident() ? "resident" : "streaming") + ")");
 }
 
-void BirdAnimation::stop() {
+bool BirdAnimation::stop() {
+    ClipStats finished;
+    bool clip_finished = detach(&finished);
+    bool stopped = stopPrefetch();
+
+    if (clip_finished) {
+        logClip(finished);
+    }
+    LOG_INFO("ANIM", "Animation stopped");
+    return stopped;
+}
+
+bool BirdAnimation::detach(ClipStats* finished) {
+    bool clip_finished = clip_stats_.frames_shown > 0;
+    if (clip_finished) {
+        if (finished) {
+            *finished = clip_stats_;
+        }
+        finishClip();
+    }
+
     if (play_timer_) {
         lv_timer_del(play_timer_);  // LVGL 9.x: lv_task_del → lv_timer_del
         play_timer_ = nullptr;
     }
     is_playing_ = false;
-    frame_processing_ = false;
+    frame_late_ = false;
     current_frame_ = 0;
-    last_frame_time_ = 0;
+    clip_start_time_ = 0;
+    next_seq_ = 0;
+    frame_pool_.setPlaybackActive(false);
 
-    // 释放图像内存
-    releasePreviousFrame();
-
-    // 清除显示内容
+    // 清除显示内容（解除LVGL对帧槽的引用，环形队列在下次start时重置）
     if (display_obj_) {
         lv_image_set_src(display_obj_, nullptr);  // LVGL 9.x: lv_img_set_src → lv_image_set_src
     }
+    current_slot_ = nullptr;
+    return clip_finished;
+}
 
-    LOG_INFO("ANIM", "Animation stopped");
+bool BirdAnimation::stopPrefetch() {
+    // 停止预取任务后bundle和帧池才能被关闭或重新分配
+    return prefetcher_.cancel();
 }
 
 void BirdAnimation::setDisplayObject(lv_obj_t* obj) {
@@ -176,387 +252,202 @@ void BirdAnimation::setDisplayObject(lv_obj_t* obj) {
     display_obj_ = obj;
 }
 
-std::string BirdAnimation::getFramePath(uint16_t frame_index) const {
-    char path[128];
-    snprintf(path, sizeof(path), "/birds/%d/%d.bin",
-             current_bird_.id, frame_index + 1); // 从1开始编号，格式为1.bin, 2.bin等
-    return std::string(path);
-}
+void BirdAnimation::showSlot(FrameSlot* slot) {
+    bool same_layout = current_slot_ &&
+                       display_dsc_.header.w == slot->dsc.header.w &&
+                       display_dsc_.header.h == slot->dsc.header.h &&
+                       display_dsc_.header.cf == slot->dsc.header.cf;
+
+    if (same_layout) {
+        // 只替换像素指针，按脏区局部刷新
+        display_dsc_.data = slot->dsc.data;
+        display_dsc_.data_size = slot->dsc.data_size;
+
+        if (slot->changed) {
+            invalidateImageArea(slot->dirty);
+            dirty_stats_.frames_partial++;
+        } else {
+            dirty_stats_.frames_unchanged++;
+        }
+    } else {
+        // 首帧或尺寸变化：设置图像源（整个对象失效）
+        display_dsc_ = slot->dsc;
+        lv_image_set_src(display_obj_, &display_dsc_);
 
-bool BirdAnimation::loadAndShowFrame(uint16_t frame_index) {
-    if (!display_obj_) {
-        LOG_ERROR("ANIM", "Display object not set");
-        return false;
-    }
+        // 设置缩放中心点为图像中心
+        lv_img_set_pivot(display_obj_, slot->dsc.header.w / 2, slot->dsc.header.h / 2);
 
-    if (frame_index >= current_frame_count_) {
-        LOG_ERROR("ANIM", "Frame index " + String(frame_index) + " out of range");
-        return false;
-    }
+        // 应用缩放（已在预取任务中放大时以1倍绘制，LVGL直接拷贝不做变换）
+        uint16_t zoom = slot->upscaled ? DISPLAY_ZOOM / 2 : DISPLAY_ZOOM;
+        lv_img_set_zoom(display_obj_, zoom);
 
-    // 释放前一帧
-    releasePreviousFrame();
+        // 设置图像位置到canvas中心
+        lv_obj_center(display_obj_);
 
-    // 从bundle加载帧
-    lv_image_dsc_t* img_dsc = nullptr;
-    uint8_t* img_data = nullptr;
+        // 确保对象可见
+        lv_obj_clear_flag(display_obj_, LV_OBJ_FLAG_HIDDEN);
 
-    if (!bundle_loader_.loadFrame(frame_index, &img_dsc, &img_data)) {
-        LOG_ERROR("ANIM", "Failed to load frame " + String(frame_index) + " from bundle");
-        return false;
-    }
+        // 记录开机到第一帧小鸟画面的时间（对比目录缓存前后的启动耗时）
+        static bool first_frame_logged = false;
+        if (!first_frame_logged) {
+            first_frame_logged = true;
+            LOG_INFO("ANIM", "First bird frame shown " + String(millis()) + "ms after boot");
+        }
 
-    if (!img_dsc || !img_data) {
-        LOG_ERROR("ANIM", "Bundle loader returned null pointers");
-        return false;
+        dirty_stats_.frames_full++;
+        dirty_stats_.pixels_invalidated += (uint64_t)slot->dsc.header.w * slot->dsc.header.h *
+                                           (zoom / 256) * (zoom / 256);
     }
 
-    // 保存当前帧引用
-    current_img_dsc_ = img_dsc;
-    current_img_data_ = img_data;
-
-    // 设置图像源
-    lv_image_set_src(display_obj_, img_dsc);
-
-    // 计算缩放比例 - canvas是240x240，图像是120x120，需要2倍缩放
-    // LVGL缩放：256 = 1.0x, 512 = 2.0x
-    uint16_t zoom_factor = 512; // 2.0x缩放
-
-    // 设置缩放中心点为图像中心
-    lv_img_set_pivot(display_obj_, img_dsc->header.w / 2, img_dsc->header.h / 2);
-
-    // 应用缩放
-    lv_img_set_zoom(display_obj_, zoom_factor);
+    // LVGL已切换到新槽，归还之前显示的槽（环形队列按顺序归还，即最早取出的槽）
+    if (current_slot_) {
+        prefetcher_.releaseOldest();
+    }
+    current_slot_ = slot;
+}
 
-    // 设置图像位置到canvas中心
-    lv_obj_center(display_obj_);
+void BirdAnimation::invalidateImageArea(const lv_area_t& area) {
+    lv_area_t obj_coords;
+    lv_obj_get_coords(display_obj_, &obj_coords);
 
-    // 确保对象可见
-    lv_obj_clear_flag(display_obj_, LV_OBJ_FLAG_HIDDEN);
+    lv_point_t pivot;
+    lv_image_get_pivot(display_obj_, &pivot);
+    int32_t scale = lv_image_get_scale(display_obj_);
 
-    // 强制刷新LVGL显示
-    lv_obj_invalidate(display_obj_);
+    // 以pivot为中心缩放：屏幕坐标 = 对象原点 + pivot + (图像坐标 - pivot) * scale
+    // 四周各留1像素余量，避免缩放取整造成残影
+    lv_area_t screen_area;
+    screen_area.x1 = obj_coords.x1 + pivot.x + ((area.x1 - pivot.x) * scale) / 256 - 1;
+    screen_area.y1 = obj_coords.y1 + pivot.y + ((area.y1 - pivot.y) * scale) / 256 - 1;
+    screen_area.x2 = obj_coords.x1 + pivot.x + ((area.x2 + 1 - pivot.x) * scale) / 256;
+    screen_area.y2 = obj_coords.y1 + pivot.y + ((area.y2 + 1 - pivot.y) * scale) / 256;
 
-    return true;
+    lv_obj_invalidate_area(display_obj_, &screen_area);
+    dirty_stats_.pixels_invalidated += (uint64_t)lv_area_get_size(&screen_area);
 }
 
 void BirdAnimation::playNextFrame() {
-    if (!is_playing_ || frame_processing_ || !display_obj_) {
+    if (!is_playing_ || !display_obj_) {
         return;
     }
 
-    // 检查是否到了播放下一帧的时间
-    // 25MHz SD卡速度：~1.5MB/s，每帧加载~18ms
-    // 加上vTaskDelay(1)的10ms，总计约30ms，可以支持30+ FPS
+    // 还没到下一帧的截止时间（片段第一帧就绪后立即显示）
     uint32_t now = millis();
-    const uint32_t FRAME_INTERVAL_MS = 66; // 15 FPS - 平衡流畅度和看门狗安全
-    
-    if (now - last_frame_time_ < FRAME_INTERVAL_MS) {
-        // 利用空闲时间预加载下一帧（25MHz SD卡足够快）
-        if (preload_enabled_ && !next_frame_ready_) {
-            uint16_t next_frame = (current_frame_ + 1) % current_frame_count_;
-            
-            // 检查剩余时间是否足够预加载（至少需要20ms）
-            uint32_t time_left = FRAME_INTERVAL_MS - (now - last_frame_time_);
-            if (time_left >= 20) {
-                bool success = preloadFrameToBuffer(next_frame, &next_img_dsc_, &next_img_data_);
-                if (success && next_img_dsc_ && next_img_data_) {
-                    next_frame_ready_ = true;
-                    preload_fail_count_ = 0;
-                } else {
-                    preload_fail_count_++;
-                    if (preload_fail_count_ >= 3) {
-                        preload_enabled_ = false;
-                        Serial.println("[WARN] Preload disabled (memory low)");
-                    }
-                }
-            }
+    if (current_slot_) {
+        int32_t wait_ms = (int32_t)(frameDeadline(next_seq_) - now);
+        if (wait_ms > 0) {
+            scheduleTimer(wait_ms);
+            return;
         }
-        return;
     }
 
-    // 标记开始处理帧
-    frame_processing_ = true;
-    uint32_t frame_start = millis();
-
-    current_frame_++;
-    if (current_frame_ >= current_frame_count_) {
-        current_frame_ = 0;
-    }
-
-    // 如果下一帧已预加载，直接使用（双缓冲）
-    if (next_frame_ready_ && next_img_dsc_ && next_img_data_) {
-        // 释放当前帧
-        if (current_img_data_) free(current_img_data_);
-        if (current_img_dsc_) free(current_img_dsc_);
-        
-        // 交换缓冲区
-        current_img_dsc_ = next_img_dsc_;
-        current_img_data_ = next_img_data_;
-        next_img_dsc_ = nullptr;
-        next_img_data_ = nullptr;
-        next_frame_ready_ = false;
-        
-        // 显示预加载的帧
-        lv_image_set_src(display_obj_, current_img_dsc_);
-        
-        if (current_img_dsc_) {
-            lv_img_set_pivot(display_obj_, current_img_dsc_->header.w / 2, current_img_dsc_->header.h / 2);
-            lv_img_set_zoom(display_obj_, 512); // 2.0x
-            lv_obj_center(display_obj_);
-            lv_obj_clear_flag(display_obj_, LV_OBJ_FLAG_HIDDEN);
-        }
-        
-        // 让出CPU给看门狗任务，防止触发看门狗超时
-        vTaskDelay(1); // 延迟1个tick (~10ms)
-    } else {
-        // 预加载失败或未启用，实时加载
-        if (next_img_data_) free(next_img_data_);
-        if (next_img_dsc_) free(next_img_dsc_);
-        next_img_data_ = nullptr;
-        next_img_dsc_ = nullptr;
-        next_frame_ready_ = false;
-        
-        if (!loadAndShowFrame(current_frame_)) {
-            stop();
-            frame_processing_ = false;
+    // 从预取环取出下一帧，UI任务不访问SD卡
+    FrameSlot* slot = prefetcher_.takeReady();
+    if (!slot) {
+        if (prefetcher_.hasFailed()) {
+            LOG_ERROR("ANIM", "Frame prefetch failed for bird " + String(current_bird_.id));
+            // 定时器回调中持有LVGL锁，只解除显示，预取任务在下次加载前停止；
+            // 出错路径很少走到，片段统计与上面的错误一样直接在锁内输出
+            ClipStats finished;
+            if (detach(&finished)) {
+                logClip(finished);
+            }
             return;
         }
-        
-        // 实时加载更耗时，也要让出CPU
-        vTaskDelay(1);
-    }
-    
-    uint32_t load_time = millis() - frame_start;
-    if (load_time > FRAME_INTERVAL_MS) {
-        Serial.printf("[WARN] Frame %d load: %dms (target: %dms)\n", current_frame_, load_time, FRAME_INTERVAL_MS);
-    }
-
-    last_frame_time_ = millis();
-    frame_processing_ = false;
-}
-
-
-bool BirdAnimation::tryManualImageLoad(const std::string& file_path) {
-    // 使用项目的SD卡接口
-    fs::FS& fs = HAL::SDInterface::getFS();
-    File file = fs.open(file_path.c_str());
-    if (!file) {
-        return false;
-    }
-
-    size_t file_size = file.size();
-    
-    if (file_size < 32) { // LVGL 9.x最小头部大小
-        file.close();
-        return false;
-    }
-
-    // 读取LVGL 9.x头部
-    uint32_t header_cf, flags, stride, reserved_2, data_size;
-    uint16_t width, height;
-
-    if (file.read((uint8_t*)&header_cf, sizeof(header_cf)) != sizeof(header_cf) ||
-        file.read((uint8_t*)&flags, sizeof(flags)) != sizeof(flags) ||
-        file.read((uint8_t*)&width, sizeof(width)) != sizeof(width) ||
-        file.read((uint8_t*)&height, sizeof(height)) != sizeof(height) ||
-        file.read((uint8_t*)&stride, sizeof(stride)) != sizeof(stride) ||
-        file.read((uint8_t*)&reserved_2, sizeof(reserved_2)) != sizeof(reserved_2) ||
-        file.read((uint8_t*)&data_size, sizeof(data_size)) != sizeof(data_size)) {
-        LOG_ERROR("BIRD", "Failed to read LVGL 9.x header");
-        file.close();
-        return false;
-    }
-
-    // 验证LVGL 9.x文件格式
-    uint8_t color_format = header_cf & 0xFF;
-    uint8_t magic = (header_cf >> 24) & 0xFF;
-
-    if (color_format != 0x12) { // LVGL 9.x: LV_COLOR_FORMAT_RGB565 = 0x12
-        LOG_ERROR("BIRD", "Invalid color format: 0x" + String(color_format, HEX));
-        file.close();
-        return false;
+        // 下一帧还没读完，继续显示当前帧（截止时间不后移，就绪后按需丢帧追赶）
+        if (current_slot_ && !frame_late_) {
+            prefetcher_.countUnderrun();
+            TRACE_EVENT(TRACE_FRAME_UNDERRUN, 0);
+            frame_late_ = true;
+        }
+        scheduleTimer(UNDERRUN_RETRY_MS);
+        return;
     }
-
-    if (magic != 0x37) { // LVGL 9.x magic number
-        LOG_ERROR("BIRD", "Invalid magic number: 0x" + String(magic, HEX));
-        file.close();
-        return false;
+    frame_late_ = false;
+
+    if (!current_slot_) {
+        // 片段第一帧：以实际显示时间为基准，打开bundle的耗时不计入延迟
+        clip_start_time_ = now;
+        next_seq_ = 0;
+    }
+    uint32_t seq = next_seq_++;
+
+    // 落后时丢帧：后一帧的截止时间也已过且已就绪，就跳过当前帧，
+    // 被跳过帧相对上一帧的变化区域并入实际显示的帧
+    uint32_t skipped = 0;
+    while ((int32_t)(now - frameDeadline(next_seq_)) >= 0 && prefetcher_.readyCount() > 0) {
+        FrameSlot* newer = prefetcher_.takeReady();
+        if (slot->changed) {
+            if (newer->changed) {
+                newer->dirty.x1 = LV_MIN(newer->dirty.x1, slot->dirty.x1);
+                newer->dirty.y1 = LV_MIN(newer->dirty.y1, slot->dirty.y1);
+                newer->dirty.x2 = LV_MAX(newer->dirty.x2, slot->dirty.x2);
+                newer->dirty.y2 = LV_MAX(newer->dirty.y2, slot->dirty.y2);
+            } else {
+                newer->dirty = slot->dirty;
+                newer->changed = true;
+            }
+        }
+        slot = newer;
+        seq = next_seq_++;
+        skipped++;
     }
 
-    // 验证数据大小
-    if (data_size != width * height * 2) {
-        file.close();
-        return false;
+    showSlot(slot);
+    current_frame_ = slot->frame_index;
+    TRACE_EVENT(TRACE_FRAME_SHOW, current_frame_);
+    if (skipped) {
+        TRACE_EVENT(TRACE_FRAME_SKIP, skipped);
     }
 
-    // 检查可用内存
-    size_t free_heap = ESP.getFreeHeap();
-    // LOG_DEBUG("ANIM", "Loading " + String(file_path.c_str()) + ", file_size: " + String(data_size) + ", free_heap: " + String(free_heap)); // 注释掉以避免日志洪流
-
-    if (free_heap < data_size + 4096) { // 预留4KB额外空间
-        LOG_ERROR("ANIM", "Insufficient memory - need " + String(data_size) + " + 4096, have " + String(free_heap));
-        file.close();
-        return false;
+    // showSlot只归还之前显示的槽，被跳过的槽按取出顺序随后归还
+    for (uint32_t i = 0; i < skipped; i++) {
+        prefetcher_.releaseOldest();
     }
 
-    // 分配内存
-    lv_image_dsc_t* img_dsc = static_cast<lv_image_dsc_t*>(malloc(sizeof(lv_image_dsc_t)));
-    if (!img_dsc) {
-        LOG_ERROR("BIRD", "Failed to allocate descriptor");
-        file.close();
-        return false;
+    // 更新片段统计
+    uint32_t late_ms = now - frameDeadline(seq);
+    clip_stats_.frames_shown++;
+    clip_stats_.frames_skipped += skipped;
+    if (late_ms > frame_interval_ms_ / 4) {
+        clip_stats_.frames_late++;
     }
-
-    uint8_t* img_data = static_cast<uint8_t*>(malloc(data_size));
-    if (!img_data) {
-        LOG_ERROR("BIRD", "Failed to allocate image data");
-        free(img_dsc);
-        file.close();
-        return false;
+    if (late_ms > clip_stats_.max_late_ms) {
+        clip_stats_.max_late_ms = late_ms;
     }
-
-    // 读取像素数据 - 性能分析
-    static uint8_t perf_log_count = 0;
-    uint32_t read_start = millis();
-    size_t bytes_read = file.read(img_data, data_size);
-    uint32_t read_time = millis() - read_start;
-    file.close();
-
-    // 前3帧输出性能日志到串口
-    if (perf_log_count < 3) {
-        Serial.printf("[PERF] SD read %uB in %ums (%u KB/s)\n", 
-                      data_size, read_time, data_size * 1000 / read_time / 1024);
-        perf_log_count++;
+    clip_stats_.duration_ms = now - clip_start_time_;
+    if (clip_stats_.duration_ms > 0) {
+        clip_stats_.achieved_fps_x10 = (uint32_t)((uint64_t)(clip_stats_.frames_shown - 1) * 10000 /
+                                                  clip_stats_.duration_ms);
     }
-
-    if (bytes_read != data_size) {
-        LOG_ERROR("BIRD", "Failed to read pixel data: " + String(bytes_read) + "/" + String(data_size));
-        free(img_dsc);
-        free(img_data);
-        return false;
+    if (skipped) {
+        LOG_DEBUGF("ANIM", "Frame %d late %lums, skipped %u", current_frame_, (unsigned long)late_ms,
+                   (unsigned)skipped);
     }
 
-    // 设置LVGL图像描述符 - LVGL 9.x格式
-    img_dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
-    img_dsc->header.cf = color_format;  // 0x12 for RGB565
-    img_dsc->header.flags = 0;
-    img_dsc->header.w = width;
-    img_dsc->header.h = height;
-    img_dsc->header.stride = width * 2;  // RGB565每像素2字节
-    img_dsc->header.reserved_2 = 0;
-    img_dsc->data_size = data_size;
-    img_dsc->data = img_data;
-
-    
-    // 释放前一帧的内存
-    releasePreviousFrame();
-
-    // 保存当前帧的引用
-    current_img_dsc_ = img_dsc;
-    current_img_data_ = img_data;
-
-    // 设置图像源
-    lv_image_set_src(display_obj_, img_dsc);  // LVGL 9.x: lv_img_set_src → lv_image_set_src
-
-    // 计算缩放比例 - canvas现在是240x240，图像是120x120，需要2倍缩放
-    // LVGL缩放：256 = 1.0x, 512 = 2.0x
-    uint16_t zoom_factor = 512; // 2.0x缩放
-
-    // 设置缩放中心点为图像中心
-    lv_img_set_pivot(display_obj_, width / 2, height / 2);
-
-    // 应用缩放
-    lv_img_set_zoom(display_obj_, zoom_factor);
-
-    // 设置图像位置到canvas中心
-    lv_obj_center(display_obj_);
-
-    // 确保对象可见 - LVGL 9.x: lv_obj_set_hidden被移除，使用add_state/clear_state
-    lv_obj_clear_flag(display_obj_, LV_OBJ_FLAG_HIDDEN);
-
-    // 测试已完成，现在显示真实图像
-    // if (false) { // 改为false来显示真实图像
-    //     createTestImage();
-    //     return true;
-    // }
-
-    return true;
+    // 下次在下一帧的截止时间触发
+    int32_t wait_ms = (int32_t)(frameDeadline(next_seq_) - millis());
+    scheduleTimer(wait_ms > 0 ? wait_ms : 1);
 }
 
-void BirdAnimation::releasePreviousFrame() {
-    // 释放前一帧的内存
-    if (current_img_data_) {
-        free(current_img_data_);
-        current_img_data_ = nullptr;
-    }
-
-    if (current_img_dsc_) {
-        free(current_img_dsc_);
-        current_img_dsc_ = nullptr;
-    }
-    
-    // 释放预加载缓冲区
-    if (next_img_data_) {
-        free(next_img_data_);
-        next_img_data_ = nullptr;
-    }
-
-    if (next_img_dsc_) {
-        free(next_img_dsc_);
-        next_img_dsc_ = nullptr;
-    }
-    
-    next_frame_ready_ = false;
-}
-
-void BirdAnimation::createTestImage() {
-    // 创建一个120x120的红色测试图像
-    const int width = 120;
-    const int height = 120;
-    const size_t data_size = width * height * 2; // RGB565
-
-    // 释放前一帧
-    releasePreviousFrame();
-
-    // 分配内存
-    lv_image_dsc_t* img_dsc = static_cast<lv_image_dsc_t*>(malloc(sizeof(lv_image_dsc_t)));
-    uint8_t* img_data = static_cast<uint8_t*>(malloc(data_size));
-
-    if (!img_dsc || !img_data) {
-        LOG_ERROR("BIRD", "Failed to allocate test image");
-        if (img_dsc) free(img_dsc);
-        if (img_data) free(img_data);
+void BirdAnimation::scheduleTimer(uint32_t delay_ms) {
+    if (!play_timer_) {
         return;
     }
+    lv_timer_set_period(play_timer_, delay_ms ? delay_ms : 1);
+    lv_timer_reset(play_timer_);
+}
 
-    // 填充红色数据 (RGB565: 红色 = 0xF800)
-    uint16_t* pixel_data = (uint16_t*)img_data;
-    for (int i = 0; i < width * height; i++) {
-        pixel_data[i] = 0xF800; // 纯红色
-    }
-
-    // 设置图像描述符 - LVGL 9.x格式
-    img_dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
-    img_dsc->header.cf = 0x12; // LV_COLOR_FORMAT_RGB565
-    img_dsc->header.flags = 0;
-    img_dsc->header.w = width;
-    img_dsc->header.h = height;
-    img_dsc->header.stride = width * 2;
-    img_dsc->header.reserved_2 = 0;
-    img_dsc->data_size = data_size;
-    img_dsc->data = img_data;
-
-    // 保存引用
-    current_img_dsc_ = img_dsc;
-    current_img_data_ = img_data;
-
-    // 设置到显示对象
-    lv_image_set_src(display_obj_, img_dsc);  // LVGL 9.x: lv_img_set_src → lv_image_set_src
+void BirdAnimation::finishClip() {
+    last_clip_stats_ = clip_stats_;
+    memset(&clip_stats_, 0, sizeof(clip_stats_));
+}
 
-    // 拉伸到全屏显示
-    lv_obj_set_pos(display_obj_, 0, 0);
-    lv_obj_set_size(display_obj_, 240, 240); // 拉伸到全屏
+void BirdAnimation::logClip(const ClipStats& clip) {
+    LOG_INFOF("ANIM", "Clip bird %u: %u frames in %lums, %u.%u FPS (target %u), late %u, skipped %u, max late %lums",
+              clip.bird_id, clip.frames_shown, (unsigned long)clip.duration_ms,
+              clip.achieved_fps_x10 / 10, clip.achieved_fps_x10 % 10, clip.target_fps,
+              clip.frames_late, clip.frames_skipped, (unsigned long)clip.max_late_ms);
 }
 
 void BirdAnimation::timerCallback(lv_timer_t* timer) {
@@ -570,18 +461,4 @@ void BirdAnimation::timerCallback(lv_timer_t* timer) {
     animation->playNextFrame();
 }
 
-bool BirdAnimation::preloadFrameToBuffer(uint16_t frame_index, lv_image_dsc_t** out_dsc, uint8_t** out_data) {
-    if (!out_dsc || !out_data) {
-        LOG_ERROR("ANIM", "Invalid output parameters for preload");
-        return false;
-    }
-
-    if (frame_index >= current_frame_count_) {
-        return false;
-    }
-
-    // 使用bundle loader加载帧
-    return bundle_loader_.loadFrame(frame_index, out_dsc, out_data);
-}
-
 } // namespace BirdWatching
\ No newline at end of file
@@ -3,10 +3,31 @@
 
 #include "bird_types.h"
 #include "bird_bundle_loader.h"
+#include "frame_prefetcher.h"
 #include <string>
 
 namespace BirdWatching {
 
+// 局部刷新统计
+struct DirtyRectStats {
+    uint32_t frames_full;        // 整体刷新的帧数（首帧/尺寸变化）
+    uint32_t frames_partial;     // 只刷新变化区域的帧数
+    uint32_t frames_unchanged;   // 与上一帧相同、无需刷新的帧数
+    uint64_t pixels_invalidated; // 累计失效的屏幕像素数
+};
+
+// 单个片段（一只小鸟从开始播放到停止）的帧调度统计
+struct ClipStats {
+    uint16_t bird_id;            // 片段对应的小鸟
+    uint32_t target_fps;         // 目标帧率
+    uint32_t frames_shown;       // 实际显示的帧数
+    uint32_t frames_late;        // 显示时超过截止时间（容差为帧间隔的1/4）的帧数
+    uint32_t frames_skipped;     // 落后时丢弃未显示的帧数
+    uint32_t max_late_ms;        // 最大延迟
+    uint32_t duration_ms;        // 第一帧到最近一帧的时长
+    uint32_t achieved_fps_x10;   // 实际帧率（x10）
+};
+
 class BirdAnimation {
 public:
     BirdAnimation();
@@ -15,14 +36,32 @@ public:
     // 初始化动画系统
     bool init(lv_obj_t* parent_obj = nullptr);
 
-    // 加载小鸟动画
+    // 加载小鸟动画（读SD卡，不要持有LVGL锁；调用前须已detach；预取任务未能停止时返回false）
     bool loadBird(const BirdInfo& bird_info);
 
-    // 开始循环播放动画
+    // 开始循环播放动画（需持有LVGL锁）
     void startLoop();
 
-    // 停止当前动画
-    void stop();
+    // 停止当前动画（detach + stopPrefetch，并输出片段统计），返回预取任务是否已停止
+    bool stop();
+
+    /**
+     * 停止播放并解除LVGL对帧槽的引用，只修改LVGL对象（需持有LVGL锁）
+     *
+     * @param finished 非空时写入刚结束的片段统计，调用方释放锁后用logClip()输出
+     * @return 是否有片段结束
+     */
+    bool detach(ClipStats* finished = nullptr);
+
+    // 输出片段统计日志（不要持有LVGL锁）
+    static void logClip(const ClipStats& clip);
+
+    /**
+     * 停止预取任务，可能等待一次SD读取完成（不要持有LVGL锁）
+     *
+     * @return false表示等待超时，任务可能仍在访问bundle和帧池，不能替换它们
+     */
+    bool stopPrefetch();
 
     // 检查是否正在播放
     bool isPlaying() const { return is_playing_; }
@@ -33,34 +72,65 @@ public:
     // 设置显示对象
     void setDisplayObject(lv_obj_t* obj);
 
+    // 获取帧池统计（用于串口status输出）
+    const FramePoolStats& getFramePoolStats() const { return frame_pool_.getStats(); }
+
+    // 获取bundle加载器（用于查询常驻状态）
+    const BirdBundleLoader& getBundleLoader() const { return bundle_loader_; }
+
+    // 获取当前帧间隔（毫秒）
+    uint32_t getFrameInterval() const { return frame_interval_ms_; }
+
+    // 获取预取统计
+    const FramePrefetchStats& getPrefetchStats() const { return prefetcher_.getStats(); }
+
+    // 获取局部刷新统计
+    const DirtyRectStats& getDirtyRectStats() const { return dirty_stats_; }
+
+    // 当前片段和上一个片段的调度统计
+    const ClipStats& getClipStats() const { return clip_stats_; }
+    const ClipStats& getLastClipStats() const { return last_clip_stats_; }
+
 private:
+    // 帧间隔：流式模式受SD卡读取速度限制，常驻模式只剩刷新开销
+    static constexpr uint32_t STREAMING_FRAME_INTERVAL_MS = 66; // 15 FPS
+    static constexpr uint32_t RESIDENT_FRAME_INTERVAL_MS = 33;  // 30 FPS
+    // 截止时间已到但下一帧未就绪时的重试间隔
+    static constexpr uint32_t UNDERRUN_RETRY_MS = 5;
+
+    // canvas是240x240，图像是120x120，需要2倍缩放（LVGL缩放：256 = 1.0x）
+    // 启用预放大（BIRD_FRAME_UPSCALE）时帧已是240x240，按1倍显示
+    static constexpr uint16_t DISPLAY_ZOOM = 512;
+
     lv_obj_t* display_obj_;      // LVGL显示对象
     BirdInfo current_bird_;      // 当前小鸟信息
     uint16_t current_frame_;     // 当前帧（支持最多65535帧）
     uint16_t current_frame_count_; // 当前小鸟的实际帧数（支持最多65535帧）
     lv_timer_t* play_timer_;      // 播放定时器 (LVGL 9.x: lv_task_t → lv_timer_t)
     bool is_playing_;            // 播放状态
-    bool frame_processing_;      // 当前是否正在处理帧
-    uint32_t last_frame_time_;   // 上一帧处理完成的时间
+    bool frame_late_;            // 下一帧已到点但尚未就绪（欠载只计一次）
+    uint32_t clip_start_time_;   // 片段第一帧的显示时间，第n帧的截止时间 = clip_start_time_ + n * 帧间隔
+    uint32_t next_seq_;          // 下一个从预取环取出的帧在片段中的序号（循环播放时持续递增）
+    uint32_t frame_interval_ms_; // 当前帧间隔（根据bundle是否常驻决定）
+
+    // 帧调度统计
+    ClipStats clip_stats_;
+    ClipStats last_clip_stats_;
 
-    // 内存管理
-    lv_image_dsc_t* current_img_dsc_; // 当前图像描述符 (LVGL 9.x: lv_img_dsc_t → lv_image_dsc_t)
-    uint8_t* current_img_data_;     // 当前图像数据
+    // 帧槽管理（所有像素缓冲区来自frame_pool_，播放期间零分配）
+    FramePool frame_pool_;
+    FrameSlot* current_slot_;       // 当前显示的帧槽（由预取环取出，显示下一帧时归还）
 
-    // 双缓冲：预加载下一帧
-    lv_image_dsc_t* next_img_dsc_;  // 下一帧图像描述符
-    uint8_t* next_img_data_;        // 下一帧图像数据
-    bool next_frame_ready_;         // 下一帧是否已准备好
-    
-    // 预加载统计（用于自适应优化）
-    uint8_t preload_fail_count_;    // 连续预加载失败次数
-    bool preload_enabled_;          // 是否启用预加载
+    // LVGL图像对象始终引用这个描述符，换帧时只替换data指针，
+    // 避免lv_image_set_src每帧使整个对象失效
+    lv_image_dsc_t display_dsc_;
+    DirtyRectStats dirty_stats_;
 
-    // 释放前一帧的内存
-    void releasePreviousFrame();
+    // Bundle加载器（播放期间只由预取任务访问）
+    BirdBundleLoader bundle_loader_;
 
-    // 创建测试图像（调试用）
-    void createTestImage();
+    // 帧预取器（必须在frame_pool_和bundle_loader_之后声明）
+    FramePrefetcher prefetcher_;
 
     // 定时器回调函数
     static void timerCallback(lv_timer_t* timer);
@@ -68,29 +138,23 @@ private:
     // 标志：是否在UI任务中运行
     bool running_in_ui_task_;
 
-    // Bundle加载器
-    BirdBundleLoader bundle_loader_;
-
-    // 获取帧文件路径
-    std::string getFramePath(uint16_t frame_index) const;
+    // 按截止时间播放下一帧，落后时丢帧追赶
+    void playNextFrame();
 
-    // 加载并显示指定帧
-    bool loadAndShowFrame(uint16_t frame_index);
+    // 第seq帧的截止时间
+    uint32_t frameDeadline(uint32_t seq) const { return clip_start_time_ + seq * frame_interval_ms_; }
 
-    // 播放下一帧
-    void playNextFrame();
+    // 让播放定时器在指定毫秒后触发
+    void scheduleTimer(uint32_t delay_ms);
 
-    // 计划下一帧播放
-    void scheduleNextFrame();
+    // 结束当前片段：保存为上一个片段（持锁调用，不输出日志）
+    void finishClip();
 
-    // 手动加载图像（LVGL无法直接加载时使用）
-    bool tryManualImageLoad(const std::string& file_path);
+    // 显示帧槽中的图像，并归还之前显示的槽
+    void showSlot(FrameSlot* slot);
 
-    // 预加载图像到缓冲区
-    bool preloadFrameToBuffer(uint16_t frame_index, lv_image_dsc_t** out_dsc, uint8_t** out_data);
-    
-    // 交换当前帧和下一帧缓冲区
-    void swapBuffers();
+    // 将图像坐标中的区域按缩放换算为屏幕坐标后使其失效
+    void invalidateImageArea(const lv_area_t& area);
 };
 
 } // namespace BirdWatching
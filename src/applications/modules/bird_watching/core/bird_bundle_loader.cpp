@@ -1,20 +1,199 @@
 #include "bird_bundle_loader.h"
 #include "system/logging/log_manager.h"
+#include "system/logging/trace_buffer.h"
+#include <esp_heap_caps.h>
+#include <cstring>
 
 namespace BirdWatching {
 
 // Bundle文件魔数: "BIRD"
 constexpr uint32_t BUNDLE_MAGIC = 0x42495244;
-constexpr uint16_t BUNDLE_VERSION = 1;
+constexpr uint16_t BUNDLE_VERSION = 2;       // 支持的最高版本（v1仍可读取）
 constexpr uint8_t RGB565_COLOR_FORMAT = 0x12;
 
+namespace {
+    // 帧数据前的LVGL 9.x图像头部 (24字节，与rgb565.py写入的格式一致)
+    struct LvImageFileHeader {
+        uint32_t header_cf;   // magic(高8位) + color format(低8位)
+        uint32_t flags;
+        uint16_t width;
+        uint16_t height;
+        uint32_t stride;
+        uint32_t reserved_2;
+        uint32_t data_size;
+    } __attribute__((packed));
+
+    // 验证帧的LVGL头部
+    bool validateFrameHeader(const LvImageFileHeader& lv_header, uint16_t frame_index) {
+        uint8_t color_format = lv_header.header_cf & 0xFF;
+        uint8_t magic = (lv_header.header_cf >> 24) & 0xFF;
+
+        if (color_format != RGB565_COLOR_FORMAT || magic != 0x37) {
+            LOG_ERROR("BUNDLE", "Invalid LVGL format in frame " + String(frame_index) +
+                      ": cf=0x" + String(color_format, HEX) + ", magic=0x" + String(magic, HEX));
+            return false;
+        }
+        return true;
+    }
+
+    // 设置LVGL图像描述符 - LVGL 9.x格式
+    void fillDescriptor(FrameSlot& slot, const LvImageFileHeader& lv_header,
+                        const uint8_t* data, uint16_t frame_index) {
+        slot.dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+        slot.dsc.header.cf = lv_header.header_cf & 0xFF;
+        slot.dsc.header.flags = 0;
+        slot.dsc.header.w = lv_header.width;
+        slot.dsc.header.h = lv_header.height;
+        slot.dsc.header.stride = lv_header.width * 2;  // RGB565每像素2字节
+        slot.dsc.header.reserved_2 = 0;
+        slot.dsc.data_size = lv_header.data_size;
+        slot.dsc.data = data;
+        slot.frame_index = frame_index;
+        slot.upscaled = false;
+    }
+
+    // 将脏区设为整帧
+    void markFullFrame(FrameSlot& slot, uint16_t width, uint16_t height) {
+        slot.dirty.x1 = 0;
+        slot.dirty.y1 = 0;
+        slot.dirty.x2 = width - 1;
+        slot.dirty.y2 = height - 1;
+        slot.changed = true;
+    }
+
+    // 脏区初始化为空（x1 > x2）
+    void resetArea(lv_area_t& area, uint16_t width, uint16_t height) {
+        area.x1 = width;
+        area.y1 = height;
+        area.x2 = -1;
+        area.y2 = -1;
+    }
+
+    // 将线性像素区间[first, last]并入脏区（跨行时取整行宽度）
+    void addSpanToArea(lv_area_t& area, uint32_t first, uint32_t last, uint16_t width) {
+        int32_t y1 = first / width;
+        int32_t y2 = last / width;
+        int32_t x1 = (y1 == y2) ? (int32_t)(first % width) : 0;
+        int32_t x2 = (y1 == y2) ? (int32_t)(last % width) : width - 1;
+        if (x1 < area.x1) area.x1 = x1;
+        if (x2 > area.x2) area.x2 = x2;
+        if (y1 < area.y1) area.y1 = y1;
+        if (y2 > area.y2) area.y2 = y2;
+    }
+
+    /**
+     * 逐行比较两帧，得到变化区域的包围盒
+     *
+     * 先用memcmp从上下两端收缩行范围，再在剩余行中收缩列范围
+     */
+    void compareFrames(const uint16_t* prev, const uint16_t* cur, uint16_t width, uint16_t height,
+                       FrameSlot& slot) {
+        const size_t row_bytes = (size_t)width * 2;
+        int32_t y1 = 0;
+        while (y1 < height && memcmp(prev + y1 * width, cur + y1 * width, row_bytes) == 0) {
+            y1++;
+        }
+        if (y1 == height) {
+            slot.changed = false;
+            return;
+        }
+
+        int32_t y2 = height - 1;
+        while (y2 > y1 && memcmp(prev + y2 * width, cur + y2 * width, row_bytes) == 0) {
+            y2--;
+        }
+
+        int32_t x1 = width - 1;
+        int32_t x2 = 0;
+        for (int32_t y = y1; y <= y2; y++) {
+            const uint16_t* p = prev + y * width;
+            const uint16_t* c = cur + y * width;
+            for (int32_t x = 0; x < x1; x++) {
+                if (p[x] != c[x]) { x1 = x; break; }
+            }
+            for (int32_t x = width - 1; x > x2; x--) {
+                if (p[x] != c[x]) { x2 = x; break; }
+            }
+        }
+
+        slot.dirty.x1 = x1;
+        slot.dirty.y1 = y1;
+        slot.dirty.x2 = x2;
+        slot.dirty.y2 = y2;
+        slot.changed = true;
+    }
+
+    /**
+     * 解码v2游程流（RLE/DELTA共用）
+     *
+     * @param fill_key true: 跳过段填充key（RLE）；false: 跳过段保留dst原有像素（DELTA）
+     * @param literal_area 非空时并入所有字面量游程覆盖的区域（DELTA的脏区）
+     */
+    bool decodeRuns(const uint8_t* src, uint32_t length, uint16_t* dst, uint32_t pixel_count,
+                    bool fill_key, uint16_t key, uint16_t width, lv_area_t* literal_area) {
+        const uint8_t* end = src + length;
+        uint32_t pos = 0;
+
+        while (src < end) {
+            uint8_t op = *src++;
+            uint32_t count = op & 0x3F;
+            if (op & 0x40) {
+                if (src >= end) return false;
+                count = (count << 8) | *src++;
+            }
+            count++;
+
+            if (count > pixel_count - pos) return false;
+
+            if (op & 0x80) {
+                uint32_t bytes = count * 2;
+                if ((uint32_t)(end - src) < bytes) return false;
+                memcpy(dst + pos, src, bytes);
+                src += bytes;
+                if (literal_area) {
+                    addSpanToArea(*literal_area, pos, pos + count - 1, width);
+                }
+            } else if (fill_key) {
+                uint16_t* p = dst + pos;
+                for (uint32_t i = 0; i < count; i++) {
+                    p[i] = key;
+                }
+            }
+            pos += count;
+        }
+
+        return pos == pixel_count;
+    }
+}
+
 BirdBundleLoader::BirdBundleLoader()
     : is_loaded_(false)
+    , resident_data_(nullptr)
+    , resident_capacity_(0)
+    , resident_budget_(BIRD_BUNDLE_RESIDENT_BUDGET)
+    , resident_(false)
+    , scratch_(nullptr)
+    , scratch_capacity_(0)
+    , last_decoded_(nullptr)
+    , last_decoded_index_(-1)
+    , bytes_read_(0)
+    , frames_read_(0)
 {
+    memset(&header_, 0, sizeof(header_));
 }
 
 BirdBundleLoader::~BirdBundleLoader() {
     close();
+    if (resident_data_) {
+        heap_caps_free(resident_data_);
+        resident_data_ = nullptr;
+        resident_capacity_ = 0;
+    }
+    if (scratch_) {
+        heap_caps_free(scratch_);
+        scratch_ = nullptr;
+        scratch_capacity_ = 0;
+    }
 }
 
 bool BirdBundleLoader::loadBundle(const std::string& bundle_path) {
@@ -26,7 +205,9 @@ bool BirdBundleLoader::loadBundle(const std::string& bundle_path) {
 
     // 打开bundle文件
     fs::FS& fs = HAL::SDInterface::getFS();
+    TRACE_EVENT(TRACE_SD_OPEN_BEGIN, 0);
     File file = fs.open(bundle_path.c_str());
+    TRACE_EVENT(TRACE_SD_OPEN_END, 0);
     if (!file) {
         LOG_ERROR("BUNDLE", "Failed to open bundle: " + String(bundle_path.c_str()));
         return false;
@@ -59,23 +240,106 @@ bool BirdBundleLoader::loadBundle(const std::string& bundle_path) {
         return false;
     }
 
+    // 优先整体读入PSRAM，之后播放不再访问SD卡
+    resident_ = loadResident(file);
     file.close();
 
-    // 重新打开文件并保持句柄以提升性能
-    fs::FS& fs_reopen = HAL::SDInterface::getFS();
-    bundle_file_ = fs_reopen.open(bundle_path.c_str());
-    if (!bundle_file_) {
-        LOG_WARN("BUNDLE", "Failed to keep bundle file open");
+    if (!resident_) {
+        // 流式模式：重新打开文件并保持句柄以提升性能
+        fs::FS& fs_reopen = HAL::SDInterface::getFS();
+        TRACE_EVENT(TRACE_SD_OPEN_BEGIN, 0);
+        bundle_file_ = fs_reopen.open(bundle_path.c_str());
+        TRACE_EVENT(TRACE_SD_OPEN_END, 0);
+        if (!bundle_file_) {
+            LOG_WARN("BUNDLE", "Failed to keep bundle file open");
+        }
+
+        // v2流式模式需要编码数据读取缓冲区（只增不减，播放期间不再分配）
+        if (isEncoded()) {
+            uint32_t needed = header_.max_encoded_size ? header_.max_encoded_size : getFrameDataSize();
+            if (needed > scratch_capacity_) {
+                if (scratch_) {
+                    heap_caps_free(scratch_);
+                }
+                scratch_ = static_cast<uint8_t*>(heap_caps_malloc(needed, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+                if (!scratch_) {
+                    scratch_ = static_cast<uint8_t*>(heap_caps_malloc(needed, MALLOC_CAP_8BIT));
+                }
+                scratch_capacity_ = scratch_ ? needed : 0;
+                if (!scratch_) {
+                    LOG_ERROR("BUNDLE", "Failed to allocate decode buffer: " + String(needed) + " bytes");
+                    bundle_file_.close();
+                    return false;
+                }
+            }
+        }
     }
 
+    last_decoded_ = nullptr;
+    last_decoded_index_ = -1;
+
     is_loaded_ = true;
-    LOG_INFO("BUNDLE", "Bundle loaded: " + String(header_.frame_count) + " frames, " +
-             String(header_.frame_width) + "x" + String(header_.frame_height));
+    LOG_INFO("BUNDLE", "Bundle v" + String(header_.version) + " loaded: " + String(header_.frame_count) + " frames, " +
+             String(header_.frame_width) + "x" + String(header_.frame_height) +
+             (resident_ ? ", resident" : ", streaming"));
 
     return true;
 }
 
-bool BirdBundleLoader::loadFrame(uint16_t frame_index, lv_image_dsc_t** out_dsc, uint8_t** out_data) {
+bool BirdBundleLoader::loadResident(File& file) {
+#ifdef BOARD_HAS_PSRAM
+    uint32_t file_size = file.size();
+    if (resident_budget_ == 0 || file_size == 0 || file_size > resident_budget_) {
+        return false;
+    }
+
+    // 头部记录的大小与实际文件不一致时不信任偏移，回退到流式读取
+    if (header_.total_size != 0 && header_.total_size != file_size) {
+        LOG_WARN("BUNDLE", "Bundle size mismatch: header " + String(header_.total_size) +
+                 ", file " + String(file_size));
+        return false;
+    }
+
+    // 常驻缓冲区只增不减，同尺寸或更小的bundle直接复用
+    if (file_size > resident_capacity_) {
+        if (resident_data_) {
+            heap_caps_free(resident_data_);
+            resident_data_ = nullptr;
+            resident_capacity_ = 0;
+        }
+        resident_data_ = static_cast<uint8_t*>(
+            heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        if (!resident_data_) {
+            LOG_WARN("BUNDLE", "No PSRAM for resident bundle (" + String(file_size) +
+                     " bytes), streaming instead");
+            return false;
+        }
+        resident_capacity_ = file_size;
+    }
+
+    // 一次顺序读完整个文件
+    unsigned long start_ms = millis();
+    file.seek(0);
+    TRACE_EVENT(TRACE_SD_READ_BEGIN, file_size > 0xFFFF ? 0xFFFF : file_size);
+    size_t bytes_read = file.read(resident_data_, file_size);
+    TRACE_EVENT(TRACE_SD_READ_END, 0);
+    if (bytes_read != file_size) {
+        LOG_WARN("BUNDLE", "Resident read incomplete: " + String(bytes_read) +
+                 "/" + String(file_size) + ", streaming instead");
+        return false;
+    }
+
+    header_.total_size = file_size;
+    LOG_INFO("BUNDLE", "Bundle resident in PSRAM: " + String(file_size / 1024) + " KB in " +
+             String(millis() - start_ms) + " ms");
+    return true;
+#else
+    (void)file;
+    return false;
+#endif
+}
+
+bool BirdBundleLoader::loadFrame(uint16_t frame_index, FrameSlot& slot) {
     if (!is_loaded_) {
         LOG_ERROR("BUNDLE", "Bundle not loaded");
         return false;
@@ -87,23 +351,114 @@ bool BirdBundleLoader::loadFrame(uint16_t frame_index, lv_image_dsc_t** out_dsc,
         return false;
     }
 
-    if (!out_dsc || !out_data) {
-        LOG_ERROR("BUNDLE", "Invalid output parameters");
-        return false;
+    if (isEncoded()) {
+        return loadEncodedFrame(frame_index, slot);
     }
 
     // 获取帧索引信息
     const FrameIndexEntry& entry = index_table_[frame_index];
 
-    // 优先使用保持打开的文件句柄，如果无效则重新打开
-    File* file_ptr = nullptr;
-    File temp_file;
-    
-    if (bundle_file_ && bundle_file_.available()) {
-        file_ptr = &bundle_file_;
+    if (resident_) {
+        return loadResidentFrame(frame_index, entry, slot);
+    }
+
+    if (!slot.buffer || slot.capacity == 0) {
+        LOG_ERROR("BUNDLE", "Invalid frame slot");
+        return false;
+    }
+
+    // 读取LVGL 9.x头部（一次读完，替代逐字段的小读）
+    LvImageFileHeader lv_header;
+    if (!readAt(entry.offset, (uint8_t*)&lv_header, sizeof(lv_header))) {
+        LOG_ERROR("BUNDLE", "Failed to read LVGL header for frame " + String(frame_index));
+        return false;
+    }
+
+    if (!validateFrameHeader(lv_header, frame_index)) {
+        return false;
+    }
+
+    // 帧数据必须能放进槽中
+    uint32_t data_size = lv_header.data_size;
+    if (data_size > slot.capacity) {
+        LOG_ERROR("BUNDLE", "Frame " + String(frame_index) + " too large for slot: " +
+                  String(data_size) + " > " + String(slot.capacity));
+        return false;
+    }
+
+    // 读取像素数据
+    if (!readAt(entry.offset + sizeof(lv_header), slot.buffer, data_size)) {
+        LOG_ERROR("BUNDLE", "Failed to read pixel data for frame " + String(frame_index));
+        return false;
+    }
+
+    bytes_read_ += sizeof(lv_header) + data_size;
+    frames_read_++;
+
+    fillDescriptor(slot, lv_header, slot.buffer, frame_index);
+    updateDirtyArea(frame_index, slot.buffer, slot);
+    return true;
+}
+
+bool BirdBundleLoader::loadResidentFrame(uint16_t frame_index, const FrameIndexEntry& entry,
+                                         FrameSlot& slot) {
+    // 帧头和像素都必须落在常驻数据范围内
+    uint32_t total = header_.total_size;
+    if (entry.offset > total || total - entry.offset < sizeof(LvImageFileHeader)) {
+        LOG_ERROR("BUNDLE", "Frame " + String(frame_index) + " offset out of range: " +
+                  String(entry.offset));
+        return false;
+    }
+
+    LvImageFileHeader lv_header;
+    memcpy(&lv_header, resident_data_ + entry.offset, sizeof(lv_header));
+
+    if (!validateFrameHeader(lv_header, frame_index)) {
+        return false;
+    }
+
+    uint32_t data_offset = entry.offset + sizeof(LvImageFileHeader);
+    if (lv_header.data_size > total - data_offset) {
+        LOG_ERROR("BUNDLE", "Frame " + String(frame_index) + " data exceeds bundle: " +
+                  String(lv_header.data_size));
+        return false;
+    }
+
+    bytes_read_ += sizeof(lv_header) + lv_header.data_size;
+    frames_read_++;
+
+    // 零拷贝：描述符直接指向常驻数据
+    fillDescriptor(slot, lv_header, resident_data_ + data_offset, frame_index);
+    updateDirtyArea(frame_index, resident_data_ + data_offset, slot);
+    return true;
+}
+
+void BirdBundleLoader::updateDirtyArea(uint16_t frame_index, const uint8_t* pixels, FrameSlot& slot) {
+    // 上一帧仍完整可读且紧邻当前帧（含循环回到第一帧）时才能比较
+    uint16_t prev_index = frame_index == 0 ? header_.frame_count - 1 : frame_index - 1;
+    if (last_decoded_ && last_decoded_ != pixels && last_decoded_index_ == (int32_t)prev_index) {
+        compareFrames(reinterpret_cast<const uint16_t*>(last_decoded_),
+                      reinterpret_cast<const uint16_t*>(pixels),
+                      header_.frame_width, header_.frame_height, slot);
     } else {
+        markFullFrame(slot, header_.frame_width, header_.frame_height);
+    }
+
+    last_decoded_ = pixels;
+    last_decoded_index_ = frame_index;
+}
+
+bool BirdBundleLoader::readAt(uint32_t offset, uint8_t* dst, uint32_t length) {
+    // 优先使用保持打开的文件句柄（seek会清除EOF状态，循环回到第一帧时无需重新打开），
+    // 如果无效则临时打开
+    File temp_file;
+    File* file_ptr = &bundle_file_;
+
+    if (!bundle_file_) {
         fs::FS& fs = HAL::SDInterface::getFS();
+        TRACE_EVENT(TRACE_SD_OPEN_BEGIN, 0);
         temp_file = fs.open(bundle_path_.c_str());
+        TRACE_EVENT(TRACE_SD_OPEN_END, 0);
         if (!temp_file) {
             LOG_ERROR("BUNDLE", "Failed to open bundle for frame reading");
             return false;
@@ -111,87 +466,179 @@ bool BirdBundleLoader::loadFrame(uint16_t frame_index, lv_image_dsc_t** out_dsc,
         file_ptr = &temp_file;
     }
 
-    // 定位到帧数据位置
-    file_ptr->seek(entry.offset);
+    TRACE_EVENT(TRACE_SD_READ_BEGIN, length > 0xFFFF ? 0xFFFF : length);
+    bool ok = file_ptr->seek(offset) && file_ptr->read(dst, length) == length;
+    TRACE_EVENT(TRACE_SD_READ_END, 0);
 
-    // 读取LVGL 9.x头部 (32字节)
-    uint32_t header_cf, flags, stride, reserved_2, data_size;
-    uint16_t width, height;
+    if (file_ptr == &temp_file) {
+        temp_file.close();
+    }
+    return ok;
+}
 
-    if (file_ptr->read((uint8_t*)&header_cf, 4) != 4 ||
-        file_ptr->read((uint8_t*)&flags, 4) != 4 ||
-        file_ptr->read((uint8_t*)&width, 2) != 2 ||
-        file_ptr->read((uint8_t*)&height, 2) != 2 ||
-        file_ptr->read((uint8_t*)&stride, 4) != 4 ||
-        file_ptr->read((uint8_t*)&reserved_2, 4) != 4 ||
-        file_ptr->read((uint8_t*)&data_size, 4) != 4) {
-        LOG_ERROR("BUNDLE", "Failed to read LVGL header for frame " + String(frame_index));
-        if (file_ptr == &temp_file) temp_file.close();
+bool BirdBundleLoader::loadEncodedFrame(uint16_t frame_index, FrameSlot& slot) {
+    const uint32_t raw_size = getFrameDataSize();
+    FrameEncoding encoding = encodingOf(frame_index);
+
+    // 常驻模式下的RAW帧可以零拷贝
+    if (resident_ && encoding == FRAME_ENCODING_RAW) {
+        const FrameIndexEntry& entry = index_table_[frame_index];
+        uint32_t size = entry.size & FRAME_SIZE_MASK;
+        if (size != raw_size || entry.offset > header_.total_size ||
+            header_.total_size - entry.offset < size) {
+            LOG_ERROR("BUNDLE", "Invalid raw frame " + String(frame_index));
+            return false;
+        }
+
+        const uint8_t* data = resident_data_ + entry.offset;
+        LvImageFileHeader lv_header = {};
+        lv_header.header_cf = (0x37u << 24) | RGB565_COLOR_FORMAT;
+        lv_header.width = header_.frame_width;
+        lv_header.height = header_.frame_height;
+        lv_header.data_size = raw_size;
+        fillDescriptor(slot, lv_header, data, frame_index);
+
+        bytes_read_ += size;
+        frames_read_++;
+        updateDirtyArea(frame_index, data, slot);
+        return true;
+    }
+
+    if (!slot.buffer || slot.capacity < raw_size) {
+        LOG_ERROR("BUNDLE", "Invalid frame slot for decode");
         return false;
     }
 
-    // 验证LVGL格式
-    uint8_t color_format = header_cf & 0xFF;
-    uint8_t magic = (header_cf >> 24) & 0xFF;
+    // 解码前记录上一帧，用于计算脏区
+    const uint8_t* prev = last_decoded_;
+    uint16_t prev_index = frame_index == 0 ? header_.frame_count - 1 : frame_index - 1;
+    bool prev_adjacent = prev && last_decoded_index_ == (int32_t)prev_index;
+    bool rebuilt = false;
+
+    if (encoding == FRAME_ENCODING_DELTA) {
+        if (last_decoded_index_ + 1 != (int32_t)frame_index || !last_decoded_) {
+            rebuilt = true;
+            // 不连续访问（首次播放/取消后重启）：从最近的关键帧重新解码到当前帧之前
+            uint16_t key_index = frame_index;
+            while (key_index > 0 && encodingOf(key_index) == FRAME_ENCODING_DELTA) {
+                key_index--;
+            }
+            if (encodingOf(key_index) == FRAME_ENCODING_DELTA) {
+                LOG_ERROR("BUNDLE", "No keyframe before frame " + String(frame_index));
+                return false;
+            }
+            for (uint16_t i = key_index; i < frame_index; i++) {
+                if (!decodeFrameInto(i, slot.buffer)) {
+                    return false;
+                }
+            }
+        } else if (last_decoded_ != slot.buffer) {
+            // 上一帧在另一个槽中（环形队列中尚未被覆盖），复制为差异基准
+            memcpy(slot.buffer, last_decoded_, raw_size);
+        }
+    }
+
+    // DELTA帧的脏区就是字面量游程覆盖的区域，无需再比较
+    lv_area_t literal_area;
+    resetArea(literal_area, header_.frame_width, header_.frame_height);
+    bool is_delta = (encoding == FRAME_ENCODING_DELTA);
 
-    if (color_format != RGB565_COLOR_FORMAT || magic != 0x37) {
-        LOG_ERROR("BUNDLE", "Invalid LVGL format in frame " + String(frame_index) +
-                  ": cf=0x" + String(color_format, HEX) + ", magic=0x" + String(magic, HEX));
-        if (file_ptr == &temp_file) temp_file.close();
+    if (!decodeFrameInto(frame_index, slot.buffer, is_delta ? &literal_area : nullptr)) {
         return false;
     }
 
-    // 检查可用内存
-    size_t free_heap = ESP.getFreeHeap();
-    if (free_heap < data_size + 4096) {
-        LOG_ERROR("BUNDLE", "Insufficient memory - need " + String(data_size) +
-                  " + 4096, have " + String(free_heap));
-        if (file_ptr == &temp_file) temp_file.close();
-        return false;
+    if (is_delta && !rebuilt) {
+        slot.changed = literal_area.x1 <= literal_area.x2;
+        slot.dirty = literal_area;
+    } else if (!rebuilt && prev_adjacent && prev != slot.buffer) {
+        compareFrames(reinterpret_cast<const uint16_t*>(prev),
+                      reinterpret_cast<const uint16_t*>(slot.buffer),
+                      header_.frame_width, header_.frame_height, slot);
+    } else {
+        markFullFrame(slot, header_.frame_width, header_.frame_height);
     }
 
-    // 分配内存
-    lv_image_dsc_t* img_dsc = static_cast<lv_image_dsc_t*>(malloc(sizeof(lv_image_dsc_t)));
-    uint8_t* img_data = static_cast<uint8_t*>(malloc(data_size));
+    LvImageFileHeader lv_header = {};
+    lv_header.header_cf = (0x37u << 24) | RGB565_COLOR_FORMAT;
+    lv_header.width = header_.frame_width;
+    lv_header.height = header_.frame_height;
+    lv_header.data_size = raw_size;
+    fillDescriptor(slot, lv_header, slot.buffer, frame_index);
+    return true;
+}
+
+bool BirdBundleLoader::decodeFrameInto(uint16_t frame_index, uint8_t* dst, lv_area_t* literal_area) {
+    const FrameIndexEntry& entry = index_table_[frame_index];
+    const uint32_t raw_size = getFrameDataSize();
+    const uint32_t size = entry.size & FRAME_SIZE_MASK;
+    const FrameEncoding encoding = encodingOf(frame_index);
 
-    if (!img_dsc || !img_data) {
-        LOG_ERROR("BUNDLE", "Failed to allocate memory for frame " + String(frame_index));
-        if (img_dsc) free(img_dsc);
-        if (img_data) free(img_data);
-        if (file_ptr == &temp_file) temp_file.close();
+    if (encoding == FRAME_ENCODING_RAW && size != raw_size) {
+        LOG_ERROR("BUNDLE", "Raw frame " + String(frame_index) + " size mismatch: " + String(size));
         return false;
     }
 
-    // 读取像素数据
-    size_t bytes_read = file_ptr->read(img_data, data_size);
-    
-    // 如果使用的是临时文件，关闭它
-    if (file_ptr == &temp_file) {
-        temp_file.close();
+    // 获取编码数据：常驻模式直接引用，流式模式读入缓冲区（RAW帧直接读入目标）
+    const uint8_t* src = nullptr;
+    if (resident_) {
+        if (entry.offset > header_.total_size || header_.total_size - entry.offset < size) {
+            LOG_ERROR("BUNDLE", "Frame " + String(frame_index) + " exceeds bundle");
+            return false;
+        }
+        src = resident_data_ + entry.offset;
+    } else if (encoding == FRAME_ENCODING_RAW) {
+        if (!readAt(entry.offset, dst, size)) {
+            LOG_ERROR("BUNDLE", "Failed to read frame " + String(frame_index));
+            return false;
+        }
+    } else {
+        if (size > scratch_capacity_) {
+            LOG_ERROR("BUNDLE", "Encoded frame " + String(frame_index) + " too large: " + String(size));
+            return false;
+        }
+        if (!readAt(entry.offset, scratch_, size)) {
+            LOG_ERROR("BUNDLE", "Failed to read frame " + String(frame_index));
+            return false;
+        }
+        src = scratch_;
     }
 
-    if (bytes_read != data_size) {
-        LOG_ERROR("BUNDLE", "Failed to read pixel data: " + String(bytes_read) +
-                  "/" + String(data_size));
-        free(img_dsc);
-        free(img_data);
-        return false;
+    bool ok = true;
+    const uint32_t pixel_count = (uint32_t)header_.frame_width * header_.frame_height;
+    switch (encoding) {
+        case FRAME_ENCODING_RAW:
+            if (src) {
+                memcpy(dst, src, raw_size);
+            }
+            break;
+        case FRAME_ENCODING_RLE:
+            ok = decodeRuns(src, size, reinterpret_cast<uint16_t*>(dst), pixel_count, true,
+                            header_.key_color, header_.frame_width, literal_area);
+            break;
+        case FRAME_ENCODING_DELTA:
+            ok = decodeRuns(src, size, reinterpret_cast<uint16_t*>(dst), pixel_count, false,
+                            0, header_.frame_width, literal_area);
+            break;
+        default:
+            LOG_ERROR("BUNDLE", "Unknown frame encoding " + String((int)encoding) +
+                      " in frame " + String(frame_index));
+            ok = false;
+            break;
     }
 
-    // 设置LVGL图像描述符 - LVGL 9.x格式
-    img_dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
-    img_dsc->header.cf = color_format;
-    img_dsc->header.flags = 0;
-    img_dsc->header.w = width;
-    img_dsc->header.h = height;
-    img_dsc->header.stride = width * 2;  // RGB565每像素2字节
-    img_dsc->header.reserved_2 = 0;
-    img_dsc->data_size = data_size;
-    img_dsc->data = img_data;
-
-    *out_dsc = img_dsc;
-    *out_data = img_data;
+    if (!ok) {
+        if (encoding != FRAME_ENCODING_RAW) {
+            LOG_ERROR("BUNDLE", "Corrupt encoded frame " + String(frame_index));
+        }
+        last_decoded_ = nullptr;
+        last_decoded_index_ = -1;
+        return false;
+    }
 
+    bytes_read_ += size;
+    frames_read_++;
+    last_decoded_ = dst;
+    last_decoded_index_ = frame_index;
     return true;
 }
 
@@ -204,6 +651,8 @@ void BirdBundleLoader::close() {
         bundle_path_.clear();
         is_loaded_ = false;
     }
+    // 常驻缓冲区保留给下一个bundle复用，避免反复分配造成PSRAM碎片
+    resident_ = false;
 }
 
 bool BirdBundleLoader::validateHeader() {
@@ -214,11 +663,11 @@ bool BirdBundleLoader::validateHeader() {
         return false;
     }
 
-    // 验证版本
-    if (header_.version != BUNDLE_VERSION) {
-        LOG_WARN("BUNDLE", "Bundle version mismatch: " + String(header_.version) +
-                 " (expected " + String(BUNDLE_VERSION) + ")");
-        // 版本不匹配只是警告，不阻止加载
+    // 验证版本（v2起帧数据经过编码，未知版本无法解码）
+    if (header_.version == 0 || header_.version > BUNDLE_VERSION) {
+        LOG_ERROR("BUNDLE", "Unsupported bundle version: " + String(header_.version) +
+                  " (max " + String(BUNDLE_VERSION) + ")");
+        return false;
     }
 
     // 验证颜色格式
@@ -4,44 +4,82 @@
 #include <Arduino.h>
 #include <FS.h>
 #include "hal/sd_interface.h"
+#include "frame_pool.h"
 #include <lvgl.h>
 #include <string>
 #include <vector>
 
+// 常驻模式预算：bundle不超过该大小时整体读入PSRAM（可通过-D覆盖）
+#ifndef BIRD_BUNDLE_RESIDENT_BUDGET
+#define BIRD_BUNDLE_RESIDENT_BUDGET (2 * 1024 * 1024)
+#endif
+
 namespace BirdWatching {
 
 /**
  * Bundle文件头部结构 (64字节)
  *
  * 与Python端rgb565.py中的格式保持一致
+ *
+ * v1: 每帧为完整的LVGL 9.x图像（24字节头 + RGB565像素）
+ * v2: 每帧为编码后的像素数据（无LVGL头），编码方式记录在FrameIndexEntry.size高8位，
+ *     key_color/keyframe_interval/max_encoded_size占用原reserved区（v1中为0）
  */
 struct BirdBundleHeader {
     uint32_t magic;          // 0x42495244 ("BIRD")
-    uint16_t version;        // 版本号 (当前: 1)
+    uint16_t version;        // 版本号 (1或2)
     uint16_t frame_count;    // 总帧数
     uint16_t frame_width;    // 帧宽度 (120)
     uint16_t frame_height;   // 帧高度 (120)
-    uint32_t frame_size;     // 单帧大小（字节，含LVGL头）
+    uint32_t frame_size;     // 单帧大小（v1: 含LVGL头；v2: 解码后像素大小）
     uint32_t index_offset;   // 索引表偏移量（通常为64）
     uint32_t data_offset;    // 数据区偏移量
     uint32_t total_size;     // 文件总大小
     uint8_t  color_format;   // 颜色格式 (0x12=RGB565)
-    uint8_t  reserved[35];   // 保留字段
+    uint16_t key_color;      // v2: 色键背景色（RGB565），RLE帧的跳过段填充此颜色
+    uint8_t  keyframe_interval; // v2: 关键帧间隔（0表示只有首帧是关键帧）
+    uint32_t max_encoded_size;  // v2: 最大编码帧大小（字节），用于分配读取缓冲区
+    uint8_t  reserved[28];   // 保留字段
 } __attribute__((packed));
 
+static_assert(sizeof(BirdBundleHeader) == 64, "BirdBundleHeader must be 64 bytes");
+
 /**
  * 帧索引条目 (12字节)
  */
 struct FrameIndexEntry {
     uint32_t offset;         // 帧数据偏移量（从文件开头）
-    uint32_t size;           // 帧数据大小（字节）
+    uint32_t size;           // 帧数据大小（字节；v2中高8位为FrameEncoding）
     uint32_t checksum;       // CRC32校验（可选）
 } __attribute__((packed));
 
+/**
+ * v2帧编码方式
+ *
+ * RLE和DELTA使用相同的游程流，每个游程以1-2字节的操作码开头：
+ *   bit7    : 1=字面量（后跟count个RGB565像素），0=跳过
+ *   bit6    : 1=长游程（下一字节为count-1的低8位）
+ *   bit5..0 : count-1（长游程时为高6位），单个游程最多16384像素
+ * 跳过段在RLE中填充key_color，在DELTA中保留上一帧的像素
+ */
+enum FrameEncoding : uint8_t {
+    FRAME_ENCODING_RAW = 0,     // 原始RGB565像素
+    FRAME_ENCODING_RLE = 1,     // 色键背景游程编码（关键帧）
+    FRAME_ENCODING_DELTA = 2    // 相对上一帧的差异游程
+};
+
+constexpr uint32_t FRAME_SIZE_MASK = 0x00FFFFFF;
+constexpr uint8_t FRAME_ENCODING_SHIFT = 24;
+
 /**
  * Bundle文件加载器
  *
  * 用于从单个bundle.bin文件中按需加载帧数据，减少SD卡文件打开次数
+ *
+ * 两种工作模式：
+ * - 常驻模式：有PSRAM且bundle不超过预算时，loadBundle一次顺序读入整个文件，
+ *   之后loadFrame直接返回指向常驻数据的描述符（零拷贝，不再访问SD卡）
+ * - 流式模式：超出预算或没有PSRAM时，每帧从SD卡读入帧槽
  */
 class BirdBundleLoader {
 public:
@@ -57,14 +95,20 @@ public:
     bool loadBundle(const std::string& bundle_path);
 
     /**
-     * 从bundle中加载指定帧
+     * 从bundle中加载指定帧到调用方提供的帧槽
+     *
+     * 不做任何堆分配：常驻模式下未编码的帧直接指向常驻数据，
+     * 其余情况解码到slot.buffer。DELTA帧需要上一帧，不连续访问时
+     * 会从最近的关键帧开始重新解码
+     *
+     * 同时计算slot.dirty：相对上一次装载的帧变化的包围盒，
+     * DELTA帧取字面量游程范围，其余帧逐行比较，无上一帧时为整帧
      *
      * @param frame_index 帧索引 (0-based，最大65535)
-     * @param out_dsc 输出LVGL图像描述符指针
-     * @param out_data 输出图像数据指针
+     * @param slot 目标帧槽（由FramePool借出）
      * @return 成功返回true
      */
-    bool loadFrame(uint16_t frame_index, lv_image_dsc_t** out_dsc, uint8_t** out_data);
+    bool loadFrame(uint16_t frame_index, FrameSlot& slot);
 
     /**
      * 获取bundle中的帧数
@@ -81,11 +125,50 @@ public:
      */
     uint16_t getFrameHeight() const { return header_.frame_height; }
 
+    /**
+     * 获取单帧像素数据大小（字节，不含LVGL头），用于确定帧池容量
+     */
+    uint32_t getFrameDataSize() const {
+        return (uint32_t)header_.frame_width * header_.frame_height * 2;  // RGB565
+    }
+
     /**
      * 检查bundle是否已加载
      */
     bool isLoaded() const { return is_loaded_; }
 
+    /**
+     * 当前bundle是否常驻PSRAM
+     */
+    bool isResident() const { return resident_; }
+
+    /**
+     * 设置常驻模式预算（字节），0表示禁用常驻模式
+     */
+    void setResidentBudget(uint32_t bytes) { resident_budget_ = bytes; }
+
+    /**
+     * 获取常驻模式预算（字节）
+     */
+    uint32_t getResidentBudget() const { return resident_budget_; }
+
+    /**
+     * 获取当前bundle文件大小（字节）
+     */
+    uint32_t getBundleSize() const { return header_.total_size; }
+
+    /**
+     * 获取bundle格式版本
+     */
+    uint16_t getVersion() const { return header_.version; }
+
+    /**
+     * 平均每帧读取的字节数（用于评估编码效果）
+     */
+    uint32_t getAverageFrameBytes() const {
+        return frames_read_ ? (uint32_t)(bytes_read_ / frames_read_) : 0;
+    }
+
     /**
      * 关闭bundle
      */
@@ -96,12 +179,72 @@ private:
     std::vector<FrameIndexEntry> index_table_;
     std::string bundle_path_;
     bool is_loaded_;
-    File bundle_file_;  // 保持文件打开以提升性能
+    File bundle_file_;  // 保持文件打开以提升性能（仅流式模式）
+
+    // 常驻模式
+    uint8_t* resident_data_;        // 整个bundle文件的PSRAM副本
+    uint32_t resident_capacity_;    // 常驻缓冲区容量（只增不减，切换小鸟时复用）
+    uint32_t resident_budget_;      // 常驻模式预算
+    bool resident_;                 // 当前bundle是否常驻
+
+    // v2解码状态
+    uint8_t* scratch_;              // 流式模式的编码数据读取缓冲区（只增不减）
+    uint32_t scratch_capacity_;
+    const uint8_t* last_decoded_;   // 最近一次解码出的像素（DELTA的基准帧）
+    int32_t last_decoded_index_;    // 对应的帧索引，-1表示无
+
+    // 读取统计
+    uint64_t bytes_read_;
+    uint32_t frames_read_;
 
     /**
      * 验证bundle文件头部
      */
     bool validateHeader();
+
+    /**
+     * 尝试将整个bundle顺序读入PSRAM
+     *
+     * @param file 已打开的bundle文件
+     * @return 成功返回true，失败时调用方回退到流式模式
+     */
+    bool loadResident(File& file);
+
+    /**
+     * 常驻模式下装载帧（零拷贝）
+     */
+    bool loadResidentFrame(uint16_t frame_index, const FrameIndexEntry& entry, FrameSlot& slot);
+
+    /**
+     * 从bundle文件的指定偏移读取数据（流式模式）
+     */
+    bool readAt(uint32_t offset, uint8_t* dst, uint32_t length);
+
+    /**
+     * 装载v2编码帧
+     */
+    bool loadEncodedFrame(uint16_t frame_index, FrameSlot& slot);
+
+    /**
+     * 将单个v2帧解码到dst（DELTA帧要求dst中已是上一帧）
+     *
+     * @param literal_area 非空时返回字面量游程覆盖的区域
+     */
+    bool decodeFrameInto(uint16_t frame_index, uint8_t* dst, lv_area_t* literal_area = nullptr);
+
+    /**
+     * 与上一帧比较得到slot的脏区，并记录当前帧为下一帧的比较基准
+     */
+    void updateDirtyArea(uint16_t frame_index, const uint8_t* pixels, FrameSlot& slot);
+
+    /**
+     * 是否为v2编码bundle
+     */
+    bool isEncoded() const { return header_.version >= 2; }
+
+    FrameEncoding encodingOf(uint16_t frame_index) const {
+        return static_cast<FrameEncoding>(index_table_[frame_index].size >> FRAME_ENCODING_SHIFT);
+    }
 };
 
 } // namespace BirdWatching
@@ -0,0 +1,193 @@
+#include "bird_catalog.h"
+#include "bird_utils.h"
+#include "system/logging/log_manager.h"
+#include "hal/sd_interface.h"
+#include <cstring>
+#include <memory>
+
+namespace BirdWatching {
+
+bool BirdCatalog::load(uint32_t csv_size, uint32_t csv_mtime, std::vector<BirdInfo>& birds) {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    File file = fs.open(CATALOG_PATH, "r");
+    if (!file) {
+        LOG_INFO("CATALOG", "No bird catalog, will scan bundles");
+        return false;
+    }
+
+    // 整个文件一次读入（80只小鸟约5.5KB）
+    size_t file_size = file.size();
+    if (file_size < sizeof(Header) || file_size > sizeof(Header) + (size_t)MAX_ENTRIES * sizeof(Entry)) {
+        file.close();
+        LOG_WARN("CATALOG", "Invalid bird catalog size: " + String((unsigned long)file_size));
+        return false;
+    }
+
+    std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[file_size]);
+    if (!buffer) {
+        file.close();
+        LOG_ERROR("CATALOG", "Out of memory loading bird catalog");
+        return false;
+    }
+    size_t bytes_read = file.read(buffer.get(), file_size);
+    file.close();
+    if (bytes_read != file_size) {
+        LOG_WARN("CATALOG", "Short read on bird catalog");
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, buffer.get(), sizeof(header));
+    if (header.magic != CATALOG_MAGIC || header.version != CATALOG_VERSION) {
+        LOG_WARN("CATALOG", "Bird catalog format mismatch, rebuilding");
+        return false;
+    }
+
+    size_t entries_bytes = (size_t)header.entry_count * sizeof(Entry);
+    if (header.entry_count == 0 || sizeof(Header) + entries_bytes != file_size) {
+        LOG_WARN("CATALOG", "Bird catalog truncated, rebuilding");
+        return false;
+    }
+
+    if (header.csv_size != csv_size || header.csv_mtime != csv_mtime) {
+        LOG_INFO("CATALOG", "Bird config changed, rebuilding catalog");
+        return false;
+    }
+
+    const uint8_t* entries = buffer.get() + sizeof(Header);
+    if (Utils::fnv1a(entries, entries_bytes) != header.checksum) {
+        LOG_WARN("CATALOG", "Bird catalog checksum mismatch, rebuilding");
+        return false;
+    }
+
+    // 逐个stat小鸟的bundle：大小或修改时间变化（同帧数的v1 bundle大小不变）都需要重新扫描
+    for (uint16_t i = 0; i < header.entry_count; i++) {
+        Entry entry;
+        memcpy(&entry, entries + (size_t)i * sizeof(Entry), sizeof(entry));
+
+        char bundle_path[64];
+        snprintf(bundle_path, sizeof(bundle_path), "/birds/%d/bundle.bin", entry.id);
+        uint32_t size = 0;
+        uint32_t mtime = 0;
+        bool present = HAL::SDInterface::stat(bundle_path, size, mtime);
+        bool scanned = entry.bundle_size != 0;
+        if (present != scanned || (present && (size != entry.bundle_size || mtime != entry.bundle_mtime))) {
+            LOG_INFO("CATALOG", "Bundle changed for bird " + String(entry.id) + ", rebuilding catalog");
+            return false;
+        }
+    }
+
+    birds.clear();
+    birds.reserve(header.entry_count);
+    for (uint16_t i = 0; i < header.entry_count; i++) {
+        Entry entry;
+        memcpy(&entry, entries + (size_t)i * sizeof(Entry), sizeof(entry));
+        entry.name[NAME_SIZE - 1] = '\0';
+
+        BirdInfo bird(entry.id, entry.name, entry.weight);
+        bird.frame_count = entry.frame_count;
+        bird.bundle_size = entry.bundle_size;
+        birds.push_back(bird);
+    }
+
+    LOG_INFO("CATALOG", "Loaded " + String(header.entry_count) + " birds from catalog");
+    return true;
+}
+
+bool BirdCatalog::rebuild(uint32_t csv_size, uint32_t csv_mtime, std::vector<BirdInfo>& birds) {
+    if (birds.empty() || birds.size() > MAX_ENTRIES) {
+        return false;
+    }
+
+    size_t entries_bytes = birds.size() * sizeof(Entry);
+    std::unique_ptr<uint8_t[]> entries(new (std::nothrow) uint8_t[entries_bytes]);
+    if (!entries) {
+        LOG_ERROR("CATALOG", "Out of memory building bird catalog");
+        return false;
+    }
+
+    for (size_t i = 0; i < birds.size(); i++) {
+        BirdInfo& bird = birds[i];
+
+        Utils::BundleInfo info;
+        memset(&info, 0, sizeof(info));
+        if (Utils::readBundleInfo(bird.id, info)) {
+            bird.frame_count = info.frame_count;
+            bird.bundle_size = info.file_size;
+        } else {
+            bird.frame_count = 0;
+            bird.bundle_size = 0;
+        }
+
+        Entry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.id = bird.id;
+        entry.weight = bird.weight;
+        entry.frame_count = info.frame_count;
+        entry.frame_width = info.frame_width;
+        entry.frame_height = info.frame_height;
+        entry.bundle_size = info.file_size;
+        entry.bundle_mtime = info.mtime;
+        strncpy(entry.name, bird.name.c_str(), NAME_SIZE - 1);
+        memcpy(entries.get() + i * sizeof(Entry), &entry, sizeof(entry));
+
+        char scan_msg[128];
+        snprintf(scan_msg, sizeof(scan_msg), "Scanned bird #%d: %d frames, %dx%d, %u bytes",
+                 bird.id, info.frame_count, info.frame_width, info.frame_height, info.file_size);
+        LOG_DEBUG("CATALOG", scan_msg);
+
+        // 每扫描一只小鸟喂一次狗
+        yield();
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CATALOG_MAGIC;
+    header.version = CATALOG_VERSION;
+    header.entry_count = birds.size();
+    header.csv_size = csv_size;
+    header.csv_mtime = csv_mtime;
+    header.checksum = Utils::fnv1a(entries.get(), entries_bytes);
+
+    // 先写临时文件再替换，避免写入中断留下半个目录
+    fs::FS& fs = HAL::SDInterface::getFS();
+    String tmp_path = String(CATALOG_PATH) + ".tmp";
+    File file = fs.open(tmp_path, FILE_WRITE);
+    if (!file) {
+        LOG_WARN("CATALOG", "Cannot write bird catalog (birds still usable)");
+        return false;
+    }
+
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              file.write(entries.get(), entries_bytes) == entries_bytes;
+    file.close();
+
+    if (!ok) {
+        fs.remove(tmp_path);
+        LOG_WARN("CATALOG", "Failed to write bird catalog");
+        return false;
+    }
+
+    if (fs.exists(CATALOG_PATH)) {
+        fs.remove(CATALOG_PATH);
+    }
+    if (!fs.rename(tmp_path, CATALOG_PATH)) {
+        fs.remove(tmp_path);
+        LOG_WARN("CATALOG", "Failed to replace bird catalog");
+        return false;
+    }
+
+    LOG_INFO("CATALOG", "Bird catalog rebuilt: " + String((unsigned)birds.size()) + " birds, " +
+             String((unsigned long)(sizeof(header) + entries_bytes)) + " bytes");
+    return true;
+}
+
+void BirdCatalog::invalidate() {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    if (fs.exists(CATALOG_PATH)) {
+        fs.remove(CATALOG_PATH);
+        LOG_INFO("CATALOG", "Bird catalog invalidated");
+    }
+}
+
+} // namespace BirdWatching
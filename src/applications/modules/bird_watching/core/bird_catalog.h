@@ -0,0 +1,80 @@
+#ifndef BIRD_CATALOG_H
+#define BIRD_CATALOG_H
+
+#include "bird_types.h"
+#include <vector>
+
+namespace BirdWatching {
+
+/**
+ * 小鸟目录缓存（/birds/catalog.bin）
+ *
+ * 保存每只小鸟的ID、名称、权重和bundle信息（帧数、尺寸、大小、修改时间），
+ * 开机时一次读取即可得到完整的小鸟列表，不再逐个打开bundle.bin读取文件头。
+ *
+ * 缓存记录生成时配置文件和每个bundle的大小、修改时间，任一变化即视为失效
+ * （加载时逐个stat bundle，不打开文件）；通过串口上传/删除/birds下的文件时
+ * 也会主动失效，下次开机重建。
+ */
+class BirdCatalog {
+public:
+    static constexpr const char* CATALOG_PATH = "/birds/catalog.bin";
+
+    /**
+     * 加载目录缓存
+     *
+     * @param csv_size 当前配置文件大小
+     * @param csv_mtime 当前配置文件修改时间
+     * @param birds 输出的小鸟列表（含帧数）
+     * @return 缓存存在、完整且与配置文件和各bundle匹配时返回true
+     */
+    static bool load(uint32_t csv_size, uint32_t csv_mtime, std::vector<BirdInfo>& birds);
+
+    /**
+     * 扫描每只小鸟的bundle并写入目录缓存
+     *
+     * 会填充birds中每只小鸟的frame_count和bundle_size
+     *
+     * @return 写入成功返回true
+     */
+    static bool rebuild(uint32_t csv_size, uint32_t csv_mtime, std::vector<BirdInfo>& birds);
+
+    /**
+     * 删除目录缓存，下次加载配置时重建
+     */
+    static void invalidate();
+
+private:
+    static constexpr uint32_t CATALOG_MAGIC = 0x54434243;  // "CBCT"
+    static constexpr uint16_t CATALOG_VERSION = 1;
+    static constexpr uint16_t MAX_ENTRIES = 512;
+    static constexpr size_t NAME_SIZE = 48;                  // UTF-8，约16个汉字
+
+    // 文件头（24字节）
+    struct __attribute__((packed)) Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t entry_count;
+        uint32_t csv_size;
+        uint32_t csv_mtime;
+        uint32_t checksum;       // 所有条目的FNV-1a校验
+        uint32_t reserved;
+    };
+
+    // 每只小鸟一个条目（68字节）
+    struct __attribute__((packed)) Entry {
+        uint16_t id;
+        uint16_t weight;
+        uint16_t frame_count;
+        uint16_t frame_width;
+        uint16_t frame_height;
+        uint16_t reserved;
+        uint32_t bundle_size;
+        uint32_t bundle_mtime;
+        char name[NAME_SIZE];
+    };
+};
+
+} // namespace BirdWatching
+
+#endif // BIRD_CATALOG_H
@@ -0,0 +1,73 @@
+#include "bird_command_mailbox.h"
+
+namespace BirdWatching {
+
+// 打包格式：[31:28]类型 [26]记录统计 [25:24]触发类型 [23:8]参数 [7:0]序号
+uint32_t BirdCommandMailbox::pack(BirdCommandType type, uint16_t arg, TriggerType trigger, bool record_stats,
+                                  uint8_t seq) {
+    return ((uint32_t)type << 28) | ((record_stats ? 1u : 0u) << 26) | (((uint32_t)trigger & 0x3) << 24) |
+           ((uint32_t)arg << 8) | seq;
+}
+
+void BirdCommandMailbox::unpack(uint32_t word, BirdCommand& command) {
+    command.type = (BirdCommandType)(word >> 28);
+    command.record_stats = (word >> 26) & 1;
+    command.trigger = (TriggerType)((word >> 24) & 0x3);
+    command.arg = (uint16_t)(word >> 8);
+    command.seq = (uint8_t)word;
+}
+
+BirdCommandMailbox::BirdCommandMailbox()
+    : posted_(0)
+    , taken_(0)
+    , coalesced_(0)
+{
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        slots_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool BirdCommandMailbox::post(BirdCommandType type, uint16_t arg, TriggerType trigger, bool record_stats) {
+    if (type == BIRD_CMD_NONE || type > SLOT_COUNT) {
+        return false;
+    }
+
+    uint8_t seq = (uint8_t)(posted_.fetch_add(1, std::memory_order_relaxed) + 1);
+    uint32_t previous = slots_[type - 1].exchange(pack(type, arg, trigger, record_stats, seq),
+                                                  std::memory_order_acq_rel);
+    if (previous != 0) {
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool BirdCommandMailbox::take(BirdCommandType type, BirdCommand& command) {
+    if (type == BIRD_CMD_NONE || type > SLOT_COUNT) {
+        return false;
+    }
+
+    uint32_t word = slots_[type - 1].exchange(0, std::memory_order_acq_rel);
+    if (word == 0) {
+        return false;
+    }
+    unpack(word, command);
+    taken_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void BirdCommandMailbox::clear(BirdCommandType type) {
+    if (type != BIRD_CMD_NONE && type <= SLOT_COUNT) {
+        slots_[type - 1].store(0, std::memory_order_release);
+    }
+}
+
+BirdMailboxStats BirdCommandMailbox::getStats() const {
+    BirdMailboxStats stats;
+    stats.posted = posted_.load(std::memory_order_relaxed);
+    stats.taken = taken_.load(std::memory_order_relaxed);
+    stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace BirdWatching
@@ -0,0 +1,75 @@
+#ifndef BIRD_COMMAND_MAILBOX_H
+#define BIRD_COMMAND_MAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace BirdWatching {
+
+// 触发类型枚举
+enum TriggerType {
+    TRIGGER_AUTO = 0,       // 自动触发
+    TRIGGER_MANUAL,         // 手动触发
+    TRIGGER_GESTURE         // 手势触发
+};
+
+// 发给UI任务的命令类型（每种类型一个槽）
+enum BirdCommandType : uint8_t {
+    BIRD_CMD_NONE = 0,
+    BIRD_CMD_PLAY,          // 播放小鸟，arg为小鸟ID（0表示随机）
+    BIRD_CMD_GESTURE        // 手势事件，arg为GestureType
+};
+
+// 解包后的命令
+struct BirdCommand {
+    BirdCommandType type;
+    TriggerType trigger;
+    uint16_t arg;
+    bool record_stats;      // 是否记录统计
+    uint8_t seq;            // 投递序号的低8位（日志中区分各次请求）
+};
+
+// 邮箱统计
+struct BirdMailboxStats {
+    uint32_t posted;        // 累计投递
+    uint32_t taken;         // 累计被UI任务取走
+    uint32_t coalesced;     // 未处理就被新命令覆盖
+};
+
+/**
+ * 小鸟命令邮箱（无锁，跨核）
+ *
+ * 整条命令打包进一个32位原子字，每种命令一个槽：投递用exchange覆盖槽中尚未处理的
+ * 同类命令（最新的请求生效），UI任务用exchange取走并清空，读写都是单条原子指令，
+ * 不会读到写了一半的请求，也不需要LVGL锁。任意任务都可以投递，只有UI任务取。
+ */
+class BirdCommandMailbox {
+public:
+    BirdCommandMailbox();
+
+    // 投递命令，返回true表示覆盖了一条未处理的同类命令
+    bool post(BirdCommandType type, uint16_t arg, TriggerType trigger = TRIGGER_AUTO, bool record_stats = true);
+
+    // 取走一条该类型的命令（仅UI任务调用）
+    bool take(BirdCommandType type, BirdCommand& command);
+
+    // 丢弃该类型未处理的命令
+    void clear(BirdCommandType type);
+
+    BirdMailboxStats getStats() const;
+
+private:
+    static constexpr int SLOT_COUNT = 2;
+
+    std::atomic<uint32_t> slots_[SLOT_COUNT];   // 0表示空
+    std::atomic<uint32_t> posted_;
+    std::atomic<uint32_t> taken_;
+    std::atomic<uint32_t> coalesced_;
+
+    static uint32_t pack(BirdCommandType type, uint16_t arg, TriggerType trigger, bool record_stats, uint8_t seq);
+    static void unpack(uint32_t word, BirdCommand& command);
+};
+
+} // namespace BirdWatching
+
+#endif // BIRD_COMMAND_MAILBOX_H
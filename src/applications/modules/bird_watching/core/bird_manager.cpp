@@ -1,15 +1,12 @@
 #include "bird_manager.h"
 #include "bird_utils.h"
 #include "system/logging/log_manager.h"
+#include "system/tasks/task_manager.h"
 #include "drivers/sensors/imu/imu.h"
-#include "drivers/io/rgb_led/rgb_led.h"
 #include "config/ui_texts.h"
 #include <cstdlib>
 #include "esp_system.h"
 
-// 声明外部全局对象
-extern Pixel rgb;
-
 // 声明外部C接口，用于访问GUI对象
 extern "C" {
     #include "applications/gui/core/gui_guider.h"
@@ -18,6 +15,16 @@ extern "C" {
 
 namespace BirdWatching {
 
+// 手势反馈闪灯交给系统任务：flash会延时等待熄灭，不能阻塞UI任务
+static void flashFeedback(uint8_t r, uint8_t g, uint8_t b) {
+    TaskMessage msg;
+    msg.type = MSG_LED_FLASH;
+    msg.param1 = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    msg.param2 = 100;
+    msg.data = nullptr;
+    TaskManager::getInstance()->sendToSystemTask(msg);
+}
+
 BirdManager::BirdManager()
     : initialized_(false)
     , first_bird_loaded_(false)
@@ -27,15 +34,10 @@ BirdManager::BirdManager()
     , stats_view_(nullptr)
     , display_obj_(nullptr)
     , last_auto_trigger_time_(0)
-    , last_stats_save_time_(0)
     , system_start_time_(0)
     , bird_info_show_time_(0)
     , bird_info_visible_(false)
 {
-    trigger_request_.pending = false;
-    trigger_request_.type = TRIGGER_AUTO;
-    trigger_request_.bird_id = 0;
-    trigger_request_.record_stats = true;
 }
 
 BirdManager::~BirdManager() {
@@ -63,7 +65,6 @@ bool BirdManager::initialize(lv_obj_t* display_obj) {
     // 记录系统启动时间
     system_start_time_ = getCurrentTime();
     last_auto_trigger_time_ = system_start_time_;
-    last_stats_save_time_ = system_start_time_;
 
     // 初始化各个子系统
     if (!initializeSubsystems(display_obj)) {
@@ -117,9 +118,7 @@ void BirdManager::update() {
 
     // 注意: 此函数在System任务中调用
     // 不要直接操作LVGL对象,只设置触发请求
-
-    // 定期保存统计数据(不涉及LVGL)
-    saveStatisticsIfNeeded();
+    // 统计数据由后台保存任务在变脏后合并写入，这里不再定期写卡
 }
 
 void BirdManager::processTriggerRequest() {
@@ -127,11 +126,18 @@ void BirdManager::processTriggerRequest() {
         return;
     }
 
-    // 注意: 此函数在UI任务中调用,已持有LVGL锁
-    
-    // 如果统计界面可见，不处理触发请求
+    // 注意: 此函数在UI任务中调用,不持有LVGL锁
+    // 各处理函数只在修改LVGL对象时短暂加锁，读SD卡和等待预取任务时不持锁
+    BirdCommand command;
+
+    // 手势可能切换统计界面，也可能投递新的播放命令，先处理
+    if (mailbox_.take(BIRD_CMD_GESTURE, command)) {
+        onGestureEvent(command.arg);
+    }
+
+    // 如果统计界面可见，不处理播放命令
     if (isStatsViewVisible()) {
-        trigger_request_.pending = false;
+        mailbox_.clear(BIRD_CMD_PLAY);
         return;
     }
     
@@ -139,17 +145,13 @@ void BirdManager::processTriggerRequest() {
     checkAndHideBirdInfo();
 
     // 安全地处理动画播放
-    if (trigger_request_.pending) {
-        bool record_stats = trigger_request_.record_stats;
-        trigger_request_.pending = false;
+    if (mailbox_.take(BIRD_CMD_PLAY, command)) {
+        LOG_DEBUGF("BIRD_MGR", "Play command #%u: bird %u, trigger %d",
+                   command.seq, command.arg, (int)command.trigger);
 
-        if (isPlaying()) {
-            animation_->stop();
-        }
-
-        if (trigger_request_.bird_id > 0) {
+        if (command.arg > 0) {
             // 播放指定的小鸟
-            playBird(trigger_request_.bird_id, record_stats);
+            playBird(command.arg, command.record_stats);
         } else {
             // 播放随机小鸟（总是记录统计）
             playRandomBird();
@@ -163,11 +165,9 @@ bool BirdManager::triggerBird(TriggerType trigger_type) {
         return false;
     }
 
-    // 设置触发请求,由UI任务处理
-    trigger_request_.pending = true;
-    trigger_request_.type = trigger_type;
-    trigger_request_.bird_id = 0; // 随机小鸟
-    trigger_request_.record_stats = true;
+    // 投递播放命令（随机小鸟）,由UI任务处理
+    mailbox_.post(BIRD_CMD_PLAY, 0, trigger_type, true);
+    TaskManager::getInstance()->notifyUITask();
 
     return true;
 }
@@ -198,11 +198,9 @@ bool BirdManager::triggerBirdById(uint16_t bird_id, TriggerType trigger_type) {
         return false;
     }
 
-    // 设置触发请求,由UI任务处理
-    trigger_request_.pending = true;
-    trigger_request_.type = trigger_type;
-    trigger_request_.bird_id = bird_id; // 指定小鸟
-    trigger_request_.record_stats = true;
+    // 投递播放命令（指定小鸟）,由UI任务处理
+    mailbox_.post(BIRD_CMD_PLAY, bird_id, trigger_type, true);
+    TaskManager::getInstance()->notifyUITask();
 
     LOG_INFO("BIRD_MGR", String("Trigger request set for bird ID: ") + String(bird_id));
     return true;
@@ -219,15 +217,18 @@ bool BirdManager::playBirdWithoutRecording(uint16_t bird_id) {
         return false;
     }
 
-    // 设置触发请求,由UI任务处理（不记录统计）
-    trigger_request_.pending = true;
-    trigger_request_.type = TRIGGER_AUTO;
-    trigger_request_.bird_id = bird_id;
-    trigger_request_.record_stats = false;
+    // 投递播放命令,由UI任务处理（不记录统计）
+    mailbox_.post(BIRD_CMD_PLAY, bird_id, TRIGGER_AUTO, false);
+    TaskManager::getInstance()->notifyUITask();
 
     return true;
 }
 
+void BirdManager::postGesture(int gesture_type) {
+    mailbox_.post(BIRD_CMD_GESTURE, (uint16_t)gesture_type);
+    TaskManager::getInstance()->notifyUITask();
+}
+
 void BirdManager::onGestureEvent(int gesture_type) {
     if (!config_.enable_gesture_trigger) {
         return;
@@ -236,21 +237,21 @@ void BirdManager::onGestureEvent(int gesture_type) {
     static unsigned long last_tilt_trigger_time = 0; // 左右倾触发新鸟的CD
     unsigned long current_time = getCurrentTime();
 
-    LOG_DEBUG("BIRD", (String("Gesture event received: ") + String(gesture_type) + 
-              String(", Stats view visible: ") + String(isStatsViewVisible() ? "yes" : "no")).c_str());
+    LOG_DEBUGF("BIRD", "Gesture event received: %d, Stats view visible: %s",
+               gesture_type, isStatsViewVisible() ? "yes" : "no");
 
     switch (gesture_type) {
         case GESTURE_FORWARD_HOLD: // 前倾保持3秒 - 进入数据界面
             LOG_INFO("BIRD", "Forward hold 1s detected, showing stats view");
             showStatsView();
-            rgb.flashGreen(100); // 绿光闪一下
+            flashFeedback(0, 255, 0); // 绿光闪一下
             break;
 
         case GESTURE_BACKWARD_HOLD: // 后倾保持3秒 - 退出数据界面
             if (isStatsViewVisible()) {
                 LOG_INFO("BIRD", "Backward hold 1s detected, hiding stats view");
                 hideStatsView();
-                rgb.flashGreen(100); // 绿光闪一下
+                flashFeedback(0, 255, 0); // 绿光闪一下
             } else {
                 LOG_DEBUG("BIRD", "Backward hold ignored, not in stats view");
             }
@@ -267,20 +268,19 @@ void BirdManager::onGestureEvent(int gesture_type) {
                     LOG_DEBUG("BIRD", "Right tilt in stats view, next page");
                     statsViewNextPage();
                 }
-                rgb.flashBlue(100); // 蓝光闪一下
+                flashFeedback(0, 0, 255); // 蓝光闪一下
             } else {
                 // 主界面中：触发新鸟（10秒CD）
                 unsigned long time_since_last_trigger = current_time - last_tilt_trigger_time;
                 if (time_since_last_trigger >= 10000) {
-                    LOG_DEBUG("BIRD", (String(gesture_type == GESTURE_LEFT_TILT ? "Left" : "Right") + 
-                              String(" tilt in main view, triggering bird")).c_str());
+                    LOG_DEBUGF("BIRD", "%s tilt in main view, triggering bird",
+                               gesture_type == GESTURE_LEFT_TILT ? "Left" : "Right");
                     triggerBird(TRIGGER_GESTURE);
                     last_tilt_trigger_time = current_time;
-                    rgb.flashBlue(100); // 蓝光闪一下
+                    flashFeedback(0, 0, 255); // 蓝光闪一下
                 } else {
                     unsigned long remaining = 10000 - time_since_last_trigger;
-                    LOG_DEBUG("BIRD", (String("Tilt ignored, CD active: ") + String(remaining) + 
-                              String("ms remaining")).c_str());
+                    LOG_DEBUGF("BIRD", "Tilt ignored, CD active: %lums remaining", remaining);
                 }
             }
             break;
@@ -301,6 +301,9 @@ void BirdManager::showStatistics() {
 
 void BirdManager::setConfig(const BirdConfig& config) {
     config_ = config;
+    if (statistics_) {
+        statistics_->setCoalesceWindow(config_.stats_save_interval * 1000);
+    }
     LOG_INFO("BIRD", "Bird manager configuration updated");
 }
 
@@ -331,14 +334,24 @@ bool BirdManager::initializeSubsystems(lv_obj_t* display_obj) {
 
     // 初始化统计系统
     statistics_ = new BirdStatistics();
+    if (statistics_) {
+        // 按选择器的小鸟顺序建立统计表索引
+        statistics_->bindBirds(selector_->getAllBirds());
+    }
     if (!statistics_ || !statistics_->initialize()) {
         LOG_ERROR("BIRD", "Failed to initialize bird statistics");
         return false;
     }
+    // 后台任务启动失败时仍可通过强制刷新保存
+    statistics_->startBackgroundSaver(config_.stats_save_interval * 1000);
 
     // 初始化统计界面（使用scenes作为父对象）
+    // 创建LVGL对象需持锁（此时UI任务已在运行）
     stats_view_ = new StatsView();
-    if (!stats_view_ || !stats_view_->initialize(display_obj, statistics_, selector_)) {
+    TaskManager::getInstance()->takeLVGLMutex();
+    bool stats_view_ready = stats_view_ && stats_view_->initialize(display_obj, statistics_, selector_);
+    TaskManager::getInstance()->giveLVGLMutex();
+    if (!stats_view_ready) {
         LOG_ERROR("BIRD", "Failed to initialize stats view");
         return false;
     }
@@ -359,7 +372,7 @@ bool BirdManager::playRandomBird() {
     }
 
     // 随机选择一只小鸟
-    BirdInfo bird = selector_->getRandomBird();
+    const BirdInfo& bird = selector_->getRandomBird();
     if (bird.id == 0) {
         LOG_ERROR("BIRD", "Failed to select random bird");
         return false;
@@ -386,7 +399,7 @@ bool BirdManager::playBird(uint16_t bird_id, bool record_stats) {
     }
 
     if (!bird_info) {
-        LOG_ERROR("BIRD", (String("Bird not found with ID: ") + String(bird_id)).c_str());
+        LOG_ERRORF("BIRD", "Bird not found with ID: %u", bird_id);
         return false;
     }
 
@@ -396,27 +409,36 @@ bool BirdManager::playBird(uint16_t bird_id, bool record_stats) {
         is_new_bird = (statistics_->getEncounterCount(bird_id) == 0);
     }
 
-    // 加载小鸟动画
+    // 停止当前动画：只在解除LVGL引用时持锁，片段统计在释放锁后输出
+    TaskManager* taskMgr = TaskManager::getInstance();
+    ClipStats finished_clip;
+    taskMgr->takeLVGLMutex();
+    bool clip_finished = animation_->detach(&finished_clip);
+    taskMgr->giveLVGLMutex();
+    if (clip_finished) {
+        BirdAnimation::logClip(finished_clip);
+    }
+
+    // 加载小鸟动画（读SD卡，不持锁）
     if (!animation_->loadBird(*bird_info)) {
         LOG_ERROR("BIRD", "Failed to load bird");
         return false;
     }
 
-    // 播放动画（循环播放）
-    animation_->startLoop();
-
     // 记录统计数据（如果需要）
     if (record_stats && statistics_) {
         statistics_->recordEncounter(bird_id);
     }
 
-    // 显示小鸟信息
+    // 播放动画（循环播放）并显示小鸟信息
+    taskMgr->takeLVGLMutex();
+    animation_->startLoop();
     if (record_stats) {
         showBirdInfo(bird_id, bird_info->name, is_new_bird);
     }
+    taskMgr->giveLVGLMutex();
 
-    LOG_INFO("BIRD", (String("Playing bird animation (ID: ") + String(bird_id) + 
-             ", record: " + String(record_stats ? "yes" : "no") + ")").c_str());
+    LOG_INFOF("BIRD", "Playing bird animation (ID: %u, record: %s)", bird_id, record_stats ? "yes" : "no");
     return true;
 }
 
@@ -433,11 +455,11 @@ void BirdManager::loadInitialBird() {
     // 检查是否有历史统计数据
     if (statistics_->hasHistoricalData()) {
         // 有历史数据：随机选择一个已经遇见过的小鸟，不计数
-        std::vector<uint16_t> encountered_birds = statistics_->getEncounteredBirdIds();
-        if (!encountered_birds.empty()) {
-            // 使用硬件随机数选择
-            uint32_t random_index = esp_random() % encountered_birds.size();
-            uint16_t bird_id = encountered_birds[random_index];
+        size_t seen_species = statistics_->getSeenSpeciesCount();
+        if (seen_species > 0) {
+            // 使用硬件随机数按排名选择，不复制ID列表
+            uint32_t random_index = esp_random() % seen_species;
+            uint16_t bird_id = statistics_->getRankedBirdId(random_index);
             
             LOG_INFO("BIRD", (String("Loading initial bird from history (ID: ") + String(bird_id) + ")").c_str());
             playBird(bird_id, false); // 不记录统计
@@ -476,21 +498,11 @@ void BirdManager::handleGesture(GestureType gesture) {
     }
 }
 
-void BirdManager::saveStatisticsIfNeeded() {
+bool BirdManager::flushStatistics(TickType_t wait) {
     if (!statistics_) {
-        return;
-    }
-
-    uint32_t current_time = getCurrentTime();
-    uint32_t time_since_last_save = current_time - last_stats_save_time_;
-
-    // 每10秒保存一次（10000毫秒）
-    if (time_since_last_save >= 10000) {
-        if (statistics_->saveToFile()) {
-            last_stats_save_time_ = current_time;
-            // LOG_DEBUG("BIRD", "Statistics saved automatically");
-        }
+        return false;
     }
+    return statistics_->saveToFile(wait);
 }
 
 uint32_t BirdManager::getCurrentTime() const {
@@ -515,7 +527,9 @@ void BirdManager::checkAndHideBirdInfo() {
     if (bird_info_visible_) {
         uint32_t current_time = getCurrentTime();
         if (current_time - bird_info_show_time_ >= 5000) {
+            TaskManager::getInstance()->takeLVGLMutex();
             hideBirdInfo();
+            TaskManager::getInstance()->giveLVGLMutex();
         }
     }
 }
@@ -589,9 +603,14 @@ void BirdManager::showStatsView() {
         return;
     }
 
+    TaskManager* taskMgr = TaskManager::getInstance();
+    ClipStats finished_clip;
+    bool clip_finished = false;
+    taskMgr->takeLVGLMutex();
+
     // 停止动画
-    if (animation_ && isPlaying()) {
-        animation_->stop();
+    if (animation_) {
+        clip_finished = animation_->detach(&finished_clip);
     }
 
     // 隐藏小鸟信息
@@ -599,6 +618,15 @@ void BirdManager::showStatsView() {
 
     // 显示统计界面
     stats_view_->show();
+    taskMgr->giveLVGLMutex();
+
+    // 释放锁后再输出片段统计、等待预取任务停止
+    if (clip_finished) {
+        BirdAnimation::logClip(finished_clip);
+    }
+    if (animation_) {
+        animation_->stopPrefetch();
+    }
     LOG_INFO("BIRD", "Stats view shown");
 }
 
@@ -607,18 +635,20 @@ void BirdManager::hideStatsView() {
         return;
     }
 
+    TaskManager::getInstance()->takeLVGLMutex();
     stats_view_->hide();
+    TaskManager::getInstance()->giveLVGLMutex();
     LOG_INFO("BIRD", "Stats view hidden");
     
     // 退出统计界面后，显示一个小鸟
     // 逻辑与初始化时相同：有历史数据则随机选择已记录的小鸟（不计数），没有则触发新鸟（计数）
     if (statistics_ && statistics_->hasHistoricalData()) {
         // 有历史数据：随机选择一个已经遇见过的小鸟，不计数
-        std::vector<uint16_t> encountered_birds = statistics_->getEncounteredBirdIds();
-        if (!encountered_birds.empty()) {
-            // 使用硬件随机数选择
-            uint32_t random_index = esp_random() % encountered_birds.size();
-            uint16_t bird_id = encountered_birds[random_index];
+        size_t seen_species = statistics_->getSeenSpeciesCount();
+        if (seen_species > 0) {
+            // 使用硬件随机数按排名选择，不复制ID列表
+            uint32_t random_index = esp_random() % seen_species;
+            uint16_t bird_id = statistics_->getRankedBirdId(random_index);
             
             LOG_INFO("BIRD", (String("Displaying random encountered bird (ID: ") + String(bird_id) + ")").c_str());
             playBird(bird_id, false); // 不记录统计
@@ -636,13 +666,17 @@ bool BirdManager::isStatsViewVisible() const {
 
 void BirdManager::statsViewPreviousPage() {
     if (stats_view_) {
+        TaskManager::getInstance()->takeLVGLMutex();
         stats_view_->previousPage();
+        TaskManager::getInstance()->giveLVGLMutex();
     }
 }
 
 void BirdManager::statsViewNextPage() {
     if (stats_view_) {
+        TaskManager::getInstance()->takeLVGLMutex();
         stats_view_->nextPage();
+        TaskManager::getInstance()->giveLVGLMutex();
     }
 }
 
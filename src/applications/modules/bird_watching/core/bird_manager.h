@@ -5,6 +5,7 @@
 #include "bird_selector.h"
 #include "bird_stats.h"
 #include "bird_types.h"
+#include "bird_command_mailbox.h"
 #include "../ui/stats_view.h"
 #include "drivers/sensors/imu/imu.h"
 #include <string>
@@ -12,21 +13,6 @@
 
 namespace BirdWatching {
 
-// 触发类型枚举
-enum TriggerType {
-    TRIGGER_AUTO = 0,       // 自动触发
-    TRIGGER_MANUAL,         // 手动触发
-    TRIGGER_GESTURE         // 手势触发
-};
-
-// 触发请求结构(用于任务间通信)
-struct BirdTriggerRequest {
-    bool pending;
-    TriggerType type;
-    uint16_t bird_id;  // 0表示随机
-    bool record_stats; // 是否记录统计
-};
-
 class BirdManager {
 public:
     BirdManager();
@@ -38,10 +24,10 @@ public:
     // 系统更新（在主循环中调用）
     void update();
 
-    // 处理触发请求(在UI任务中调用)
+    // 处理邮箱中的手势和播放命令(在UI任务中调用)
     void processTriggerRequest();
 
-    // 手动触发小鸟出现(设置触发请求)
+    // 手动触发小鸟出现(投递播放命令，任意任务可调用，不需要LVGL锁)
     bool triggerBird(TriggerType trigger_type = TRIGGER_MANUAL);
     
     // 触发指定小鸟ID
@@ -50,9 +36,15 @@ public:
     // 播放指定小鸟（不记录统计）
     bool playBirdWithoutRecording(uint16_t bird_id);
 
-    // 处理手势事件
+    // 投递手势事件，由UI任务处理（任意任务可调用，不需要LVGL锁）
+    void postGesture(int gesture_type);
+
+    // 处理手势事件（UI任务中调用，不持有LVGL锁，修改界面时内部加锁）
     void onGestureEvent(int gesture_type);
 
+    // 命令邮箱统计
+    BirdMailboxStats getMailboxStats() const { return mailbox_.getStats(); }
+
     // 显示统计信息
     void showStatistics();
 
@@ -68,24 +60,30 @@ public:
     // 获取统计信息
     const BirdStatistics& getStatistics() const { return *statistics_; }
 
+    // 立即把未保存的统计写入SD卡（重启/深度睡眠前调用）
+    bool flushStatistics(TickType_t wait = portMAX_DELAY);
+
+    // 获取动画播放器（用于状态查询）
+    const BirdAnimation* getAnimation() const { return animation_; }
+
     // 获取小鸟列表
     const std::vector<BirdInfo>& getAllBirds() const;
 
-    // 显示小鸟信息（在右下角）
+    // 显示小鸟信息（在右下角，需持有LVGL锁）
     void showBirdInfo(uint16_t bird_id, const std::string& bird_name, bool is_new);
 
-    // 隐藏小鸟信息
+    // 隐藏小鸟信息（需持有LVGL锁）
     void hideBirdInfo();
     
     // 检查并隐藏小鸟信息（如果超时）
     void checkAndHideBirdInfo();
     
-    // 显示/隐藏统计界面
+    // 显示/隐藏统计界面（内部加锁，调用时不要持有LVGL锁）
     void showStatsView();
     void hideStatsView();
     bool isStatsViewVisible() const;
     
-    // 统计界面页面切换
+    // 统计界面页面切换（内部加锁）
     void statsViewPreviousPage();
     void statsViewNextPage();
 
@@ -100,11 +98,10 @@ private:
     lv_obj_t* display_obj_;                      // 显示对象（用于访问GUI）
 
     uint32_t last_auto_trigger_time_;            // 上次自动触发时间
-    uint32_t last_stats_save_time_;              // 上次统计数据保存时间
     uint32_t system_start_time_;                 // 系统启动时间
 
-    // 触发请求(用于跨任务通信)
-    BirdTriggerRequest trigger_request_;
+    // 发给UI任务的命令（无锁邮箱，最新的请求生效）
+    BirdCommandMailbox mailbox_;
 
     // 小鸟信息显示时间戳
     uint32_t bird_info_show_time_;
@@ -122,15 +119,12 @@ private:
     // 播放随机小鸟
     bool playRandomBird();
     
-    // 播放指定小鸟（内部使用，可选择是否记录统计）
+    // 播放指定小鸟（内部使用，可选择是否记录统计；读SD卡时不持锁，调用时不要持有LVGL锁）
     bool playBird(uint16_t bird_id, bool record_stats = true);
 
     // 更新手势检测
     void updateGestureDetection();
 
-    // 保存统计数据
-    void saveStatisticsIfNeeded();
-
     // 获取当前时间（毫秒）
     uint32_t getCurrentTime() const;
 
@@ -1,5 +1,6 @@
 #include "bird_selector.h"
 #include "bird_utils.h"
+#include "bird_catalog.h"
 #include "system/logging/log_manager.h"
 #include "hal/sd_interface.h"
 #include "esp_system.h"
@@ -81,34 +82,35 @@ bool BirdSelector::initialize(const std::string& config_path) {
         total_weight_ += 30;
     }
 
+    buildAliasTable();
+
     LOG_INFO("SELECTOR", "Bird selector initialized");
 
     return !birds_.empty();
 }
 
-BirdInfo BirdSelector::getRandomBird() {
-    if (birds_.empty()) {
+const BirdInfo& BirdSelector::getRandomBird() const {
+    static const BirdInfo empty_bird;
+    if (birds_.empty() || alias_table_.size() != birds_.size()) {
         LOG_ERROR("BIRD", "No birds available for selection");
-        return BirdInfo();
+        return empty_bird;
     }
 
     // 使用ESP32硬件真随机数生成器(TRNG)
     // 基于射频噪声，质量远超std::rand()
-    uint32_t hw_random = esp_random();
-    int random_weight = hw_random % total_weight_;
+    // 一次取32位：高16位选列，低16位决定取本列还是别名
+    return birds_[alias_table_.pick(esp_random())];
+}
 
-    int current_weight = 0;
+void BirdSelector::buildAliasTable() {
+    std::vector<uint32_t> weights;
+    weights.reserve(birds_.size());
     for (const auto& bird : birds_) {
-        current_weight += bird.weight;
-        if (random_weight < current_weight) {
-            LOG_DEBUG("SELECTOR", "Bird selected by weight");
-            return bird;
-        }
+        weights.push_back(bird.weight);
     }
+    alias_table_.build(weights);
 
-    // 如果由于某种原因没有选中，返回第一只鸟
-    LOG_WARN("SELECTOR", "Random selection fallback, returning first bird");
-    return birds_[0];
+    LOG_DEBUG("SELECTOR", "Alias table built for " + String((unsigned)alias_table_.size()) + " birds");
 }
 
 const BirdInfo* BirdSelector::findBird(const std::string& name) const {
@@ -140,8 +142,24 @@ bool BirdSelector::loadBirdConfig(const std::string& config_path) {
 
     LOG_INFO("SELECTOR", "Successfully opened bird config file");
 
+    unsigned long load_start = millis();
+
     // 读取文件内容
     long file_size = file.size();
+    uint32_t file_mtime = (uint32_t)file.getLastWrite();
+
+    // 目录缓存与配置文件匹配时直接使用，不再读取CSV和逐个扫描bundle
+    std::vector<BirdInfo> cached;
+    if (file_size > 0 && BirdCatalog::load((uint32_t)file_size, file_mtime, cached)) {
+        file.close();
+        birds_.swap(cached);
+        total_weight_ = 0;
+        for (const auto& bird : birds_) {
+            total_weight_ += bird.weight;
+        }
+        LOG_INFO("SELECTOR", "Bird list loaded from catalog in " + String(millis() - load_start) + "ms");
+        return true;
+    }
 
     char size_msg[64];
     snprintf(size_msg, sizeof(size_msg), "Config file size: %ld bytes", file_size);
@@ -166,7 +184,7 @@ bool BirdSelector::loadBirdConfig(const std::string& config_path) {
     birds_.clear();
     total_weight_ = 0;
 
-    LOG_INFO("SELECTOR", "Starting CSV parsing and resource scanning");
+    LOG_INFO("SELECTOR", "Starting CSV parsing");
 
     const char* ptr = buffer;
     int bird_count = 0;
@@ -203,25 +221,9 @@ bool BirdSelector::loadBirdConfig(const std::string& config_path) {
         parseCSVLine(line.c_str(), id, name, weight);
 
         if (id > 0 && !name.empty() && weight > 0) {
-            BirdInfo bird(id, name, weight);
-
-            // 预先检测帧数并缓存（显示进度）
-            char progress_msg[256];
-            snprintf(progress_msg, sizeof(progress_msg), "Scanning bird #%d: %s...", id, name.c_str());
-            LOG_INFO("SELECTOR", progress_msg);
-
-            bird.frame_count = Utils::detectFrameCount(id);
-
-            birds_.push_back(bird);
+            birds_.emplace_back(id, name, weight);
             total_weight_ += weight;
             bird_count++;
-
-            char success_msg[256];
-            snprintf(success_msg, sizeof(success_msg), "  -> Found %d frames for bird #%d", bird.frame_count, id);
-            LOG_INFO("SELECTOR", success_msg);
-
-            // 每处理一只小鸟喂一次狗
-            yield();
         } else {
             char invalid_msg[256];
             snprintf(invalid_msg, sizeof(invalid_msg), "Invalid bird data - id: %d, name: '%s', weight: %d", id, name.c_str(), weight);
@@ -238,7 +240,10 @@ bool BirdSelector::loadBirdConfig(const std::string& config_path) {
     delete[] buffer;
 
     if (!birds_.empty()) {
-        LOG_INFO("SELECTOR", "Bird config loaded successfully");
+        // 扫描每只小鸟的bundle帧数并写入目录缓存，下次开机一次读取即可
+        LOG_INFO("SELECTOR", "Scanning bundles for " + String(bird_count) + " birds...");
+        BirdCatalog::rebuild((uint32_t)file_size, file_mtime, birds_);
+        LOG_INFO("SELECTOR", "Bird config loaded and scanned in " + String(millis() - load_start) + "ms");
         return true;
     }
 
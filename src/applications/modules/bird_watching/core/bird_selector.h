@@ -2,8 +2,10 @@
 #define BIRD_SELECTOR_H
 
 #include "bird_types.h"
+#include "bird_alias_table.h"
 #include <vector>
 #include <string>
+#include <cstdint>
 
 namespace BirdWatching {
 
@@ -15,8 +17,12 @@ public:
     // 初始化选择器，加载小鸟列表
     bool initialize(const std::string& config_path = "S:/configs/bird_config.csv");
 
-    // 根据权重随机选择一只小鸟
-    BirdInfo getRandomBird();
+    /**
+     * 根据权重随机选择一只小鸟（别名表，O(1)）
+     *
+     * 返回的引用在下次重新加载配置前一直有效；没有小鸟时返回id为0的空对象
+     */
+    const BirdInfo& getRandomBird() const;
 
     // 获取所有可用小鸟
     const std::vector<BirdInfo>& getAllBirds() const { return birds_; }
@@ -37,6 +43,12 @@ private:
     std::vector<BirdInfo> birds_;    // 小鸟列表
     int total_weight_;               // 总权重
 
+    // 按birds_的权重建立的别名表，下标与birds_一致
+    AliasTable alias_table_;
+
+    // 根据birds_的权重重建别名表（每次加载配置后调用）
+    void buildAliasTable();
+
     // 从JSON配置文件加载小鸟列表
     bool loadBirdConfig(const std::string& config_path);
 
@@ -1,24 +1,64 @@
 #include "bird_stats.h"
+#include "bird_utils.h"
 #include "system/logging/log_manager.h"
 #include "hal/sd_interface.h"
+#include "system/tasks/task_manager.h"
 #include <ctime>
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
 
 namespace BirdWatching {
 
-BirdStatistics::BirdStatistics() : total_encounters_(0) {
+BirdStatistics::BirdStatistics()
+    : seen_species_(0)
+    , total_encounters_(0)
+    , journal_records_(0)
+    , snapshot_epoch_(0)
+    , snapshot_dirty_(false)
+    , data_mutex_(xSemaphoreCreateMutex())
+    , io_mutex_(xSemaphoreCreateMutex())
+    , saver_task_(nullptr)
+    , stop_saver_(false)
+    , saver_done_(xSemaphoreCreateBinary())
+    , dirty_gen_(0)
+    , saved_gen_(0)
+    , first_dirty_ms_(0)
+    , coalesce_ms_(DEFAULT_COALESCE_MS)
+{
+    memset(&save_stats_, 0, sizeof(save_stats_));
 }
 
 BirdStatistics::~BirdStatistics() {
-    saveToFile();
+    // 直接删除后台任务时它可能正在写卡并持有锁，之后的保存会一直等下去：先让它自己退出
+    if (saver_task_) {
+        stop_saver_ = true;
+        xTaskNotifyGive(saver_task_);
+        if (xSemaphoreTake(saver_done_, pdMS_TO_TICKS(BIRD_STATS_SHUTDOWN_WAIT_MS)) != pdTRUE) {
+            LOG_WARN("BIRD", "Stats saver did not stop in time, deleting it");
+            vTaskDelete(saver_task_);
+        }
+        saver_task_ = nullptr;
+    }
+
+    // 被强制删除的任务可能仍持有锁，限时等待，超时放弃保存
+    saveToFile(pdMS_TO_TICKS(BIRD_STATS_SHUTDOWN_WAIT_MS));
+    if (saver_done_) {
+        vSemaphoreDelete(saver_done_);
+    }
+    if (data_mutex_) {
+        vSemaphoreDelete(data_mutex_);
+    }
+    if (io_mutex_) {
+        vSemaphoreDelete(io_mutex_);
+    }
 }
 
-bool BirdStatistics::initialize(const std::string& data_file) {
-    data_file_ = data_file;
+bool BirdStatistics::initialize(const std::string& legacy_file) {
+    legacy_file_ = legacy_file;
 
-    // 尝试加载现有统计数据
-    bool loaded = loadFromFile();
+    // 尝试加载现有统计数据（快照+日志，或从旧版JSON迁移）
+    bool loaded = loadFromFile() || migrateLegacyJson();
     if (!loaded) {
         LOG_INFO("BIRD", "No existing bird stats found, starting with empty statistics");
         resetStats();
@@ -28,35 +68,164 @@ bool BirdStatistics::initialize(const std::string& data_file) {
     return true;
 }
 
+void BirdStatistics::bindBirds(const std::vector<BirdInfo>& birds) {
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+
+    // 按新列表重建索引，已有次数按ID带过来
+    std::vector<uint16_t> old_ids;
+    std::vector<uint32_t> old_counts;
+    old_ids.swap(bird_ids_);
+    old_counts.swap(counts_);
+    id_index_.clear();
+
+    // 预留余量，追加列表外的ID时不必重新分配
+    bird_ids_.reserve(birds.size() + 16);
+    counts_.reserve(birds.size() + 16);
+    id_index_.reserve(birds.size() + 16);
+    for (const auto& bird : birds) {
+        if (bird.id > 0 && findIndex(bird.id) < 0) {
+            indexForLocked(bird.id);
+        }
+    }
+    for (size_t i = 0; i < old_ids.size(); i++) {
+        if (old_counts[i] > 0) {
+            counts_[indexForLocked(old_ids[i])] = old_counts[i];
+        }
+    }
+
+    rebuildRankLocked();
+    xSemaphoreGive(data_mutex_);
+
+    LOG_DEBUG("BIRD", "Statistics bound to " + String((unsigned)birds.size()) + " birds");
+}
+
+int BirdStatistics::findIndex(uint16_t bird_id) const {
+    auto it = std::lower_bound(id_index_.begin(), id_index_.end(), bird_id,
+                               [](const IdIndex& entry, uint16_t id) { return entry.bird_id < id; });
+    if (it != id_index_.end() && it->bird_id == bird_id) {
+        return it->index;
+    }
+    return -1;
+}
+
+uint16_t BirdStatistics::indexForLocked(uint16_t bird_id) {
+    auto it = std::lower_bound(id_index_.begin(), id_index_.end(), bird_id,
+                               [](const IdIndex& entry, uint16_t id) { return entry.bird_id < id; });
+    if (it != id_index_.end() && it->bird_id == bird_id) {
+        return it->index;
+    }
+
+    // 新项次数为0、索引最大，按排名规则正好排在最后
+    uint16_t index = bird_ids_.size();
+    id_index_.insert(it, IdIndex{bird_id, index});
+    bird_ids_.push_back(bird_id);
+    counts_.push_back(0);
+    rank_pos_.push_back(rank_.size());
+    rank_.push_back(index);
+    return index;
+}
+
+void BirdStatistics::incrementLocked(uint16_t index) {
+    if (counts_[index]++ == 0) {
+        seen_species_++;
+    }
+
+    // 只需越过次数刚被追上的相邻项，不做全表排序
+    uint16_t pos = rank_pos_[index];
+    while (pos > 0 && ranksBefore(index, rank_[pos - 1])) {
+        uint16_t other = rank_[pos - 1];
+        rank_[pos] = other;
+        rank_pos_[other] = pos;
+        pos--;
+    }
+    rank_[pos] = index;
+    rank_pos_[index] = pos;
+}
+
+void BirdStatistics::rebuildRankLocked() {
+    const size_t n = counts_.size();
+    rank_.resize(n);
+    rank_pos_.resize(n);
+    seen_species_ = 0;
+    for (size_t i = 0; i < n; i++) {
+        rank_[i] = i;
+        if (counts_[i] > 0) {
+            seen_species_++;
+        }
+    }
+
+    std::sort(rank_.begin(), rank_.end(),
+              [this](uint16_t a, uint16_t b) { return ranksBefore(a, b); });
+    for (size_t pos = 0; pos < n; pos++) {
+        rank_pos_[rank_[pos]] = pos;
+    }
+}
+
+void BirdStatistics::clearCountsLocked() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_encounters_ = 0;
+    rebuildRankLocked();
+}
+
 void BirdStatistics::recordEncounter(uint16_t bird_id) {
     if (bird_id == 0) {
         LOG_ERROR("BIRD", "Cannot record encounter with invalid bird_id");
         return;
     }
 
-    // 更新统计
-    bird_id_stats_[bird_id]++;
+    JournalRecord record;
+    record.timestamp = (uint32_t)time(nullptr);
+    record.bird_id = bird_id;
+    record.check = (uint16_t)~bird_id;
+
+    // 更新统计，新记录等待后台任务合并写入日志
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    incrementLocked(indexForLocked(bird_id));
     total_encounters_++;
+    pending_.push_back(record);
+    markDirtyLocked();
+    xSemaphoreGive(data_mutex_);
+
+    LOG_INFOF("BIRD", "Recorded bird encounter for ID: %u", bird_id);
+}
 
-    LOG_INFO("BIRD", (String("Recorded bird encounter for ID: ") + String(bird_id)).c_str());
+int BirdStatistics::countForLocked(uint16_t bird_id) const {
+    int index = findIndex(bird_id);
+    return index >= 0 ? (int)counts_[index] : 0;
 }
 
 int BirdStatistics::getEncounterCount(uint16_t bird_id) const {
-    auto it = bird_id_stats_.find(bird_id);
-    if (it != bird_id_stats_.end()) {
-        return it->second;
-    }
-    return 0;
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    int count = countForLocked(bird_id);
+    xSemaphoreGive(data_mutex_);
+    return count;
+}
+
+int BirdStatistics::getEncounterCountAt(size_t index, uint16_t bird_id) const {
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    int count = (index < bird_ids_.size() && bird_ids_[index] == bird_id) ? (int)counts_[index]
+                                                                         : countForLocked(bird_id);
+    xSemaphoreGive(data_mutex_);
+    return count;
+}
+
+uint16_t BirdStatistics::getRankedBirdId(size_t rank) const {
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    uint16_t bird_id = rankedIdLocked(rank);
+    xSemaphoreGive(data_mutex_);
+    return bird_id;
 }
 
 std::vector<uint16_t> BirdStatistics::getEncounteredBirdIds() const {
     std::vector<uint16_t> bird_ids;
-    bird_ids.reserve(bird_id_stats_.size());
-    
-    for (const auto& pair : bird_id_stats_) {
-        bird_ids.push_back(pair.first);
+
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    bird_ids.reserve(seen_species_);
+    for (size_t rank = 0; rank < seen_species_; rank++) {
+        bird_ids.push_back(bird_ids_[rank_[rank]]);
     }
-    
+    xSemaphoreGive(data_mutex_);
+
     return bird_ids;
 }
 
@@ -65,126 +234,456 @@ float BirdStatistics::getProgressPercentage(int total_bird_species) const {
         return 0.0f;
     }
 
-    int seen_species = bird_id_stats_.size();
-    return (static_cast<float>(seen_species) / total_bird_species) * 100.0f;
+    return (static_cast<float>(seen_species_) / total_bird_species) * 100.0f;
 }
 
 uint16_t BirdStatistics::getMostSeenBirdId() const {
-    if (bird_id_stats_.empty()) {
-        return 0;
+    return getRankedBirdId(0);
+}
+
+uint16_t BirdStatistics::getRarestBirdId() const {
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    uint16_t bird_id = seen_species_ > 0 ? rankedIdLocked(seen_species_ - 1) : 0;
+    xSemaphoreGive(data_mutex_);
+    return bird_id;
+}
+
+void BirdStatistics::markDirtyLocked() {
+    dirty_gen_++;
+    if (first_dirty_ms_ == 0) {
+        first_dirty_ms_ = millis() | 1;  // 0表示干净
     }
+    if (saver_task_) {
+        xTaskNotifyGive(saver_task_);
+    }
+}
 
-    uint16_t most_seen_id = 0;
-    int max_count = 0;
+bool BirdStatistics::isDirty() const {
+    return dirty_gen_ != saved_gen_;
+}
 
-    for (const auto& pair : bird_id_stats_) {
-        if (pair.second > max_count) {
-            max_count = pair.second;
-            most_seen_id = pair.first;
-        }
+bool BirdStatistics::startBackgroundSaver(uint32_t coalesce_ms) {
+    coalesce_ms_ = coalesce_ms;
+    if (saver_task_) {
+        return true;
+    }
+
+    // 写卡在系统核的独立任务中进行，不阻塞系统任务和UI任务
+    BaseType_t result = xTaskCreatePinnedToCore(
+        saverTaskFunction,
+        "Stats_Task",
+        STATS_TASK_STACK_SIZE,
+        this,
+        STATS_TASK_PRIORITY,
+        &saver_task_,
+        STATS_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        LOG_ERROR("BIRD", "Failed to create stats saver task");
+        saver_task_ = nullptr;
+        return false;
     }
 
-    return most_seen_id;
+    LOG_INFO("BIRD", "Stats saver started, coalescing writes over " + String(coalesce_ms_) + "ms");
+    return true;
 }
 
-uint16_t BirdStatistics::getRarestBirdId() const {
-    if (bird_id_stats_.empty()) {
-        return 0;
+void BirdStatistics::setCoalesceWindow(uint32_t coalesce_ms) {
+    coalesce_ms_ = coalesce_ms;
+    if (saver_task_) {
+        xTaskNotifyGive(saver_task_);
     }
+}
+
+void BirdStatistics::saverTaskFunction(void* parameter) {
+    BirdStatistics* stats = static_cast<BirdStatistics*>(parameter);
 
-    uint16_t rarest_id = 0;
-    int min_count = INT_MAX;
+    while (!stats->stop_saver_) {
+        // 计算合并窗口剩余时间：干净时一直等待，直到有新记录唤醒
+        TickType_t wait = portMAX_DELAY;
+        xSemaphoreTake(stats->data_mutex_, portMAX_DELAY);
+        if (stats->first_dirty_ms_) {
+            uint32_t elapsed = millis() - stats->first_dirty_ms_;
+            wait = elapsed >= stats->coalesce_ms_ ? 0 : pdMS_TO_TICKS(stats->coalesce_ms_ - elapsed);
+        }
+        xSemaphoreGive(stats->data_mutex_);
+
+        if (wait > 0 && ulTaskNotifyTake(pdTRUE, wait) > 0) {
+            // 被新记录或窗口调整唤醒，重新计算剩余时间
+            continue;
+        }
 
-    for (const auto& pair : bird_id_stats_) {
-        if (pair.second > 0 && pair.second < min_count) {
-            min_count = pair.second;
-            rarest_id = pair.first;
+        if (stats->isDirty()) {
+            stats->saveToFile();
         }
     }
 
-    return rarest_id;
+    // 析构函数在等待，释放后不能再访问stats
+    xSemaphoreGive(stats->saver_done_);
+    vTaskDelete(nullptr);
 }
 
-bool BirdStatistics::saveToFile() {
-    if (data_file_.empty()) {
-        LOG_ERROR("BIRD", "No data file specified for saving statistics");
+bool BirdStatistics::saveToFile(TickType_t wait) {
+    // 串行化写卡（后台任务与强制刷新可能同时调用）
+    if (xSemaphoreTake(io_mutex_, wait) != pdTRUE) {
+        LOG_WARN("BIRD", "Stats save skipped: storage busy");
         return false;
     }
 
-    std::string json_data = formatStatsAsJson();
-    if (json_data.empty()) {
-        LOG_ERROR("BIRD", "Failed to format statistics as JSON");
+    // 在锁内取出要写的数据，写卡时不持有数据锁
+    if (xSemaphoreTake(data_mutex_, wait) != pdTRUE) {
+        xSemaphoreGive(io_mutex_);
+        LOG_WARN("BIRD", "Stats save skipped: statistics busy");
         return false;
     }
+    uint32_t gen = dirty_gen_;
+    std::vector<JournalRecord> records;
+    records.swap(pending_);
+    bool need_snapshot = snapshot_dirty_ || journal_records_ + records.size() > COMPACT_THRESHOLD;
+    bool fresh_journal = journal_records_ == 0;
+    std::vector<SnapshotEntry> entries;
+    uint32_t total = 0;
+    if (need_snapshot) {
+        entries.reserve(seen_species_);
+        for (size_t i = 0; i < counts_.size(); i++) {
+            if (counts_[i] == 0) {
+                continue;
+            }
+            SnapshotEntry entry;
+            entry.bird_id = bird_ids_[i];
+            entry.reserved = 0;
+            entry.count = counts_[i];
+            entries.push_back(entry);
+        }
+        total = total_encounters_;
+    }
+    first_dirty_ms_ = 0;
+    xSemaphoreGive(data_mutex_);
+
+    bool ok = true;
+    if (need_snapshot) {
+        ok = writeSnapshot(entries, total);
+    } else if (!records.empty()) {
+        ok = appendJournal(records, fresh_journal);
+    }
+
+    // 数据已写卡；只有限时等待（关机）时才可能拿不到锁，此时不再更新计数直接返回
+    if (xSemaphoreTake(data_mutex_, wait) != pdTRUE) {
+        xSemaphoreGive(io_mutex_);
+        LOG_WARN("BIRD", "Stats saved but bookkeeping skipped: statistics busy");
+        return ok;
+    }
+    if (ok) {
+        if (need_snapshot) {
+            journal_records_ = 0;
+            snapshot_dirty_ = false;
+        } else {
+            journal_records_ += records.size();
+        }
+        if (need_snapshot || !records.empty()) {
+            save_stats_.writes++;
+            save_stats_.records_written += records.size();
+        }
+        saved_gen_ = gen;
+    } else {
+        // 快照已包含所有记录；日志可能写了一半，下次改写快照以恢复一致
+        snapshot_dirty_ = true;
+        save_stats_.failures++;
+        if (first_dirty_ms_ == 0) {
+            first_dirty_ms_ = millis() | 1;
+        }
+    }
+    xSemaphoreGive(data_mutex_);
 
+    xSemaphoreGive(io_mutex_);
+    return ok;
+}
 
-    // 使用SD卡API写入文件
+bool BirdStatistics::appendJournal(const std::vector<JournalRecord>& records, bool fresh) {
+    // 一次追加所有新记录；新日志（或上次快照后没删掉的旧日志）先截断并写文件头
     fs::FS& fs = HAL::SDInterface::getFS();
-    File file = fs.open(data_file_.c_str(), FILE_WRITE);
+    File file = fs.open(JOURNAL_PATH, fresh ? FILE_WRITE : FILE_APPEND);
     if (!file) {
-        LOG_ERROR("BIRD", (String("Failed to open file for writing: ") + data_file_.c_str()).c_str());
+        LOG_ERROR("BIRD", String("Failed to open stats journal: ") + JOURNAL_PATH);
         return false;
     }
 
-    size_t written = file.print(json_data.c_str());
+    bool ok = true;
+    if (fresh) {
+        JournalHeader header;
+        header.magic = JOURNAL_MAGIC;
+        header.epoch = snapshot_epoch_;
+        ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    }
+    size_t bytes = records.size() * sizeof(JournalRecord);
+    ok = ok && file.write((const uint8_t*)records.data(), bytes) == bytes;
     file.close();
 
-    if (written != json_data.length()) {
-        LOG_ERROR("BIRD", "Failed to write complete data to file");
+    if (!ok) {
+        LOG_ERROR("BIRD", "Failed to append stats journal");
         return false;
     }
-
-    // LOG_INFO("BIRD", (String("Statistics saved to ") + data_file_.c_str()).c_str());
     return true;
 }
 
 bool BirdStatistics::loadFromFile() {
-    if (data_file_.empty()) {
-        LOG_ERROR("BIRD", "No data file specified for loading statistics");
+    // 与saveToFile()相同的加锁顺序：读卡期间后台任务不能改写文件，读取方不能看到一半的表
+    xSemaphoreTake(io_mutex_, portMAX_DELAY);
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    clearCountsLocked();
+    pending_.clear();
+    journal_records_ = 0;
+    snapshot_epoch_ = 0;
+
+    // 加载时直接累加次数，最后统一排序一次
+    bool has_snapshot = loadSnapshot();
+    uint32_t replayed = replayJournal(has_snapshot);
+    rebuildRankLocked();
+    uint16_t species = seen_species_;
+    int total = total_encounters_;
+    bool compact = journal_records_ > COMPACT_THRESHOLD || snapshot_dirty_;
+    if (compact) {
+        snapshot_dirty_ = true;
+    }
+    xSemaphoreGive(data_mutex_);
+    xSemaphoreGive(io_mutex_);
+    if (!has_snapshot && replayed == 0) {
         return false;
     }
 
+    LOG_INFO("BIRD", "Statistics loaded: " + String(species) + " birds, " +
+             String(total) + " encounters (" + String(replayed) + " from journal)");
 
-    // 检查文件是否存在
-    if (!HAL::SDInterface::exists(data_file_.c_str())) {
-        LOG_INFO("BIRD", (String("Statistics file does not exist: ") + data_file_.c_str()).c_str());
-        return false;
+    // 日志过长或有损坏记录时启动即压缩
+    if (compact) {
+        saveToFile();
     }
+    return true;
+}
 
-    // 读取文件
+bool BirdStatistics::readSnapshotFile(const char* path, std::vector<SnapshotEntry>& entries, uint32_t& epoch) {
     fs::FS& fs = HAL::SDInterface::getFS();
-    File file = fs.open(data_file_.c_str(), FILE_READ);
+    File file = fs.open(path, FILE_READ);
     if (!file) {
-        LOG_ERROR("BIRD", (String("Failed to open file for reading: ") + data_file_.c_str()).c_str());
         return false;
     }
 
-    // 读取文件内容
-    String content = "";
-    while (file.available()) {
-        content += (char)file.read();
+    // v1文件头没有epoch字段
+    SnapshotHeader header;
+    const size_t v1_header_size = sizeof(header) - sizeof(header.epoch);
+    bool ok = file.read((uint8_t*)&header, v1_header_size) == v1_header_size &&
+              header.magic == SNAPSHOT_MAGIC && (header.version == 1 || header.version == SNAPSHOT_VERSION);
+    if (ok && header.version == 1) {
+        header.epoch = 0;
+    } else if (ok) {
+        ok = file.read((uint8_t*)&header.epoch, sizeof(header.epoch)) == sizeof(header.epoch);
+    }
+    if (!ok) {
+        file.close();
+        LOG_ERROR("BIRD", String("Invalid stats snapshot: ") + path);
+        return false;
     }
+
+    // 条目一次读入
+    entries.resize(header.entry_count);
+    size_t bytes = entries.size() * sizeof(SnapshotEntry);
+    size_t bytes_read = bytes ? file.read((uint8_t*)entries.data(), bytes) : 0;
     file.close();
 
-    if (content.length() == 0) {
-        LOG_ERROR("BIRD", "File is empty");
+    if (bytes_read != bytes || Utils::fnv1a((const uint8_t*)entries.data(), bytes) != header.checksum) {
+        LOG_ERROR("BIRD", String("Stats snapshot corrupted, ignoring: ") + path);
         return false;
     }
 
-    // 解析JSON数据
-    bool success = parseStatsFromFile(content.c_str());
-    if (success) {
-        LOG_INFO("BIRD", (String("Statistics loaded from ") + data_file_.c_str()).c_str());
+    epoch = header.epoch;
+    return true;
+}
+
+bool BirdStatistics::loadSnapshot() {
+    std::vector<SnapshotEntry> entries;
+    uint32_t epoch = 0;
+    if (!readSnapshotFile(SNAPSHOT_PATH, entries, epoch)) {
+        // 替换快照时旧文件已删、改名前断电：临时文件是完整的新快照
+        fs::FS& fs = HAL::SDInterface::getFS();
+        String tmp_path = String(SNAPSHOT_PATH) + ".tmp";
+        if (!fs.exists(tmp_path) || !readSnapshotFile(tmp_path.c_str(), entries, epoch)) {
+            return false;
+        }
+        if (fs.exists(SNAPSHOT_PATH)) {
+            fs.remove(SNAPSHOT_PATH);
+        }
+        fs.rename(tmp_path, SNAPSHOT_PATH);
+        LOG_WARN("BIRD", "Stats snapshot recovered from interrupted replace");
+    }
+
+    for (const auto& entry : entries) {
+        if (entry.bird_id > 0 && entry.count > 0) {
+            counts_[indexForLocked(entry.bird_id)] = entry.count;
+            total_encounters_ += entry.count;
+        }
+    }
+    snapshot_epoch_ = epoch;
+    return true;
+}
+
+uint32_t BirdStatistics::replayJournal(bool has_snapshot) {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    File file = fs.open(JOURNAL_PATH, FILE_READ);
+    if (!file) {
+        return 0;
+    }
+
+    // 没有文件头的v1日志从头开始就是记录，epoch视为0
+    JournalHeader header;
+    uint32_t epoch = 0;
+    if (file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && header.magic == JOURNAL_MAGIC) {
+        epoch = header.epoch;
     } else {
-        LOG_ERROR("BIRD", "Failed to parse statistics file");
+        file.seek(0);
+    }
+
+    // 快照替换后没来得及删除的旧日志：记录已包含在快照中
+    if (has_snapshot && epoch != snapshot_epoch_) {
+        file.close();
+        LOG_INFO("BIRD", "Skipping stats journal of snapshot epoch " + String(epoch) +
+                 " (current " + String(snapshot_epoch_) + ")");
+        return 0;
     }
 
-    return success;
+    // 按块读取，每块64条记录
+    JournalRecord records[64];
+    uint32_t replayed = 0;
+    uint32_t dropped = 0;
+    while (true) {
+        size_t bytes_read = file.read((uint8_t*)records, sizeof(records));
+        size_t count = bytes_read / sizeof(JournalRecord);
+        for (size_t i = 0; i < count; i++) {
+            const JournalRecord& record = records[i];
+            if (record.bird_id == 0 || record.check != (uint16_t)~record.bird_id) {
+                dropped++;
+                continue;
+            }
+            counts_[indexForLocked(record.bird_id)]++;
+            total_encounters_++;
+            replayed++;
+        }
+        if (bytes_read < sizeof(records)) {
+            // 不足一条的尾部是断电时写了一半的记录
+            if (bytes_read % sizeof(JournalRecord)) {
+                dropped++;
+            }
+            break;
+        }
+    }
+    file.close();
+
+    journal_records_ = replayed + dropped;
+    if (dropped || !has_snapshot) {
+        if (dropped) {
+            LOG_WARN("BIRD", "Dropped " + String(dropped) + " damaged stats journal records");
+        }
+        snapshot_dirty_ = true;
+    }
+    return replayed;
+}
+
+bool BirdStatistics::writeSnapshot(const std::vector<SnapshotEntry>& entries, uint32_t total_encounters) {
+    SnapshotHeader header;
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.entry_count = entries.size();
+    header.total_encounters = total_encounters;
+    size_t bytes = entries.size() * sizeof(SnapshotEntry);
+    header.checksum = Utils::fnv1a((const uint8_t*)entries.data(), bytes);
+    header.epoch = snapshot_epoch_ + 1;
+
+    // 先写完整的临时文件再替换：删除旧快照后断电时，加载从临时文件恢复；
+    // 替换后旧日志的epoch不再匹配，删除前断电也不会被重复重放
+    fs::FS& fs = HAL::SDInterface::getFS();
+    String tmp_path = String(SNAPSHOT_PATH) + ".tmp";
+    File file = fs.open(tmp_path, FILE_WRITE);
+    if (!file) {
+        LOG_ERROR("BIRD", "Failed to open stats snapshot for writing");
+        return false;
+    }
+
+    bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              (bytes == 0 || file.write((const uint8_t*)entries.data(), bytes) == bytes);
+    file.close();
+
+    if (!ok) {
+        fs.remove(tmp_path);
+        LOG_ERROR("BIRD", "Failed to write stats snapshot");
+        return false;
+    }
+
+    // FAT的rename不覆盖已有文件，只能先删除
+    if (fs.exists(SNAPSHOT_PATH)) {
+        fs.remove(SNAPSHOT_PATH);
+    }
+    if (!fs.rename(tmp_path, SNAPSHOT_PATH)) {
+        LOG_ERROR("BIRD", "Failed to replace stats snapshot");
+        return false;
+    }
+    snapshot_epoch_ = header.epoch;
+
+    // 快照已包含取出时的全部记录，清空日志（删除失败时下次追加会截断重建）
+    if (fs.exists(JOURNAL_PATH)) {
+        fs.remove(JOURNAL_PATH);
+    }
+
+    LOG_DEBUG("BIRD", "Stats snapshot written: " + String((unsigned)entries.size()) + " birds, epoch " +
+              String(header.epoch));
+    return true;
+}
+
+bool BirdStatistics::migrateLegacyJson() {
+    if (legacy_file_.empty() || !HAL::SDInterface::exists(legacy_file_.c_str())) {
+        return false;
+    }
+
+    fs::FS& fs = HAL::SDInterface::getFS();
+    File file = fs.open(legacy_file_.c_str(), FILE_READ);
+    if (!file) {
+        LOG_ERROR("BIRD", (String("Failed to open file for reading: ") + legacy_file_.c_str()).c_str());
+        return false;
+    }
+
+    // 一次读入整个文件
+    size_t size = file.size();
+    std::vector<char> content(size + 1, '\0');
+    size_t bytes_read = size ? file.read((uint8_t*)content.data(), size) : 0;
+    file.close();
+
+    if (bytes_read == 0 || !parseStatsFromFile(content.data())) {
+        LOG_ERROR("BIRD", "Failed to parse legacy statistics file");
+        return false;
+    }
+
+    // 写入快照后把旧文件改名保留，避免重复迁移
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    snapshot_dirty_ = true;
+    markDirtyLocked();
+    xSemaphoreGive(data_mutex_);
+    if (saveToFile()) {
+        String backup = String(legacy_file_.c_str()) + ".bak";
+        if (fs.exists(backup)) {
+            fs.remove(backup);
+        }
+        fs.rename(legacy_file_.c_str(), backup);
+        LOG_INFO("BIRD", (String("Statistics migrated from ") + legacy_file_.c_str()).c_str());
+    }
+    return true;
 }
 
 void BirdStatistics::resetStats() {
-    bird_id_stats_.clear();
-    total_encounters_ = 0;
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    clearCountsLocked();
+    pending_.clear();
+    snapshot_dirty_ = true;
+    markDirtyLocked();
+    xSemaphoreGive(data_mutex_);
     LOG_INFO("BIRD", "Bird statistics reset");
 }
 
@@ -192,15 +691,20 @@ void BirdStatistics::printStats() const {
     Serial.println("=== Bird Watching Statistics ===");
     Serial.println("Total bird encounters: " + String(total_encounters_));
 
-    if (bird_id_stats_.empty()) {
+    if (seen_species_ == 0) {
         Serial.println("No birds encountered yet");
         return;
     }
 
-    Serial.println("\nBirds encountered:");
-    for (const auto& pair : bird_id_stats_) {
-        Serial.println("  - Bird ID " + String(pair.first) + ": " + String(pair.second) + " times");
+    // 按已维护的排名输出，不需要排序
+    Serial.println("\nBirds encountered (" + String((unsigned)seen_species_) + " species, by count):");
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    for (size_t rank = 0; rank < seen_species_; rank++) {
+        uint16_t index = rank_[rank];
+        Serial.println("  " + String((unsigned)(rank + 1)) + ". Bird ID " + String(bird_ids_[index]) + ": " +
+                       String(counts_[index]) + " times");
     }
+    xSemaphoreGive(data_mutex_);
 
     uint16_t most_seen = getMostSeenBirdId();
     uint16_t rarest = getRarestBirdId();
@@ -215,6 +719,10 @@ void BirdStatistics::printStats() const {
                       " (" + String(getEncounterCount(rarest)) + " times)");
     }
 
+    Serial.println("\nPersistence: " + String(save_stats_.writes) + " writes, " +
+                   String(save_stats_.records_written) + " records appended, " +
+                   String(save_stats_.failures) + " failures" + (isDirty() ? " (unsaved changes)" : ""));
+
     Serial.println("================================");
     LOG_DEBUG("BIRD", "Statistics printed to serial");
 }
@@ -226,8 +734,8 @@ bool BirdStatistics::parseStatsFromFile(const char* content) {
 
     // 简单的JSON解析：期望格式 {"1001": 5, "1002": 3}
     // 重置现有数据
-    bird_id_stats_.clear();
-    total_encounters_ = 0;
+    xSemaphoreTake(data_mutex_, portMAX_DELAY);
+    clearCountsLocked();
 
     const char* ptr = content;
     
@@ -271,7 +779,7 @@ bool BirdStatistics::parseStatsFromFile(const char* content) {
             int count = atoi(value_str);
             
             if (bird_id > 0 && count > 0) {
-                bird_id_stats_[bird_id] = count;
+                counts_[indexForLocked(bird_id)] = count;
                 total_encounters_ += count;
             }
         } else {
@@ -279,27 +787,12 @@ bool BirdStatistics::parseStatsFromFile(const char* content) {
         }
     }
 
-    LOG_INFO("BIRD", (String("Parsed ") + String(bird_id_stats_.size()) + " bird records").c_str());
-    return !bird_id_stats_.empty();
-}
+    rebuildRankLocked();
+    uint16_t species = seen_species_;
+    xSemaphoreGive(data_mutex_);
 
-std::string BirdStatistics::formatStatsAsJson() const {
-    // 新格式：简化为 {bird_id: count}
-    std::string json = "{\n";
-    
-    bool first = true;
-    for (const auto& pair : bird_id_stats_) {
-        if (!first) {
-            json += ",\n";
-        }
-        first = false;
-        
-        json += "  \"" + std::to_string(pair.first) + "\": " + std::to_string(pair.second);
-    }
-    
-    json += "\n}";
-    
-    return json;
+    LOG_INFO("BIRD", (String("Parsed ") + String(species) + " bird records").c_str());
+    return species > 0;
 }
 
 } // namespace BirdWatching
\ No newline at end of file
@@ -3,18 +3,50 @@
 
 #include <string>
 #include <vector>
-#include <map>
 #include <cstdint>
+#include "bird_types.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+// 关机/析构时保存统计：等待互斥锁、等待后台保存任务退出的最长时间（毫秒）
+#ifndef BIRD_STATS_SHUTDOWN_WAIT_MS
+#define BIRD_STATS_SHUTDOWN_WAIT_MS 500
+#endif
 
 namespace BirdWatching {
 
+// 统计持久化计数
+struct StatsSaveStats {
+    uint32_t writes;            // 实际写卡次数（追加或快照）
+    uint32_t records_written;   // 追加到日志的记录数
+    uint32_t failures;          // 写卡失败次数
+};
+
 class BirdStatistics {
 public:
     BirdStatistics();
+
+    // 先通知后台保存任务退出并等它结束，再限时保存一次
     ~BirdStatistics();
 
-    // 初始化统计数据
-    bool initialize(const std::string& data_file = "/db.json");
+    /**
+     * 初始化统计数据
+     *
+     * 从快照+日志恢复；两者都不存在时从旧版JSON文件迁移
+     *
+     * @param legacy_file 旧版JSON统计文件路径
+     */
+    bool initialize(const std::string& legacy_file = "/db.json");
+
+    /**
+     * 绑定小鸟列表，建立稠密索引
+     *
+     * 稠密索引与列表中的小鸟顺序一致（即BirdSelector::getAllBirds()的下标），
+     * 统计界面可按下标直接取次数。已有的统计按ID保留，不在列表中的ID追加在后。
+     * 应在initialize()之前调用。
+     */
+    void bindBirds(const std::vector<BirdInfo>& birds);
 
     // 记录一次小鸟遇见（使用bird_id）
     void recordEncounter(uint16_t bird_id);
@@ -22,14 +54,38 @@ public:
     // 获取总观鸟次数
     int getTotalEncounters() const { return total_encounters_; }
 
+    /*
+     * 以下读取接口会在UI、系统和串口任务中调用，都持有data_mutex_：
+     * 记录新ID时统计表的vector可能扩容，不加锁读取会访问已释放的内存
+     */
+
     // 获取指定小鸟的统计信息（通过ID）
     int getEncounterCount(uint16_t bird_id) const;
 
-    // 获取所有有统计数据的小鸟ID列表
+    /**
+     * 按稠密索引获取遇见次数（索引即小鸟列表下标，O(1)）
+     *
+     * 该位置的ID与bird_id不一致时（列表有重复ID等）退回按ID查找
+     */
+    int getEncounterCountAt(size_t index, uint16_t bird_id) const;
+
+    // 获取所有有统计数据的小鸟ID列表（按遇见次数降序）
     std::vector<uint16_t> getEncounteredBirdIds() const;
 
+    // 遇见过的种类数
+    size_t getSeenSpeciesCount() const { return seen_species_; }
+
+    /**
+     * 按排名获取小鸟ID（0为最常遇见）
+     *
+     * 排名随每次遇见增量维护，按次数降序，次数相同时按稠密索引升序
+     *
+     * @return rank超出遇见过的种类数时返回0
+     */
+    uint16_t getRankedBirdId(size_t rank) const;
+
     // 检查是否有历史统计数据
-    bool hasHistoricalData() const { return !bird_id_stats_.empty(); }
+    bool hasHistoricalData() const { return seen_species_ > 0; }
 
     // 获取观鸟进度百分比（遇到的不同种类占总种类的比例）
     float getProgressPercentage(int total_bird_species) const;
@@ -40,10 +96,36 @@ public:
     // 获取最稀有的小鸟ID
     uint16_t getRarestBirdId() const;
 
-    // 保存统计数据到文件
-    bool saveToFile();
+    /**
+     * 立即保存统计数据（强制刷新，重置统计或重启前调用）
+     *
+     * 只把上次保存后的新记录追加到日志（没有新记录时不写卡），
+     * 日志过长或统计被重置时改写快照并清空日志
+     *
+     * @param wait 等待互斥锁的最长时间；超时则放弃本次保存返回false（关机时使用，
+     *             避免持锁的任务无法运行时卡死在重启流程中）
+     */
+    bool saveToFile(TickType_t wait = portMAX_DELAY);
+
+    /**
+     * 启动后台保存任务
+     *
+     * 数据变脏后等待coalesce_ms再写卡，窗口内的多次遇见合并为一次追加
+     */
+    bool startBackgroundSaver(uint32_t coalesce_ms);
 
-    // 从文件加载统计数据
+    // 修改合并写入窗口
+    void setCoalesceWindow(uint32_t coalesce_ms);
+
+    // 是否有尚未写卡的修改
+    bool isDirty() const;
+
+    // 当前修改代数（每次记录/重置递增）
+    uint32_t getDirtyGeneration() const { return dirty_gen_; }
+
+    const StatsSaveStats& getSaveStats() const { return save_stats_; }
+
+    // 从快照和日志加载统计数据（加载期间持有io_mutex_和data_mutex_，读取方等待加载完成）
     bool loadFromFile();
 
     // 重置统计数据
@@ -53,15 +135,143 @@ public:
     void printStats() const;
 
 private:
-    std::map<uint16_t, int> bird_id_stats_;   // 统计数据：{bird_id: count}
+    static constexpr const char* SNAPSHOT_PATH = "/stats.snap";
+    static constexpr const char* JOURNAL_PATH = "/stats.jrn";
+    static constexpr uint32_t SNAPSHOT_MAGIC = 0x54534243;   // "CBST"
+    static constexpr uint16_t SNAPSHOT_VERSION = 2;          // v2增加epoch；v1仍可读取（epoch视为0）
+    static constexpr uint32_t JOURNAL_MAGIC = 0x524A4243;    // "CBJR"
+    static constexpr uint32_t COMPACT_THRESHOLD = 256;        // 日志超过这么多条记录时压缩为快照
+    static constexpr uint32_t DEFAULT_COALESCE_MS = 10000;
+
+    // 快照文件头（v2为20字节，v1没有epoch字段），后跟entry_count个SnapshotEntry
+    struct __attribute__((packed)) SnapshotHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t entry_count;
+        uint32_t total_encounters;
+        uint32_t checksum;       // 所有条目的FNV-1a校验
+        uint32_t epoch;          // 快照代数，每次改写加一
+    };
+
+    struct __attribute__((packed)) SnapshotEntry {
+        uint16_t bird_id;
+        uint16_t reserved;
+        uint32_t count;
+    };
+
+    /**
+     * 日志文件头（8字节），epoch为日志所接续的快照代数
+     *
+     * 快照替换后、旧日志删除前断电时，旧日志的epoch与新快照不符，
+     * 重放时整体跳过，避免把已包含在快照中的记录重复计数。
+     * 没有文件头的日志来自v1，视为epoch 0。
+     */
+    struct __attribute__((packed)) JournalHeader {
+        uint32_t magic;
+        uint32_t epoch;
+    };
+
+    // 日志记录（8字节），check = ~bird_id，用于识别写了一半的尾部记录
+    struct __attribute__((packed)) JournalRecord {
+        uint32_t timestamp;
+        uint16_t bird_id;
+        uint16_t check;
+    };
+
+    // bird_id到稠密索引的映射项（按bird_id排序，二分查找）
+    struct IdIndex {
+        uint16_t bird_id;
+        uint16_t index;
+    };
+
+    // 扁平统计表，下标为稠密索引
+    std::vector<uint16_t> bird_ids_;          // 稠密索引 -> bird_id
+    std::vector<uint32_t> counts_;            // 稠密索引 -> 遇见次数
+    std::vector<IdIndex> id_index_;           // bird_id -> 稠密索引
+    std::vector<uint16_t> rank_;              // 排名 -> 稠密索引（前seen_species_项次数>0）
+    std::vector<uint16_t> rank_pos_;          // 稠密索引 -> 排名
+    uint16_t seen_species_;                   // 遇见过的种类数
     int total_encounters_;                    // 总遇见次数
-    std::string data_file_;                   // 数据文件路径
+    std::string legacy_file_;                 // 旧版JSON文件路径（仅用于迁移）
 
-    // 从文件解析统计数据
-    bool parseStatsFromFile(const char* content);
+    std::vector<JournalRecord> pending_;      // 尚未写入日志的记录
+    uint32_t journal_records_;                // 日志中属于当前快照的记录数（0时下次追加重建日志）
+    uint32_t snapshot_epoch_;                 // 当前快照代数（由io_mutex_保护）
+    bool snapshot_dirty_;                     // 需要改写快照（重置/迁移后）
+
+    // 以上数据由data_mutex_保护；io_mutex_串行化写卡
+    SemaphoreHandle_t data_mutex_;
+    SemaphoreHandle_t io_mutex_;
+    TaskHandle_t saver_task_;
+    volatile bool stop_saver_;                // 析构时通知后台任务退出
+    SemaphoreHandle_t saver_done_;            // 后台任务退出前释放
+
+    // 脏代数：dirty_gen_每次修改递增，saved_gen_为最近一次成功写卡时的代数
+    volatile uint32_t dirty_gen_;
+    volatile uint32_t saved_gen_;
+    uint32_t first_dirty_ms_;                 // 本轮第一次变脏的时间（0表示干净）
+    uint32_t coalesce_ms_;                    // 合并写入窗口
+    StatsSaveStats save_stats_;
+
+    // 标记数据已修改并唤醒后台任务（调用者持有data_mutex_）
+    void markDirtyLocked();
+
+    // 查找bird_id的稠密索引，不存在时返回-1
+    int findIndex(uint16_t bird_id) const;
+
+    // 以下两个读取函数要求调用者持有data_mutex_
+    int countForLocked(uint16_t bird_id) const;
+    uint16_t rankedIdLocked(size_t rank) const {
+        return rank < seen_species_ ? bird_ids_[rank_[rank]] : 0;
+    }
+
+    // 查找bird_id的稠密索引，不存在时追加一项
+    uint16_t indexForLocked(uint16_t bird_id);
+
+    // 排名比较：次数多的在前，次数相同时稠密索引小的在前
+    bool ranksBefore(uint16_t a, uint16_t b) const {
+        return counts_[a] > counts_[b] || (counts_[a] == counts_[b] && a < b);
+    }
+
+    // 次数加一并把该项向前移到新的排名位置
+    void incrementLocked(uint16_t index);
+
+    // 直接改写counts_后（加载/重置）重新排序并统计种类数
+    void rebuildRankLocked();
 
-    // 将统计数据格式化为JSON字符串
-    std::string formatStatsAsJson() const;
+    // 清空所有次数（保留索引）
+    void clearCountsLocked();
+
+    static void saverTaskFunction(void* parameter);
+
+    /**
+     * 追加日志记录
+     *
+     * @param fresh 日志中还没有当前快照的记录：截断重建并先写文件头
+     */
+    bool appendJournal(const std::vector<JournalRecord>& records, bool fresh);
+
+    // 读取快照；快照缺失或损坏时从完整的临时文件恢复，都不可用时返回false（调用者持有两把锁）
+    bool loadSnapshot();
+
+    // 读取并校验一个快照文件
+    bool readSnapshotFile(const char* path, std::vector<SnapshotEntry>& entries, uint32_t& epoch);
+
+    /**
+     * 重放日志，返回重放的记录数（调用者持有两把锁）
+     *
+     * @param has_snapshot 已加载快照时只重放epoch与之相同的日志
+     */
+    uint32_t replayJournal(bool has_snapshot);
+
+    // 写入快照并清空日志
+    bool writeSnapshot(const std::vector<SnapshotEntry>& entries, uint32_t total_encounters);
+
+    // 从旧版JSON文件迁移
+    bool migrateLegacyJson();
+
+    // 从文件解析统计数据（内部持有data_mutex_）
+    bool parseStatsFromFile(const char* content);
 };
 
 } // namespace BirdWatching
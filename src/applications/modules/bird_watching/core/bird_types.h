@@ -17,10 +17,11 @@ struct BirdInfo {
     std::string name;          // 小鸟名称（中文）
     uint16_t weight;           // 权重（用于随机选择）
     mutable uint16_t frame_count; // 帧数缓存（0表示未检测，支持最多65535帧，使用mutable允许在const方法中修改）
+    uint32_t bundle_size;      // 目录缓存中记录的bundle大小（0表示未知）
 
-    BirdInfo() : id(0), name(""), weight(10), frame_count(0) {}
+    BirdInfo() : id(0), name(""), weight(10), frame_count(0), bundle_size(0) {}
     BirdInfo(uint16_t bird_id, const std::string& bird_name, uint16_t bird_weight = 10)
-        : id(bird_id), name(bird_name), weight(bird_weight), frame_count(0) {}
+        : id(bird_id), name(bird_name), weight(bird_weight), frame_count(0), bundle_size(0) {}
 };
 
 // 全局配置结构
@@ -28,13 +29,13 @@ struct BirdConfig {
     uint32_t auto_trigger_interval;      // 自动触发间隔（秒）
     bool enable_gesture_trigger;         // 启用手势触发
     int16_t gesture_threshold;           // 手势检测阈值
-    uint32_t stats_save_interval;        // 统计数据保存间隔（秒，已废弃，固定10秒）
+    uint32_t stats_save_interval;        // 统计数据合并写入窗口（秒），变脏后最多等待这么久再写卡
 
     BirdConfig()
         : auto_trigger_interval(900)
         , enable_gesture_trigger(true)
         , gesture_threshold(3000)
-        , stats_save_interval(10) {}  // 固定为10秒
+        , stats_save_interval(10) {}
 };
 
 } // namespace BirdWatching
@@ -1,6 +1,7 @@
 #include "bird_utils.h"
 #include "hal/sd_interface.h"
 #include <cstdio>
+#include <cstring>
 #include <Arduino.h>
 
 namespace BirdWatching {
@@ -10,8 +11,7 @@ namespace Utils {
 constexpr uint32_t BUNDLE_MAGIC = 0x42495244;
 constexpr uint8_t RGB565_COLOR_FORMAT = 0x12;
 
-uint16_t detectFrameCount(uint16_t bird_id) {
-    // Bundle模式：直接从bundle文件头读取帧数
+bool readBundleInfo(uint16_t bird_id, BundleInfo& info) {
     char bundle_path[64];
     snprintf(bundle_path, sizeof(bundle_path), "/birds/%d/bundle.bin", bird_id);
 
@@ -19,53 +19,66 @@ uint16_t detectFrameCount(uint16_t bird_id) {
     File bundle_file = fs.open(bundle_path);
     if (!bundle_file) {
         Serial.printf("[WARN] Bundle not found: %s\n", bundle_path);
-        return 0;
+        return false;
     }
 
-    // 读取bundle文件头的前20字节（足够获取frame_count）
-    // Bundle Header结构：
+    // Bundle Header前16字节：
     // - magic (4B)
     // - version (2B)
-    // - frame_count (2B) <-- 我们需要这个
+    // - frame_count (2B)
     // - frame_width (2B)
     // - frame_height (2B)
-    // ...
-
-    uint32_t magic = 0;
-    uint16_t version = 0;
-    uint16_t frame_count = 0;
-    uint16_t frame_width = 0;
-    uint16_t frame_height = 0;
-    uint32_t frame_size = 0;
+    // - frame_size (4B)
+    uint8_t header[16];
+    bool ok = bundle_file.read(header, sizeof(header)) == sizeof(header);
+    info.file_size = bundle_file.size();
+    info.mtime = (uint32_t)bundle_file.getLastWrite();
+    bundle_file.close();
 
-    // 读取关键字段
-    if (bundle_file.read((uint8_t*)&magic, 4) != 4 ||
-        bundle_file.read((uint8_t*)&version, 2) != 2 ||
-        bundle_file.read((uint8_t*)&frame_count, 2) != 2 ||
-        bundle_file.read((uint8_t*)&frame_width, 2) != 2 ||
-        bundle_file.read((uint8_t*)&frame_height, 2) != 2 ||
-        bundle_file.read((uint8_t*)&frame_size, 4) != 4) {
+    if (!ok) {
         Serial.printf("[ERROR] Failed to read bundle header: %s\n", bundle_path);
-        bundle_file.close();
-        return 0;
+        return false;
     }
 
-    bundle_file.close();
+    uint32_t magic;
+    memcpy(&magic, header, 4);
+    memcpy(&info.frame_count, header + 6, 2);
+    memcpy(&info.frame_width, header + 8, 2);
+    memcpy(&info.frame_height, header + 10, 2);
 
     // 验证魔数
     if (magic != BUNDLE_MAGIC) {
         Serial.printf("[ERROR] Invalid bundle magic: 0x%08X (expected 0x%08X)\n", magic, BUNDLE_MAGIC);
-        return 0;
+        return false;
     }
 
     // 验证帧数合理性（支持最多65535帧）
-    if (frame_count == 0 || frame_count > 65535) {
-        Serial.printf("[WARN] Suspicious frame count: %d\n", frame_count);
+    if (info.frame_count == 0) {
+        Serial.printf("[WARN] Suspicious frame count: %d\n", info.frame_count);
+        return false;
+    }
+
+    return true;
+}
+
+uint16_t detectFrameCount(uint16_t bird_id) {
+    // Bundle模式：直接从bundle文件头读取帧数
+    BundleInfo info;
+    if (!readBundleInfo(bird_id, info)) {
         return 0;
     }
 
-    Serial.printf("[INFO] Bundle detected: %d frames, %dx%d\n", frame_count, frame_width, frame_height);
-    return frame_count;
+    Serial.printf("[INFO] Bundle detected: %d frames, %dx%d\n", info.frame_count, info.frame_width, info.frame_height);
+    return info.frame_count;
+}
+
+uint32_t fnv1a(const uint8_t* data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
 }
 
 } // namespace Utils
@@ -2,10 +2,33 @@
 #define BIRD_UTILS_H
 
 #include <cstdint>
+#include <cstddef>
 
 namespace BirdWatching {
 namespace Utils {
 
+/**
+ * @brief bundle文件的基本信息（来自文件头和目录项）
+ */
+struct BundleInfo {
+    uint16_t frame_count;
+    uint16_t frame_width;
+    uint16_t frame_height;
+    uint32_t file_size;
+    uint32_t mtime;            // 最后修改时间（FAT时间戳）
+};
+
+/**
+ * @brief 读取小鸟bundle的文件头信息
+ *
+ * 只打开一次文件并一次读取文件头
+ *
+ * @param bird_id 小鸟ID
+ * @param info 输出的bundle信息
+ * @return bundle存在且文件头有效时返回true
+ */
+bool readBundleInfo(uint16_t bird_id, BundleInfo& info);
+
 /**
  * @brief 从bundle文件检测小鸟的帧数
  *
@@ -16,6 +39,11 @@ namespace Utils {
  */
 uint16_t detectFrameCount(uint16_t bird_id);
 
+/**
+ * @brief 计算FNV-1a 32位校验（用于SD卡上的二进制缓存文件）
+ */
+uint32_t fnv1a(const uint8_t* data, size_t len);
+
 } // namespace Utils
 } // namespace BirdWatching
 
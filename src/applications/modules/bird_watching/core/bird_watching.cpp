@@ -1,12 +1,22 @@
 #include "bird_watching.h"
 #include "bird_utils.h"
+#include "frame_upscaler.h"
+#include "bird_catalog.h"
 #include "system/logging/log_manager.h"
+#include "system/tasks/task_manager.h"
+#include "esp_system.h"
 
 namespace BirdWatching {
 
 // 全局观鸟管理器实例
 BirdManager* g_birdManager = nullptr;
 
+// esp_restart()前保存未写卡的统计数据
+// 关机处理函数里不能无限等待：持有统计锁的任务可能已无法继续运行，超时则放弃保存
+static void flushStatisticsOnShutdown() {
+    flushBirdStatistics(pdMS_TO_TICKS(BIRD_STATS_SHUTDOWN_WAIT_MS));
+}
+
 bool initializeBirdWatching(lv_obj_t* display_obj) {
     if (g_birdManager) {
         LOG_WARN("BIRD", "Bird watching system already initialized");
@@ -28,6 +38,8 @@ bool initializeBirdWatching(lv_obj_t* display_obj) {
         return false;
     }
 
+    esp_register_shutdown_handler(flushStatisticsOnShutdown);
+
     LOG_INFO("BIRD", "Bird Watching System initialized successfully");
     return true;
 }
@@ -65,7 +77,8 @@ void onGesture(int gesture_type) {
         return;
     }
 
-    g_birdManager->onGestureEvent(gesture_type);
+    // 投递到命令邮箱，由UI任务处理
+    g_birdManager->postGesture(gesture_type);
 }
 
 void showBirdStatistics() {
@@ -163,7 +176,80 @@ int getStatisticsCount() {
     if (!g_birdManager) {
         return 0;
     }
-    return g_birdManager->getStatistics().getEncounteredBirdIds().size();
+    return g_birdManager->getStatistics().getSeenSpeciesCount();
+}
+
+void printAnimationStatus() {
+    if (!g_birdManager || !g_birdManager->getAnimation()) {
+        return;
+    }
+
+    const BirdAnimation* animation = g_birdManager->getAnimation();
+    const BirdBundleLoader& loader = animation->getBundleLoader();
+    if (loader.isLoaded()) {
+        Serial.println("Bundle: " + String(loader.isResident() ? "resident in PSRAM" : "streaming from SD") +
+                       ", " + String(loader.getBundleSize() / 1024) + " KB (budget " +
+                       String(loader.getResidentBudget() / 1024) + " KB), " +
+                       String(animation->getFrameInterval()) + "ms/frame");
+        Serial.println("  Format: v" + String(loader.getVersion()) + ", avg " +
+                       String(loader.getAverageFrameBytes()) + " bytes read/frame (raw " +
+                       String(loader.getFrameDataSize()) + ")");
+    }
+
+    const FramePoolStats& stats = animation->getFramePoolStats();
+    Serial.println("Frame Pool: " + String(FramePool::SLOT_COUNT) + " slots, " +
+                   String(stats.slab_bytes) + " bytes (" + String(stats.in_psram ? "PSRAM" : "internal RAM") + ")");
+    Serial.println("  Slab allocations: " + String(stats.slab_allocations));
+    Serial.println("  Allocations during playback: " + String(stats.allocs_during_playback));
+    Serial.println("  Frames loaded: " + String(stats.frames_loaded));
+    Serial.println("  Upscale: " + String(!stats.upscale_buffers ? "LVGL zoom" :
+                                          (BIRD_FRAME_UPSCALE == 2 ? "2x bilinear (prefetch core)"
+                                                                   : "2x nearest (prefetch core)")));
+
+    const DirtyRectStats& dirty = animation->getDirtyRectStats();
+    uint32_t shown = dirty.frames_full + dirty.frames_partial + dirty.frames_unchanged;
+    Serial.println("Dirty rects: " + String(dirty.frames_partial) + " partial, " +
+                   String(dirty.frames_full) + " full, " + String(dirty.frames_unchanged) + " unchanged, avg " +
+                   String(shown ? (uint32_t)(dirty.pixels_invalidated / shown) : 0) + " px/frame");
+
+    const FramePrefetchStats& prefetch = animation->getPrefetchStats();
+    Serial.println("Prefetch: depth " + String(FRAME_PREFETCH_DEPTH) + ", core " + String(PREFETCH_TASK_CORE));
+    Serial.println("  Frames prefetched: " + String(prefetch.frames_prefetched));
+    Serial.println("  Underruns: " + String(prefetch.underruns));
+    Serial.println("  Load errors: " + String(prefetch.load_errors));
+    Serial.println("  Max load time: " + String(prefetch.max_load_ms) + "ms");
+    Serial.println("  Max upscale time: " + String(prefetch.max_upscale_us) + "us");
+    Serial.println("  Cancels: " + String(prefetch.cancels));
+
+    const ClipStats* clips[2] = { &animation->getClipStats(), &animation->getLastClipStats() };
+    const char* clip_labels[2] = { "Current clip", "Last clip" };
+    for (int i = 0; i < 2; i++) {
+        const ClipStats& clip = *clips[i];
+        if (clip.frames_shown == 0) {
+            continue;
+        }
+        Serial.println(String(clip_labels[i]) + ": bird " + String(clip.bird_id) + ", " +
+                       String(clip.frames_shown) + " frames in " + String(clip.duration_ms) + "ms");
+        Serial.println("  FPS: " + String(clip.achieved_fps_x10 / 10) + "." + String(clip.achieved_fps_x10 % 10) +
+                       " (target " + String(clip.target_fps) + ")");
+        Serial.println("  Late: " + String(clip.frames_late) + ", skipped: " + String(clip.frames_skipped) +
+                       ", max late: " + String(clip.max_late_ms) + "ms");
+    }
+
+    BirdMailboxStats mailbox = g_birdManager->getMailboxStats();
+    Serial.println("Command mailbox: " + String(mailbox.posted) + " posted, " +
+                   String(mailbox.taken) + " taken, " + String(mailbox.coalesced) + " coalesced");
+}
+
+bool flushBirdStatistics(TickType_t wait) {
+    if (!g_birdManager) {
+        return false;
+    }
+    return g_birdManager->flushStatistics(wait);
+}
+
+void invalidateBirdCatalog() {
+    BirdCatalog::invalidate();
 }
 
 } // namespace BirdWatching
\ No newline at end of file
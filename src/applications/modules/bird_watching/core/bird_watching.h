@@ -36,7 +36,7 @@ void processBirdTriggerRequest();
 // bird_id: 小鸟ID，0表示随机选择
 bool triggerBird(uint16_t bird_id = 0);
 
-// 便捷函数：处理手势事件
+// 便捷函数：投递手势事件（任意任务可调用，不需要LVGL锁）
 void onGesture(int gesture_type);
 
 // 便捷函数：获取观鸟统计
@@ -54,6 +54,16 @@ bool isAnimationPlaying();
 bool isStatsViewVisible();
 int getStatisticsCount();
 
+// 便捷函数：打印动画帧池状态（零分配计数器）
+void printAnimationStatus();
+
+// 便捷函数：立即保存未写卡的统计数据（重启/深度睡眠前调用）
+// wait为等待统计互斥锁的最长时间，超时放弃保存
+bool flushBirdStatistics(TickType_t wait = portMAX_DELAY);
+
+// 便捷函数：小鸟资源或配置变化时使目录缓存失效（下次开机重建）
+void invalidateBirdCatalog();
+
 // 全局观鸟管理器实例（外部声明）
 extern BirdManager* g_birdManager;
 
@@ -0,0 +1,100 @@
+#include "frame_pool.h"
+#include "system/logging/log_manager.h"
+#include <esp_heap_caps.h>
+#include <cstring>
+
+namespace BirdWatching {
+
+FramePool::FramePool()
+    : slab_(nullptr)
+    , slot_capacity_(0)
+    , scaled_capacity_(0)
+    , playback_active_(false)
+{
+    memset(&stats_, 0, sizeof(stats_));
+    memset(slots_, 0, sizeof(slots_));
+}
+
+FramePool::~FramePool() {
+    freeSlab();
+}
+
+bool FramePool::reserve(uint32_t frame_bytes, uint32_t scaled_bytes) {
+    if (frame_bytes == 0) {
+        LOG_ERROR("POOL", "Invalid frame size: 0");
+        return false;
+    }
+
+    // 容量足够则直接复用（切换同尺寸小鸟不会重新分配）
+    // 预放大缓冲区必须与请求一致：不需要时不保留，避免浪费内存
+    bool scaled_fits = scaled_bytes ? (scaled_bytes <= scaled_capacity_) : (scaled_capacity_ == 0);
+    if (slab_ && frame_bytes <= slot_capacity_ && scaled_fits) {
+        return true;
+    }
+
+    freeSlab();
+
+    // 每个槽按4字节对齐
+    uint32_t capacity = (frame_bytes + 3) & ~3u;
+    uint32_t scaled_capacity = (scaled_bytes + 3) & ~3u;
+    size_t stride = (size_t)capacity + scaled_capacity;
+    size_t slab_size = stride * SLOT_COUNT;
+
+    bool in_psram = false;
+#ifdef BOARD_HAS_PSRAM
+    slab_ = static_cast<uint8_t*>(heap_caps_malloc(slab_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    in_psram = (slab_ != nullptr);
+#endif
+    if (!slab_) {
+        slab_ = static_cast<uint8_t*>(heap_caps_malloc(slab_size, MALLOC_CAP_8BIT));
+    }
+
+    if (!slab_) {
+        LOG_ERROR("POOL", "Failed to allocate frame slab: " + String((unsigned long)slab_size) + " bytes");
+        return false;
+    }
+
+    slot_capacity_ = capacity;
+    scaled_capacity_ = scaled_capacity;
+    for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+        slots_[i].buffer = slab_ + stride * i;
+        slots_[i].capacity = capacity;
+        slots_[i].scaled = scaled_capacity ? slots_[i].buffer + capacity : nullptr;
+        slots_[i].scaled_capacity = scaled_capacity;
+        slots_[i].upscaled = false;
+        slots_[i].frame_index = 0;
+        memset(&slots_[i].dsc, 0, sizeof(lv_image_dsc_t));
+    }
+
+    stats_.slab_allocations++;
+    if (playback_active_) {
+        stats_.allocs_during_playback++;
+    }
+    stats_.slab_bytes = slab_size;
+    stats_.in_psram = in_psram;
+    stats_.upscale_buffers = (scaled_capacity != 0);
+
+    LOG_INFO("POOL", "Frame slab allocated: " + String(SLOT_COUNT) + " x " + String((unsigned long)stride) +
+             " bytes in " + String(in_psram ? "PSRAM" : "internal RAM") +
+             (scaled_capacity ? " (with 2x upscale buffers)" : ""));
+    return true;
+}
+
+void FramePool::freeSlab() {
+    if (slab_) {
+        heap_caps_free(slab_);
+        slab_ = nullptr;
+    }
+    slot_capacity_ = 0;
+    scaled_capacity_ = 0;
+    for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+        slots_[i].buffer = nullptr;
+        slots_[i].capacity = 0;
+        slots_[i].scaled = nullptr;
+        slots_[i].scaled_capacity = 0;
+    }
+    stats_.slab_bytes = 0;
+    stats_.upscale_buffers = false;
+}
+
+} // namespace BirdWatching
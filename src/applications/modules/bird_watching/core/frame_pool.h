@@ -0,0 +1,111 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <cstdint>
+
+// 预取深度：播放头之前最多准备好的帧数（可通过-D覆盖）
+#ifndef FRAME_PREFETCH_DEPTH
+#define FRAME_PREFETCH_DEPTH 3
+#endif
+
+namespace BirdWatching {
+
+/**
+ * 帧槽
+ *
+ * 描述符内嵌在槽中，像素缓冲区指向帧池slab中的固定区域，
+ * 播放过程中槽按环形顺序复用，不做任何堆分配
+ */
+struct FrameSlot {
+    lv_image_dsc_t dsc;      // LVGL图像描述符（dsc.data指向实际像素）
+    uint8_t* buffer;         // 槽自有的像素缓冲区（slab中的一段）
+    uint32_t capacity;       // 缓冲区容量（字节）
+    uint8_t* scaled;         // 预放大缓冲区（未启用预放大时为nullptr）
+    uint32_t scaled_capacity; // 预放大缓冲区容量（字节）
+    bool upscaled;           // dsc是否指向放大后的图像
+    uint16_t frame_index;    // 当前装载的帧索引
+    lv_area_t dirty;         // 相对上一帧变化的区域（图像坐标，无上一帧时为整帧）
+    bool changed;            // 与上一帧是否有差异（false时dirty无意义）
+};
+
+/**
+ * 帧池统计（用于证明稳态播放零分配）
+ */
+struct FramePoolStats {
+    uint32_t slab_allocations;      // slab分配次数（仅在帧尺寸变大时发生）
+    uint32_t allocs_during_playback; // 播放期间发生的分配次数（稳态应为0）
+    uint32_t frames_loaded;         // 累计装载帧数
+    uint32_t slab_bytes;            // 当前slab大小（字节，含预放大缓冲区）
+    bool in_psram;                  // slab是否位于PSRAM
+    bool upscale_buffers;           // 是否带有2倍预放大缓冲区
+};
+
+/**
+ * 固定帧缓冲池
+ *
+ * 一次性分配SLOT_COUNT个帧缓冲区组成的slab（有PSRAM时优先放入PSRAM），
+ * 大小由bundle头部的帧尺寸决定。切换小鸟时若帧尺寸不变则直接复用，
+ * 长时间运行也不会因为逐帧malloc/free造成堆碎片
+ *
+ * 槽的所有权由FramePrefetcher的环形队列管理，帧池本身不做借还记录
+ */
+class FramePool {
+public:
+    static constexpr uint8_t SLOT_COUNT = FRAME_PREFETCH_DEPTH + 1;  // 预取帧 + 当前显示帧
+
+    FramePool();
+    ~FramePool();
+
+    /**
+     * 确保每个槽至少能容纳frame_bytes字节
+     *
+     * 调用时不能有任务正在使用槽（预取任务须已停止）
+     *
+     * @param frame_bytes 单帧像素数据大小（字节）
+     * @param scaled_bytes 每个槽的预放大缓冲区大小（字节），0表示不需要
+     * @return 成功返回true
+     */
+    bool reserve(uint32_t frame_bytes, uint32_t scaled_bytes = 0);
+
+    /**
+     * 按下标获取槽（index < SLOT_COUNT）
+     */
+    FrameSlot* slot(uint8_t index) { return &slots_[index % SLOT_COUNT]; }
+
+    /**
+     * 槽是否已分配缓冲区
+     */
+    bool isReady() const { return slab_ != nullptr; }
+
+    /**
+     * 标记播放状态，用于统计播放期间的分配
+     */
+    void setPlaybackActive(bool active) { playback_active_ = active; }
+
+    /**
+     * 记录一次成功装载的帧
+     */
+    void countFrameLoaded() { stats_.frames_loaded++; }
+
+    const FramePoolStats& getStats() const { return stats_; }
+
+private:
+    FrameSlot slots_[SLOT_COUNT];
+    uint8_t* slab_;
+    uint32_t slot_capacity_;
+    uint32_t scaled_capacity_;
+    bool playback_active_;
+    FramePoolStats stats_;
+
+    void freeSlab();
+
+    // 禁止拷贝
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+};
+
+} // namespace BirdWatching
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,204 @@
+#include "frame_prefetcher.h"
+#include "frame_upscaler.h"
+#include "system/logging/log_manager.h"
+#include "system/tasks/task_manager.h"
+#include "system/logging/trace_buffer.h"
+#include <cstring>
+
+namespace BirdWatching {
+
+FramePrefetcher::FramePrefetcher(FramePool& pool, BirdBundleLoader& loader)
+    : pool_(pool)
+    , loader_(loader)
+    , task_handle_(nullptr)
+    , write_count_(0)
+    , consume_count_(0)
+    , release_count_(0)
+    , running_(false)
+    , command_gen_(0)
+    , ack_gen_(0)
+    , failed_(false)
+    , next_frame_(0)
+    , frame_count_(0)
+    , consecutive_errors_(0)
+{
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+FramePrefetcher::~FramePrefetcher() {
+    cancel();
+    if (task_handle_) {
+        vTaskDelete(task_handle_);
+        task_handle_ = nullptr;
+    }
+}
+
+bool FramePrefetcher::begin() {
+    if (task_handle_) {
+        return true;
+    }
+
+    // 预取任务运行在系统核，SD卡读取不再占用UI核
+    BaseType_t result = xTaskCreatePinnedToCore(
+        taskFunction,
+        "Prefetch_Task",
+        PREFETCH_TASK_STACK_SIZE,
+        this,
+        PREFETCH_TASK_PRIORITY,
+        &task_handle_,
+        PREFETCH_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        LOG_ERROR("PREFETCH", "Failed to create prefetch task");
+        task_handle_ = nullptr;
+        return false;
+    }
+
+    LOG_INFO("PREFETCH", "Prefetch task created on Core " + String(PREFETCH_TASK_CORE) +
+             ", depth " + String(FRAME_PREFETCH_DEPTH));
+    return true;
+}
+
+void FramePrefetcher::start(uint16_t first_frame, uint16_t frame_count) {
+    // 预取任务必须空闲才能重置环形队列
+    if (ack_gen_.load(std::memory_order_acquire) != command_gen_.load(std::memory_order_relaxed)) {
+        cancel();
+    }
+
+    write_count_.store(0, std::memory_order_relaxed);
+    consume_count_.store(0, std::memory_order_relaxed);
+    release_count_.store(0, std::memory_order_relaxed);
+    next_frame_ = first_frame;
+    frame_count_ = frame_count;
+    consecutive_errors_ = 0;
+    failed_.store(false, std::memory_order_relaxed);
+
+    // release语义保证预取任务看到running_时上面的状态也已可见
+    running_.store(true, std::memory_order_release);
+    command_gen_.fetch_add(1, std::memory_order_release);
+
+    if (task_handle_) {
+        xTaskNotifyGive(task_handle_);
+    }
+}
+
+bool FramePrefetcher::cancel(uint32_t timeout_ms) {
+    running_.store(false, std::memory_order_release);
+    uint32_t gen = command_gen_.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    if (!task_handle_) {
+        ack_gen_.store(gen, std::memory_order_release);
+        return true;
+    }
+
+    // 唤醒预取任务并等待它确认（最长等待一次帧读取的时间）
+    xTaskNotifyGive(task_handle_);
+    unsigned long start = millis();
+    while (ack_gen_.load(std::memory_order_acquire) != gen) {
+        if (millis() - start > timeout_ms) {
+            LOG_ERROR("PREFETCH", "Prefetch task did not stop within " + String(timeout_ms) + "ms");
+            return false;
+        }
+        vTaskDelay(1);
+    }
+
+    stats_.cancels++;
+    return true;
+}
+
+FrameSlot* FramePrefetcher::takeReady() {
+    uint32_t consumed = consume_count_.load(std::memory_order_relaxed);
+    if (consumed == write_count_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    consume_count_.store(consumed + 1, std::memory_order_release);
+    return pool_.slot(consumed % FramePool::SLOT_COUNT);
+}
+
+void FramePrefetcher::releaseOldest() {
+    uint32_t released = release_count_.load(std::memory_order_relaxed);
+    if (released == consume_count_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    release_count_.store(released + 1, std::memory_order_release);
+
+    // 有空闲槽了，立即唤醒预取任务
+    if (task_handle_) {
+        xTaskNotifyGive(task_handle_);
+    }
+}
+
+uint32_t FramePrefetcher::readyCount() const {
+    return write_count_.load(std::memory_order_acquire) -
+           consume_count_.load(std::memory_order_relaxed);
+}
+
+void FramePrefetcher::taskFunction(void* parameter) {
+    FramePrefetcher* prefetcher = static_cast<FramePrefetcher*>(parameter);
+    prefetcher->run();
+}
+
+void FramePrefetcher::run() {
+    while (true) {
+        uint32_t gen = command_gen_.load(std::memory_order_acquire);
+
+        // 空闲：确认当前命令后等待start()唤醒
+        if (!running_.load(std::memory_order_acquire) || failed_.load(std::memory_order_relaxed)) {
+            ack_gen_.store(gen, std::memory_order_release);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // 环已满：等待UI任务归还槽
+        uint32_t written = write_count_.load(std::memory_order_relaxed);
+        if (written - release_count_.load(std::memory_order_acquire) >= FramePool::SLOT_COUNT) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IDLE_WAIT_MS));
+            continue;
+        }
+
+        FrameSlot* slot = pool_.slot(written % FramePool::SLOT_COUNT);
+        unsigned long load_start = millis();
+        TRACE_EVENT(TRACE_FRAME_LOAD_BEGIN, next_frame_);
+        bool ok = loader_.loadFrame(next_frame_, *slot);
+        uint32_t load_ms = millis() - load_start;
+
+        // 预放大在预取任务中完成，UI核只需1倍绘制
+        if (ok && slot->scaled) {
+            unsigned long upscale_start = micros();
+            FrameUpscaler::upscaleSlot(*slot);
+            uint32_t upscale_us = micros() - upscale_start;
+            if (upscale_us > stats_.max_upscale_us) {
+                stats_.max_upscale_us = upscale_us;
+            }
+        }
+        TRACE_EVENT(TRACE_FRAME_LOAD_END, next_frame_);
+
+        if (!ok) {
+            stats_.load_errors++;
+            if (++consecutive_errors_ >= MAX_CONSECUTIVE_ERRORS) {
+                LOG_ERROR("PREFETCH", "Prefetch stopped after " + String(consecutive_errors_) +
+                          " consecutive load failures (frame " + String(next_frame_) + ")");
+                failed_.store(true, std::memory_order_release);
+            } else {
+                vTaskDelay(1);
+            }
+            continue;
+        }
+
+        consecutive_errors_ = 0;
+        pool_.countFrameLoaded();
+        stats_.frames_prefetched++;
+        if (load_ms > stats_.max_load_ms) {
+            stats_.max_load_ms = load_ms;
+        }
+
+        // 发布帧槽：release语义保证UI任务看到计数时像素数据已写完
+        write_count_.store(written + 1, std::memory_order_release);
+        next_frame_ = (next_frame_ + 1) % frame_count_;
+    }
+}
+
+} // namespace BirdWatching
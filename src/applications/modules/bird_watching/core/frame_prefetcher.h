@@ -0,0 +1,131 @@
+#ifndef FRAME_PREFETCHER_H
+#define FRAME_PREFETCHER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "frame_pool.h"
+#include "bird_bundle_loader.h"
+
+namespace BirdWatching {
+
+/**
+ * 帧预取统计
+ */
+struct FramePrefetchStats {
+    uint32_t frames_prefetched;     // 预取完成的帧数
+    uint32_t underruns;             // 到点时下一帧尚未就绪的次数
+    uint32_t load_errors;           // 帧读取失败次数
+    uint32_t max_load_ms;           // 单帧最长读取耗时
+    uint32_t max_upscale_us;        // 单帧最长预放大耗时（微秒）
+    uint32_t cancels;               // 取消次数（切换小鸟/停止播放）
+};
+
+/**
+ * 帧预取器
+ *
+ * 在绑定到系统核的独立I/O任务中按播放顺序读取帧，始终保持播放头之前
+ * 最多FRAME_PREFETCH_DEPTH帧就绪。预取任务（生产者）与UI任务（消费者）
+ * 通过单生产者单消费者的无锁环形队列交接帧槽：
+ *
+ *   [release_count_, consume_count_)  UI已取出、仍被LVGL引用的槽
+ *   [consume_count_, write_count_)    已就绪、等待显示的槽
+ *   [write_count_, release_count_+N)  空闲槽，预取任务可写入
+ *
+ * 每个计数器只由一方写入，因此不需要互斥锁，UI任务播放期间不会访问SD卡
+ */
+class FramePrefetcher {
+public:
+    FramePrefetcher(FramePool& pool, BirdBundleLoader& loader);
+    ~FramePrefetcher();
+
+    /**
+     * 创建预取任务（只需调用一次）
+     */
+    bool begin();
+
+    /**
+     * 从指定帧开始预取
+     *
+     * 调用前预取任务必须处于空闲状态（初始状态或cancel()之后）
+     *
+     * @param first_frame 第一个要预取的帧
+     * @param frame_count bundle总帧数
+     */
+    void start(uint16_t first_frame, uint16_t frame_count);
+
+    /**
+     * 取消预取并等待预取任务离开loadFrame
+     *
+     * 返回后bundle加载器和帧池可以安全地被关闭或重新分配
+     *
+     * @param timeout_ms 等待超时时间
+     * @return 预取任务已确认空闲返回true
+     */
+    bool cancel(uint32_t timeout_ms = 500);
+
+    /**
+     * 取出下一个就绪的帧槽（仅UI任务调用），未就绪时返回nullptr
+     */
+    FrameSlot* takeReady();
+
+    /**
+     * 归还最早取出的帧槽（仅UI任务调用，LVGL已不再引用该槽）
+     */
+    void releaseOldest();
+
+    /**
+     * 预取任务是否因连续读取失败而停止
+     */
+    bool hasFailed() const { return failed_.load(std::memory_order_acquire); }
+
+    /**
+     * 当前已就绪的帧数
+     */
+    uint32_t readyCount() const;
+
+    /**
+     * 记录一次欠载（UI到点但没有就绪帧）
+     */
+    void countUnderrun() { stats_.underruns++; }
+
+    const FramePrefetchStats& getStats() const { return stats_; }
+
+private:
+    static constexpr uint8_t MAX_CONSECUTIVE_ERRORS = 3;
+    static constexpr uint32_t IDLE_WAIT_MS = 50;    // 环满时的最长等待（UI归还槽时会立即唤醒）
+
+    FramePool& pool_;
+    BirdBundleLoader& loader_;
+    TaskHandle_t task_handle_;
+
+    // 环形队列计数器（单调递增，取模SLOT_COUNT得到槽下标）
+    std::atomic<uint32_t> write_count_;     // 预取任务写入
+    std::atomic<uint32_t> consume_count_;   // UI任务写入
+    std::atomic<uint32_t> release_count_;   // UI任务写入
+
+    // 控制握手
+    std::atomic<bool> running_;             // UI任务写入：是否需要预取
+    std::atomic<uint32_t> command_gen_;     // UI任务写入：每次start/cancel递增
+    std::atomic<uint32_t> ack_gen_;         // 预取任务写入：已确认空闲的命令代数
+    std::atomic<bool> failed_;              // 预取任务写入：连续失败后停止
+
+    // 预取任务私有状态（start()时由UI任务在任务空闲期间设置）
+    uint16_t next_frame_;
+    uint16_t frame_count_;
+    uint8_t consecutive_errors_;
+
+    FramePrefetchStats stats_;
+
+    static void taskFunction(void* parameter);
+    void run();
+
+    // 禁止拷贝
+    FramePrefetcher(const FramePrefetcher&) = delete;
+    FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+};
+
+} // namespace BirdWatching
+
+#endif // FRAME_PREFETCHER_H
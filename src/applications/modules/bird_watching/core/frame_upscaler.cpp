@@ -0,0 +1,106 @@
+#include "frame_upscaler.h"
+#include <cstring>
+
+namespace BirdWatching {
+namespace FrameUpscaler {
+
+namespace {
+    // 两个RGB565像素的逐通道平均（不拆分通道，去掉每个通道的最低位后相加）
+    inline uint16_t average565(uint16_t a, uint16_t b) {
+        return (a & b) + (((a ^ b) & 0xF7DE) >> 1);
+    }
+}
+
+void upscale2xNearest(const uint16_t* src, uint16_t width, uint16_t height, uint16_t* dst) {
+    const size_t dst_row_bytes = (size_t)width * 4;
+
+    for (uint16_t y = 0; y < height; y++) {
+        const uint16_t* s = src + (size_t)y * width;
+        uint32_t* d = reinterpret_cast<uint32_t*>(dst + (size_t)y * 2 * width * 2);
+
+        // 小端序：低16位是左侧像素
+        for (uint16_t x = 0; x < width; x++) {
+            uint32_t p = s[x];
+            d[x] = p | (p << 16);
+        }
+
+        memcpy(reinterpret_cast<uint8_t*>(d) + dst_row_bytes, d, dst_row_bytes);
+    }
+}
+
+void upscale2xBilinear(const uint16_t* src, uint16_t width, uint16_t height, uint16_t* dst) {
+    const size_t dst_width = (size_t)width * 2;
+
+    for (uint16_t y = 0; y < height; y++) {
+        const uint16_t* row = src + (size_t)y * width;
+        const uint16_t* next_row = (y + 1 < height) ? row + width : row;
+        uint16_t* d0 = dst + (size_t)y * 2 * dst_width;
+        uint16_t* d1 = d0 + dst_width;
+
+        for (uint16_t x = 0; x < width; x++) {
+            uint16_t x1 = (x + 1 < width) ? x + 1 : x;
+            uint16_t a = row[x];
+            uint16_t b = row[x1];
+            uint16_t c = next_row[x];
+            uint16_t d = next_row[x1];
+
+            uint16_t ab = average565(a, b);
+            uint16_t ac = average565(a, c);
+
+            d0[x * 2] = a;
+            d0[x * 2 + 1] = ab;
+            d1[x * 2] = ac;
+            d1[x * 2 + 1] = average565(ab, average565(c, d));
+        }
+    }
+}
+
+bool upscaleSlot(FrameSlot& slot) {
+    if (!enabled() || !slot.scaled || !slot.dsc.data) {
+        return false;
+    }
+
+    // 只处理紧密排列的RGB565帧
+    const uint16_t width = slot.dsc.header.w;
+    const uint16_t height = slot.dsc.header.h;
+    if (slot.dsc.header.cf != LV_COLOR_FORMAT_RGB565 ||
+        (slot.dsc.header.stride != 0 && slot.dsc.header.stride != width * 2)) {
+        return false;
+    }
+
+    const uint32_t scaled_bytes = (uint32_t)width * height * 2 * 4;
+    if (scaled_bytes > slot.scaled_capacity) {
+        return false;
+    }
+
+    const uint16_t* src = reinterpret_cast<const uint16_t*>(slot.dsc.data);
+    uint16_t* dst = reinterpret_cast<uint16_t*>(slot.scaled);
+
+#if BIRD_FRAME_UPSCALE == 2
+    upscale2xBilinear(src, width, height, dst);
+#else
+    upscale2xNearest(src, width, height, dst);
+#endif
+
+    slot.dsc.header.w = width * 2;
+    slot.dsc.header.h = height * 2;
+    slot.dsc.header.stride = width * 2 * 2;
+    slot.dsc.data_size = scaled_bytes;
+    slot.dsc.data = slot.scaled;
+    slot.upscaled = true;
+
+    // 脏区同步放大（双线性时相邻像素也会受影响，向左上各扩1像素）
+    if (slot.changed) {
+        int32_t grow = (BIRD_FRAME_UPSCALE == 2) ? 1 : 0;
+        slot.dirty.x1 = slot.dirty.x1 * 2 - grow;
+        slot.dirty.y1 = slot.dirty.y1 * 2 - grow;
+        slot.dirty.x2 = slot.dirty.x2 * 2 + 1;
+        slot.dirty.y2 = slot.dirty.y2 * 2 + 1;
+        if (slot.dirty.x1 < 0) slot.dirty.x1 = 0;
+        if (slot.dirty.y1 < 0) slot.dirty.y1 = 0;
+    }
+    return true;
+}
+
+} // namespace FrameUpscaler
+} // namespace BirdWatching
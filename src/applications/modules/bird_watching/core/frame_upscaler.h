@@ -0,0 +1,49 @@
+#ifndef FRAME_UPSCALER_H
+#define FRAME_UPSCALER_H
+
+#include <Arduino.h>
+#include "frame_pool.h"
+
+// 帧放大方式：0=交给LVGL软件缩放，1=2倍最近邻，2=2倍双线性（可通过-D覆盖）
+// 预放大需要每个槽额外4倍帧大小的缓冲区，默认只在有PSRAM时启用
+#ifndef BIRD_FRAME_UPSCALE
+#ifdef BOARD_HAS_PSRAM
+#define BIRD_FRAME_UPSCALE 1
+#else
+#define BIRD_FRAME_UPSCALE 0
+#endif
+#endif
+
+namespace BirdWatching {
+namespace FrameUpscaler {
+
+/**
+ * 是否启用预放大
+ */
+constexpr bool enabled() { return BIRD_FRAME_UPSCALE != 0; }
+
+/**
+ * 2倍最近邻放大RGB565图像
+ *
+ * 每个源像素以32位写入同一行的两个目标像素，偶数行生成后整行复制到奇数行
+ */
+void upscale2xNearest(const uint16_t* src, uint16_t width, uint16_t height, uint16_t* dst);
+
+/**
+ * 2倍双线性放大RGB565图像（插值像素取相邻像素的平均，边缘复制）
+ */
+void upscale2xBilinear(const uint16_t* src, uint16_t width, uint16_t height, uint16_t* dst);
+
+/**
+ * 将槽中的帧放大到slot.scaled，并把描述符和脏区改为放大后的图像
+ *
+ * 在预取任务中调用，UI任务只需以1倍缩放显示
+ *
+ * @return 已放大返回true；槽没有放大缓冲区或容量不足时保持原样返回false
+ */
+bool upscaleSlot(FrameSlot& slot);
+
+} // namespace FrameUpscaler
+} // namespace BirdWatching
+
+#endif // FRAME_UPSCALER_H
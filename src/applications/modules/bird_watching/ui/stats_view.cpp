@@ -135,7 +135,7 @@ void StatsView::previousPage() {
     if (current_page_ > 0) {
         current_page_--;
         update();
-        LOG_INFO("STATS_VIEW", (String("Previous page: ") + String(current_page_)).c_str());
+        LOG_INFOF("STATS_VIEW", "Previous page: %d", current_page_);
     }
 }
 
@@ -143,7 +143,7 @@ void StatsView::nextPage() {
     if (current_page_ < total_pages_ - 1) {
         current_page_++;
         update();
-        LOG_INFO("STATS_VIEW", (String("Next page: ") + String(current_page_)).c_str());
+        LOG_INFOF("STATS_VIEW", "Next page: %d", current_page_);
     }
 }
 
@@ -181,7 +181,8 @@ void StatsView::updateBirdList() {
         
         if (bird_index < total_birds) {
             const BirdInfo& bird = all_birds[bird_index];
-            int count = statistics_->getEncounterCount(bird.id);
+            // 统计表的稠密索引与小鸟列表下标一致，直接按下标取次数
+            int count = statistics_->getEncounterCountAt(bird_index, bird.id);
             
             char text[128];
             if (count > 0) {
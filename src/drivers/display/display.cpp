@@ -1,5 +1,6 @@
 #include "display.h"
 #include "log_manager.h"
+#include "trace_buffer.h"
 
 /*
 Display driver using LovyanGFX
@@ -8,6 +9,8 @@ Replaces TFT_eSPI with same interface
 
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 // ESP32-S3 使用 SPI2_HOST (FSPI)，ESP32 使用 VSPI_HOST
 #if defined(CONFIG_IDF_TARGET_ESP32S3)
@@ -71,6 +74,16 @@ public:
 
 static LGFX tft;
 
+// 完整刷新到屏幕的帧数（UI任务写入，task命令读取）
+static volatile uint32_t s_frame_count = 0;
+static bool s_flush_pending = false;   // 有DMA刷新尚未等待完成（用于跟踪记录配对）
+
+// LVGL时钟直接取自esp_timer，不依赖调用lv_tick_inc的频率
+static uint32_t lvgl_tick_get()
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
 void my_print(lv_log_level_t level, const char* file, uint32_t line, const char* fun, const char* dsc)
 {
 	LogManager* logManager = LogManager::getInstance();
@@ -101,12 +114,69 @@ void my_disp_flush(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map)
 	uint32_t w = (area->x2 - area->x1 + 1);
 	uint32_t h = (area->y2 - area->y1 + 1);
 
-	tft.startWrite();
-	tft.setAddrWindow(area->x1, area->y1, w, h);
-	tft.pushPixels((uint16_t*)px_map, w * h, true);
-	tft.endWrite();
+	// 屏幕需要大端RGB565，原地交换字节后DMA可以直接从缓冲区发送
+	lv_draw_sw_rgb565_swap(px_map, w * h);
+
+	// SPI事务保持打开（endWrite会等待DMA完成），只启动DMA传输后立即返回
+	if (tft.getStartCount() == 0) {
+		tft.startWrite();
+	}
+	TRACE_EVENT(TRACE_FLUSH_BEGIN, h);
+	s_flush_pending = true;
+	tft.pushImageDMA(area->x1, area->y1, w, h, (const lgfx::swap565_t*)px_map);
+
+	if (lv_display_flush_is_last(disp)) {
+		s_frame_count++;
+	}
+
+	// 不在这里调用lv_display_flush_ready：LVGL需要复用该缓冲区时会调用my_disp_flush_wait
+}
+
+void my_disp_flush_wait(lv_display_t* disp)
+{
+	// LVGL在下一次flush前（或单缓冲渲染前）调用，此时另一个缓冲区已渲染完成
+	tft.waitDMA();
+	if (s_flush_pending) {
+		s_flush_pending = false;
+		TRACE_EVENT(TRACE_FLUSH_END, 0);
+	}
+}
+
+// 分配DMA刷新缓冲区，返回每个缓冲区的字节数（失败返回0）
+static uint32_t allocDisplayBuffers(void** buf1, void** buf2, bool* in_psram)
+{
+	*in_psram = false;
+
+#if DISPLAY_BUF_IN_PSRAM && defined(BOARD_HAS_PSRAM)
+	{
+		uint32_t size = 240 * 240 * sizeof(lv_color16_t);
+		*buf1 = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+		*buf2 = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+		if (*buf1 && *buf2) {
+			*in_psram = true;
+			return size;
+		}
+		heap_caps_free(*buf1);
+		heap_caps_free(*buf2);
+		LOG_WARN("TFT", "PSRAM frame buffers unavailable, using internal DMA buffers");
+	}
+#endif
+
+	// 内部DMA内存不足时逐步减少行数
+	for (uint32_t lines = DISPLAY_BUF_LINES; lines >= DISPLAY_BUF_MIN_LINES; lines /= 2) {
+		uint32_t size = 240 * lines * sizeof(lv_color16_t);
+		*buf1 = heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+		*buf2 = heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+		if (*buf1 && *buf2) {
+			return size;
+		}
+		heap_caps_free(*buf1);
+		heap_caps_free(*buf2);
+	}
 
-	lv_display_flush_ready(disp);
+	*buf1 = nullptr;
+	*buf2 = nullptr;
+	return 0;
 }
 
 void Display::init()
@@ -117,6 +187,7 @@ void Display::init()
 	setBackLight(1.0);  // 最大亮度
 
 	lv_init();
+	lv_tick_set_cb(lvgl_tick_get);
 
 	LOG_INFO("TFT", "Initializing LovyanGFX...");
 
@@ -133,9 +204,22 @@ void Display::init()
 
 	lv_display_t* disp = lv_display_create(240, 240);
 	lv_display_set_flush_cb(disp, my_disp_flush);
-
-	static lv_color_t buf1[240 * 10];
-	lv_display_set_buffers(disp, buf1, NULL, sizeof(buf1), LV_DISPLAY_RENDER_MODE_PARTIAL);
+	lv_display_set_flush_wait_cb(disp, my_disp_flush_wait);
+
+	void* buf1 = nullptr;
+	void* buf2 = nullptr;
+	bool in_psram = false;
+	uint32_t buf_size = allocDisplayBuffers(&buf1, &buf2, &in_psram);
+	if (buf_size) {
+		lv_display_set_buffers(disp, buf1, buf2, buf_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+		LOG_INFO("TFT", "Display buffers: 2 x " + String(buf_size / (240 * sizeof(lv_color16_t))) +
+		         " lines (" + String(buf_size) + " bytes each, " + String(in_psram ? "PSRAM" : "internal DMA") + ")");
+	} else {
+		// 最后的后备：单个静态缓冲区，渲染前会等待上一次DMA完成
+		static lv_color16_t fallback_buf[240 * DISPLAY_BUF_MIN_LINES];
+		lv_display_set_buffers(disp, fallback_buf, NULL, sizeof(fallback_buf), LV_DISPLAY_RENDER_MODE_PARTIAL);
+		LOG_WARN("TFT", "DMA buffer allocation failed, using single " + String(DISPLAY_BUF_MIN_LINES) + "-line buffer");
+	}
 	
 	lv_obj_t* black_scr = lv_obj_create(NULL);
 	lv_obj_set_style_bg_color(black_scr, lv_color_black(), 0);
@@ -143,10 +227,14 @@ void Display::init()
 	lv_scr_load(black_scr);
 }
 
-void Display::routine()
+uint32_t Display::routine()
+{
+    return lv_timer_handler();
+}
+
+uint32_t Display::getFrameCount()
 {
-    lv_tick_inc(1);
-    lv_timer_handler();
+    return s_frame_count;
 }
 
 void Display::setBackLight(float duty)
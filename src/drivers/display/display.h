@@ -6,6 +6,21 @@
 // LCD_BL_PWM_CHANNEL 暂时保留，后续可能用于PWM调光
 #define LCD_BL_PWM_CHANNEL 0
 
+// 显示刷新缓冲区配置（可通过-D覆盖）
+// 两个缓冲区交替使用：LVGL渲染一个条带的同时，另一个条带通过SPI DMA发送
+#ifndef DISPLAY_BUF_LINES
+#define DISPLAY_BUF_LINES 40        // 每个缓冲区的行数（240x40x2 = 19.2KB）
+#endif
+
+// 1 = 在PSRAM中分配两个整帧缓冲区（仅S3等带PSRAM的板子）
+// 注意：PSRAM不能直接作为SPI DMA源，LovyanGFX会分块拷贝到内部DMA缓冲区再发送
+#ifndef DISPLAY_BUF_IN_PSRAM
+#define DISPLAY_BUF_IN_PSRAM 0
+#endif
+
+// 内部RAM不足时退回的最小行数
+#define DISPLAY_BUF_MIN_LINES 10
+
 
 class Display
 {
@@ -14,8 +29,19 @@ private:
 
 public:
 	void init();
-	void routine();
+
+	/**
+	 * 执行一次LVGL渲染（定时器处理+刷新）
+	 * @return 距离下一个LVGL定时器到期的毫秒数（无定时器时为LV_NO_TIMER_READY）
+	 */
+	uint32_t routine();
+
 	void setBackLight(float);
+
+	/**
+	 * 已完整刷新到屏幕的帧数（每次刷新的最后一个条带计一帧）
+	 */
+	static uint32_t getFrameCount();
 };
 
 #endif
\ No newline at end of file
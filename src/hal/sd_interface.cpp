@@ -9,6 +9,7 @@
 #include "sd_interface.h"
 #include "../system/logging/log_manager.h"
 #include <SPI.h>
+#include <sys/stat.h>
 
 namespace HAL {
 
@@ -16,6 +17,7 @@ namespace HAL {
 HardwareConfig::SDCardMode SDInterface::current_mode_ = HardwareConfig::SDCardMode::FAILED;
 bool SDInterface::mounted_ = false;
 SPIClass* SDInterface::spi_instance_ = nullptr;
+const char* SDInterface::mount_point_ = nullptr;
 
 /**
  * @brief 主初始化函数
@@ -71,6 +73,7 @@ bool SDInterface::init(HardwareConfig::SDCardMode mode)
     } else {
         mounted_ = false;
         current_mode_ = HardwareConfig::SDCardMode::FAILED;
+        mount_point_ = nullptr;
         LOG_ERROR("SD", "SD card initialization failed in all modes");
     }
     
@@ -106,10 +109,11 @@ bool SDInterface::initSDMMC()
     // ESP32-S3: 通常为20MHz（40MHz在S3上有稳定性问题）
     LOG_INFO("SD", "Attempting SDMMC with default frequency (1-bit mode)...");
     
-    success = SD_MMC.begin("/sdcard", true, false, SDMMC_FREQ_DEFAULT);
+    success = SD_MMC.begin(SDMMC_MOUNT_POINT, true, false, SDMMC_FREQ_DEFAULT);
     
     if (success) {
         current_mode_ = HardwareConfig::SDCardMode::SDMMC;
+        mount_point_ = SDMMC_MOUNT_POINT;
         
         uint8_t cardType = SD_MMC.cardType();
         String typeStr = (cardType == CARD_SD) ? "SDSC" : (cardType == CARD_SDHC) ? "SDHC" : "Unknown";
@@ -198,10 +202,11 @@ bool SDInterface::initSPI()
         uint32_t spi_freq = freq_list[attempt];
         LOG_INFO("SD", "Testing SPI at " + String(spi_freq/1000000) + "MHz...");
         
-        if (SD.begin(cs_pin, *spi_instance_, spi_freq))
+        if (SD.begin(cs_pin, *spi_instance_, spi_freq, SPI_MOUNT_POINT))
         {
             mounted = true;
             current_mode_ = HardwareConfig::SDCardMode::SPI;
+            mount_point_ = SPI_MOUNT_POINT;
             LOG_INFO("SD", "✓ SPI initialized at " + String(spi_freq/1000000) + "MHz");
             return true;
         }
@@ -299,6 +304,7 @@ void SDInterface::unmount()
     
     mounted_ = false;
     current_mode_ = HardwareConfig::SDCardMode::FAILED;
+    mount_point_ = nullptr;
     LOG_INFO("SD", "SD card unmounted");
 }
 
@@ -620,6 +626,23 @@ bool SDInterface::exists(const char* path)
     return fs.exists(path);
 }
 
+bool SDInterface::stat(const char* path, uint32_t& size, uint32_t& mtime)
+{
+    if (!mounted_ || mount_point_ == nullptr) return false;
+    
+    // 直接走VFS，路径加上初始化时的挂载点
+    char full_path[128];
+    snprintf(full_path, sizeof(full_path), "%s%s", mount_point_, path);
+    
+    struct stat st;
+    if (::stat(full_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    size = (uint32_t)st.st_size;
+    mtime = (uint32_t)st.st_mtime;
+    return true;
+}
+
 void SDInterface::readBinFromSd(const char* path, uint8_t* buf)
 {
     if (!mounted_) return;
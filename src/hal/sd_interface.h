@@ -123,6 +123,15 @@ public:
      */
     static bool exists(const char* path);
     
+    /**
+     * @brief 获取文件大小和修改时间，不打开文件
+     * @param path 文件路径（相对SD卡根目录）
+     * @param size 输出文件大小
+     * @param mtime 输出修改时间（与File::getLastWrite()相同）
+     * @return 文件存在且为普通文件时返回true
+     */
+    static bool stat(const char* path, uint32_t& size, uint32_t& mtime);
+    
     /**
      * @brief 读取二进制文件
      */
@@ -157,10 +166,15 @@ private:
      */
     static void hardwareReset();
     
+    // VFS挂载点，初始化时传给SD_MMC.begin/SD.begin
+    static constexpr const char* SDMMC_MOUNT_POINT = "/sdcard";
+    static constexpr const char* SPI_MOUNT_POINT = "/sd";
+    
     // 状态变量
     static HardwareConfig::SDCardMode current_mode_;
     static bool mounted_;
     static SPIClass* spi_instance_;
+    static const char* mount_point_;    // 当前挂载点，stat()拼接VFS路径用；未挂载时为nullptr
 };
 
 } // namespace HAL
@@ -16,6 +16,7 @@
 #include "system/logging/log_manager.h"
 #include "system/tasks/task_manager.h"
 #include "system/commands/serial_commands.h"
+#include "system/commands/binary_transfer.h"
 #include "hal/hal_manager.h"
 #include "hal/sd_interface.h"
 #include "drivers/display/display.h"
@@ -63,6 +64,8 @@ void earlyRgbInit() {
 }
 
 void setupSerial() {
+    // 必须在begin()之前设置：默认256字节的接收缓冲区装不下二进制传输的一个窗口
+    size_t rxBufferSize = Serial.setRxBufferSize(FILE_XFER_RX_BUFFER_SIZE);
     Serial.begin(115200);
     
 #ifdef PLATFORM_ESP32_S3
@@ -114,6 +117,11 @@ void setupSerial() {
     Serial.println("║");
     
     Serial.println("╚════════════════════════════════════════╝\n");
+    
+    if (rxBufferSize < FILE_XFER_RX_BUFFER_SIZE) {
+        Serial.printf("WARNING: Serial RX buffer is %u bytes (wanted %u), binary transfers will retransmit\n",
+                      (unsigned)rxBufferSize, (unsigned)FILE_XFER_RX_BUFFER_SIZE);
+    }
 }
 
 void setupLogging() {
@@ -0,0 +1,621 @@
+#include "binary_transfer.h"
+#include "log_manager.h"
+#include "hal/sd_interface.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    // 传输期间日志只写SD卡，结束后恢复原来的输出方式
+    class SerialLogPause {
+    public:
+        SerialLogPause()
+            : logManager(LogManager::getInstance())
+            , saved(logManager->getLogOutput())
+        {
+            if (saved != LogManager::OUTPUT_SD_CARD) {
+                logManager->setLogOutput(LogManager::OUTPUT_SD_CARD);
+            }
+        }
+
+        ~SerialLogPause() {
+            if (saved != LogManager::OUTPUT_SD_CARD) {
+                logManager->setLogOutput(saved);
+            }
+        }
+
+    private:
+        LogManager* logManager;
+        LogManager::LogOutput saved;
+    };
+
+    void putU16(uint8_t* out, uint16_t value) {
+        out[0] = value & 0xFF;
+        out[1] = value >> 8;
+    }
+
+    void putU32(uint8_t* out, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            out[i] = (value >> (8 * i)) & 0xFF;
+        }
+    }
+
+    uint16_t getU16(const uint8_t* in) {
+        return in[0] | (in[1] << 8);
+    }
+
+    uint32_t getU32(const uint8_t* in) {
+        return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+    }
+
+}
+
+uint32_t BinaryTransfer::crc32(uint32_t crc, const uint8_t* data, size_t length) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool BinaryTransfer::crc32File(const String& path, size_t length, uint32_t& crc) {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    File file = fs.open(path, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    uint8_t buffer[1024];
+    size_t remaining = length;
+    crc = 0;
+    while (remaining > 0) {
+        size_t chunk = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+        size_t bytesRead = file.read(buffer, chunk);
+        if (bytesRead == 0) {
+            break;
+        }
+        crc = crc32(crc, buffer, bytesRead);
+        remaining -= bytesRead;
+        yield();
+    }
+    file.close();
+    return remaining == 0;
+}
+
+bool BinaryTransfer::ensureParentDirectory(const String& path) {
+    int lastSlash = path.lastIndexOf('/');
+    if (lastSlash <= 0) {
+        return true;
+    }
+
+    String dirPath = path.substring(0, lastSlash);
+    fs::FS& fs = HAL::SDInterface::getFS();
+    if (fs.exists(dirPath)) {
+        return true;
+    }
+
+    // 创建目录结构
+    String currentPath = "";
+    int start = 1; // 跳过开头的 '/'
+    while (start < (int)dirPath.length()) {
+        int nextSlash = dirPath.indexOf('/', start);
+        if (nextSlash == -1) nextSlash = dirPath.length();
+
+        currentPath += "/" + dirPath.substring(start, nextSlash);
+        if (!fs.exists(currentPath) && !fs.mkdir(currentPath)) {
+            Serial.println("ERROR: Failed to create directory: " + currentPath);
+            return false;
+        }
+        start = nextSlash + 1;
+    }
+    return true;
+}
+
+bool BinaryTransfer::printFileHash(File& file, const String& path, bool blocks, uint8_t* buffer, size_t bufferSize) {
+    size_t size = file.size();
+    uint32_t crc = 0;
+    uint32_t blockCrc = 0;
+    size_t blockUsed = 0;
+    std::vector<uint32_t> blockCrcs;
+    if (blocks) {
+        blockCrcs.reserve((size + FILE_HASH_BLOCK_SIZE - 1) / FILE_HASH_BLOCK_SIZE);
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        // 读取不跨块边界，块CRC和整体CRC一次读完
+        size_t chunk = bufferSize;
+        if (blocks && chunk > FILE_HASH_BLOCK_SIZE - blockUsed) {
+            chunk = FILE_HASH_BLOCK_SIZE - blockUsed;
+        }
+        size_t bytesRead = file.read(buffer, chunk);
+        if (bytesRead == 0) {
+            break;
+        }
+        crc = crc32(crc, buffer, bytesRead);
+        total += bytesRead;
+
+        if (blocks) {
+            blockCrc = crc32(blockCrc, buffer, bytesRead);
+            blockUsed += bytesRead;
+            if (blockUsed == FILE_HASH_BLOCK_SIZE || total == size) {
+                blockCrcs.push_back(blockCrc);
+                blockCrc = 0;
+                blockUsed = 0;
+            }
+        }
+        yield();
+    }
+
+    if (total != size) {
+        Serial.println("ERROR: Read failed: " + path);
+        return false;
+    }
+
+    Serial.printf("HASH %08lx %u %s\n", (unsigned long)crc, (unsigned)size, path.c_str());
+    for (size_t i = 0; i < blockCrcs.size(); i++) {
+        Serial.printf("BLOCK %u %08lx\n", (unsigned)i, (unsigned long)blockCrcs[i]);
+    }
+    return true;
+}
+
+size_t BinaryTransfer::printHashes(const String& path, bool blocks) {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    File root = fs.open(path);
+    if (!root) {
+        Serial.println("ERROR: Path not found: " + path);
+        return 0;
+    }
+
+    const size_t bufferSize = 4096;
+    std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[bufferSize]);
+    if (!buffer) {
+        root.close();
+        Serial.println("ERROR: Out of memory for hash buffer");
+        return 0;
+    }
+
+    if (!root.isDirectory()) {
+        bool ok = printFileHash(root, path, blocks, buffer.get(), bufferSize);
+        root.close();
+        return ok ? 1 : 0;
+    }
+
+    // 目录：逐层展开，未完成的传输（.part）不参与比较
+    size_t count = 0;
+    std::vector<String> pending;
+    pending.push_back(path.endsWith("/") && path.length() > 1 ? path.substring(0, path.length() - 1) : path);
+    root.close();
+
+    while (!pending.empty()) {
+        String dirPath = pending.back();
+        pending.pop_back();
+
+        File dir = fs.open(dirPath);
+        if (!dir || !dir.isDirectory()) {
+            continue;
+        }
+
+        File file = dir.openNextFile();
+        while (file) {
+            String childPath = (dirPath == "/" ? "" : dirPath) + "/" + file.name();
+            if (file.isDirectory()) {
+                pending.push_back(childPath);
+            } else if (!childPath.endsWith(".part") &&
+                       printFileHash(file, childPath, blocks, buffer.get(), bufferSize)) {
+                count++;
+            }
+            file.close();
+            file = dir.openNextFile();
+        }
+        dir.close();
+    }
+    return count;
+}
+
+bool BinaryTransfer::copyPrefix(const String& src, const String& dst, size_t length) {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    File in = fs.open(src, FILE_READ);
+    if (!in || in.size() < length) {
+        return false;
+    }
+    File out = fs.open(dst, FILE_WRITE);
+    if (!out) {
+        in.close();
+        return false;
+    }
+
+    std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[FILE_XFER_WRITE_BLOCK]);
+    size_t remaining = buffer ? length : 1;
+    while (buffer && remaining > 0) {
+        size_t chunk = remaining < FILE_XFER_WRITE_BLOCK ? remaining : FILE_XFER_WRITE_BLOCK;
+        size_t bytesRead = in.read(buffer.get(), chunk);
+        if (bytesRead == 0 || out.write(buffer.get(), bytesRead) != bytesRead) {
+            break;
+        }
+        remaining -= bytesRead;
+        yield();
+    }
+    in.close();
+    out.close();
+    return remaining == 0;
+}
+
+BinaryTransfer::ReadResult BinaryTransfer::readFrame(FrameHeader& header, uint8_t* payload, uint32_t timeoutMs) {
+    // 找帧头，跳过主机发来的换行等
+    uint32_t start = millis();
+    while (true) {
+        if (Serial.available()) {
+            if (Serial.read() == FRAME_MAGIC) {
+                break;
+            }
+            continue;
+        }
+        if (millis() - start >= timeoutMs) {
+            return READ_TIMEOUT;
+        }
+        delay(1);
+    }
+
+    uint8_t raw[FRAME_HEADER_SIZE - 1];
+    if (Serial.readBytes(raw, sizeof(raw)) != sizeof(raw)) {
+        return READ_BAD_FRAME;
+    }
+    header.type = raw[0];
+    header.seq = getU16(raw + 1);
+    header.offset = getU32(raw + 3);
+    header.length = getU16(raw + 7);
+    if (header.length > FILE_XFER_FRAME_SIZE || header.type < FRAME_DATA || header.type > FRAME_ABORT) {
+        return READ_BAD_FRAME;
+    }
+
+    uint8_t crcBytes[4];
+    if ((header.length && Serial.readBytes(payload, header.length) != header.length) ||
+        Serial.readBytes(crcBytes, sizeof(crcBytes)) != sizeof(crcBytes)) {
+        return READ_BAD_FRAME;
+    }
+
+    uint32_t crc = crc32(crc32(0, raw, sizeof(raw)), payload, header.length);
+    return crc == getU32(crcBytes) ? READ_OK : READ_BAD_FRAME;
+}
+
+void BinaryTransfer::writeFrame(uint8_t* frame, uint8_t type, uint16_t seq, uint32_t offset, uint16_t length) {
+    frame[0] = FRAME_MAGIC;
+    frame[1] = type;
+    putU16(frame + 2, seq);
+    putU32(frame + 4, offset);
+    putU16(frame + 8, length);
+    uint32_t crc = crc32(0, frame + 1, FRAME_HEADER_SIZE - 1 + length);
+    putU32(frame + FRAME_HEADER_SIZE + length, crc);
+
+    // 整帧一次写出，避免与其他任务的串口输出交错
+    Serial.write(frame, FRAME_HEADER_SIZE + length + 4);
+}
+
+bool BinaryTransfer::pollLine(char* line, size_t size, size_t& used) {
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\r') {
+            continue;
+        }
+        if (c == '\n') {
+            line[used] = '\0';
+            used = 0;
+            return true;
+        }
+        if (used < size - 1) {
+            line[used++] = c;
+        }
+    }
+    return false;
+}
+
+bool BinaryTransfer::receive(const String& path, size_t size, uint32_t crc, size_t keep) {
+    if (!ensureParentDirectory(path)) {
+        return false;
+    }
+
+    fs::FS& fs = HAL::SDInterface::getFS();
+    String partPath = path + ".part";
+
+    // 差异同步：现有文件的前keep字节与新文件相同，作为部分文件续传
+    if (keep > 0 && keep <= size && !copyPrefix(path, partPath, keep)) {
+        fs.remove(partPath);
+    }
+
+    // 已有部分文件时报告其大小和CRC，由主机决定是否续传
+    size_t offset = 0;
+    uint32_t partCrc = 0;
+    if (fs.exists(partPath)) {
+        File part = fs.open(partPath, FILE_READ);
+        size_t partSize = part ? part.size() : 0;
+        part.close();
+        if (partSize <= size && crc32File(partPath, partSize, partCrc)) {
+            offset = partSize;
+        } else {
+            partCrc = 0;
+        }
+    }
+
+    std::unique_ptr<uint8_t[]> payload(new (std::nothrow) uint8_t[FILE_XFER_FRAME_SIZE]);
+    std::unique_ptr<uint8_t[]> block(new (std::nothrow) uint8_t[FILE_XFER_WRITE_BLOCK]);
+    if (!payload || !block) {
+        Serial.println("ERROR: Out of memory for transfer buffers");
+        return false;
+    }
+
+    File file = fs.open(partPath, offset > 0 ? FILE_APPEND : FILE_WRITE);
+    if (!file) {
+        Serial.println("ERROR: Failed to create file: " + partPath);
+        return false;
+    }
+
+    SerialLogPause pause;
+    Serial.printf("BIN_READY %u %08lx\n", (unsigned)offset, (unsigned long)partCrc);
+    uint32_t startMs = millis();
+
+    size_t expected = offset;
+    uint32_t runningCrc = partCrc;
+    size_t blockUsed = 0;
+    bool nakSent = false;
+    bool writeFailed = false;
+    bool finished = false;
+    bool success = false;
+    uint32_t lastValid = millis();
+
+    while (!finished && millis() - lastValid < FILE_XFER_IDLE_TIMEOUT_MS) {
+        FrameHeader header;
+        ReadResult result = readFrame(header, payload.get(), 500);
+        if (result == READ_TIMEOUT) {
+            // 主机可能在等确认，提示当前期望的偏移
+            Serial.printf("NAK %u\n", (unsigned)expected);
+            continue;
+        }
+        if (result == READ_BAD_FRAME) {
+            // 同一个缺口只请求一次重发，后续乱序帧直接丢弃
+            if (!nakSent) {
+                Serial.printf("NAK %u\n", (unsigned)expected);
+                nakSent = true;
+            }
+            continue;
+        }
+
+        if (header.type == FRAME_ABORT) {
+            break;
+        }
+
+        // 本次还没收到数据时主机从0开始：部分文件与本地不一致，重写
+        if (header.type == FRAME_DATA && header.offset == 0 && expected == offset && offset > 0) {
+            file.close();
+            file = fs.open(partPath, FILE_WRITE);
+            if (!file) {
+                Serial.println("ERROR: Failed to recreate file: " + partPath);
+                return false;
+            }
+            offset = 0;
+            expected = 0;
+            runningCrc = 0;
+        }
+
+        if (header.offset != expected) {
+            if (header.offset < expected) {
+                // 重发的旧帧，重新确认
+                Serial.printf("ACK %u\n", (unsigned)expected);
+            } else if (!nakSent) {
+                Serial.printf("NAK %u\n", (unsigned)expected);
+                nakSent = true;
+            }
+            continue;
+        }
+        nakSent = false;
+        lastValid = millis();
+
+        if (header.type == FRAME_END) {
+            if (blockUsed > 0 && file.write(block.get(), blockUsed) != blockUsed) {
+                writeFailed = true;
+            }
+            file.close();
+            finished = true;
+
+            uint32_t fileCrc = header.length >= 4 ? getU32(payload.get()) : crc;
+            if (writeFailed) {
+                Serial.println("ERROR: SD card write failed");
+            } else if (expected != size) {
+                Serial.printf("ERROR: Size mismatch: got %u, expected %u\n", (unsigned)expected, (unsigned)size);
+            } else if (runningCrc != crc || fileCrc != crc) {
+                Serial.printf("ERROR: CRC mismatch: %08lx != %08lx\n", (unsigned long)runningCrc, (unsigned long)crc);
+                fs.remove(partPath);
+            } else {
+                if (fs.exists(path)) {
+                    fs.remove(path);
+                }
+                success = fs.rename(partPath, path);
+                if (!success) {
+                    Serial.println("ERROR: Failed to rename " + partPath);
+                }
+            }
+            break;
+        }
+
+        if (expected + header.length > size) {
+            Serial.println("ERROR: Data exceeds declared file size");
+            break;
+        }
+
+        // 攒够一个块再写卡
+        if (blockUsed + header.length > FILE_XFER_WRITE_BLOCK) {
+            if (file.write(block.get(), blockUsed) != blockUsed) {
+                writeFailed = true;
+                Serial.println("ERROR: SD card write failed");
+                break;
+            }
+            blockUsed = 0;
+        }
+        memcpy(block.get() + blockUsed, payload.get(), header.length);
+        blockUsed += header.length;
+        runningCrc = crc32(runningCrc, payload.get(), header.length);
+        expected += header.length;
+        Serial.printf("ACK %u\n", (unsigned)expected);
+    }
+
+    if (!finished) {
+        // 中断时保留已收到的数据，下次上传同一文件时续传
+        if (!writeFailed && blockUsed > 0) {
+            file.write(block.get(), blockUsed);
+        }
+        file.close();
+        Serial.printf("ERROR: Transfer interrupted at %u / %u bytes (partial file kept for resume)\n",
+                      (unsigned)expected, (unsigned)size);
+        return false;
+    }
+
+    if (success) {
+        Serial.println("SUCCESS: File uploaded successfully!");
+        Serial.printf("Path: %s\n", path.c_str());
+        Serial.printf("Size: %u bytes (%u resumed)\n", (unsigned)size, (unsigned)offset);
+        uint32_t elapsed = millis() - startMs;
+        Serial.printf("Rate: %u bytes in %lu ms (%lu B/s)\n", (unsigned)(size - offset), (unsigned long)elapsed,
+                      (unsigned long)((uint64_t)(size - offset) * 1000 / (elapsed ? elapsed : 1)));
+    }
+    return success;
+}
+
+bool BinaryTransfer::send(const String& path, size_t offset) {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    if (!fs.exists(path)) {
+        Serial.println("ERROR: File not found: " + path);
+        return false;
+    }
+
+    File file = fs.open(path, FILE_READ);
+    if (!file) {
+        Serial.println("ERROR: Failed to open file: " + path);
+        return false;
+    }
+
+    std::unique_ptr<uint8_t[]> frame(new (std::nothrow) uint8_t[FRAME_HEADER_SIZE + FILE_XFER_FRAME_SIZE + 4]);
+    if (!frame) {
+        file.close();
+        Serial.println("ERROR: Out of memory for transfer buffer");
+        return false;
+    }
+    uint8_t* payload = frame.get() + FRAME_HEADER_SIZE;
+
+    size_t size = file.size();
+    if (offset > size) {
+        offset = 0;
+    }
+
+    // END帧携带整个文件的CRC：续传时从已发送部分的CRC接着累计，主机借此校验本地已有的前缀
+    uint32_t crc = 0;
+    if (offset > 0 && !crc32File(path, offset, crc)) {
+        file.close();
+        Serial.println("ERROR: Failed to read file: " + path);
+        return false;
+    }
+
+    SerialLogPause pause;
+    Serial.printf("BIN_START %u %u\n", (unsigned)size, (unsigned)offset);
+
+    const size_t window = (size_t)FILE_XFER_WINDOW * FILE_XFER_FRAME_SIZE;
+    size_t acked = offset;
+    size_t sendPos = offset;
+    size_t crcPos = offset;        // CRC只累计首次发送的数据
+    uint16_t seq = 0;
+    bool endSent = false;
+    bool done = false;
+    bool aborted = false;
+    bool readFailed = false;
+    uint32_t lastAck = millis();
+    uint32_t lastProgress = millis();
+    char line[32];
+    size_t lineUsed = 0;
+
+    while (!done && !aborted && !readFailed && millis() - lastProgress < FILE_XFER_IDLE_TIMEOUT_MS) {
+        bool sent = false;
+
+        // 窗口未满时继续发送
+        if (sendPos < size && sendPos - acked < window) {
+            if (file.position() != sendPos) {
+                file.seek(sendPos);
+            }
+            size_t chunk = size - sendPos < FILE_XFER_FRAME_SIZE ? size - sendPos : FILE_XFER_FRAME_SIZE;
+            if (file.read(payload, chunk) != chunk) {
+                readFailed = true;
+                break;
+            }
+            if (sendPos == crcPos) {
+                crc = crc32(crc, payload, chunk);
+                crcPos += chunk;
+            }
+            writeFrame(frame.get(), FRAME_DATA, seq++, sendPos, chunk);
+            sendPos += chunk;
+            sent = true;
+        } else if (acked == size && !endSent) {
+            putU32(payload, crc);
+            writeFrame(frame.get(), FRAME_END, seq++, size, 4);
+            endSent = true;
+            sent = true;
+        }
+
+        // 处理主机回复
+        while (pollLine(line, sizeof(line), lineUsed)) {
+            if (strncmp(line, "ACK ", 4) == 0) {
+                size_t value = strtoul(line + 4, nullptr, 10);
+                if (value > acked && value <= sendPos) {
+                    acked = value;
+                    lastProgress = millis();
+                }
+                lastAck = millis();
+            } else if (strncmp(line, "NAK ", 4) == 0) {
+                // 从主机期望的位置重发
+                size_t value = strtoul(line + 4, nullptr, 10);
+                if (value >= acked && value < sendPos) {
+                    acked = value;
+                    sendPos = value;
+                }
+                lastAck = millis();
+            } else if (strcmp(line, "DONE") == 0) {
+                done = true;
+            } else if (strcmp(line, "ABORT") == 0) {
+                aborted = true;
+            }
+        }
+
+        // 一段时间没有确认：从最后确认的位置重发（包括END帧）
+        if (!done && !aborted && millis() - lastAck > 1000) {
+            sendPos = acked;
+            endSent = false;
+            lastAck = millis();
+        }
+
+        if (!sent) {
+            delay(1);
+        }
+    }
+
+    file.close();
+
+    if (done) {
+        Serial.printf("SUCCESS: %u bytes sent (%u resumed)\n", (unsigned)(size - offset), (unsigned)offset);
+    } else if (readFailed) {
+        Serial.println("ERROR: SD card read failed at " + String((unsigned)sendPos));
+    } else {
+        Serial.printf("ERROR: Transfer aborted at %u / %u bytes\n", (unsigned)acked, (unsigned)size);
+    }
+    return done;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// 每帧最大负载（字节）
+#ifndef FILE_XFER_FRAME_SIZE
+#define FILE_XFER_FRAME_SIZE 2048
+#endif
+
+// 滑动窗口：未确认的帧数上限
+#ifndef FILE_XFER_WINDOW
+#define FILE_XFER_WINDOW 8
+#endif
+
+// 串口接收缓冲区：容纳一整个窗口的帧（每帧另有帧头10字节和CRC 4字节）再留一点余量，
+// 写卡期间主机继续发来的帧暂存在这里，不会溢出变成NAK重发
+#ifndef FILE_XFER_RX_BUFFER_SIZE
+#define FILE_XFER_RX_BUFFER_SIZE (FILE_XFER_WINDOW * (FILE_XFER_FRAME_SIZE + 14) + 256)
+#endif
+
+// 上传时攒够该大小再写卡
+#ifndef FILE_XFER_WRITE_BLOCK
+#define FILE_XFER_WRITE_BLOCK 4096
+#endif
+
+// 超过该时间没有收到有效帧/确认则放弃（毫秒）
+#ifndef FILE_XFER_IDLE_TIMEOUT_MS
+#define FILE_XFER_IDLE_TIMEOUT_MS 10000
+#endif
+
+// file hash 按块输出CRC时的块大小
+#ifndef FILE_HASH_BLOCK_SIZE
+#define FILE_HASH_BLOCK_SIZE 65536
+#endif
+
+/**
+ * 二进制分帧文件传输（file put / file get）
+ *
+ * 帧格式（小端）：
+ *   0xB5  类型(u8)  序号(u16)  偏移(u32)  长度(u16)  负载  CRC32(u32，覆盖类型到负载)
+ * 类型：DATA 0x01，END 0x02（偏移为文件大小，负载为CRC32），ABORT 0x03
+ *
+ * 上传：file put <path> <size> <crc32> [keep]
+ *   keep>0时先把设备上现有文件的前keep字节复制为<path>.part（主机已通过file hash
+ *   确认这部分相同），只传输之后的数据。
+ *   设备把数据写到<path>.part，回复"BIN_READY <offset> <crc32>"：
+ *   offset为已有的部分文件大小，crc32为这部分数据的CRC，主机核对后从offset续传，
+ *   不一致时从0开始（设备收到偏移0的帧会重写部分文件）。
+ *   设备每收到一帧回复"ACK <下一个偏移>"，校验失败或乱序时回复"NAK <期望偏移>"，
+ *   主机从该偏移重发（go-back-N）。END帧的CRC与整个文件一致后改名为<path>。
+ *
+ * 下载：file get <path> [offset]
+ *   设备回复"BIN_START <size> <offset>"后连续发送DATA帧，窗口内不等待确认；
+ *   主机回复"ACK <偏移>"/"NAK <偏移>"，收到END帧（负载为整个文件的CRC，
+ *   续传时包含主机已有的前offset字节）校验通过后回复"DONE"。
+ *
+ * 差异同步：file hash <path|dir> [blocks]
+ *   每个文件一行"HASH <crc32> <size> <path>"，blocks时其后每FILE_HASH_BLOCK_SIZE字节一行
+ *   "BLOCK <index> <crc32>"，最后一行"HASH_END <文件数>"。主机据此跳过未变化的文件。
+ *
+ * 传输期间日志只写SD卡，避免串口日志混入数据流。
+ */
+class BinaryTransfer {
+public:
+    static constexpr uint8_t FRAME_MAGIC = 0xB5;
+    static constexpr size_t FRAME_HEADER_SIZE = 10;
+
+    enum FrameType : uint8_t {
+        FRAME_DATA = 0x01,
+        FRAME_END = 0x02,
+        FRAME_ABORT = 0x03
+    };
+
+    /**
+     * 接收主机上传的文件
+     *
+     * @param size 文件总大小
+     * @param crc 整个文件的CRC32
+     * @param keep 沿用设备上现有文件的前keep字节
+     * @return 文件完整写入并通过校验返回true
+     */
+    static bool receive(const String& path, size_t size, uint32_t crc, size_t keep = 0);
+
+    /**
+     * 向主机发送文件
+     *
+     * @param offset 从该偏移开始发送（续传）
+     * @return 主机确认收到全部数据返回true
+     */
+    static bool send(const String& path, size_t offset);
+
+    // CRC32（与zlib.crc32相同），crc为之前的结果，首次传0
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length);
+
+    // 计算文件前length字节的CRC32
+    static bool crc32File(const String& path, size_t length, uint32_t& crc);
+
+    // 逐级创建path所在的目录
+    static bool ensureParentDirectory(const String& path);
+
+    /**
+     * 输出文件（或目录下所有文件，递归）的CRC32
+     *
+     * @param blocks 同时输出每块的CRC32
+     * @return 输出的文件数
+     */
+    static size_t printHashes(const String& path, bool blocks);
+
+private:
+    enum ReadResult {
+        READ_OK,
+        READ_TIMEOUT,
+        READ_BAD_FRAME
+    };
+
+    struct FrameHeader {
+        uint8_t type;
+        uint16_t seq;
+        uint32_t offset;
+        uint16_t length;
+    };
+
+    // 读取一帧（负载写入payload，至少FILE_XFER_FRAME_SIZE字节）
+    static ReadResult readFrame(FrameHeader& header, uint8_t* payload, uint32_t timeoutMs);
+
+    // 填写帧头和CRC后一次写出（负载已在frame + FRAME_HEADER_SIZE处）
+    static void writeFrame(uint8_t* frame, uint8_t type, uint16_t seq, uint32_t offset, uint16_t length);
+
+    // 非阻塞读取主机的一行回复（ACK/NAK/DONE）
+    static bool pollLine(char* line, size_t size, size_t& used);
+
+    // 输出单个文件的HASH/BLOCK行
+    static bool printFileHash(File& file, const String& path, bool blocks, uint8_t* buffer, size_t bufferSize);
+
+    // 把src的前length字节复制到dst（覆盖）
+    static bool copyPrefix(const String& src, const String& dst, size_t length);
+};
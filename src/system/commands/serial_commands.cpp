@@ -1,6 +1,8 @@
 #include <Arduino.h>
 #include "serial_commands.h"
+#include "binary_transfer.h"
 #include "log_manager.h"
+#include "trace_buffer.h"
 #include "system/tasks/task_manager.h"
 #include "config/version.h"
 
@@ -13,6 +15,44 @@ namespace BirdWatching {
     bool isBirdManagerInitialized();
     bool isAnimationPlaying();
     int getStatisticsCount();
+    void printAnimationStatus();
+    void invalidateBirdCatalog();
+}
+
+// 小鸟资源或配置被修改时，使小鸟目录缓存失效
+static void invalidateCatalogIfNeeded(const String& path) {
+    if ((path.startsWith("/birds/") && !path.startsWith("/birds/catalog.bin")) ||
+        path.startsWith("/configs/bird_config.csv")) {
+        BirdWatching::invalidateBirdCatalog();
+    }
+}
+
+// 输出LVGL互斥锁统计，detailed时附带等待/持有时间直方图
+static void printLVGLLockStats(const LVGLLockStats& live, bool detailed) {
+    // 统计由持锁任务更新，这里复制一份再输出
+    LVGLLockStats stats = live;
+
+    Serial.println("\n--- LVGL Mutex ---");
+    Serial.printf("Acquisitions: %u, timeouts: %u\n", stats.acquisitions, stats.timeouts);
+    Serial.printf("Max wait: %uus, max hold: %uus (%s)\n", stats.max_wait_us, stats.max_hold_us,
+                  stats.max_hold_task[0] ? stats.max_hold_task : "-");
+    if (!detailed) {
+        return;
+    }
+
+    Serial.println("Bucket          Wait        Hold");
+    uint32_t lower = 0;
+    for (int i = 0; i < LVGL_LOCK_HIST_BUCKETS; i++) {
+        uint32_t upper = TaskManager::lockHistBucketLimit(i);
+        char range[24];
+        if (upper) {
+            snprintf(range, sizeof(range), "%u-%uus", lower, upper);
+        } else {
+            snprintf(range, sizeof(range), ">=%uus", lower);
+        }
+        Serial.printf("%-14s %8u    %8u\n", range, stats.wait_hist[i], stats.hold_hist[i]);
+        lower = upper;
+    }
 }
 
 // 静态成员初始化
@@ -22,6 +62,8 @@ SerialCommands::SerialCommands() {
     logManager = nullptr;
     commandEnabled = true;
     commandCount = 0;
+    workerTask = nullptr;
+    workerBusy = false;
 }
 
 SerialCommands* SerialCommands::getInstance() {
@@ -36,13 +78,18 @@ void SerialCommands::initialize() {
 
     // 注册内置命令
     registerCommand("help", "Show available commands");
-    registerCommand("log", "Log file operations (clear, size, lines [N], cat) - default shows last 20 lines");
+    registerCommand("log", "Log file operations (clear, size, lines [N], cat, stats, rate) - default shows last 20 lines");
     registerCommand("status", "Show system status");
     registerCommand("clear", "Clear terminal screen");
     registerCommand("tree", "Show SD card directory tree structure [path] [levels]");
     registerCommand("bird", "Bird watching commands (trigger, stats, help)");
     registerCommand("task", "Task monitoring commands (stats, info)");
     registerCommand("file", "File transfer commands (upload, download, delete, info)");
+    registerCommand("trace", "Event trace ring (status, on, off, clear, dump)");
+
+    if (!startWorkerTask()) {
+        LOG_WARN("CMD", "Command task unavailable, long commands will run on the system task");
+    }
 
     LOG_INFO("CMD", "Serial command system initialized");
     Serial.println("Serial command system ready. Type 'help' for available commands.");
@@ -57,68 +104,140 @@ void SerialCommands::registerCommand(const String& name, const String& descripti
     }
 }
 
+bool SerialCommands::startWorkerTask() {
+    if (workerTask) {
+        return true;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        workerTaskFunction,
+        "Cmd_Task",
+        CMD_TASK_STACK_SIZE,
+        this,
+        CMD_TASK_PRIORITY,
+        &workerTask,
+        CMD_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        workerTask = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void SerialCommands::workerTaskFunction(void* parameter) {
+    SerialCommands* commands = static_cast<SerialCommands*>(parameter);
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        commands->executeCommand(commands->pendingCommand, commands->pendingParam);
+        commands->workerBusy = false;
+    }
+}
+
+bool SerialCommands::isLongRunning(const String& command) {
+    return command.equals("file") || command.equals("tree") || command.equals("log") ||
+           command.equals("trace");
+}
+
+bool SerialCommands::readLine(String& line) {
+    // 只取已到达的字节，不完整的行留到下个周期，避免readStringUntil等待超时
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\n') {
+            line = inputLine;
+            inputLine = "";
+            return true;
+        }
+        if (inputLine.length() < MAX_INPUT_LENGTH) {
+            inputLine += c;
+        }
+    }
+    return false;
+}
+
 void SerialCommands::handleInput() {
     if (!commandEnabled) return;
 
-    if (Serial.available()) {
-        String input = Serial.readStringUntil('\n');
-        input.trim();
+    // 命令任务执行期间（如文件传输）串口输入由它读取
+    if (workerBusy) return;
 
-        if (input.length() == 0) return; // 忽略空行
+    String input;
+    if (!readLine(input)) return;
+    input.trim();
 
-        LOG_DEBUG("CMD", "Received command: " + input);
+    if (input.length() == 0) return; // 忽略空行
 
-        // 解析命令和参数
-        String command = input;
-        String param = "";
+    LOG_DEBUG("CMD", "Received command: " + input);
 
-        int spaceIndex = input.indexOf(' ');
-        if (spaceIndex > 0) {
-            command = input.substring(0, spaceIndex);
-            param = input.substring(spaceIndex + 1);
-        }
+    // 解析命令和参数
+    String command = input;
+    String param = "";
 
-        // 处理命令
-        bool commandFound = false;
+    int spaceIndex = input.indexOf(' ');
+    if (spaceIndex > 0) {
+        command = input.substring(0, spaceIndex);
+        param = input.substring(spaceIndex + 1);
+    }
 
-        if (command.equals("help")) {
-            showHelp();
-            commandFound = true;
-        }
-        else if (command.equals("log")) {
-            handleLogCommand(param);
-            commandFound = true;
-        }
-        else if (command.equals("status")) {
-            handleStatusCommand();
-            commandFound = true;
-        }
-        else if (command.equals("clear")) {
-            handleClearCommand();
-            commandFound = true;
-        }
-        else if (command.equals("tree")) {
-            handleTreeCommand(param);
-            commandFound = true;
-        }
-        else if (command.equals("bird")) {
-            handleBirdCommand(param);
-            commandFound = true;
-        }
-        else if (command.equals("task")) {
-            handleTaskCommand(param);
-            commandFound = true;
-        }
-        else if (command.equals("file")) {
-            handleFileCommand(param);
-            commandFound = true;
-        }
+    // 耗时命令交给命令任务，系统任务继续保持10ms周期
+    if (workerTask && isLongRunning(command)) {
+        pendingCommand = command;
+        pendingParam = param;
+        workerBusy = true;
+        xTaskNotifyGive(workerTask);
+        return;
+    }
 
-        if (!commandFound) {
-            Serial.println("Unknown command: " + command);
-            Serial.println("Type 'help' for available commands");
-            LOG_WARN("CMD", "Unknown command: " + command);
-        }
+    executeCommand(command, param);
+}
+
+void SerialCommands::executeCommand(const String& command, const String& param) {
+    // 处理命令
+    bool commandFound = false;
+
+    if (command.equals("help")) {
+        showHelp();
+        commandFound = true;
+    }
+    else if (command.equals("log")) {
+        handleLogCommand(param);
+        commandFound = true;
+    }
+    else if (command.equals("status")) {
+        handleStatusCommand();
+        commandFound = true;
+    }
+    else if (command.equals("clear")) {
+        handleClearCommand();
+        commandFound = true;
+    }
+    else if (command.equals("tree")) {
+        handleTreeCommand(param);
+        commandFound = true;
+    }
+    else if (command.equals("bird")) {
+        handleBirdCommand(param);
+        commandFound = true;
+    }
+    else if (command.equals("task")) {
+        handleTaskCommand(param);
+        commandFound = true;
+    }
+    else if (command.equals("file")) {
+        handleFileCommand(param);
+        commandFound = true;
+    }
+    else if (command.equals("trace")) {
+        handleTraceCommand(param);
+        commandFound = true;
+    }
+
+    if (!commandFound) {
+        Serial.println("Unknown command: " + command);
+        Serial.println("Type 'help' for available commands");
+        LOG_WARN("CMD", "Unknown command: " + command);
     }
 }
 
@@ -172,42 +291,11 @@ void SerialCommands::handleLogCommand(const String& param) {
         Serial.println("<<<RESPONSE_START>>>");
         Serial.println("=== Full Log File Content ===");
 
-        // 直接顺序读取文件，避免重复读取相同内容
-        if (!logManager->isSDCardAvailable()) {
-            Serial.println("SD card is not available!");
-        } else {
-            // 直接打开日志文件顺序读取
-            String logFilePath = "/logs/cybird_watching.log";
-            if (!HAL::SDInterface::exists(logFilePath.c_str())) {
-                Serial.println("No log file found");
-            } else {
-                fs::FS& fs = HAL::SDInterface::getFS();
-                File logFile = fs.open(logFilePath, FILE_READ);
-                if (!logFile) {
-                    Serial.println("Failed to open log file");
-                } else {
-                    const int MAX_LINES = 5000; // 最大读取5000行
-                    int linesRead = 0;
-
-                    while (logFile.available() && linesRead < MAX_LINES) {
-                        String line = logFile.readStringUntil('\n');
-                        if (line.length() > 0) {
-                            // 限制行长度避免输出过长
-                            if (line.length() > 512) {
-                                line = line.substring(0, 512) + "...(truncated)";
-                            }
-                            Serial.println(line);
-                            linesRead++;
-                        }
-                    }
-
-                    logFile.close();
-
-                    if (linesRead >= MAX_LINES) {
-                        Serial.println("\n... (Reached maximum read limit of " + String(MAX_LINES) + " lines) ...");
-                    }
-                }
-            }
+        // 设备端顺序解码当前日志文件，更早的轮转代请下载后用cybird-cli decode解码
+        const int MAX_LINES = 5000; // 最大读取5000行
+        int linesRead = logManager->printLog(Serial, MAX_LINES);
+        if (linesRead >= MAX_LINES) {
+            Serial.println("\n... (Reached maximum read limit of " + String(MAX_LINES) + " lines) ...");
         }
 
         Serial.println("=== End of Log File ===");
@@ -216,6 +304,23 @@ void SerialCommands::handleLogCommand(const String& param) {
             logManager->logToSDOnly(LogManager::LM_LOG_INFO, "CMD", "Full log file exported");
         }
     }
+    else if (param.equals("stats")) {
+        Serial.println("<<<RESPONSE_START>>>");
+        LogRingStats stats = logManager->getRingStats();
+        Serial.println("=== Log Buffer ===");
+        Serial.println("Ring: " + String(LOG_RING_RECORDS) + " records x 128 bytes, peak used " + String(stats.peak_used));
+        Serial.println("Records logged: " + String(stats.records));
+        Serial.println("Records dropped: " + String(stats.dropped));
+        Serial.println("SD writes: " + String(stats.block_writes) + " (" + String(stats.bytes_written) + " bytes, " +
+                       String(LOG_BLOCK_SIZE) + "-byte blocks)");
+        Serial.println("Rotations: " + String(stats.rotations));
+        Serial.println("<<<RESPONSE_END>>>");
+    }
+    else if (param.equals("rate") || param.startsWith("rate ")) {
+        Serial.println("<<<RESPONSE_START>>>");
+        handleLogRateCommand(param.substring(4));
+        Serial.println("<<<RESPONSE_END>>>");
+    }
     else if (param.equals("help")) {
         Serial.println("<<<RESPONSE_START>>>");
         Serial.println("Log subcommands:");
@@ -224,10 +329,14 @@ void SerialCommands::handleLogCommand(const String& param) {
         Serial.println("  size        - Show log file size");
         Serial.println("  lines N     - Show last N lines (1-500)");
         Serial.println("  cat/export  - Show full log file content");
+        Serial.println("  stats       - Show log buffer statistics");
+        Serial.println("  rate        - Show per-tag rate limits");
+        Serial.println("  rate <TAG|default> <N|off> [burst] - Limit a tag to N lines/s");
         Serial.println("  help        - Show this help");
         Serial.println("Examples:");
         Serial.println("  log           - Show last 20 lines");
         Serial.println("  log lines 100 - Show last 100 lines");
+        Serial.println("  log rate anim 5 10 - Allow ANIM 5 lines/s, bursts of 10");
         Serial.println("<<<RESPONSE_END>>>");
     }
     else {
@@ -239,6 +348,66 @@ void SerialCommands::handleLogCommand(const String& param) {
     }
 }
 
+void SerialCommands::handleLogRateCommand(const String& args) {
+    String rest = args;
+    rest.trim();
+
+    // log rate：显示各标签的限流状态
+    if (rest.isEmpty()) {
+        Serial.println("=== Log Rate Limits ===");
+        Serial.println("Default: " + (logManager->getDefaultRate() ? String(logManager->getDefaultRate()) + "/s" : String("off")) +
+                       ", burst " + String(logManager->getDefaultBurst()));
+        Serial.println("Tag          Rate   Burst  Suppressed  Collapsed");
+
+        LogTagRateStats stats[LOG_RATE_MAX_TAGS];
+        size_t count = logManager->getTagRateStats(stats, LOG_RATE_MAX_TAGS);
+        for (size_t i = 0; i < count; i++) {
+            char line[80];
+            snprintf(line, sizeof(line), "%-11s %5s%c %6u  %10lu  %9lu",
+                     stats[i].tag, stats[i].rate ? String(stats[i].rate).c_str() : "off",
+                     stats[i].custom ? '*' : ' ', (unsigned)stats[i].burst,
+                     (unsigned long)stats[i].suppressed, (unsigned long)stats[i].collapsed);
+            Serial.println(line);
+        }
+        Serial.println("(* = set with 'log rate <TAG> ...')");
+        return;
+    }
+
+    // log rate <TAG|default> <N|off> [burst]
+    int firstSpace = rest.indexOf(' ');
+    if (firstSpace <= 0) {
+        Serial.println("Usage: log rate <TAG|default> <N|off> [burst]");
+        return;
+    }
+    String tag = rest.substring(0, firstSpace);
+    String value = rest.substring(firstSpace + 1);
+    value.trim();
+    String burstStr = "";
+    int secondSpace = value.indexOf(' ');
+    if (secondSpace > 0) {
+        burstStr = value.substring(secondSpace + 1);
+        value = value.substring(0, secondSpace);
+    }
+
+    long rate = value.equals("off") ? 0 : value.toInt();
+    long burst = burstStr.isEmpty() ? 0 : burstStr.toInt();
+    if ((rate == 0 && !value.equals("off") && !value.equals("0")) || rate < 0 || rate > 1000 ||
+        burst < 0 || burst > 1000) {
+        Serial.println("Invalid rate. Use: log rate <TAG|default> <1-1000|off> [burst 1-1000]");
+        return;
+    }
+
+    if (tag.equals("default")) {
+        logManager->setDefaultRateLimit(rate, burst);
+        Serial.println("Default log rate set to " + (rate ? String(rate) + "/s" : String("off")));
+    } else if (logManager->setTagRateLimit(tag.c_str(), rate, burst)) {
+        tag.toUpperCase();
+        Serial.println("Log rate for " + tag + " set to " + (rate ? String(rate) + "/s" : String("off")));
+    } else {
+        Serial.println("Too many log tags, cannot add " + tag);
+    }
+}
+
 void SerialCommands::handleStatusCommand() {
     // Start response marker
     Serial.println("<<<RESPONSE_START>>>");
@@ -426,6 +595,7 @@ void SerialCommands::handleBirdCommand(const String& param) {
             Serial.println("Bird Manager: Initialized");
             Serial.println("Animation System: " + String(BirdWatching::isAnimationPlaying() ? "Playing" : "Idle"));
             Serial.println("Statistics Records: " + String(BirdWatching::getStatisticsCount()));
+            BirdWatching::printAnimationStatus();
         } else {
             Serial.println("Bird Manager: NOT INITIALIZED");
         }
@@ -458,10 +628,22 @@ void SerialCommands::handleTaskCommand(const String& param) {
         Serial.println("Task monitoring subcommands:");
         Serial.println("  stats      - Show task statistics (stack usage, heap)");
         Serial.println("  info       - Show detailed task information");
+        Serial.println("  lock       - Show LVGL mutex wait/hold histograms");
+        Serial.println("  lock reset - Clear LVGL mutex statistics");
         Serial.println("  help       - Show this help");
         Serial.println("Examples:");
         Serial.println("  task stats  - Show task statistics");
         Serial.println("  task info   - Show detailed info");
+        Serial.println("  task lock   - Check how long the LVGL mutex is held");
+    }
+    else if (param.equals("lock") || param.equals("lock reset")) {
+        TaskManager* taskMgr = TaskManager::getInstance();
+        if (param.equals("lock reset")) {
+            taskMgr->resetLVGLLockStats();
+            Serial.println("LVGL mutex statistics cleared");
+        } else {
+            printLVGLLockStats(taskMgr->getLVGLLockStats(), true);
+        }
     }
     else if (param.equals("stats") || param.equals("info")) {
         Serial.println("=== Dual-Core Task Monitor ===");
@@ -470,7 +652,7 @@ void SerialCommands::handleTaskCommand(const String& param) {
         if (taskMgr) {
             Serial.println("\n--- Architecture ---");
             Serial.println("Core 0 (Protocol Core):  UI Task");
-            Serial.println("  - LVGL GUI (200Hz)");
+            Serial.println("  - LVGL GUI (deadline-driven)");
             Serial.println("  - Display Driver");
             Serial.println("  - Bird Animation");
             Serial.println("");
@@ -482,6 +664,16 @@ void SerialCommands::handleTaskCommand(const String& param) {
             
             Serial.println("\n--- Task Statistics ---");
             taskMgr->printTaskStats();
+
+            const UITimingStats& timing = taskMgr->getUITimingStats();
+            Serial.println("\n--- UI Render Timing ---");
+            Serial.printf("FPS: %u (display frames in last second)\n", timing.fps);
+            Serial.printf("Render cycles: %u, last sleep: %ums\n", timing.cycles, timing.last_sleep_ms);
+            Serial.printf("Wakeups: %u/s (%u by notification)\n", timing.wakeups, timing.notified_wakeups);
+            Serial.printf("Wake jitter: avg %uus, max %uus\n", timing.avg_jitter_us, timing.max_jitter_us);
+            Serial.printf("Max render time: %uus\n", timing.max_render_us);
+
+            printLVGLLockStats(taskMgr->getLVGLLockStats(), false);
             
             if (param.equals("info")) {
                 Serial.println("\n--- FreeRTOS Info ---");
@@ -508,6 +700,60 @@ void SerialCommands::handleTaskCommand(const String& param) {
     }
 }
 
+struct TraceDumpContext {
+    SerialCommands* commands;
+    uint32_t crc;
+};
+
+void SerialCommands::traceDumpSink(const uint8_t* data, size_t length, void* context) {
+    TraceDumpContext* dump = static_cast<TraceDumpContext*>(context);
+    dump->crc = BinaryTransfer::crc32(dump->crc, data, length);
+    Serial.println(dump->commands->base64Encode(data, length));
+    yield(); // 喂狗
+}
+
+void SerialCommands::handleTraceCommand(const String& param) {
+    Serial.println("<<<RESPONSE_START>>>");
+
+    if (param.isEmpty() || param.equals("status")) {
+        Serial.println("Trace: " + String(TraceBuffer::isEnabled() ? "on" : "off") +
+                       " (compiled " + String(TRACE_ENABLED ? "in" : "out") + ")");
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            uint32_t written = TraceBuffer::getWritten(core);
+            Serial.printf("Core %d: %u events, %u kept (ring %u)\n", core, written,
+                          written < TRACE_RING_SIZE ? written : TRACE_RING_SIZE, TRACE_RING_SIZE);
+        }
+    }
+    else if (param.equals("on") || param.equals("off")) {
+        TraceBuffer::setEnabled(param.equals("on"));
+        Serial.println("Trace " + param);
+    }
+    else if (param.equals("clear")) {
+        TraceBuffer::clear();
+        Serial.println("Trace cleared");
+    }
+    else if (param.equals("dump")) {
+        // 二进制快照按768字节一行base64输出，最后一行给出总长度和CRC32
+        TraceDumpContext context = { this, 0 };
+        Serial.println("TRACE_START");
+        size_t total = TraceBuffer::dump(traceDumpSink, &context);
+        Serial.printf("TRACE_END:%u:%08x\n", (unsigned)total, context.crc);
+    }
+    else if (param.equals("help")) {
+        Serial.println("Trace subcommands:");
+        Serial.println("  status     - Show trace state and event counts per core");
+        Serial.println("  on | off   - Enable or pause recording");
+        Serial.println("  clear      - Drop all recorded events");
+        Serial.println("  dump       - Dump the rings (save with 'cybird-cli trace', convert with trace2json)");
+    }
+    else {
+        Serial.println("Unknown trace subcommand: " + param);
+        Serial.println("Use 'trace help' for available subcommands");
+    }
+
+    Serial.println("<<<RESPONSE_END>>>");
+}
+
 SerialCommands::~SerialCommands() {
     LOG_DEBUG("CMD", "Serial command system destroyed");
 }
@@ -523,6 +769,9 @@ void SerialCommands::handleFileCommand(const String& param) {
         Serial.println("File transfer subcommands:");
         Serial.println("  upload <path>   - Upload file to SD card (receives base64 data)");
         Serial.println("  download <path> - Download file from SD card (sends base64 data)");
+        Serial.println("  put <path> <size> <crc32> [keep] - Binary framed upload with resume");
+        Serial.println("  get <path> [offset]       - Binary framed download with resume");
+        Serial.println("  hash <path|dir> [blocks]  - CRC32 of a file or every file under a directory");
         Serial.println("  delete <path>   - Delete file from SD card");
         Serial.println("  info <path>     - Show file information");
         Serial.println("  help            - Show this help");
@@ -532,9 +781,11 @@ void SerialCommands::handleFileCommand(const String& param) {
         Serial.println("  3. Send: FILE_SIZE:<bytes>");
         Serial.println("  4. Send base64 encoded data in chunks (max 512 bytes/line)");
         Serial.println("  5. Send: FILE_END");
+        Serial.println("\nBinary protocol (put/get): CRC32 frames, sliding window, see binary_transfer.h");
         Serial.println("\nExamples:");
         Serial.println("  file download /configs/bird_config.csv");
         Serial.println("  file info /birds/1001/1.bin");
+        Serial.println("  file hash /birds blocks");
         Serial.println("  file delete /temp/old_file.txt");
     }
     else if (param.startsWith("upload ")) {
@@ -547,6 +798,15 @@ void SerialCommands::handleFileCommand(const String& param) {
         path.trim();
         handleFileDownload(path);
     }
+    else if (param.startsWith("put ")) {
+        handleFilePut(param.substring(4));
+    }
+    else if (param.startsWith("get ")) {
+        handleFileGet(param.substring(4));
+    }
+    else if (param.startsWith("hash ")) {
+        handleFileHash(param.substring(5));
+    }
     else if (param.startsWith("delete ")) {
         String path = param.substring(7);
         path.trim();
@@ -576,29 +836,8 @@ void SerialCommands::handleFileUpload(const String& path) {
     }
 
     // 确保目录存在
-    String dirPath = path;
-    int lastSlash = dirPath.lastIndexOf('/');
-    if (lastSlash > 0) {
-        dirPath = dirPath.substring(0, lastSlash);
-        fs::FS& fs = HAL::SDInterface::getFS();
-        if (!fs.exists(dirPath)) {
-            // 创建目录结构
-            String currentPath = "";
-            int start = 1; // 跳过开头的 '/'
-            while (start < dirPath.length()) {
-                int nextSlash = dirPath.indexOf('/', start);
-                if (nextSlash == -1) nextSlash = dirPath.length();
-                
-                currentPath += "/" + dirPath.substring(start, nextSlash);
-                if (!fs.exists(currentPath)) {
-                    if (!fs.mkdir(currentPath)) {
-                        Serial.println("ERROR: Failed to create directory: " + currentPath);
-                        return;
-                    }
-                }
-                start = nextSlash + 1;
-            }
-        }
+    if (!BinaryTransfer::ensureParentDirectory(path)) {
+        return;
     }
 
     Serial.println("READY");
@@ -641,6 +880,7 @@ void SerialCommands::handleFileUpload(const String& path) {
     String base64Buffer = "";
     size_t totalWritten = 0;
     bool transferComplete = false;
+    unsigned long lastProgress = 0;
     timeout = millis() + 120000; // 2分钟超时
 
     while (millis() < timeout && !transferComplete) {
@@ -664,9 +904,14 @@ void SerialCommands::handleFileUpload(const String& path) {
                 if (decodedLen > 0) {
                     size_t written = file.write(decoded, decodedLen);
                     totalWritten += written;
-                    Serial.printf("Progress: %u / %u bytes (%.1f%%)\n", 
-                        totalWritten, expectedSize, 
-                        (totalWritten * 100.0) / expectedSize);
+
+                    // 进度最多每500ms输出一次，避免串口输出拖慢接收
+                    if (millis() - lastProgress >= 500) {
+                        lastProgress = millis();
+                        Serial.printf("Progress: %u / %u bytes (%.1f%%)\n",
+                            totalWritten, expectedSize,
+                            (totalWritten * 100.0) / expectedSize);
+                    }
                 }
                 
                 base64Buffer = base64Buffer.substring(1364);
@@ -691,6 +936,7 @@ void SerialCommands::handleFileUpload(const String& path) {
         Serial.printf("SUCCESS: File uploaded successfully!\n");
         Serial.printf("Path: %s\n", path.c_str());
         Serial.printf("Size: %u bytes\n", totalWritten);
+        invalidateCatalogIfNeeded(path);
     } else {
         Serial.println("ERROR: Transfer timeout or incomplete");
         fs.remove(path); // 删除不完整的文件
@@ -743,6 +989,75 @@ void SerialCommands::handleFileDownload(const String& path) {
     Serial.printf("SUCCESS: %u bytes sent\n", totalSent);
 }
 
+void SerialCommands::handleFilePut(const String& args) {
+    if (!logManager || !logManager->isSDCardAvailable()) {
+        Serial.println("ERROR: SD card not available");
+        return;
+    }
+
+    // file put <path> <size> <crc32> [keep]
+    String rest = args;
+    rest.trim();
+    int firstSpace = rest.indexOf(' ');
+    int secondSpace = firstSpace > 0 ? rest.indexOf(' ', firstSpace + 1) : -1;
+    if (firstSpace <= 0 || secondSpace <= 0) {
+        Serial.println("ERROR: Usage: file put <path> <size> <crc32> [keep]");
+        return;
+    }
+
+    String path = rest.substring(0, firstSpace);
+    size_t size = strtoul(rest.substring(firstSpace + 1, secondSpace).c_str(), nullptr, 10);
+    const char* crcText = rest.c_str() + secondSpace + 1;
+    char* end = nullptr;
+    uint32_t crc = strtoul(crcText, &end, 16);
+    size_t keep = end ? strtoul(end, nullptr, 10) : 0;
+
+    if (BinaryTransfer::receive(path, size, crc, keep)) {
+        invalidateCatalogIfNeeded(path);
+    }
+}
+
+void SerialCommands::handleFileGet(const String& args) {
+    if (!logManager || !logManager->isSDCardAvailable()) {
+        Serial.println("ERROR: SD card not available");
+        return;
+    }
+
+    // file get <path> [offset]
+    String rest = args;
+    rest.trim();
+    String path = rest;
+    size_t offset = 0;
+    int space = rest.indexOf(' ');
+    if (space > 0) {
+        path = rest.substring(0, space);
+        offset = strtoul(rest.substring(space + 1).c_str(), nullptr, 10);
+    }
+
+    BinaryTransfer::send(path, offset);
+}
+
+void SerialCommands::handleFileHash(const String& args) {
+    if (!logManager || !logManager->isSDCardAvailable()) {
+        Serial.println("ERROR: SD card not available");
+        return;
+    }
+
+    // file hash <path|dir> [blocks]
+    String path = args;
+    path.trim();
+    bool blocks = false;
+    int space = path.lastIndexOf(' ');
+    if (space > 0 && path.substring(space + 1).equalsIgnoreCase("blocks")) {
+        blocks = true;
+        path = path.substring(0, space);
+        path.trim();
+    }
+
+    size_t count = BinaryTransfer::printHashes(path, blocks);
+    Serial.printf("HASH_END %u\n", (unsigned)count);
+}
+
 void SerialCommands::handleFileDelete(const String& path) {
     if (!logManager || !logManager->isSDCardAvailable()) {
         Serial.println("ERROR: SD card not available");
@@ -757,6 +1072,7 @@ void SerialCommands::handleFileDelete(const String& path) {
 
     if (fs.remove(path)) {
         Serial.println("SUCCESS: File deleted: " + path);
+        invalidateCatalogIfNeeded(path);
     } else {
         Serial.println("ERROR: Failed to delete file: " + path);
     }
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "log_manager.h"
 #include "hal/sd_interface.h"
 
 class SerialCommands {
 private:
     static const int MAX_COMMANDS = 20;
+    static const size_t MAX_INPUT_LENGTH = 256;
 
     struct Command {
         String name;
@@ -19,6 +22,15 @@ private:
     LogManager* logManager;
     bool commandEnabled;
 
+    // 未读完的一行输入（逐周期拼接，不阻塞系统任务）
+    String inputLine;
+
+    // 耗时命令（file/tree/log）交给命令任务执行，执行期间串口输入归命令任务读取
+    TaskHandle_t workerTask;
+    volatile bool workerBusy;
+    String pendingCommand;
+    String pendingParam;
+
     // 私有构造函数，单例模式
     SerialCommands();
 
@@ -32,9 +44,12 @@ public:
     // 注册新命令
     void registerCommand(const String& name, const String& description);
 
-    // 处理串口输入
+    // 处理串口输入（非阻塞，由系统任务每周期调用）
     void handleInput();
 
+    // 命令任务是否正在执行耗时命令
+    bool isBusy() const { return workerBusy; }
+
     // 显示帮助信息
     void showHelp();
 
@@ -48,18 +63,38 @@ public:
     ~SerialCommands();
 
 private:
+    // 读取一行输入，行不完整时返回false
+    bool readLine(String& line);
+
+    // 分发并执行一条命令
+    void executeCommand(const String& command, const String& param);
+
+    // 只访问SD卡和串口的耗时命令，可以在命令任务中执行
+    static bool isLongRunning(const String& command);
+
+    bool startWorkerTask();
+    static void workerTaskFunction(void* parameter);
+
     // 命令处理函数
     void handleLogCommand(const String& param);
+    void handleLogRateCommand(const String& args);
     void handleStatusCommand();
     void handleClearCommand();
     void handleTreeCommand(const String& param);
     void handleBirdCommand(const String& param);
     void handleTaskCommand(const String& param);
     void handleFileCommand(const String& param);
+    void handleTraceCommand(const String& param);
+
+    // trace dump的输出回调：每块数据base64编码为一行并累计CRC32
+    static void traceDumpSink(const uint8_t* data, size_t length, void* context);
     
     // 文件传输辅助函数
     void handleFileUpload(const String& param);
     void handleFileDownload(const String& param);
+    void handleFilePut(const String& args);
+    void handleFileGet(const String& args);
+    void handleFileHash(const String& args);
     void handleFileDelete(const String& param);
     void handleFileInfo(const String& param);
     String base64Encode(const uint8_t* data, size_t length);
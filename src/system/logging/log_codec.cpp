@@ -0,0 +1,592 @@
+#include "log_codec.h"
+#include <cstring>
+
+namespace {
+
+    // 一个printf转换说明的各部分（都指向格式串内部）
+    struct ConversionSpec {
+        const char* flags;
+        size_t flagsLen;
+        const char* width;
+        size_t widthLen;
+        bool starWidth;
+        bool hasPrecision;
+        const char* precision;
+        size_t precisionLen;
+        bool starPrecision;
+        char length[3];       // "", "hh", "h", "l", "ll", "z", "j", "t", "L"
+        char conversion;      // 0表示格式串在说明中间结束
+    };
+
+    // 参数的编码类别
+    enum ArgClass {
+        ARG_NONE,
+        ARG_SIGNED,
+        ARG_UNSIGNED,
+        ARG_DOUBLE,
+        ARG_STRING,
+        ARG_POINTER,
+        ARG_SKIP              // %n：取出参数但不编码
+    };
+
+    // 解析从'%'之后开始的转换说明，返回说明之后的位置
+    const char* parseSpec(const char* p, ConversionSpec& spec) {
+        memset(&spec, 0, sizeof(spec));
+
+        spec.flags = p;
+        while (*p && strchr("-+ #0", *p)) p++;
+        spec.flagsLen = p - spec.flags;
+
+        if (*p == '*') {
+            spec.starWidth = true;
+            p++;
+        } else {
+            spec.width = p;
+            while (*p >= '0' && *p <= '9') p++;
+            spec.widthLen = p - spec.width;
+        }
+
+        if (*p == '.') {
+            spec.hasPrecision = true;
+            p++;
+            if (*p == '*') {
+                spec.starPrecision = true;
+                p++;
+            } else {
+                spec.precision = p;
+                while (*p >= '0' && *p <= '9') p++;
+                spec.precisionLen = p - spec.precision;
+            }
+        }
+
+        if ((p[0] == 'h' && p[1] == 'h') || (p[0] == 'l' && p[1] == 'l')) {
+            spec.length[0] = p[0];
+            spec.length[1] = p[1];
+            p += 2;
+        } else if (*p && strchr("hlzjtL", *p)) {
+            spec.length[0] = *p++;
+        }
+
+        spec.conversion = *p;
+        return *p ? p + 1 : p;
+    }
+
+    ArgClass classify(char conversion) {
+        switch (conversion) {
+            case 'd': case 'i': case 'c':
+                return ARG_SIGNED;
+            case 'u': case 'o': case 'x': case 'X':
+                return ARG_UNSIGNED;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                return ARG_DOUBLE;
+            case 's':
+                return ARG_STRING;
+            case 'p':
+                return ARG_POINTER;
+            case 'n':
+                return ARG_SKIP;
+            default:
+                return ARG_NONE;
+        }
+    }
+
+    // hh/h按printf的规则截断为char/short（参数经过整数提升，超出范围的值要在编码前截断）
+    int64_t narrowSigned(const ConversionSpec& spec, int64_t value) {
+        if (strcmp(spec.length, "hh") == 0) return (signed char)value;
+        if (strcmp(spec.length, "h") == 0) return (short)value;
+        return value;
+    }
+
+    uint64_t narrowUnsigned(const ConversionSpec& spec, uint64_t value) {
+        if (strcmp(spec.length, "hh") == 0) return (unsigned char)value;
+        if (strcmp(spec.length, "h") == 0) return (unsigned short)value;
+        return value;
+    }
+
+    int64_t readSigned(const ConversionSpec& spec, va_list& args) {
+        const char* len = spec.length;
+        if (strcmp(len, "l") == 0) return va_arg(args, long);
+        if (strcmp(len, "ll") == 0) return va_arg(args, long long);
+        if (strcmp(len, "z") == 0) return (int64_t)va_arg(args, size_t);
+        if (strcmp(len, "j") == 0) return va_arg(args, intmax_t);
+        if (strcmp(len, "t") == 0) return va_arg(args, ptrdiff_t);
+        return narrowSigned(spec, va_arg(args, int));
+    }
+
+    uint64_t readUnsigned(const ConversionSpec& spec, va_list& args) {
+        const char* len = spec.length;
+        if (strcmp(len, "l") == 0) return va_arg(args, unsigned long);
+        if (strcmp(len, "ll") == 0) return va_arg(args, unsigned long long);
+        if (strcmp(len, "z") == 0) return va_arg(args, size_t);
+        if (strcmp(len, "j") == 0) return va_arg(args, uintmax_t);
+        if (strcmp(len, "t") == 0) return (uint64_t)va_arg(args, ptrdiff_t);
+        return narrowUnsigned(spec, va_arg(args, unsigned int));
+    }
+
+    // 从负载顺序读取参数
+    struct PayloadCursor {
+        const uint8_t* data;
+        size_t length;
+        size_t pos;
+
+        bool readVarint(uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64 && pos < length; shift += 7) {
+                uint8_t byte = data[pos++];
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // 重建转换说明：宽度/精度用解码出的数值，整数统一按ll格式化
+    void buildSpec(const ConversionSpec& spec, int width, int precision, const char* length, char conversion,
+                   char* out, size_t size) {
+        String text = "%";
+        text += String(spec.flags).substring(0, spec.flagsLen);
+        if (spec.starWidth) {
+            text += String(width);
+        } else {
+            text += String(spec.width).substring(0, spec.widthLen);
+        }
+        if (spec.hasPrecision) {
+            text += '.';
+            if (spec.starPrecision) {
+                text += String(precision);
+            } else {
+                text += String(spec.precision).substring(0, spec.precisionLen);
+            }
+        }
+        text += length;
+        text += conversion;
+        strncpy(out, text.c_str(), size - 1);
+        out[size - 1] = '\0';
+    }
+
+    // 按格式串编码参数（args为局部va_list的引用，便于在辅助函数间传递）
+    size_t encodeArgList(uint8_t* out, size_t capacity, const char* format, va_list& args) {
+        size_t pos = 0;
+        const char* p = format;
+
+        while (*p) {
+            if (*p++ != '%') {
+                continue;
+            }
+            if (*p == '%') {
+                p++;
+                continue;
+            }
+
+            ConversionSpec spec;
+            p = parseSpec(p, spec);
+            ArgClass argClass = classify(spec.conversion);
+            if (argClass == ARG_NONE) {
+                break;
+            }
+
+            // *宽度/精度先于参数本身
+            int stars = (spec.starWidth ? 1 : 0) + (spec.starPrecision ? 1 : 0);
+            for (int i = 0; i < stars; i++) {
+                int value = va_arg(args, int);
+                if (pos + LogCodec::MAX_VARINT_SIZE > capacity) return pos;
+                pos += LogCodec::writeVarint(out + pos, LogCodec::zigzag(value));
+            }
+
+            switch (argClass) {
+                case ARG_SIGNED: {
+                    int64_t value = readSigned(spec, args);
+                    if (pos + LogCodec::MAX_VARINT_SIZE > capacity) return pos;
+                    pos += LogCodec::writeVarint(out + pos, LogCodec::zigzag(value));
+                    break;
+                }
+                case ARG_UNSIGNED: {
+                    uint64_t value = readUnsigned(spec, args);
+                    if (pos + LogCodec::MAX_VARINT_SIZE > capacity) return pos;
+                    pos += LogCodec::writeVarint(out + pos, value);
+                    break;
+                }
+                case ARG_POINTER: {
+                    uint64_t value = (uintptr_t)va_arg(args, void*);
+                    if (pos + LogCodec::MAX_VARINT_SIZE > capacity) return pos;
+                    pos += LogCodec::writeVarint(out + pos, value);
+                    break;
+                }
+                case ARG_DOUBLE: {
+                    double value = strcmp(spec.length, "L") == 0 ? (double)va_arg(args, long double)
+                                                                : va_arg(args, double);
+                    if (pos + sizeof(value) > capacity) return pos;
+                    memcpy(out + pos, &value, sizeof(value));
+                    pos += sizeof(value);
+                    break;
+                }
+                case ARG_STRING: {
+                    const char* value = va_arg(args, const char*);
+                    if (!value) value = "(null)";
+                    size_t len = strlen(value);
+                    if (pos + LogCodec::MAX_VARINT_SIZE >= capacity) return pos;
+                    // 放不下时截断字符串本身
+                    size_t room = capacity - pos - LogCodec::MAX_VARINT_SIZE;
+                    if (len > room) len = room;
+                    pos += LogCodec::writeVarint(out + pos, len);
+                    memcpy(out + pos, value, len);
+                    pos += len;
+                    break;
+                }
+                case ARG_SKIP:
+                    va_arg(args, void*);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        return pos;
+    }
+
+}
+
+size_t LogCodec::writeVarint(uint8_t* out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+size_t LogCodec::writeFileHeader(uint8_t* out) {
+    uint32_t magic = FILE_MAGIC;
+    uint16_t version = FILE_VERSION;
+    uint16_t reserved = 0;
+    memcpy(out, &magic, 4);
+    memcpy(out + 4, &version, 2);
+    memcpy(out + 6, &reserved, 2);
+    return FILE_HEADER_SIZE;
+}
+
+size_t LogCodec::encodeArgs(uint8_t* out, size_t capacity, const char* format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    size_t pos = encodeArgList(out, capacity, format, copy);
+    va_end(copy);
+    return pos;
+}
+
+void LogCodec::formatArgs(const char* format, const uint8_t* payload, size_t length, String& out) {
+    PayloadCursor cursor = { payload, length, 0 };
+    const char* p = format;
+    const char* literal = p;
+
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+
+        // 先输出转换说明前的普通文本
+        out += String(literal).substring(0, p - literal);
+        p++;
+        if (*p == '%') {
+            out += '%';
+            literal = ++p;
+            continue;
+        }
+
+        ConversionSpec spec;
+        const char* specStart = p - 1;
+        p = parseSpec(p, spec);
+        literal = p;
+        ArgClass argClass = classify(spec.conversion);
+        if (argClass == ARG_NONE) {
+            out += String(specStart).substring(0, p - specStart);
+            continue;
+        }
+        if (argClass == ARG_SKIP) {
+            continue;
+        }
+
+        uint64_t raw = 0;
+        int width = 0;
+        int precision = 0;
+        bool ok = true;
+        if (spec.starWidth) {
+            ok = ok && cursor.readVarint(raw);
+            width = (int)unzigzag(raw);
+        }
+        if (spec.starPrecision) {
+            ok = ok && cursor.readVarint(raw);
+            precision = (int)unzigzag(raw);
+        }
+
+        char specText[32];
+        char text[128];
+        text[0] = '\0';
+        switch (argClass) {
+            case ARG_SIGNED:
+                ok = ok && cursor.readVarint(raw);
+                if (!ok) break;
+                if (spec.conversion == 'c') {
+                    buildSpec(spec, width, precision, "", 'c', specText, sizeof(specText));
+                    snprintf(text, sizeof(text), specText, (int)unzigzag(raw));
+                } else {
+                    // 旧文件中hh/h的参数未截断，解码时再截断一次
+                    buildSpec(spec, width, precision, "ll", spec.conversion, specText, sizeof(specText));
+                    snprintf(text, sizeof(text), specText, (long long)narrowSigned(spec, unzigzag(raw)));
+                }
+                break;
+            case ARG_UNSIGNED:
+                ok = ok && cursor.readVarint(raw);
+                if (!ok) break;
+                buildSpec(spec, width, precision, "ll", spec.conversion, specText, sizeof(specText));
+                snprintf(text, sizeof(text), specText, (unsigned long long)narrowUnsigned(spec, raw));
+                break;
+            case ARG_POINTER:
+                ok = ok && cursor.readVarint(raw);
+                if (!ok) break;
+                snprintf(text, sizeof(text), "0x%llx", (unsigned long long)raw);
+                break;
+            case ARG_DOUBLE: {
+                double value = 0;
+                ok = ok && cursor.pos + sizeof(value) <= cursor.length;
+                if (!ok) break;
+                memcpy(&value, cursor.data + cursor.pos, sizeof(value));
+                cursor.pos += sizeof(value);
+                buildSpec(spec, width, precision, "", spec.conversion, specText, sizeof(specText));
+                snprintf(text, sizeof(text), specText, value);
+                break;
+            }
+            case ARG_STRING: {
+                ok = ok && cursor.readVarint(raw) && cursor.pos + raw <= cursor.length;
+                if (!ok) break;
+                String value;
+                value.reserve(raw);
+                for (size_t i = 0; i < raw; i++) {
+                    value += (char)cursor.data[cursor.pos + i];
+                }
+                cursor.pos += raw;
+                if (spec.widthLen == 0 && !spec.starWidth && !spec.hasPrecision) {
+                    out += value;
+                } else {
+                    buildSpec(spec, width, precision, "", 's', specText, sizeof(specText));
+                    snprintf(text, sizeof(text), specText, value.c_str());
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        // 负载被截断时缺少的参数显示为"?"
+        out += ok ? text : "?";
+    }
+
+    out += String(literal);
+}
+
+void LogCodec::formatTimestamp(uint64_t us, char* out, size_t size) {
+    unsigned long ms = (unsigned long)(us / 1000);
+    unsigned long seconds = ms / 1000;
+    unsigned long minutes = seconds / 60;
+    unsigned long hours = minutes / 60;
+
+    snprintf(out, size, "%02lu:%02lu:%02lu.%03lu",
+             hours % 24, minutes % 60, seconds % 60, ms % 1000);
+}
+
+const char* LogCodec::levelName(uint8_t level) {
+    switch (level) {
+        case 1: return "FATAL";
+        case 2: return "ERROR";
+        case 3: return "WARN";
+        case 4: return "INFO";
+        case 5: return "DEBUG";
+        case 6: return "TRACE";
+        default: return "UNKNOWN";
+    }
+}
+
+LogReader::LogReader(File& file)
+    : file(file)
+    , valid(false)
+    , truncated(false)
+    , bufferLen(0)
+    , bufferPos(0)
+    , lastTimestamp(0)
+    , wallBase(0)
+{
+    uint8_t header[LogCodec::FILE_HEADER_SIZE];
+    if (readBytes(header, sizeof(header))) {
+        uint32_t magic;
+        uint16_t version;
+        memcpy(&magic, header, 4);
+        memcpy(&version, header + 4, 2);
+        valid = magic == LogCodec::FILE_MAGIC && version == LogCodec::FILE_VERSION;
+    }
+}
+
+bool LogReader::readByte(uint8_t& value) {
+    if (bufferPos == bufferLen) {
+        bufferLen = file.read(buffer, sizeof(buffer));
+        bufferPos = 0;
+        if (bufferLen == 0) {
+            return false;
+        }
+    }
+    value = buffer[bufferPos++];
+    return true;
+}
+
+bool LogReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte;
+        if (!readByte(byte)) {
+            return false;
+        }
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LogReader::readBytes(uint8_t* out, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (!readByte(out[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogReader::readString(String& out) {
+    uint64_t length;
+    if (!readVarint(length) || length > 1024) {
+        return false;
+    }
+    out = "";
+    out.reserve(length);
+    for (uint64_t i = 0; i < length; i++) {
+        uint8_t c;
+        if (!readByte(c)) {
+            return false;
+        }
+        out += (char)c;
+    }
+    return true;
+}
+
+void LogReader::setEntry(std::vector<String>& table, uint64_t id, const String& value) {
+    if (id >= 4096) {
+        return;
+    }
+    if (table.size() <= id) {
+        table.resize(id + 1);
+    }
+    table[id] = value;
+}
+
+const String& LogReader::getEntry(const std::vector<String>& table, uint64_t id) {
+    static const String unknown = "?";
+    return id < table.size() ? table[id] : unknown;
+}
+
+void LogReader::formatLine(const LogEntry& entry, String& line) {
+    char timestamp[16];
+    LogCodec::formatTimestamp(entry.timestamp, timestamp, sizeof(timestamp));
+    line = String("[") + timestamp + "] [" + LogCodec::levelName(entry.level) + "] [" + entry.tag + "] " +
+           entry.message;
+}
+
+bool LogReader::next(String& line) {
+    LogEntry entry;
+    if (!next(entry)) {
+        return false;
+    }
+    formatLine(entry, line);
+    return true;
+}
+
+bool LogReader::next(LogEntry& entry) {
+    if (!valid) {
+        return false;
+    }
+
+    while (true) {
+        uint8_t type;
+        if (!readByte(type)) {
+            return false;
+        }
+
+        uint64_t id;
+        String text;
+        switch (type) {
+            case LogCodec::ENTRY_SYNC: {
+                uint64_t epoch;
+                uint64_t syncUs;
+                if (!readVarint(epoch) || !readVarint(syncUs)) return fail();
+                tags.clear();
+                formats.clear();
+                lastTimestamp = 0;
+                wallBase = epoch ? (int64_t)epoch * 1000000 - (int64_t)syncUs : 0;
+                continue;
+            }
+            case LogCodec::ENTRY_TAG:
+                if (!readVarint(id) || !readString(text)) return fail();
+                setEntry(tags, id, text);
+                continue;
+            case LogCodec::ENTRY_FORMAT:
+                if (!readVarint(id) || !readString(text)) return fail();
+                setEntry(formats, id, text);
+                continue;
+            case LogCodec::ENTRY_DROP: {
+                uint64_t count;
+                if (!readVarint(count)) return fail();
+                entry.timestamp = lastTimestamp;
+                entry.wallTime = wallBase ? wallBase + (int64_t)lastTimestamp : 0;
+                entry.level = 3;
+                entry.tag = "LOG";
+                entry.message = String((unsigned long)count) + " log records dropped (buffer full)";
+                return true;
+            }
+            default:
+                break;
+        }
+
+        if ((type & 0xF8) != LogCodec::ENTRY_RECORD) {
+            // 未知条目，后面的数据无法再对齐
+            return fail();
+        }
+
+        uint64_t delta, tagId, formatId, length;
+        if (!readVarint(delta) || !readVarint(tagId) || !readVarint(formatId) || !readVarint(length) ||
+            length > 4096) {
+            return fail();
+        }
+        payload.resize(length);
+        if (length && !readBytes(payload.data(), length)) {
+            return fail();
+        }
+        lastTimestamp += LogCodec::unzigzag(delta);
+
+        entry.timestamp = lastTimestamp;
+        entry.wallTime = wallBase ? wallBase + (int64_t)lastTimestamp : 0;
+        entry.level = type & 0x07;
+        entry.tag = getEntry(tags, tagId);
+        entry.message = "";
+        if (formatId == 0) {
+            entry.message.reserve(length);
+            for (size_t i = 0; i < length; i++) {
+                entry.message += (char)payload[i];
+            }
+        } else {
+            LogCodec::formatArgs(getEntry(formats, formatId).c_str(), payload.data(), length, entry.message);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <cstdarg>
+#include <vector>
+
+/**
+ * 二进制日志（.clog）编解码
+ *
+ * 文件头8字节："CLOG" + 版本(u16) + 保留(u16)，之后是一串条目，首字节为类型：
+ *   SYNC    0x01       墙上时间(varint秒，未校时为0) 同步时刻(varint us)
+ *                      解码器清空标签/格式表，时间基准归零
+ *   TAG     0x02       id(varint) 长度(varint) 字节
+ *   FORMAT  0x03       id(varint) 长度(varint) 字节
+ *   DROP    0x04       丢弃条数(varint)
+ *   RECORD  0x10|级别  时间增量us(zigzag varint) 标签id 格式id(0为纯文本) 负载长度 负载
+ *
+ * 每个文件（以及每次开机追加时）以SYNC开始，标签和格式串在其后首次使用时定义，
+ * 因此任一轮转代的文件都可以单独解码。
+ *
+ * 负载按格式串的转换说明依次编码：整数为varint（有符号用zigzag，hh/h先截断为char/short），%s为长度+字节，
+ * 浮点为8字节double，*宽度/精度作为int参数编码；纯文本记录的负载就是消息本身。
+ * 主机端解码器scripts/host_bench/clog_decode.cpp编译本文件，使用同一个LogReader。
+ */
+class LogCodec {
+public:
+    static constexpr uint32_t FILE_MAGIC = 0x474F4C43;   // "CLOG"
+    static constexpr uint16_t FILE_VERSION = 1;
+    static constexpr size_t FILE_HEADER_SIZE = 8;
+    static constexpr size_t MAX_VARINT_SIZE = 10;
+
+    enum EntryType : uint8_t {
+        ENTRY_SYNC = 0x01,
+        ENTRY_TAG = 0x02,
+        ENTRY_FORMAT = 0x03,
+        ENTRY_DROP = 0x04,
+        ENTRY_RECORD = 0x10       // 低3位为级别
+    };
+
+    // 写入varint，返回字节数（out至少MAX_VARINT_SIZE字节）
+    static size_t writeVarint(uint8_t* out, uint64_t value);
+
+    static uint64_t zigzag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+    static int64_t unzigzag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+    // 写入文件头，返回字节数
+    static size_t writeFileHeader(uint8_t* out);
+
+    /**
+     * 按格式串把参数编码到out
+     *
+     * @return 写入的字节数；容量不足时后面的参数被丢弃，解码时显示为"?"
+     */
+    static size_t encodeArgs(uint8_t* out, size_t capacity, const char* format, va_list args);
+
+    // 按格式串解码负载，把格式化后的文本追加到out
+    static void formatArgs(const char* format, const uint8_t* payload, size_t length, String& out);
+
+    // 格式化开机以来的时间戳（hh:mm:ss.mmm）
+    static void formatTimestamp(uint64_t us, char* out, size_t size);
+
+    // 日志级别名称
+    static const char* levelName(uint8_t level);
+};
+
+// 解码后的一条日志
+struct LogEntry {
+    uint64_t timestamp;         // 开机以来的微秒数
+    int64_t wallTime;           // 墙上时间（Unix微秒），设备未校时为0
+    uint8_t level;
+    String tag;
+    String message;
+};
+
+/**
+ * 顺序读取.clog文件并逐条解码
+ *
+ * 行格式与旧版文本日志相同：[hh:mm:ss.mmm] [LEVEL] [TAG] message
+ */
+class LogReader {
+public:
+    explicit LogReader(File& file);
+
+    // 文件头是否有效
+    bool isValid() const { return valid; }
+
+    // 读取下一条日志，文件结束或数据损坏时返回false
+    bool next(LogEntry& entry);
+
+    // 读取下一行
+    bool next(String& line);
+
+    // 是否因数据不完整/损坏而提前结束（写入中途断电时文件末尾可能只有半个条目）
+    bool isTruncated() const { return truncated; }
+
+    // 按开机时间格式化一行
+    static void formatLine(const LogEntry& entry, String& line);
+
+private:
+    File& file;
+    bool valid;
+    bool truncated;
+    uint8_t buffer[512];
+    size_t bufferLen;
+    size_t bufferPos;
+    uint64_t lastTimestamp;
+    int64_t wallBase;           // 墙上时间 - 同步时刻（微秒），未校时为0
+    std::vector<String> tags;
+    std::vector<String> formats;
+    std::vector<uint8_t> payload;
+
+    bool readByte(uint8_t& value);
+    bool readVarint(uint64_t& value);
+    bool readBytes(uint8_t* out, size_t length);
+    bool readString(String& out);
+
+    // 数据损坏，停止解码
+    bool fail() { truncated = true; return false; }
+
+    static void setEntry(std::vector<String>& table, uint64_t id, const String& value);
+    static const String& getEntry(const std::vector<String>& table, uint64_t id);
+};
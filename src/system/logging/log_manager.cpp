@@ -1,18 +1,68 @@
 #include <Arduino.h>
 #include "log_manager.h"
+#include "log_codec.h"
 #include "hal/sd_interface.h"
+#include "system/tasks/task_manager.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include <time.h>
 #include <vector>
+#include <cstring>
+#include <cstdarg>
 
 // 静态成员初始化
 LogManager* LogManager::instance = nullptr;
+int LogManager::runtimeLogLevel = LogManager::LM_LOG_INFO;
+
+// esp_restart()前把缓冲区中的日志写卡
+// 关机处理函数里不能无限等待：持有限流表/文件锁的任务可能已无法继续运行，超时则跳过
+static void flushLogOnShutdown() {
+    LogManager::getInstance()->flush(pdMS_TO_TICKS(LOG_SHUTDOWN_WAIT_MS));
+}
+
+// FNV-1a，用于判断日志内容是否与上一条相同
+static const uint32_t HASH_SEED = 2166136261u;
+
+static uint32_t hashBytes(uint32_t hash, const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
 LogManager::LogManager() {
     sdCardAvailable = false;
-    logFilePath = "/logs/cybird_watching.log";
-    maxLogFileSize = 1024 * 1024; // 默认1MB
+    logFilePath = "/logs/cybird_watching.clog";
+    maxLogFileSize = LOG_FILE_MAX_SIZE;
     currentLogLevel = LM_LOG_INFO;
     logOutputMode = OUTPUT_BOTH;
-    lastFlushTime = 0;
+
+    for (uint32_t i = 0; i < LOG_RING_RECORDS; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0);
+    dequeuePos.store(0);
+    ringRecords.store(0);
+    ringDropped.store(0);
+    ringPeakUsed.store(0);
+    droppedReported = 0;
+
+    fileMutex = xSemaphoreCreateMutex();
+    flushTask = nullptr;
+    logFileSize = 0;
+    block = nullptr;
+    blockUsed = 0;
+    lastTimestamp = 0;
+    bytesWritten = 0;
+    blockWrites = 0;
+    rotations = 0;
+
+    tagLimitCount = 0;
+    defaultRate = LOG_RATE_DEFAULT_PER_SEC;
+    defaultBurst = LOG_RATE_DEFAULT_BURST;
+    rateMutex = xSemaphoreCreateMutex();
 }
 
 LogManager* LogManager::getInstance() {
@@ -24,6 +74,7 @@ LogManager* LogManager::getInstance() {
 
 bool LogManager::initialize(LogLevel level, LogOutput output) {
     currentLogLevel = level;
+    runtimeLogLevel = level;
     logOutputMode = output;
 
     // 简化初始化：如果是只输出到串口，直接成功
@@ -55,66 +106,350 @@ bool LogManager::createLogDirectory() {
     return true;
 }
 
-void LogManager::checkLogRotation() {
-    if (!sdCardAvailable) return;
+bool LogManager::openLogFile() {
+    fs::FS& fs = HAL::SDInterface::getFS();
+    logFile = fs.open(logFilePath, FILE_APPEND);
+    if (!logFile) {
+        logFileSize = 0;
+        return false;
+    }
+
+    // 之后只在内存中累加，不再为判断轮转而打开文件
+    logFileSize = logFile.size();
+    resetEncoder(logFileSize == 0);
+    return true;
+}
+
+void LogManager::resetEncoder(bool newFile) {
+    uint8_t header[LogCodec::FILE_HEADER_SIZE + 1 + 2 * LogCodec::MAX_VARINT_SIZE];
+    size_t len = 0;
+    if (newFile) {
+        len += LogCodec::writeFileHeader(header);
+    }
+
+    // 已校时则记录墙上时间，主机端可据此换算绝对时间
+    time_t now = time(nullptr);
+    uint64_t epoch = now > 1600000000 ? (uint64_t)now : 0;
+    header[len++] = LogCodec::ENTRY_SYNC;
+    len += LogCodec::writeVarint(header + len, epoch);
+    len += LogCodec::writeVarint(header + len, (uint64_t)esp_timer_get_time());
+
+    internedTags.clear();
+    internedFormats.clear();
+    lastTimestamp = 0;
+    appendToBlock(header, len);
+}
+
+uint32_t LogManager::internTag(const char* tag) {
+    for (size_t i = 0; i < internedTags.size(); i++) {
+        if (internedTags[i].equals(tag)) {
+            return i;
+        }
+    }
+
+    uint32_t id = internedTags.size();
+    internedTags.push_back(String(tag));
+
+    uint8_t entry[1 + 2 * LogCodec::MAX_VARINT_SIZE];
+    size_t length = strlen(tag);
+    size_t len = 0;
+    entry[len++] = LogCodec::ENTRY_TAG;
+    len += LogCodec::writeVarint(entry + len, id);
+    len += LogCodec::writeVarint(entry + len, length);
+    appendToBlock(entry, len);
+    appendToBlock((const uint8_t*)tag, length);
+    return id;
+}
+
+uint32_t LogManager::internFormat(const char* format) {
+    // 格式串都是字符串常量，按指针比较即可；id 0保留给纯文本
+    for (size_t i = 0; i < internedFormats.size(); i++) {
+        if (internedFormats[i] == format) {
+            return i + 1;
+        }
+    }
+
+    uint32_t id = internedFormats.size() + 1;
+    internedFormats.push_back(format);
+
+    uint8_t entry[1 + 2 * LogCodec::MAX_VARINT_SIZE];
+    size_t length = strlen(format);
+    size_t len = 0;
+    entry[len++] = LogCodec::ENTRY_FORMAT;
+    len += LogCodec::writeVarint(entry + len, id);
+    len += LogCodec::writeVarint(entry + len, length);
+    appendToBlock(entry, len);
+    appendToBlock((const uint8_t*)format, length);
+    return id;
+}
+
+String LogManager::generationPath(int generation) const {
+    if (generation == 0) {
+        return logFilePath;
+    }
 
+    // cybird_watching.clog -> cybird_watching.N.clog
+    int dot = logFilePath.lastIndexOf('.');
+    if (dot <= logFilePath.lastIndexOf('/')) {
+        return logFilePath + "." + String(generation);
+    }
+    return logFilePath.substring(0, dot) + "." + String(generation) + logFilePath.substring(dot);
+}
+
+void LogManager::checkLogRotation(size_t incoming) {
+    if (!sdCardAvailable || !logFile) return;
+
+    // 只有文件头和同步条目时不轮转
+    unsigned long pending = logFileSize + blockUsed;
+    if (pending <= LogCodec::FILE_HEADER_SIZE + 1 + 2 * LogCodec::MAX_VARINT_SIZE ||
+        pending + incoming <= maxLogFileSize) {
+        return;
+    }
+
+    writeBlock();
+    unsigned long size = logFileSize;
+    logFile.close();
+
+    // 最旧的一代被删除，其余依次后移
     fs::FS& fs = HAL::SDInterface::getFS();
-    File logFile = fs.open(logFilePath, FILE_READ);
-    if (logFile) {
-        unsigned long size = logFile.size();
-        logFile.close();
+    String oldest = generationPath(LOG_ROTATE_GENERATIONS);
+    if (fs.exists(oldest)) {
+        fs.remove(oldest);
+    }
+    for (int generation = LOG_ROTATE_GENERATIONS - 1; generation >= 0; generation--) {
+        String from = generationPath(generation);
+        if (fs.exists(from)) {
+            fs.rename(from, generationPath(generation + 1));
+        }
+    }
 
-        // 如果文件超过最大大小，进行轮转
-        if (size > maxLogFileSize) {
-            // 删除旧的备份文件
-            if (fs.exists(logFilePath + ".old")) {
-                fs.remove(logFilePath + ".old");
-            }
+    openLogFile();
+    rotations++;
 
-            // 将当前日志重命名为备份
-            fs.rename(logFilePath, logFilePath + ".old");
+    if (logOutputMode == OUTPUT_SERIAL || logOutputMode == OUTPUT_BOTH) {
+        Serial.println("[LOG] Log rotated, old size: " + String(size) + " bytes");
+    }
+}
+
+void LogManager::writeToSDCard(LogLevel level, const char* tag, const char* format, const uint8_t* payload, size_t length) {
+    if (!sdCardAvailable) return;
+
+    const uint32_t mask = LOG_RING_RECORDS - 1;
+    uint8_t parts = length ? (length + RECORD_DATA_SIZE - 1) / RECORD_DATA_SIZE : 1;
+    if (parts > MAX_RECORD_PARTS) {
+        parts = MAX_RECORD_PARTS;
+        length = MAX_RECORD_PARTS * RECORD_DATA_SIZE;
+    }
 
-            if (logOutputMode == OUTPUT_SERIAL || logOutputMode == OUTPUT_BOTH) {
-                Serial.println("[LOG] Log rotated, old size: " + String(size) + " bytes");
+    // 占用连续parts个槽位：确认都可写后用CAS推进写入位置，不加锁
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        bool writable = true;
+        for (uint8_t i = 0; i < parts; i++) {
+            if (ring[(pos + i) & mask].sequence.load(std::memory_order_acquire) != pos + i) {
+                writable = false;
+                break;
             }
         }
+
+        if (!writable) {
+            // 写入位置已被其他任务推进时重试，否则缓冲区已满
+            uint32_t current = enqueuePos.load(std::memory_order_relaxed);
+            if (current != pos) {
+                pos = current;
+                continue;
+            }
+            ringDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (enqueuePos.compare_exchange_weak(pos, pos + parts, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    int64_t now = esp_timer_get_time();
+    for (uint8_t i = 0; i < parts; i++) {
+        LogRecord& record = ring[(pos + i) & mask];
+        size_t offset = (size_t)i * RECORD_DATA_SIZE;
+        size_t chunk = length - offset < RECORD_DATA_SIZE ? length - offset : RECORD_DATA_SIZE;
+        if (i == 0) {
+            record.timestamp = now;
+            record.format = format;
+            record.level = level;
+            record.parts = parts;
+            strncpy(record.tag, tag, RECORD_TAG_SIZE - 1);
+            record.tag[RECORD_TAG_SIZE - 1] = '\0';
+        }
+        memcpy(record.data, payload + offset, chunk);
+        record.length = chunk;
+        record.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    ringRecords.fetch_add(1, std::memory_order_relaxed);
+    uint32_t used = pos + parts - dequeuePos.load(std::memory_order_relaxed);
+    uint32_t peak = ringPeakUsed.load(std::memory_order_relaxed);
+    while (used > peak && !ringPeakUsed.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+
+    if (flushTask) {
+        // 缓冲区过半时提前唤醒刷新任务
+        if (used >= LOG_RING_RECORDS / 2) {
+            xTaskNotifyGive(flushTask);
+        }
+    } else if (xSemaphoreTake(fileMutex, 0) == pdTRUE) {
+        // 刷新任务未启动时在调用任务中写卡
+        drainRing();
+        xSemaphoreGive(fileMutex);
     }
 }
 
-String LogManager::getTimestamp() {
-    unsigned long currentTime = millis();
-    unsigned long seconds = currentTime / 1000;
-    unsigned long minutes = seconds / 60;
-    unsigned long hours = minutes / 60;
+void LogManager::drainRing() {
+    if (!block) return;
+
+    const uint32_t mask = LOG_RING_RECORDS - 1;
+    uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+    uint32_t writesBefore = blockWrites;
+
+    while (true) {
+        LogRecord& first = ring[pos & mask];
+        if (first.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break;
+        }
+
+        // 长日志的后续记录可能还在写入，下次再取
+        uint8_t parts = first.parts;
+        bool complete = true;
+        for (uint8_t i = 1; i < parts; i++) {
+            if (ring[(pos + i) & mask].sequence.load(std::memory_order_acquire) != pos + i + 1) {
+                complete = false;
+                break;
+            }
+        }
+        if (!complete) {
+            break;
+        }
+
+        size_t payloadLen = 0;
+        for (uint8_t i = 0; i < parts; i++) {
+            payloadLen += ring[(pos + i) & mask].length;
+        }
 
-    unsigned long millis_part = currentTime % 1000;
-    unsigned long seconds_part = seconds % 60;
-    unsigned long minutes_part = minutes % 60;
-    unsigned long hours_part = hours % 24;
+        // 按条目最大可能长度（含标签/格式定义）判断轮转，条目不会跨文件
+        size_t entryMax = 1 + 4 * LogCodec::MAX_VARINT_SIZE + payloadLen +
+                          2 * (1 + 2 * LogCodec::MAX_VARINT_SIZE) + RECORD_TAG_SIZE +
+                          (first.format ? strlen(first.format) : 0);
+        checkLogRotation(entryMax);
+
+        uint32_t tagId = internTag(first.tag);
+        uint32_t formatId = first.format ? internFormat(first.format) : 0;
+
+        uint8_t header[1 + 4 * LogCodec::MAX_VARINT_SIZE];
+        size_t headerLen = 0;
+        header[headerLen++] = LogCodec::ENTRY_RECORD | (first.level & 0x07);
+        headerLen += LogCodec::writeVarint(header + headerLen, LogCodec::zigzag(first.timestamp - lastTimestamp));
+        headerLen += LogCodec::writeVarint(header + headerLen, tagId);
+        headerLen += LogCodec::writeVarint(header + headerLen, formatId);
+        headerLen += LogCodec::writeVarint(header + headerLen, payloadLen);
+        lastTimestamp = first.timestamp;
+
+        appendToBlock(header, headerLen);
+        for (uint8_t i = 0; i < parts; i++) {
+            LogRecord& record = ring[(pos + i) & mask];
+            appendToBlock(record.data, record.length);
+            record.sequence.store(pos + i + LOG_RING_RECORDS, std::memory_order_release);
+        }
 
-    char timestamp[32];
-    sprintf(timestamp, "%02lu:%02lu:%02lu.%03lu",
-            hours_part, minutes_part, seconds_part, millis_part);
+        pos += parts;
+        dequeuePos.store(pos, std::memory_order_release);
+    }
 
-    return String(timestamp);
+    // 丢弃的日志在文件中留下记录
+    uint32_t dropped = ringDropped.load(std::memory_order_relaxed);
+    if (dropped != droppedReported) {
+        uint8_t entry[1 + LogCodec::MAX_VARINT_SIZE];
+        size_t len = 0;
+        entry[len++] = LogCodec::ENTRY_DROP;
+        len += LogCodec::writeVarint(entry + len, dropped - droppedReported);
+        appendToBlock(entry, len);
+        droppedReported = dropped;
+    }
+
+    writeBlock();
+    if (blockWrites != writesBefore && logFile) {
+        logFile.flush();
+    }
 }
 
-void LogManager::writeToSDCard(const String& levelStr, const String& tag, const String& message) {
-    if (!sdCardAvailable) return;
+void LogManager::appendToBlock(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        if (blockUsed == LOG_BLOCK_SIZE) {
+            writeBlock();
+        }
+        size_t chunk = LOG_BLOCK_SIZE - blockUsed < len ? LOG_BLOCK_SIZE - blockUsed : len;
+        memcpy(block + blockUsed, data, chunk);
+        blockUsed += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
 
-    checkLogRotation();
+void LogManager::writeBlock() {
+    if (blockUsed == 0) return;
 
-    fs::FS& fs = HAL::SDInterface::getFS();
-    File logFile = fs.open(logFilePath, FILE_APPEND);
     if (logFile) {
-        String logLine = "[" + getTimestamp() + "] [" + levelStr + "] [" + tag + "] " + message + "\n";
-        logFile.print(logLine);
-        logFile.close();
+        size_t written = logFile.write(block, blockUsed);
+        logFileSize += written;
+        bytesWritten += written;
+        blockWrites++;
+    }
+    blockUsed = 0;
+}
+
+bool LogManager::startFlushTask() {
+    if (flushTask) {
+        return true;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        flushTaskFunction,
+        "Log_Task",
+        LOG_TASK_STACK_SIZE,
+        this,
+        LOG_TASK_PRIORITY,
+        &flushTask,
+        LOG_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        flushTask = nullptr;
+        Serial.println("[LOG] Failed to create log flush task, writing logs synchronously");
+        return false;
+    }
+
+    esp_register_shutdown_handler(flushLogOnShutdown);
+    return true;
+}
+
+void LogManager::flushTaskFunction(void* parameter) {
+    LogManager* manager = static_cast<LogManager*>(parameter);
+
+    while (true) {
+        // 定期刷新，缓冲区过半时被提前唤醒
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_FLUSH_INTERVAL_MS));
+
+        // 洪泛停止后也要把积累的重复/限流汇总写出
+        manager->reportSuppressed();
+
+        xSemaphoreTake(manager->fileMutex, portMAX_DELAY);
+        manager->drainRing();
+        xSemaphoreGive(manager->fileMutex);
     }
 }
 
 void LogManager::setLogLevel(LogLevel level) {
     currentLogLevel = level;
+    runtimeLogLevel = level;
 }
 
 void LogManager::setLogOutput(LogOutput output) {
@@ -126,7 +461,20 @@ void LogManager::setLogOutput(LogOutput output) {
         // 使用新接口检查SD卡是否已挂载
         if (HAL::SDInterface::isMounted()) {
             sdCardAvailable = true;
-            if (createLogDirectory()) {
+            if (!block) {
+                block = new (std::nothrow) uint8_t[LOG_BLOCK_SIZE];
+            }
+            if (!block) {
+                sdCardAvailable = false;
+                Serial.println("[LOG] Out of memory for log buffer - logging to serial only");
+            } else if (createLogDirectory()) {
+                xSemaphoreTake(fileMutex, portMAX_DELAY);
+                bool opened = openLogFile();
+                xSemaphoreGive(fileMutex);
+                if (!opened) {
+                    Serial.println("[LOG] Cannot open log file: " + logFilePath);
+                }
+                startFlushTask();
                 Serial.println("[LOG] SD card is available for logging");
             } else {
                 sdCardAvailable = false;
@@ -150,36 +498,285 @@ void LogManager::setMaxLogFileSize(unsigned long size) {
     maxLogFileSize = size;
 }
 
-void LogManager::log(LogLevel level, const String& tag, const String& message) {
-    if (level > currentLogLevel) return;
+void LogManager::writeToSerial(LogLevel level, const char* tag, const char* message, size_t length) {
+    char line[LOG_FORMAT_BUFFER_SIZE + 48];
+    int prefix = snprintf(line, sizeof(line), "[%s] [%s] ", LogCodec::levelName(level), tag);
+    if (prefix < 0) return;
+    if ((size_t)prefix >= sizeof(line)) {
+        prefix = sizeof(line) - 1;
+    }
+
+    // 整行一次写入，避免多个任务的输出交错
+    if ((size_t)prefix + length + 2 <= sizeof(line)) {
+        memcpy(line + prefix, message, length);
+        line[prefix + length] = '\r';
+        line[prefix + length + 1] = '\n';
+        Serial.write((const uint8_t*)line, prefix + length + 2);
+    } else {
+        Serial.write((const uint8_t*)line, prefix);
+        Serial.write((const uint8_t*)message, length);
+        Serial.println();
+    }
+}
+
+LogManager::TagLimit* LogManager::findTagLimit(const char* tag, bool create) {
+    for (size_t i = 0; i < tagLimitCount; i++) {
+        if (strncasecmp(tagLimits[i].tag, tag, RECORD_TAG_SIZE - 1) == 0) {
+            return &tagLimits[i];
+        }
+    }
+    if (!create || tagLimitCount == LOG_RATE_MAX_TAGS) {
+        return nullptr;
+    }
+
+    TagLimit& limit = tagLimits[tagLimitCount++];
+    memset(&limit, 0, sizeof(limit));
+    for (size_t i = 0; i < RECORD_TAG_SIZE - 1 && tag[i]; i++) {
+        limit.tag[i] = toupper((unsigned char)tag[i]);
+    }
+    limit.rate = defaultRate;
+    limit.burst = defaultBurst;
+    limit.tokens = (uint32_t)defaultBurst * 1000;
+    limit.lastRefill = millis();
+    return &limit;
+}
+
+bool LogManager::admit(LogLevel level, const char* tag, uint32_t hash, bool toSerial) {
+    if (level == LM_LOG_FATAL || !rateMutex) return true;
+
+    // 不等待：另一个任务正在检查或汇总时直接放行这一条
+    if (xSemaphoreTake(rateMutex, 0) != pdTRUE) return true;
+    TagLimit* limit = findTagLimit(tag, true);
+    if (!limit) {
+        xSemaphoreGive(rateMutex);
+        return true;
+    }
+
+    uint32_t now = millis();
+
+    // 短时间内与上一条相同：只计数，不消耗令牌
+    if (hash == limit->lastHash && now - limit->lastSeen < LOG_REPEAT_WINDOW_MS) {
+        limit->lastSeen = now;
+        limit->repeats++;
+        limit->collapsed++;
+        limit->level = level;
+        xSemaphoreGive(rateMutex);
+        return false;
+    }
 
-    String levelStr;
-    switch (level) {
-        case LM_LOG_FATAL: levelStr = "FATAL"; break;
-        case LM_LOG_ERROR: levelStr = "ERROR"; break;
-        case LM_LOG_WARN:  levelStr = "WARN";  break;
-        case LM_LOG_INFO:  levelStr = "INFO";  break;
-        case LM_LOG_DEBUG: levelStr = "DEBUG"; break;
-        case LM_LOG_TRACE: levelStr = "TRACE"; break;
-        default: levelStr = "UNKNOWN"; break;
+    if (limit->rate > 0) {
+        uint32_t capacity = (uint32_t)limit->burst * 1000;
+        uint64_t tokens = limit->tokens + (uint64_t)(now - limit->lastRefill) * limit->rate;
+        limit->tokens = tokens > capacity ? capacity : (uint32_t)tokens;
+        limit->lastRefill = now;
+
+        if (limit->tokens < 1000) {
+            limit->pendingSuppressed++;
+            limit->suppressed++;
+            limit->level = level;
+            xSemaphoreGive(rateMutex);
+            return false;
+        }
+        limit->tokens -= 1000;
+    }
+
+    uint32_t repeats = limit->repeats;
+    uint32_t suppressed = limit->pendingSuppressed;
+    LogLevel summaryLevel = (LogLevel)limit->level;
+    limit->repeats = 0;
+    limit->pendingSuppressed = 0;
+    limit->lastHash = hash;
+    limit->lastSeen = now;
+    if (repeats || suppressed) {
+        limit->lastSummary = now;
+    }
+    xSemaphoreGive(rateMutex);
+
+    // 先汇总被合并/丢弃的日志，保持先后顺序
+    if (repeats || suppressed) {
+        emitSummary(summaryLevel, tag, repeats, suppressed, toSerial);
+    }
+    return true;
+}
+
+void LogManager::emitSummary(LogLevel level, const char* tag, uint32_t repeats, uint32_t suppressed, bool toSerial) {
+    char message[96];
+    int length;
+    if (repeats && suppressed) {
+        length = snprintf(message, sizeof(message), "Last message repeated %lu times, %lu messages suppressed (rate limit)",
+                          (unsigned long)repeats, (unsigned long)suppressed);
+    } else if (repeats) {
+        length = snprintf(message, sizeof(message), "Last message repeated %lu times", (unsigned long)repeats);
+    } else {
+        length = snprintf(message, sizeof(message), "%lu messages suppressed (rate limit)", (unsigned long)suppressed);
     }
+    if (length < 0) return;
+    if ((size_t)length >= sizeof(message)) {
+        length = sizeof(message) - 1;
+    }
+
+    emit(level, tag, message, length, toSerial);
+}
+
+bool LogManager::reportSuppressed(TickType_t wait) {
+    if (!rateMutex) return true;
 
+    // 逐个取出待汇总的标签，输出时不持有rateMutex
+    for (size_t i = 0; ; i++) {
+        if (xSemaphoreTake(rateMutex, wait) != pdTRUE) {
+            return false;
+        }
+        if (i >= tagLimitCount) {
+            xSemaphoreGive(rateMutex);
+            break;
+        }
+
+        TagLimit& limit = tagLimits[i];
+        uint32_t now = millis();
+        uint32_t repeats = 0;
+        uint32_t suppressed = 0;
+        char tag[RECORD_TAG_SIZE];
+        LogLevel level = (LogLevel)limit.level;
+        if ((limit.repeats || limit.pendingSuppressed) && now - limit.lastSummary >= LOG_REPEAT_WINDOW_MS) {
+            repeats = limit.repeats;
+            suppressed = limit.pendingSuppressed;
+            limit.repeats = 0;
+            limit.pendingSuppressed = 0;
+            limit.lastSummary = now;
+            memcpy(tag, limit.tag, sizeof(tag));
+        }
+        xSemaphoreGive(rateMutex);
+
+        if (repeats || suppressed) {
+            emitSummary(level, tag, repeats, suppressed, true);
+        }
+    }
+    return true;
+}
+
+bool LogManager::setTagRateLimit(const char* tag, uint16_t perSecond, uint16_t burst) {
+    if (!rateMutex) return false;
+
+    xSemaphoreTake(rateMutex, portMAX_DELAY);
+    TagLimit* limit = findTagLimit(tag, true);
+    if (limit) {
+        limit->rate = perSecond;
+        limit->burst = burst ? burst : (perSecond ? perSecond : 1);
+        limit->custom = true;
+        limit->tokens = (uint32_t)limit->burst * 1000;
+        limit->lastRefill = millis();
+    }
+    xSemaphoreGive(rateMutex);
+    return limit != nullptr;
+}
+
+void LogManager::setDefaultRateLimit(uint16_t perSecond, uint16_t burst) {
+    if (!rateMutex) return;
+
+    xSemaphoreTake(rateMutex, portMAX_DELAY);
+    defaultRate = perSecond;
+    defaultBurst = burst ? burst : (perSecond ? perSecond : 1);
+    for (size_t i = 0; i < tagLimitCount; i++) {
+        if (!tagLimits[i].custom) {
+            tagLimits[i].rate = defaultRate;
+            tagLimits[i].burst = defaultBurst;
+        }
+    }
+    xSemaphoreGive(rateMutex);
+}
+
+size_t LogManager::getTagRateStats(LogTagRateStats* out, size_t maxCount) {
+    if (!rateMutex) return 0;
+
+    xSemaphoreTake(rateMutex, portMAX_DELAY);
+    size_t count = tagLimitCount < maxCount ? tagLimitCount : maxCount;
+    for (size_t i = 0; i < count; i++) {
+        const TagLimit& limit = tagLimits[i];
+        memcpy(out[i].tag, limit.tag, sizeof(out[i].tag));
+        out[i].rate = limit.rate;
+        out[i].burst = limit.burst;
+        out[i].custom = limit.custom;
+        out[i].suppressed = limit.suppressed;
+        out[i].collapsed = limit.collapsed;
+    }
+    xSemaphoreGive(rateMutex);
+    return count;
+}
+
+void LogManager::write(LogLevel level, const char* tag, const char* message, size_t length, bool toSerial) {
+    if (level > currentLogLevel) return;
+
+    uint8_t levelByte = level;
+    uint32_t hash = hashBytes(hashBytes(HASH_SEED, &levelByte, 1), message, length);
+    if (!admit(level, tag, hash, toSerial)) return;
+
+    emit(level, tag, message, length, toSerial);
+}
+
+void LogManager::emit(LogLevel level, const char* tag, const char* message, size_t length, bool toSerial) {
     // 输出到串口
-    if (logOutputMode == OUTPUT_SERIAL || logOutputMode == OUTPUT_BOTH) {
-        String logLine = "[" + levelStr + "] [" + tag + "] " + message;
-        Serial.println(logLine);
+    if (toSerial && (logOutputMode == OUTPUT_SERIAL || logOutputMode == OUTPUT_BOTH)) {
+        writeToSerial(level, tag, message, length);
     }
 
-    // 输出到SD卡
+    // 输出到SD卡（只进入缓冲区，由后台任务写卡）
     if ((logOutputMode == OUTPUT_SD_CARD || logOutputMode == OUTPUT_BOTH)) {
-        writeToSDCard(levelStr, tag, message);
+        writeToSDCard(level, tag, nullptr, (const uint8_t*)message, length);
+    }
+}
+
+void LogManager::log(LogLevel level, const String& tag, const String& message) {
+    write(level, tag.c_str(), message.c_str(), message.length(), true);
+}
+
+void LogManager::log(LogLevel level, const char* tag, const char* message) {
+    write(level, tag, message, strlen(message), true);
+}
+
+void LogManager::logf(LogLevel level, const char* tag, const char* format, ...) {
+    if (level > currentLogLevel) return;
+
+    bool toSerial = logOutputMode == OUTPUT_SERIAL || logOutputMode == OUTPUT_BOTH;
+    bool toSD = sdCardAvailable && (logOutputMode == OUTPUT_SD_CARD || logOutputMode == OUTPUT_BOTH);
+
+    va_list args;
+    va_start(args, format);
+
+    // 串口仍然输出格式化后的文本
+    char message[LOG_FORMAT_BUFFER_SIZE];
+    int length = 0;
+    if (toSerial) {
+        va_list serialArgs;
+        va_copy(serialArgs, args);
+        length = vsnprintf(message, sizeof(message), format, serialArgs);
+        va_end(serialArgs);
+        if (length < 0) {
+            toSerial = false;
+            length = 0;
+        } else if ((size_t)length >= sizeof(message)) {
+            length = sizeof(message) - 1;
+        }
     }
 
-    // 定期刷新缓冲区
-    unsigned long currentTime = millis();
-    if (currentTime - lastFlushTime > FLUSH_INTERVAL) {
-        flush();
-        lastFlushTime = currentTime;
+    // SD卡只记录格式串id和二进制参数，由主机端或log命令解码
+    uint8_t payload[LOG_FORMAT_BUFFER_SIZE];
+    size_t payloadLength = 0;
+    if (toSD) {
+        payloadLength = LogCodec::encodeArgs(payload, sizeof(payload), format, args);
+    }
+    va_end(args);
+
+    // 同一格式串、相同参数视为重复
+    uint8_t levelByte = level;
+    uint32_t hash = hashBytes(hashBytes(HASH_SEED, &levelByte, 1), &format, sizeof(format));
+    hash = toSD ? hashBytes(hash, payload, payloadLength) : hashBytes(hash, message, length);
+    if (!admit(level, tag, hash, toSerial)) return;
+
+    if (toSerial) {
+        writeToSerial(level, tag, message, length);
+    }
+    if (toSD) {
+        writeToSDCard(level, tag, format, payload, payloadLength);
     }
 }
 
@@ -204,45 +801,67 @@ void LogManager::fatal(const String& tag, const String& message) {
 }
 
 void LogManager::logToSDOnly(LogLevel level, const String& tag, const String& message) {
-    if (level > currentLogLevel) return;
-
     // Only output to SD card, not to serial port
-    if (logOutputMode == OUTPUT_SD_CARD || logOutputMode == OUTPUT_BOTH) {
-        String levelStr;
-        switch (level) {
-            case LM_LOG_FATAL: levelStr = "FATAL"; break;
-            case LM_LOG_ERROR: levelStr = "ERROR"; break;
-            case LM_LOG_WARN:  levelStr = "WARN";  break;
-            case LM_LOG_INFO:  levelStr = "INFO";  break;
-            case LM_LOG_DEBUG: levelStr = "DEBUG"; break;
-            case LM_LOG_TRACE: levelStr = "TRACE"; break;
-            default: levelStr = "UNKNOWN"; break;
-        }
+    write(level, tag.c_str(), message.c_str(), message.length(), false);
+}
 
-        writeToSDCard(levelStr, tag, message);
+void LogManager::flush() {
+    flush(portMAX_DELAY);
+}
 
-        // Update flush timer
-        unsigned long currentTime = millis();
-        if (currentTime - lastFlushTime > FLUSH_INTERVAL) {
-            flush();
-            lastFlushTime = currentTime;
-        }
+bool LogManager::flush(TickType_t wait) {
+    // 先输出积累的重复/限流汇总
+    bool complete = reportSuppressed(wait);
+    if (!complete) {
+        Serial.println("[LOG] Log summaries skipped: rate limiter busy");
     }
-}
 
-void LogManager::flush() {
     // 刷新串口缓冲区
     Serial.flush();
 
-    // SD卡文件操作已经自动刷新，不需要额外处理
+    // 把缓冲区中的日志立即写卡
+    if (sdCardAvailable && fileMutex) {
+        if (xSemaphoreTake(fileMutex, wait) != pdTRUE) {
+            Serial.println("[LOG] Log flush skipped: log file busy");
+            Serial.flush();
+            return false;
+        }
+        drainRing();
+        xSemaphoreGive(fileMutex);
+    }
+    return complete;
+}
+
+LogRingStats LogManager::getRingStats() const {
+    LogRingStats stats;
+    stats.records = ringRecords.load(std::memory_order_relaxed);
+    stats.dropped = ringDropped.load(std::memory_order_relaxed);
+    stats.peak_used = ringPeakUsed.load(std::memory_order_relaxed);
+    stats.bytes_written = bytesWritten;
+    stats.block_writes = blockWrites;
+    stats.rotations = rotations;
+    return stats;
 }
 
 void LogManager::clearLogFile() {
-    if (sdCardAvailable && HAL::SDInterface::exists(logFilePath.c_str())) {
-        fs::FS& fs = HAL::SDInterface::getFS();
-        fs.remove(logFilePath);
-        info("LOG", "Log file cleared");
+    if (!sdCardAvailable) return;
+
+    // 先写出缓冲区中较早的日志，再关闭常开的文件后删除
+    xSemaphoreTake(fileMutex, portMAX_DELAY);
+    drainRing();
+    writeBlock();
+    logFile.close();
+    fs::FS& fs = HAL::SDInterface::getFS();
+    for (int generation = 0; generation <= LOG_ROTATE_GENERATIONS; generation++) {
+        String path = generationPath(generation);
+        if (fs.exists(path)) {
+            fs.remove(path);
+        }
     }
+    openLogFile();
+    xSemaphoreGive(fileMutex);
+
+    info("LOG", "Log file cleared");
 }
 
 String LogManager::getLogContent(int maxLines) {
@@ -252,6 +871,9 @@ String LogManager::getLogContent(int maxLines) {
         return content;
     }
 
+    // 先把缓冲区中的日志写卡
+    flush();
+
     // 限制最大行数以避免内存问题和看门狗超时
     const int safeMaxLines = min(maxLines, 100);
 
@@ -262,92 +884,100 @@ String LogManager::getLogContent(int maxLines) {
         return content;
     }
 
-    unsigned long fileSize = logFile.size();
-    if (fileSize == 0) {
+    LogReader reader(logFile);
+    if (!reader.isValid()) {
         logFile.close();
-        content = "Log file is empty\n";
+        content = "Log file is empty or unreadable\n";
         return content;
     }
 
-    // 策略：从文件末尾开始，向前读取足够的数据以获取最后N行
-    // 估算：每行平均100字节，读取 safeMaxLines * 150 字节应该足够
-    const size_t readSize = min((size_t)(safeMaxLines * 150), (size_t)fileSize);
-    const size_t readPos = (fileSize > readSize) ? (fileSize - readSize) : 0;
-
-    // 移动到读取位置
-    logFile.seek(readPos);
-
-    // 如果不是从文件开头读取，跳过第一个不完整的行
-    if (readPos > 0) {
-        logFile.readStringUntil('\n'); // 丢弃第一个可能不完整的行
-    }
-
-    // 使用动态分配的vector
-    std::vector<String> lineBuffer;
-    lineBuffer.reserve(safeMaxLines);
-    
+    // 二进制日志无法从末尾定位行，顺序解码并在环形缓冲区中保留最后N行
+    std::vector<String> lineBuffer(safeMaxLines);
     int totalLines = 0;
-    int linesProcessed = 0;
-    
-    // 读取剩余行
-    while (logFile.available() && totalLines < safeMaxLines * 2) { // 读取最多2倍行数以确保足够
-        String line = logFile.readStringUntil('\n');
-        if (line.length() > 0) {
-            // 限制行长度避免内存问题
-            if (line.length() > 256) {
-                line = line.substring(0, 256) + "...";
-            }
-
-            // 使用环形缓冲区逻辑
-            if (lineBuffer.size() < safeMaxLines) {
-                lineBuffer.push_back(line);
-            } else {
-                // 移除最旧的行，添加新行
-                lineBuffer.erase(lineBuffer.begin());
-                lineBuffer.push_back(line);
-            }
-            totalLines++;
+    String line;
+    while (reader.next(line)) {
+        // 限制行长度避免内存问题
+        if (line.length() > 256) {
+            line = line.substring(0, 256) + "...";
         }
-        
+        lineBuffer[totalLines % safeMaxLines] = line;
+        totalLines++;
+
         // 每处理5行，让出CPU并喂狗
-        linesProcessed++;
-        if (linesProcessed % 5 == 0) {
+        if (totalLines % 5 == 0) {
             yield();
         }
     }
     logFile.close();
 
-    // 构建结果
-    int linesToShow = lineBuffer.size();
-    content = "=== Last " + String(linesToShow) + " lines ===\n";
-
-    for (int i = 0; i < linesToShow; i++) {
-        if (lineBuffer[i].length() > 0) {
-            content += lineBuffer[i] + "\n";
-        }
+    if (totalLines == 0) {
+        content = "Log file is empty\n";
+        return content;
     }
 
-    if (content.length() == 0) {
-        content = "Log file is empty or unreadable\n";
+    // 构建结果
+    int linesToShow = min(totalLines, safeMaxLines);
+    content = "=== Last " + String(linesToShow) + " lines ===\n";
+    for (int i = totalLines - linesToShow; i < totalLines; i++) {
+        content += lineBuffer[i % safeMaxLines] + "\n";
     }
 
     return content;
 }
 
-unsigned long LogManager::getLogFileSize() {
-    if (!sdCardAvailable || !HAL::SDInterface::exists(logFilePath.c_str())) {
+int LogManager::printLog(Print& out, int maxLines) {
+    if (!sdCardAvailable) {
+        out.println("SD card is not available!");
+        return 0;
+    }
+
+    // 先把缓冲区中的日志写卡，再顺序解码
+    flush();
+    if (!HAL::SDInterface::exists(logFilePath.c_str())) {
+        out.println("No log file found");
         return 0;
     }
 
     fs::FS& fs = HAL::SDInterface::getFS();
     File logFile = fs.open(logFilePath, FILE_READ);
-    if (logFile) {
-        unsigned long size = logFile.size();
+    if (!logFile) {
+        out.println("Failed to open log file");
+        return 0;
+    }
+
+    LogReader reader(logFile);
+    if (!reader.isValid()) {
         logFile.close();
-        return size;
+        out.println("Log file is not in .clog format");
+        return 0;
     }
 
-    return 0;
+    int linesRead = 0;
+    String line;
+    while (linesRead < maxLines && reader.next(line)) {
+        // 限制行长度避免输出过长
+        if (line.length() > 512) {
+            line = line.substring(0, 512) + "...(truncated)";
+        }
+        out.println(line);
+        linesRead++;
+    }
+    logFile.close();
+
+    return linesRead;
+}
+
+unsigned long LogManager::getLogFileSize() {
+    if (!sdCardAvailable) {
+        return 0;
+    }
+
+    // 内存中维护的大小，缓冲区写卡后即为文件实际大小
+    flush();
+    xSemaphoreTake(fileMutex, portMAX_DELAY);
+    unsigned long size = logFileSize;
+    xSemaphoreGive(fileMutex);
+    return size;
 }
 
 bool LogManager::isSDCardAvailable() const {
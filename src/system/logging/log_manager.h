@@ -3,6 +3,92 @@
 #include <Arduino.h>
 #include <FS.h>
 #include <SD.h>
+#include <atomic>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+// 编译期日志级别（数值同LogManager::LogLevel，5为DEBUG）
+// 低于该级别的LOG_*调用连同参数表达式在编译时被去掉，发布版可设为4（INFO）
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 5
+#endif
+
+// LOG_*F格式化/参数编码用的栈缓冲区大小，超出部分截断
+#ifndef LOG_FORMAT_BUFFER_SIZE
+#define LOG_FORMAT_BUFFER_SIZE 256
+#endif
+
+// 日志环形缓冲区记录数（必须是2的幂），每条记录128字节
+#ifndef LOG_RING_RECORDS
+#define LOG_RING_RECORDS 64
+#endif
+
+// 后台任务攒满这么多字节再写一次卡
+#ifndef LOG_BLOCK_SIZE
+#define LOG_BLOCK_SIZE 4096
+#endif
+
+// 保留的日志轮转代数（cybird_watching.1.clog ~ .N.clog）
+#ifndef LOG_ROTATE_GENERATIONS
+#define LOG_ROTATE_GENERATIONS 8
+#endif
+
+// 单个日志文件的最大大小（字节）
+#ifndef LOG_FILE_MAX_SIZE
+#define LOG_FILE_MAX_SIZE (256 * 1024)
+#endif
+
+// 后台任务最长刷新间隔（毫秒）
+#ifndef LOG_FLUSH_INTERVAL_MS
+#define LOG_FLUSH_INTERVAL_MS 1000
+#endif
+
+// 每个标签默认每秒允许的日志条数（令牌桶速率，0为不限流）
+#ifndef LOG_RATE_DEFAULT_PER_SEC
+#define LOG_RATE_DEFAULT_PER_SEC 20
+#endif
+
+// 每个标签默认允许的突发条数（令牌桶容量）
+#ifndef LOG_RATE_DEFAULT_BURST
+#define LOG_RATE_DEFAULT_BURST 50
+#endif
+
+// 相同内容的日志在该时间内再次出现时合并计数（毫秒）
+#ifndef LOG_REPEAT_WINDOW_MS
+#define LOG_REPEAT_WINDOW_MS 5000
+#endif
+
+// 参与限流的标签数，超出的标签不限流
+#ifndef LOG_RATE_MAX_TAGS
+#define LOG_RATE_MAX_TAGS 32
+#endif
+
+// esp_restart()关机时刷新日志，等待每把锁的最长时间（毫秒）
+#ifndef LOG_SHUTDOWN_WAIT_MS
+#define LOG_SHUTDOWN_WAIT_MS 500
+#endif
+
+// 日志缓冲统计
+struct LogRingStats {
+    uint32_t records;           // 进入缓冲区的日志条数
+    uint32_t dropped;           // 缓冲区满被丢弃的日志条数
+    uint32_t peak_used;         // 缓冲区最高占用记录数
+    uint32_t bytes_written;     // 写入SD卡的字节数
+    uint32_t block_writes;      // 写卡次数
+    uint32_t rotations;         // 日志轮转次数
+};
+
+// 单个标签的限流状态（用于log rate命令）
+struct LogTagRateStats {
+    char tag[12];
+    uint16_t rate;              // 每秒条数，0为不限流
+    uint16_t burst;             // 突发条数
+    bool custom;                // 是否通过log rate单独设置
+    uint32_t suppressed;        // 超出速率被丢弃的条数
+    uint32_t collapsed;         // 与上一条相同被合并的条数
+};
 
 class LogManager {
 public:
@@ -24,13 +110,92 @@ public:
 
 private:
     static LogManager* instance;
+    static int runtimeLogLevel;        // currentLogLevel的静态副本，宏在取实例、构造参数前检查
     bool sdCardAvailable;
     String logFilePath;
     unsigned long maxLogFileSize;
     int currentLogLevel;
     LogOutput logOutputMode;
-    unsigned long lastFlushTime;
-    const unsigned long FLUSH_INTERVAL = 5000; // 5秒刷新一次
+
+    static constexpr size_t RECORD_TAG_SIZE = 12;
+    static constexpr size_t RECORD_DATA_SIZE = 96;
+    static constexpr uint8_t MAX_RECORD_PARTS = 8;   // 一条日志最多占用的记录数，超出部分截断
+
+    static_assert((LOG_RING_RECORDS & (LOG_RING_RECORDS - 1)) == 0, "LOG_RING_RECORDS must be a power of 2");
+
+    /**
+     * 环形缓冲区记录（ESP32上128字节）
+     *
+     * format为nullptr时负载是消息文本，否则是按format编码的参数（见LogCodec）。
+     * 长负载占用连续多条记录，首条记录的parts为总条数，后续记录只携带负载。
+     * sequence为槽位序号：等于写入位置时可写，等于写入位置+1时可读。
+     */
+    struct LogRecord {
+        std::atomic<uint32_t> sequence;
+        uint8_t level;
+        uint8_t parts;
+        uint8_t length;
+        uint8_t reserved;
+        int64_t timestamp;              // esp_timer微秒
+        const char* format;             // LOG_*F的格式串常量
+        char tag[RECORD_TAG_SIZE];
+        uint8_t data[RECORD_DATA_SIZE];
+    };
+    static_assert(sizeof(void*) != 4 || sizeof(LogRecord) == 128, "LogRecord must stay 128 bytes");
+
+    // 多生产者单消费者环形缓冲区：LOG_*在调用任务中只拷贝/编码进记录，写卡由后台任务完成
+    LogRecord ring[LOG_RING_RECORDS];
+    std::atomic<uint32_t> enqueuePos;
+    std::atomic<uint32_t> dequeuePos;
+    std::atomic<uint32_t> ringRecords;
+    std::atomic<uint32_t> ringDropped;
+    std::atomic<uint32_t> ringPeakUsed;
+    uint32_t droppedReported;           // 已写入日志文件的丢弃计数
+
+    /**
+     * 每个标签的令牌桶和重复合并状态
+     *
+     * 令牌以千分之一条为单位按经过的毫秒补充，每条日志消耗1000；
+     * 与上一条内容相同的日志只计数，之后以"Last message repeated N times"汇总。
+     */
+    struct TagLimit {
+        char tag[RECORD_TAG_SIZE];
+        uint16_t rate;
+        uint16_t burst;
+        bool custom;
+        uint8_t level;                  // 最近一条被抑制日志的级别，汇总时沿用
+        uint32_t tokens;                // 千分之一条
+        uint32_t lastRefill;
+        uint32_t lastHash;              // 上一条放行日志的内容哈希
+        uint32_t lastSeen;              // 上一条相同日志出现的时间
+        uint32_t lastSummary;           // 上次输出汇总的时间
+        uint32_t repeats;               // 待汇总的重复条数
+        uint32_t pendingSuppressed;     // 待汇总的限流丢弃条数
+        uint32_t suppressed;
+        uint32_t collapsed;
+    };
+    TagLimit tagLimits[LOG_RATE_MAX_TAGS];
+    size_t tagLimitCount;
+    uint16_t defaultRate;
+    uint16_t defaultBurst;
+    SemaphoreHandle_t rateMutex;        // admit()只尝试获取，不等待
+
+    // 以下由fileMutex保护（后台任务和flush()/clearLogFile()都可能写卡）
+    SemaphoreHandle_t fileMutex;
+    TaskHandle_t flushTask;
+    File logFile;                       // 常开的日志文件
+    unsigned long logFileSize;          // 内存中维护的文件大小，用于轮转判断
+    uint8_t* block;                     // 待写入的数据块
+    size_t blockUsed;
+
+    // 当前文件的编码状态：标签和格式串在首次使用时定义，时间戳按增量编码
+    std::vector<String> internedTags;
+    std::vector<const char*> internedFormats;
+    int64_t lastTimestamp;
+
+    uint32_t bytesWritten;
+    uint32_t blockWrites;
+    uint32_t rotations;
 
     // 私有构造函数，单例模式
     LogManager();
@@ -38,14 +203,74 @@ private:
     // 创建日志文件目录
     bool createLogDirectory();
 
-    // 检查并执行日志轮转
-    void checkLogRotation();
+    // 写入的数据将超过最大大小时轮转日志（调用者持有fileMutex）
+    void checkLogRotation(size_t incoming);
 
-    // 获取格式化的时间戳字符串
-    String getTimestamp();
+    // 第generation代日志文件路径，0为当前文件
+    String generationPath(int generation) const;
 
-    // 写入日志到SD卡
-    void writeToSDCard(const String& levelStr, const String& tag, const String& message);
+    /**
+     * 把日志放入环形缓冲区，缓冲区满时丢弃并计数
+     *
+     * @param format 为nullptr时payload是消息文本，否则是按format编码的参数
+     */
+    void writeToSDCard(LogLevel level, const char* tag, const char* format, const uint8_t* payload, size_t length);
+
+    // 在栈缓冲区拼好整行后一次写入串口
+    void writeToSerial(LogLevel level, const char* tag, const char* message, size_t length);
+
+    // 检查级别和限流后分发一条日志
+    void write(LogLevel level, const char* tag, const char* message, size_t length, bool toSerial);
+
+    // 按输出模式分发一条日志
+    void emit(LogLevel level, const char* tag, const char* message, size_t length, bool toSerial);
+
+    // 查找标签的限流状态，首次出现时分配（调用者持有rateMutex，表满时返回nullptr）
+    TagLimit* findTagLimit(const char* tag, bool create);
+
+    /**
+     * 重复合并和令牌桶检查，FATAL不受限制
+     *
+     * 每条LOG都经过这里，因此取rateMutex时不等待：限流表正被其他任务使用时直接放行，
+     * 不计入令牌桶和重复合并。持锁区间只有几次字段更新，争用很少，代价是争用时
+     * 偶尔多放行一条；换来的是LOG调用不会被低优先级的持锁任务挡住（优先级反转）。
+     * 令牌、重复计数和汇总状态需要一起更新，没有改为逐字段的原子操作。
+     *
+     * @param hash 消息内容哈希
+     * @return 放行返回true；放行前先输出该标签积累的汇总
+     */
+    bool admit(LogLevel level, const char* tag, uint32_t hash, bool toSerial);
+
+    // 输出一个标签积累的重复/限流汇总
+    void emitSummary(LogLevel level, const char* tag, uint32_t repeats, uint32_t suppressed, bool toSerial);
+
+    // 打开常驻日志文件并读取当前大小，写入文件头/同步条目（调用者持有fileMutex）
+    bool openLogFile();
+
+    // 清空标签/格式表并写入同步条目，新文件先写文件头
+    void resetEncoder(bool newFile);
+
+    // 返回标签/格式串在当前文件中的id，首次使用时写入定义
+    uint32_t internTag(const char* tag);
+    uint32_t internFormat(const char* format);
+
+    // 启动后台刷新任务
+    bool startFlushTask();
+
+    static void flushTaskFunction(void* parameter);
+
+    /**
+     * 取出缓冲区中所有完整的日志，按块写入文件
+     *
+     * 同一时刻只有一个消费者：调用者必须持有fileMutex
+     */
+    void drainRing();
+
+    // 把数据追加到写入块，块满时写卡
+    void appendToBlock(const uint8_t* data, size_t len);
+
+    // 把写入块写到文件（调用者持有fileMutex）
+    void writeBlock();
 
 public:
     // 获取单例实例
@@ -69,8 +294,24 @@ public:
     // 设置最大日志文件大小（字节）
     void setMaxLogFileSize(unsigned long size);
 
+    /**
+     * 当前运行时级别是否输出该级别的日志
+     *
+     * LOG_*宏先用它判断，关闭的日志不会构造String参数
+     */
+    static bool isLevelEnabled(LogLevel level) { return level <= runtimeLogLevel; }
+
     // 日志记录方法
     void log(LogLevel level, const String& tag, const String& message);
+    void log(LogLevel level, const char* tag, const char* message);
+
+    /**
+     * printf风格日志，不分配堆内存
+     *
+     * 串口输出格式化后的文本；SD卡只记录格式串id和二进制参数（见LogCodec）。
+     * format必须是字符串常量，写卡时按指针去重。
+     */
+    void logf(LogLevel level, const char* tag, const char* format, ...) __attribute__((format(printf, 4, 5)));
     void debug(const String& tag, const String& message);
     void info(const String& tag, const String& message);
     void warn(const String& tag, const String& message);
@@ -80,16 +321,56 @@ public:
     // 仅记录到SD卡，不输出到串口（用于避免干扰命令响应）
     void logToSDOnly(LogLevel level, const String& tag, const String& message);
 
-    // 刷新缓冲区
+    // 刷新缓冲区：把环形缓冲区中的日志立即写卡
     void flush();
 
+    /**
+     * 限时刷新缓冲区
+     *
+     * @param wait 等待限流表锁和文件锁各自的最长时间；超时则跳过该步骤并在串口警告
+     *             （关机时使用，持锁的任务可能已无法运行）
+     * @return 汇总和写卡都完成返回true
+     */
+    bool flush(TickType_t wait);
+
+    // 获取日志缓冲统计
+    LogRingStats getRingStats() const;
+
+    /**
+     * 设置单个标签的限流（标签不区分大小写）
+     *
+     * @param perSecond 每秒条数，0为不限流
+     * @param burst 突发条数，0时取perSecond
+     * @return 标签表已满时返回false
+     */
+    bool setTagRateLimit(const char* tag, uint16_t perSecond, uint16_t burst);
+
+    // 设置未单独配置的标签使用的默认限流
+    void setDefaultRateLimit(uint16_t perSecond, uint16_t burst);
+    uint16_t getDefaultRate() const { return defaultRate; }
+    uint16_t getDefaultBurst() const { return defaultBurst; }
+
+    // 获取各标签的限流统计，返回条数
+    size_t getTagRateStats(LogTagRateStats* out, size_t maxCount);
+
+    // 输出所有标签积累的重复/限流汇总（刷新任务定期调用），等不到限流表锁时返回false
+    bool reportSuppressed(TickType_t wait = portMAX_DELAY);
+
     // 清空日志文件
     void clearLogFile();
 
-    // 获取日志文件内容（用于串口命令）
+    // 获取日志文件内容（用于串口命令，解码当前日志文件的最后maxLines行）
     String getLogContent(int maxLines = 100);
 
-    // 获取日志文件大小
+    /**
+     * 从头解码当前日志文件并逐行输出（用于log cat）
+     *
+     * @param maxLines 最多输出的行数
+     * @return 输出的行数
+     */
+    int printLog(Print& out, int maxLines);
+
+    // 获取当前日志文件大小
     unsigned long getLogFileSize();
 
     // 检查SD卡是否可用
@@ -103,8 +384,30 @@ public:
 };
 
 // 全局日志宏定义，方便使用
-#define LOG_DEBUG(tag, msg) LogManager::getInstance()->debug(tag, msg)
-#define LOG_INFO(tag, msg) LogManager::getInstance()->info(tag, msg)
-#define LOG_WARN(tag, msg) LogManager::getInstance()->warn(tag, msg)
-#define LOG_ERROR(tag, msg) LogManager::getInstance()->error(tag, msg)
-#define LOG_FATAL(tag, msg) LogManager::getInstance()->fatal(tag, msg)
\ No newline at end of file
+// 先检查编译期和运行时级别，关闭的日志只有一次比较，不会求值msg
+#define LOG_AT(level, tag, msg) \
+    do { \
+        if ((level) <= LOG_COMPILE_LEVEL && LogManager::isLevelEnabled(level)) { \
+            LogManager::getInstance()->log(level, tag, msg); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(tag, msg) LOG_AT(LogManager::LM_LOG_DEBUG, tag, msg)
+#define LOG_INFO(tag, msg) LOG_AT(LogManager::LM_LOG_INFO, tag, msg)
+#define LOG_WARN(tag, msg) LOG_AT(LogManager::LM_LOG_WARN, tag, msg)
+#define LOG_ERROR(tag, msg) LOG_AT(LogManager::LM_LOG_ERROR, tag, msg)
+#define LOG_FATAL(tag, msg) LOG_AT(LogManager::LM_LOG_FATAL, tag, msg)
+
+// printf风格：LOG_INFOF("BIRD", "Playing bird %d", id)，格式串须为字符串常量
+#define LOG_ATF(level, tag, ...) \
+    do { \
+        if ((level) <= LOG_COMPILE_LEVEL && LogManager::isLevelEnabled(level)) { \
+            LogManager::getInstance()->logf(level, tag, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUGF(tag, ...) LOG_ATF(LogManager::LM_LOG_DEBUG, tag, __VA_ARGS__)
+#define LOG_INFOF(tag, ...) LOG_ATF(LogManager::LM_LOG_INFO, tag, __VA_ARGS__)
+#define LOG_WARNF(tag, ...) LOG_ATF(LogManager::LM_LOG_WARN, tag, __VA_ARGS__)
+#define LOG_ERRORF(tag, ...) LOG_ATF(LogManager::LM_LOG_ERROR, tag, __VA_ARGS__)
+#define LOG_FATALF(tag, ...) LOG_ATF(LogManager::LM_LOG_FATAL, tag, __VA_ARGS__)
@@ -0,0 +1,186 @@
+#include "trace_buffer.h"
+#include <esp_timer.h>
+#include <cstring>
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+static_assert(sizeof(TraceRecord) == 8, "TraceRecord must stay 8 bytes");
+
+TraceBuffer::Ring TraceBuffer::rings_[portNUM_PROCESSORS];
+TraceBuffer::TaskEntry TraceBuffer::tasks_[TRACE_MAX_TASKS];
+std::atomic<uint8_t> TraceBuffer::task_count_(0);
+std::atomic<bool> TraceBuffer::enabled_(true);
+portMUX_TYPE TraceBuffer::task_lock_ = portMUX_INITIALIZER_UNLOCKED;
+
+// 按TraceEvent的顺序排列（下标为事件ID）
+static const TraceEventInfo EVENT_INFO[] = {
+    {nullptr, 0, nullptr},
+    {"ui_cycle", 'B', "notified"},
+    {"ui_cycle", 'E', nullptr},
+    {"lvgl_lock_wait", 'B', nullptr},
+    {"lvgl_lock_wait", 'E', "timeout"},
+    {"lvgl_lock_hold", 'B', nullptr},
+    {"lvgl_lock_hold", 'E', nullptr},
+    {"frame_load", 'B', "frame"},
+    {"frame_load", 'E', "frame"},
+    {"flush", 'B', "lines"},
+    {"flush", 'E', nullptr},
+    {"sd_open", 'B', nullptr},
+    {"sd_open", 'E', nullptr},
+    {"sd_read", 'B', "bytes"},
+    {"sd_read", 'E', nullptr},
+    {"imu_sample", 'B', nullptr},
+    {"imu_sample", 'E', nullptr},
+    {"frame_show", 'i', "frame"},
+    {"frame_skip", 'i', "skipped"},
+    {"frame_underrun", 'i', nullptr},
+};
+static_assert(sizeof(EVENT_INFO) / sizeof(EVENT_INFO[0]) == TRACE_EVENT_COUNT,
+              "EVENT_INFO must list every TraceEvent");
+
+namespace {
+
+// 把导出数据攒成DUMP_CHUNK_SIZE的块交给回调
+struct DumpWriter {
+    void (*sink)(const uint8_t*, size_t, void*);
+    void* context;
+    uint8_t buffer[TraceBuffer::DUMP_CHUNK_SIZE];
+    size_t used;
+    size_t total;
+
+    void write(const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (length > 0) {
+            size_t n = sizeof(buffer) - used;
+            if (n > length) {
+                n = length;
+            }
+            memcpy(buffer + used, bytes, n);
+            used += n;
+            bytes += n;
+            length -= n;
+            total += n;
+            if (used == sizeof(buffer)) {
+                flush();
+            }
+        }
+    }
+
+    void flush() {
+        if (used > 0) {
+            sink(buffer, used, context);
+            used = 0;
+        }
+    }
+};
+
+} // namespace
+
+uint8_t TraceBuffer::taskId(TaskHandle_t handle) {
+    uint8_t count = task_count_.load(std::memory_order_acquire);
+    for (uint8_t i = 0; i < count; i++) {
+        if (tasks_[i].handle == handle) {
+            return i;
+        }
+    }
+
+    // 首次出现的任务：登记名称（最后一个槽留给超出数量的任务）
+    uint8_t id = TRACE_MAX_TASKS - 1;
+    portENTER_CRITICAL(&task_lock_);
+    count = task_count_.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; i < count; i++) {
+        if (tasks_[i].handle == handle) {
+            id = i;
+            break;
+        }
+    }
+    if (id == TRACE_MAX_TASKS - 1 && count < TRACE_MAX_TASKS - 1) {
+        id = count;
+        tasks_[id].handle = handle;
+        strncpy(tasks_[id].name, pcTaskGetName(handle), TASK_NAME_SIZE - 1);
+        tasks_[id].name[TASK_NAME_SIZE - 1] = '\0';
+        task_count_.store(count + 1, std::memory_order_release);
+    }
+    portEXIT_CRITICAL(&task_lock_);
+    return id;
+}
+
+void TraceBuffer::record(TraceEvent event, uint16_t arg) {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    Ring& ring = rings_[xPortGetCoreID()];
+    uint32_t index = ring.head.fetch_add(1, std::memory_order_relaxed) & (TRACE_RING_SIZE - 1);
+    TraceRecord& rec = ring.records[index];
+    rec.timestamp_us = (uint32_t)esp_timer_get_time();
+    rec.event = event;
+    rec.task = taskId(xTaskGetCurrentTaskHandle());
+    rec.arg = arg;
+}
+
+void TraceBuffer::clear() {
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        rings_[core].head.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t TraceBuffer::getWritten(int core) {
+    if (core < 0 || core >= portNUM_PROCESSORS) {
+        return 0;
+    }
+    return rings_[core].head.load(std::memory_order_relaxed);
+}
+
+const TraceEventInfo* TraceBuffer::eventInfo(uint8_t event) {
+    return event > 0 && event < TRACE_EVENT_COUNT ? &EVENT_INFO[event] : nullptr;
+}
+
+size_t TraceBuffer::dump(void (*sink)(const uint8_t* data, size_t length, void* context), void* context) {
+    // 暂停记录，等另一核上正在写的记录完成
+    bool was_enabled = enabled_.exchange(false);
+    vTaskDelay(1);
+
+    DumpWriter writer;
+    writer.sink = sink;
+    writer.context = context;
+    writer.used = 0;
+    writer.total = 0;
+
+    uint32_t magic = DUMP_MAGIC;
+    uint16_t version = DUMP_VERSION;
+    uint16_t cores = portNUM_PROCESSORS;
+    uint64_t now = (uint64_t)esp_timer_get_time();
+    writer.write(&magic, sizeof(magic));
+    writer.write(&version, sizeof(version));
+    writer.write(&cores, sizeof(cores));
+    writer.write(&now, sizeof(now));
+
+    // 任务表；超出数量的任务共用最后一个编号
+    uint8_t task_count = task_count_.load(std::memory_order_acquire);
+    bool has_other = task_count == TRACE_MAX_TASKS - 1;
+    uint8_t listed = task_count + (has_other ? 1 : 0);
+    writer.write(&listed, sizeof(listed));
+    for (uint8_t i = 0; i < listed; i++) {
+        char name[TASK_NAME_SIZE] = {0};
+        strncpy(name, i < task_count ? tasks_[i].name : "other", TASK_NAME_SIZE - 1);
+        writer.write(&i, sizeof(i));
+        writer.write(name, TASK_NAME_SIZE);
+    }
+
+    // 每个核从旧到新输出
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        Ring& ring = rings_[core];
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+        uint32_t count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+        uint32_t overwritten = head - count;
+        writer.write(&count, sizeof(count));
+        writer.write(&overwritten, sizeof(overwritten));
+        for (uint32_t i = head - count; i != head; i++) {
+            writer.write(&ring.records[i & (TRACE_RING_SIZE - 1)], sizeof(TraceRecord));
+        }
+    }
+    writer.flush();
+
+    enabled_.store(was_enabled);
+    return writer.total;
+}
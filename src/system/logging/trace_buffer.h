@@ -0,0 +1,136 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+
+// 是否编译跟踪点（关闭后TRACE_EVENT为空操作）
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+// 每个核的环形缓冲区记录数（每条8字节，必须是2的幂）
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 512
+#endif
+
+// 可区分的任务数（超出后记录到最后一个槽"other"）
+#ifndef TRACE_MAX_TASKS
+#define TRACE_MAX_TASKS 12
+#endif
+
+/**
+ * 跟踪事件ID
+ *
+ * 成对的BEGIN/END事件在主机端转换为时间段，其余为瞬时事件。
+ * 新增事件时在trace_buffer.cpp的事件表中补上名称和参数名（主机端转换工具共用该表）。
+ */
+enum TraceEvent : uint8_t {
+    TRACE_UI_CYCLE_BEGIN = 1,     // UI任务一个周期（arg: 是否被通知唤醒）
+    TRACE_UI_CYCLE_END,
+    TRACE_LOCK_WAIT_BEGIN,        // 等待LVGL锁
+    TRACE_LOCK_WAIT_END,          // 等到锁（arg: 0）或超时（arg: 1）
+    TRACE_LOCK_HOLD_BEGIN,        // 持有LVGL锁
+    TRACE_LOCK_HOLD_END,
+    TRACE_FRAME_LOAD_BEGIN,       // 预取任务读取并解码一帧（arg: 帧索引）
+    TRACE_FRAME_LOAD_END,
+    TRACE_FLUSH_BEGIN,            // 启动DMA刷新（arg: 行数）
+    TRACE_FLUSH_END,              // DMA刷新完成（LVGL等待缓冲区返回时）
+    TRACE_SD_OPEN_BEGIN,          // 打开SD卡文件
+    TRACE_SD_OPEN_END,
+    TRACE_SD_READ_BEGIN,          // 读取SD卡（arg: 字节数，超过65535记为65535）
+    TRACE_SD_READ_END,
+    TRACE_IMU_SAMPLE_BEGIN,       // IMU采样
+    TRACE_IMU_SAMPLE_END,
+    TRACE_FRAME_SHOW,             // 显示一帧（arg: 帧索引）
+    TRACE_FRAME_SKIP,             // 落后丢帧（arg: 丢弃帧数）
+    TRACE_FRAME_UNDERRUN,         // 到点时下一帧未就绪
+    TRACE_EVENT_COUNT             // 事件ID上限（不是事件）
+};
+
+// 事件的显示信息：名称、阶段（'B'/'E'成对，'i'为瞬时事件）、参数名（nullptr为不显示参数）
+struct TraceEventInfo {
+    const char* name;
+    char phase;
+    const char* arg;
+};
+
+// 一条跟踪记录（8字节）
+struct TraceRecord {
+    uint32_t timestamp_us;        // esp_timer时间的低32位
+    uint8_t event;
+    uint8_t task;                 // TraceBuffer分配的任务编号
+    uint16_t arg;
+};
+
+/**
+ * 按核划分的跟踪环形缓冲区
+ *
+ * 每个核一个固定大小的环，写入时用原子自增占位，不加锁、不分配内存，
+ * 可以在任何任务中调用（不要在中断中调用）。环满后覆盖最旧的记录。
+ *
+ * 导出格式（小端）：
+ *   "CTRC" 版本(u16) 核数(u16) 导出时刻(u64 us)
+ *   任务数(u8)，每个任务：编号(u8) 名称(16字节，0填充)
+ *   每个核：记录数(u32) 被覆盖数(u32) 记录(8字节 x 记录数，从旧到新)
+ * 用cybird-cli trace保存导出数据，主机端用scripts/host_bench的trace2json转换为Chrome trace JSON。
+ */
+class TraceBuffer {
+public:
+    static constexpr uint32_t DUMP_MAGIC = 0x43525443;   // "CTRC"
+    static constexpr uint16_t DUMP_VERSION = 1;
+    static constexpr size_t TASK_NAME_SIZE = 16;
+    static constexpr size_t DUMP_CHUNK_SIZE = 768;         // base64编码后刚好1024字符
+
+    // 记录一个事件（未启用时立即返回）
+    static void record(TraceEvent event, uint16_t arg = 0);
+
+    static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // 清空所有环
+    static void clear();
+
+    // 某个核已写入的记录总数（含已被覆盖的）
+    static uint32_t getWritten(int core);
+
+    // 事件的显示信息，未知事件返回nullptr
+    static const TraceEventInfo* eventInfo(uint8_t event);
+
+    /**
+     * 按导出格式逐块输出快照
+     *
+     * 导出期间暂停记录，结束后恢复原来的启用状态
+     *
+     * @param sink 每块数据的回调（每块最多DUMP_CHUNK_SIZE字节）
+     * @return 导出的总字节数
+     */
+    static size_t dump(void (*sink)(const uint8_t* data, size_t length, void* context), void* context);
+
+private:
+    struct Ring {
+        std::atomic<uint32_t> head;      // 单调递增的写入计数
+        TraceRecord records[TRACE_RING_SIZE];
+    };
+
+    struct TaskEntry {
+        TaskHandle_t handle;
+        char name[TASK_NAME_SIZE];
+    };
+
+    static Ring rings_[portNUM_PROCESSORS];
+    static TaskEntry tasks_[TRACE_MAX_TASKS];
+    static std::atomic<uint8_t> task_count_;
+    static std::atomic<bool> enabled_;
+    static portMUX_TYPE task_lock_;
+
+    // 当前任务的编号，首次出现时登记名称
+    static uint8_t taskId(TaskHandle_t handle);
+};
+
+#if TRACE_ENABLED
+#define TRACE_EVENT(event, arg) TraceBuffer::record((event), (arg))
+#else
+#define TRACE_EVENT(event, arg) ((void)0)
+#endif
@@ -1,11 +1,13 @@
 #include "task_manager.h"
 #include "system/logging/log_manager.h"
+#include "system/logging/trace_buffer.h"
 #include "drivers/display/display.h"
 #include "drivers/sensors/imu/imu.h"
 #include "drivers/io/rgb_led/rgb_led.h"
 #include "system/commands/serial_commands.h"
 #include "applications/modules/bird_watching/core/bird_watching.h"
 #include "applications/gui/core/lv_cubic_gui.h"
+#include <esp_timer.h>
 
 // 外部对象引用(在main.cpp中定义)
 extern Display screen;
@@ -20,7 +22,16 @@ TaskManager::TaskManager()
     , ui_queue_(nullptr)
     , system_queue_(nullptr)
     , lvgl_mutex_(nullptr)
+    , lock_taken_us_(0)
+    , timeouts_lock_(portMUX_INITIALIZER_UNLOCKED)
+    , timing_window_start_us_(0)
+    , timing_window_frames_(0)
+    , timing_window_jitter_us_(0)
+    , timing_window_wakeups_(0)
+    , timing_window_notified_(0)
 {
+    memset(&ui_timing_, 0, sizeof(ui_timing_));
+    memset(&lock_stats_, 0, sizeof(lock_stats_));
 }
 
 TaskManager::~TaskManager()
@@ -119,7 +130,18 @@ bool TaskManager::sendToUITask(const TaskMessage& msg)
     if (!ui_queue_) {
         return false;
     }
-    return xQueueSend(ui_queue_, &msg, pdMS_TO_TICKS(100)) == pdTRUE;
+    if (xQueueSend(ui_queue_, &msg, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    notifyUITask();
+    return true;
+}
+
+void TaskManager::notifyUITask()
+{
+    if (ui_task_handle_ && xTaskGetCurrentTaskHandle() != ui_task_handle_) {
+        xTaskNotifyGive(ui_task_handle_);
+    }
 }
 
 bool TaskManager::sendToSystemTask(const TaskMessage& msg)
@@ -135,16 +157,85 @@ bool TaskManager::takeLVGLMutex(uint32_t timeout_ms)
     if (!lvgl_mutex_) {
         return false;
     }
-    return xSemaphoreTake(lvgl_mutex_, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+
+    int64_t start_us = esp_timer_get_time();
+    TickType_t ticks = timeout_ms == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    TRACE_EVENT(TRACE_LOCK_WAIT_BEGIN, 0);
+    if (xSemaphoreTake(lvgl_mutex_, ticks) != pdTRUE) {
+        TRACE_EVENT(TRACE_LOCK_WAIT_END, 1);
+        // 没有拿到锁，多个任务可能同时超时
+        portENTER_CRITICAL(&timeouts_lock_);
+        lock_stats_.timeouts++;
+        portEXIT_CRITICAL(&timeouts_lock_);
+        return false;
+    }
+    TRACE_EVENT(TRACE_LOCK_WAIT_END, 0);
+    TRACE_EVENT(TRACE_LOCK_HOLD_BEGIN, 0);
+
+    // 已持锁，以下统计更新不会与其他任务并发
+    lock_taken_us_ = esp_timer_get_time();
+    uint32_t wait_us = (uint32_t)(lock_taken_us_ - start_us);
+    lock_stats_.acquisitions++;
+    lock_stats_.wait_hist[lockHistBucket(wait_us)]++;
+    if (wait_us > lock_stats_.max_wait_us) {
+        lock_stats_.max_wait_us = wait_us;
+    }
+    return true;
 }
 
 void TaskManager::giveLVGLMutex()
 {
     if (lvgl_mutex_) {
+        // 释放前记录持有时间，仍在锁内
+        uint32_t hold_us = (uint32_t)(esp_timer_get_time() - lock_taken_us_);
+        lock_stats_.hold_hist[lockHistBucket(hold_us)]++;
+        if (hold_us > lock_stats_.max_hold_us) {
+            lock_stats_.max_hold_us = hold_us;
+            strncpy(lock_stats_.max_hold_task, pcTaskGetName(nullptr), sizeof(lock_stats_.max_hold_task) - 1);
+            lock_stats_.max_hold_task[sizeof(lock_stats_.max_hold_task) - 1] = '\0';
+        }
+
+        TRACE_EVENT(TRACE_LOCK_HOLD_END, 0);
         xSemaphoreGive(lvgl_mutex_);
+        // 其他任务可能修改了LVGL对象，唤醒UI任务渲染
+        notifyUITask();
     }
 }
 
+void TaskManager::resetLVGLLockStats()
+{
+    if (!lvgl_mutex_) {
+        return;
+    }
+    // 直接操作信号量，避免清零操作本身计入统计
+    xSemaphoreTake(lvgl_mutex_, portMAX_DELAY);
+    portENTER_CRITICAL(&timeouts_lock_);
+    memset(&lock_stats_, 0, sizeof(lock_stats_));
+    portEXIT_CRITICAL(&timeouts_lock_);
+    xSemaphoreGive(lvgl_mutex_);
+}
+
+uint32_t TaskManager::lockHistBucketLimit(int index)
+{
+    static const uint32_t limits[LVGL_LOCK_HIST_BUCKETS] = {
+        100, 500, 1000, 5000, 10000, 50000, 100000, 0
+    };
+    if (index < 0 || index >= LVGL_LOCK_HIST_BUCKETS) {
+        return 0;
+    }
+    return limits[index];
+}
+
+int TaskManager::lockHistBucket(uint32_t us)
+{
+    for (int i = 0; i < LVGL_LOCK_HIST_BUCKETS - 1; i++) {
+        if (us < lockHistBucketLimit(i)) {
+            return i;
+        }
+    }
+    return LVGL_LOCK_HIST_BUCKETS - 1;
+}
+
 void TaskManager::printTaskStats()
 {
     char buffer[256];
@@ -155,6 +246,9 @@ void TaskManager::printTaskStats()
         UBaseType_t stackHighWaterMark = uxTaskGetStackHighWaterMark(ui_task_handle_);
         snprintf(buffer, sizeof(buffer), "UI Task - Stack free: %u bytes", stackHighWaterMark);
         LOG_INFO("TASK_MGR", buffer);
+        snprintf(buffer, sizeof(buffer), "UI Task - Wakeups: %u/s (%u by notification)",
+                 ui_timing_.wakeups, ui_timing_.notified_wakeups);
+        LOG_INFO("TASK_MGR", buffer);
     }
     
     if (system_task_handle_) {
@@ -167,12 +261,56 @@ void TaskManager::printTaskStats()
     LOG_INFO("TASK_MGR", buffer);
 }
 
+void TaskManager::recordUICycle(uint32_t jitter_us, uint32_t render_us, uint32_t sleep_ms, bool notified)
+{
+    ui_timing_.cycles++;
+    ui_timing_.last_sleep_ms = sleep_ms;
+    if (jitter_us > ui_timing_.max_jitter_us) {
+        ui_timing_.max_jitter_us = jitter_us;
+    }
+    if (render_us > ui_timing_.max_render_us) {
+        ui_timing_.max_render_us = render_us;
+    }
+
+    timing_window_jitter_us_ += jitter_us;
+    timing_window_wakeups_++;
+    if (notified) {
+        timing_window_notified_++;
+    }
+
+    // 每秒结算一次FPS和平均抖动
+    int64_t now = esp_timer_get_time();
+    if (timing_window_start_us_ == 0) {
+        timing_window_start_us_ = now;
+        timing_window_frames_ = Display::getFrameCount();
+        timing_window_jitter_us_ = 0;
+        timing_window_wakeups_ = 0;
+        timing_window_notified_ = 0;
+        return;
+    }
+
+    int64_t elapsed_us = now - timing_window_start_us_;
+    if (elapsed_us >= 1000000) {
+        uint32_t frames = Display::getFrameCount();
+        ui_timing_.fps = (uint32_t)((uint64_t)(frames - timing_window_frames_) * 1000000 / elapsed_us);
+        uint32_t timed_wakeups = timing_window_wakeups_ - timing_window_notified_;
+        ui_timing_.avg_jitter_us = timed_wakeups ? (uint32_t)(timing_window_jitter_us_ / timed_wakeups) : 0;
+        ui_timing_.wakeups = (uint32_t)((uint64_t)timing_window_wakeups_ * 1000000 / elapsed_us);
+        ui_timing_.notified_wakeups = (uint32_t)((uint64_t)timing_window_notified_ * 1000000 / elapsed_us);
+
+        timing_window_start_us_ = now;
+        timing_window_frames_ = frames;
+        timing_window_jitter_us_ = 0;
+        timing_window_wakeups_ = 0;
+        timing_window_notified_ = 0;
+    }
+}
+
 /**
  * @brief UI任务函数 - 运行在Core 0
  * 
  * 职责:
- * - LVGL GUI更新 (lv_timer_handler)
- * - Display驱动 (screen.routine)
+ * - LVGL GUI更新 (screen.routine，每周期一次lv_timer_handler)
  * - BirdAnimation动画播放
  * - 图片解码和渲染
  */
@@ -182,22 +320,30 @@ void TaskManager::uiTaskFunction(void* parameter)
     LOG_INFO("UI_TASK", "UI Task started on Core 0");
 
     TaskMessage msg;
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    const TickType_t taskPeriod = pdMS_TO_TICKS(5); // 5ms周期 = 200Hz
+    int64_t expected_wake_us = 0;     // 本次计划唤醒时间（用于统计抖动）
+    bool notified = false;            // 本次是否由任务通知唤醒
     
     static bool logo_hidden = false;  // 标记logo是否已隐藏
 
     while (true) {
+        int64_t wake_us = esp_timer_get_time();
+        uint32_t jitter_us = 0;
+        if (expected_wake_us && !notified) {
+            // 只有按计划超时唤醒才计入抖动，被通知提前唤醒不算
+            int64_t diff = wake_us - expected_wake_us;
+            jitter_us = (uint32_t)(diff < 0 ? -diff : diff);
+        }
+        uint32_t render_us = 0;
+        uint32_t sleep_ms = UI_TASK_MIN_SLEEP_MS;
+        TRACE_EVENT(TRACE_UI_CYCLE_BEGIN, notified ? 1 : 0);
+
         // 处理消息队列(非阻塞)
         while (xQueueReceive(manager->ui_queue_, &msg, 0) == pdTRUE) {
             // 处理UI相关消息
             switch (msg.type) {
                 case MSG_TRIGGER_BIRD:
-                    // 触发小鸟动画
-                    if (manager->takeLVGLMutex(100)) {
-                        BirdWatching::triggerBird();
-                        manager->giveLVGLMutex();
-                    }
+                    // 投递播放命令，下面processBirdTriggerRequest中处理
+                    BirdWatching::triggerBird();
                     break;
                 
                 default:
@@ -205,15 +351,15 @@ void TaskManager::uiTaskFunction(void* parameter)
             }
         }
 
+        // 处理BirdWatching命令(必须在UI任务中执行)
+        // 不在锁内调用：加载bundle要读SD卡，内部只在修改LVGL对象时短暂持锁
+        BirdWatching::processBirdTriggerRequest();
+
         // 获取LVGL互斥锁并更新UI
         if (manager->takeLVGLMutex(10)) {
             // 检查logo显示超时（必须在UI任务中执行）
             lv_check_logo_timeout();
             
-            // 处理BirdWatching触发请求(必须在UI任务中执行)
-            // 注意: 图像加载可能耗时较长，但已优化为分块加载
-            BirdWatching::processBirdTriggerRequest();
-            
             // 如果动画正在播放且logo还没隐藏，立即隐藏logo
             if (!logo_hidden && BirdWatching::isAnimationPlaying()) {
                 lv_hide_logo();
@@ -221,20 +367,22 @@ void TaskManager::uiTaskFunction(void* parameter)
                 LOG_INFO("UI_TASK", "Animation started, logo hidden automatically");
             }
 
-            // LVGL定时器处理
-            lv_timer_handler();
-            
-            // Display驱动更新
-            screen.routine();
+            // 每个周期只执行一次LVGL渲染（定时器处理+刷新），返回下一个定时器的到期时间
+            int64_t render_start = esp_timer_get_time();
+            uint32_t next_ms = screen.routine();
+            render_us = (uint32_t)(esp_timer_get_time() - render_start);
             
             manager->giveLVGLMutex();
-        } else {
-            // 如果无法获取互斥锁，让出CPU避免死锁
-            vTaskDelay(1);
+
+            sleep_ms = constrain(next_ms, (uint32_t)UI_TASK_MIN_SLEEP_MS, (uint32_t)UI_TASK_MAX_SLEEP_MS);
         }
 
-        // 精确延时,保证稳定的刷新率
-        vTaskDelayUntil(&lastWakeTime, taskPeriod);
+        manager->recordUICycle(jitter_us, render_us, sleep_ms, notified);
+        TRACE_EVENT(TRACE_UI_CYCLE_END, 0);
+
+        // 休眠到LVGL下一个定时器到期，期间有新消息、触发请求或界面修改时被通知提前唤醒
+        expected_wake_us = esp_timer_get_time() + (int64_t)sleep_ms * 1000;
+        notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleep_ms)) > 0;
     }
 }
 
@@ -275,6 +423,10 @@ void TaskManager::systemTaskFunction(void* parameter)
                 case MSG_GESTURE_EVENT:
                     // 处理手势事件
                     break;
+
+                case MSG_LED_FLASH:
+                    rgb.flash((msg.param1 >> 16) & 0xFF, (msg.param1 >> 8) & 0xFF, msg.param1 & 0xFF, msg.param2);
+                    break;
                 
                 default:
                     break;
@@ -283,45 +435,35 @@ void TaskManager::systemTaskFunction(void* parameter)
 
         // 更新IMU数据 (200ms间隔)
         if (currentTime - lastMPUUpdate >= MPU_UPDATE_INTERVAL) {
+            TRACE_EVENT(TRACE_IMU_SAMPLE_BEGIN, 0);
             mpu.update(0); // 不使用内部延时
+            TRACE_EVENT(TRACE_IMU_SAMPLE_END, 0);
             lastMPUUpdate = currentTime;
 
             // 检测手势并触发相应事件
             GestureType gesture = mpu.detectGesture();
             if (gesture != GESTURE_NONE) {
-                // 将手势类型转发给BirdWatching系统
-                // BirdManager会根据当前状态决定如何响应
+                // 将手势投递到BirdWatching邮箱，由UI任务按当前状态响应
+                // 系统任务不再为手势等待LVGL锁
                 switch (gesture) {
                     case GESTURE_FORWARD_HOLD:
                         LOG_INFO("SYS_TASK", "Forward hold detected (1s)");
-                        if (manager->takeLVGLMutex(100)) {
-                            BirdWatching::onGesture(GESTURE_FORWARD_HOLD);
-                            manager->giveLVGLMutex();
-                        }
+                        BirdWatching::onGesture(GESTURE_FORWARD_HOLD);
                         break;
                     
                     case GESTURE_BACKWARD_HOLD:
                         LOG_INFO("SYS_TASK", "Backward hold detected (1s)");
-                        if (manager->takeLVGLMutex(100)) {
-                            BirdWatching::onGesture(GESTURE_BACKWARD_HOLD);
-                            manager->giveLVGLMutex();
-                        }
+                        BirdWatching::onGesture(GESTURE_BACKWARD_HOLD);
                         break;
                     
                     case GESTURE_LEFT_TILT:
                         LOG_DEBUG("SYS_TASK", "Left tilt detected");
-                        if (manager->takeLVGLMutex(100)) {
-                            BirdWatching::onGesture(GESTURE_LEFT_TILT);
-                            manager->giveLVGLMutex();
-                        }
+                        BirdWatching::onGesture(GESTURE_LEFT_TILT);
                         break;
                     
                     case GESTURE_RIGHT_TILT:
                         LOG_DEBUG("SYS_TASK", "Right tilt detected");
-                        if (manager->takeLVGLMutex(100)) {
-                            BirdWatching::onGesture(GESTURE_RIGHT_TILT);
-                            manager->giveLVGLMutex();
-                        }
+                        BirdWatching::onGesture(GESTURE_RIGHT_TILT);
                         break;
                     
                     default:
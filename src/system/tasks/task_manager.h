@@ -15,13 +15,65 @@
 #define UI_TASK_CORE            0       // UI任务运行在Core 0 (Protocol Core)
 #define SYSTEM_TASK_CORE        1       // 系统任务运行在Core 1 (Application Core)
 
+// UI任务阻塞在任务通知上，由新消息、触发请求、其他任务修改LVGL对象唤醒，
+// 否则休眠到LVGL下一个定时器到期；上限只用于logo/小鸟信息的超时检查
+#define UI_TASK_MIN_SLEEP_MS    1
+#define UI_TASK_MAX_SLEEP_MS    250
+
+// 帧预取任务配置（SD卡读取与UI渲染分核进行）
+#define PREFETCH_TASK_STACK_SIZE 4096   // 预取任务栈大小(4KB)
+#define PREFETCH_TASK_PRIORITY   2      // 高于系统任务，保证播放头前的帧及时就绪
+#define PREFETCH_TASK_CORE       SYSTEM_TASK_CORE
+
+// 统计保存任务配置（合并写入，写卡不阻塞系统任务）
+#define STATS_TASK_STACK_SIZE    4096
+#define STATS_TASK_PRIORITY      1
+#define STATS_TASK_CORE          SYSTEM_TASK_CORE
+
+// 日志刷新任务配置（低优先级，把日志缓冲区按块写入SD卡）
+#define LOG_TASK_STACK_SIZE      4096
+#define LOG_TASK_PRIORITY        0       // 与空闲任务同级，只在其他任务都空闲时写卡
+#define LOG_TASK_CORE            SYSTEM_TASK_CORE
+
+// 串口命令任务配置（文件传输、日志导出等耗时命令，不占用系统任务的10ms周期）
+#define CMD_TASK_STACK_SIZE      8192
+#define CMD_TASK_PRIORITY        0       // 低于系统任务，传输期间系统任务照常调度
+#define CMD_TASK_CORE            SYSTEM_TASK_CORE
+
 // 任务间消息类型
 enum TaskMessageType {
     MSG_TRIGGER_BIRD = 0,      // 触发小鸟动画
     MSG_UPDATE_CONFIG,         // 更新配置
     MSG_SHOW_STATS,           // 显示统计信息
     MSG_GESTURE_EVENT,        // 手势事件
-    MSG_SYSTEM_EVENT          // 系统事件
+    MSG_SYSTEM_EVENT,         // 系统事件
+    MSG_LED_FLASH             // RGB灯闪一下（param1为0xRRGGBB，param2为毫秒）
+};
+
+// UI渲染周期统计（由UI任务更新，task命令读取）
+struct UITimingStats {
+    uint32_t cycles;            // 渲染周期总数
+    uint32_t fps;               // 最近1秒实际刷新到屏幕的帧数
+    uint32_t avg_jitter_us;     // 最近1秒唤醒时间与计划时间的平均偏差
+    uint32_t max_jitter_us;     // 唤醒偏差最大值
+    uint32_t max_render_us;     // 单次lv_timer_handler最长耗时
+    uint32_t last_sleep_ms;     // 最近一次休眠时长
+    uint32_t wakeups;           // 最近1秒的唤醒次数
+    uint32_t notified_wakeups;  // 其中由任务通知唤醒的次数
+};
+
+// LVGL互斥锁统计（等待时间和持有时间直方图）
+// 桶上限(us): 100, 500, 1000, 5000, 10000, 50000, 100000, 其余计入最后一桶
+#define LVGL_LOCK_HIST_BUCKETS  8
+
+struct LVGLLockStats {
+    uint32_t acquisitions;                        // 成功加锁次数
+    uint32_t timeouts;                            // 等待超时次数
+    uint32_t wait_hist[LVGL_LOCK_HIST_BUCKETS];   // 等待时间分布
+    uint32_t hold_hist[LVGL_LOCK_HIST_BUCKETS];   // 持有时间分布
+    uint32_t max_wait_us;                         // 最长等待时间
+    uint32_t max_hold_us;                         // 最长持有时间
+    char max_hold_task[16];                       // 最长持有时的任务名
 };
 
 // 任务间消息结构
@@ -55,10 +107,21 @@ public:
     // 发送消息到系统任务
     bool sendToSystemTask(const TaskMessage& msg);
 
+    // 唤醒UI任务（有新的触发请求或界面需要刷新时调用）
+    void notifyUITask();
+
     // 获取LVGL互斥锁(在访问LVGL对象前必须获取)
+    // 其他任务释放锁时会唤醒UI任务，使修改尽快渲染
     bool takeLVGLMutex(uint32_t timeout_ms = portMAX_DELAY);
     void giveLVGLMutex();
 
+    // LVGL锁统计（task lock命令输出）
+    const LVGLLockStats& getLVGLLockStats() const { return lock_stats_; }
+    void resetLVGLLockStats();
+
+    // 直方图第index个桶的上限(us)，最后一个桶返回0表示无上限
+    static uint32_t lockHistBucketLimit(int index);
+
     // 获取任务句柄
     TaskHandle_t getUITaskHandle() const { return ui_task_handle_; }
     TaskHandle_t getSystemTaskHandle() const { return system_task_handle_; }
@@ -66,6 +129,9 @@ public:
     // 任务统计信息
     void printTaskStats();
 
+    // UI渲染周期统计
+    const UITimingStats& getUITimingStats() const { return ui_timing_; }
+
 private:
     TaskManager();
     ~TaskManager();
@@ -83,6 +149,24 @@ private:
     // LVGL互斥锁(保护LVGL对象访问)
     SemaphoreHandle_t lvgl_mutex_;
 
+    // LVGL锁统计，只在持锁期间更新；超时计数没有持锁，在timeouts_lock_临界区内递增
+    LVGLLockStats lock_stats_;
+    int64_t lock_taken_us_;
+    portMUX_TYPE timeouts_lock_;
+
+    static int lockHistBucket(uint32_t us);
+
+    // UI渲染周期统计及1秒统计窗口
+    UITimingStats ui_timing_;
+    int64_t timing_window_start_us_;
+    uint32_t timing_window_frames_;
+    uint64_t timing_window_jitter_us_;
+    uint32_t timing_window_wakeups_;
+    uint32_t timing_window_notified_;
+
+    // 记录一次UI周期（仅UI任务调用）
+    void recordUICycle(uint32_t jitter_us, uint32_t render_us, uint32_t sleep_ms, bool notified);
+
     // 任务函数(静态方法)
     static void uiTaskFunction(void* parameter);
     static void systemTaskFunction(void* parameter);